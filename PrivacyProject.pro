@@ -7,7 +7,8 @@ SUBDIRS += src/CoreLib \
     src/DatasetParser \
     src/PrivacyFilters \
     src/PersonReid \
-    src/PrivacyEditor
+    src/PrivacyEditor \
+    src/Benchmarks
 
 # Install script
 DESTDIR = $$OUT_PWD/bin
@@ -0,0 +1,223 @@
+#include "BenchmarkRunner.h"
+#include "opencv_utils_simd.h"
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QThread>
+#include <QStringList>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace dai {
+
+BenchmarkRunner::BenchmarkRunner()
+    : m_minIterations(10)
+    , m_maxIterations(10000)
+    , m_minTimeNs(500 * 1000000LL)
+{
+}
+
+void BenchmarkRunner::setFilter(const QString& pattern)
+{
+    m_filter = QRegularExpression(pattern);
+}
+
+void BenchmarkRunner::setMinIterations(int iterations)
+{
+    m_minIterations = iterations > 0 ? iterations : 1;
+}
+
+void BenchmarkRunner::setMaxIterations(int iterations)
+{
+    m_maxIterations = iterations > 0 ? iterations : 1;
+}
+
+void BenchmarkRunner::setMinTime(int ms)
+{
+    m_minTimeNs = qint64(ms) * 1000000LL;
+}
+
+bool BenchmarkRunner::isEnabled(const QString& suite, const QString& name) const
+{
+    if (m_filter.pattern().isEmpty())
+        return true;
+
+    return m_filter.match(suite + "/" + name).hasMatch();
+}
+
+void BenchmarkRunner::measure(const QString& suite, const QString& name, std::function<void ()> func,
+                              double itemsPerCall, const QString& unit)
+{
+    if (!isEnabled(suite, name))
+        return;
+
+    QVector<qint64> samples;
+    QElapsedTimer timer, callTimer;
+    qint64 totalTime = 0;
+
+    // Warm up (caches, lazy allocations)
+    func();
+
+    timer.start();
+
+    while (samples.size() < m_maxIterations &&
+           (samples.size() < m_minIterations || timer.nsecsElapsed() < m_minTimeNs))
+    {
+        callTimer.start();
+        func();
+        qint64 elapsed = callTimer.nsecsElapsed();
+        samples << elapsed;
+        totalTime += elapsed;
+    }
+
+    double throughput = 0;
+
+    if (itemsPerCall > 0 && totalTime > 0)
+        throughput = itemsPerCall * samples.size() * 1000000000.0 / totalTime;
+
+    addResult(suite, name, samples, throughput, unit);
+}
+
+void BenchmarkRunner::addResult(const QString& suite, const QString& name, QVector<qint64> samples,
+                                double throughput, const QString& unit, const QVariantMap& extra)
+{
+    if (samples.isEmpty())
+        return;
+
+    BenchmarkResult result;
+    result.suite = suite;
+    result.name = name;
+    result.iterations = samples.size();
+    result.throughput = throughput;
+    result.throughputUnit = unit;
+    result.extra = extra;
+
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0;
+    for (qint64 sample : samples)
+        sum += sample;
+
+    const double mean = sum / samples.size();
+    double variance = 0;
+
+    for (qint64 sample : samples)
+        variance += (sample - mean) * (sample - mean);
+
+    variance /= samples.size();
+
+    const double nsToMs = 1.0 / 1000000.0;
+    result.minMs = samples.first() * nsToMs;
+    result.maxMs = samples.last() * nsToMs;
+    result.meanMs = mean * nsToMs;
+    result.medianMs = samples[samples.size() / 2] * nsToMs;
+    result.p95Ms = samples[std::min<int>(samples.size() - 1, std::ceil(samples.size() * 0.95) - 1)] * nsToMs;
+    result.stddevMs = std::sqrt(variance) * nsToMs;
+
+    m_results << result;
+    printResult(result);
+}
+
+const QList<BenchmarkResult>& BenchmarkRunner::results() const
+{
+    return m_results;
+}
+
+void BenchmarkRunner::printResult(const BenchmarkResult& result) const
+{
+    QString line = QString("%1/%2: median %3 ms, mean %4 ms, p95 %5 ms (%6 runs)")
+            .arg(result.suite).arg(result.name)
+            .arg(result.medianMs, 0, 'f', 4).arg(result.meanMs, 0, 'f', 4)
+            .arg(result.p95Ms, 0, 'f', 4).arg(result.iterations);
+
+    if (result.throughput > 0)
+        line += QString(", %1 %2").arg(result.throughput, 0, 'f', 1).arg(result.throughputUnit);
+
+    qDebug().noquote() << line;
+}
+
+QVariantMap BenchmarkRunner::environment()
+{
+    QVariantMap env;
+    env["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    env["os"] = QSysInfo::prettyProductName();
+    env["cpu_arch"] = QSysInfo::currentCpuArchitecture();
+    env["cpu_threads"] = QThread::idealThreadCount();
+    env["qt_version"] = qVersion();
+    env["simd"] = simdLevelName(simdSupportedLevel());
+
+#if defined(__clang__)
+    env["compiler"] = QString("clang %1.%2").arg(__clang_major__).arg(__clang_minor__);
+#elif defined(__GNUC__)
+    env["compiler"] = QString("gcc %1.%2").arg(__GNUC__).arg(__GNUC_MINOR__);
+#elif defined(_MSC_VER)
+    env["compiler"] = QString("msvc %1").arg(_MSC_VER);
+#endif
+
+#ifdef QT_DEBUG
+    env["build"] = "debug";
+#else
+    env["build"] = "release";
+#endif
+
+    return env;
+}
+
+QByteArray BenchmarkRunner::toJson() const
+{
+    QJsonArray benchmarks;
+
+    for (const BenchmarkResult& result : m_results)
+    {
+        QJsonObject item;
+        item["suite"] = result.suite;
+        item["name"] = result.name;
+        item["iterations"] = result.iterations;
+        item["min_ms"] = result.minMs;
+        item["max_ms"] = result.maxMs;
+        item["mean_ms"] = result.meanMs;
+        item["median_ms"] = result.medianMs;
+        item["p95_ms"] = result.p95Ms;
+        item["stddev_ms"] = result.stddevMs;
+
+        if (result.throughput > 0) {
+            item["throughput"] = result.throughput;
+            item["throughput_unit"] = result.throughputUnit;
+        }
+
+        if (!result.extra.isEmpty())
+            item["extra"] = QJsonObject::fromVariantMap(result.extra);
+
+        benchmarks.append(item);
+    }
+
+    QJsonObject root;
+    root["environment"] = QJsonObject::fromVariantMap(environment());
+    root["benchmarks"] = benchmarks;
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+QByteArray BenchmarkRunner::toCsv() const
+{
+    QByteArray csv = "suite,name,iterations,min_ms,max_ms,mean_ms,median_ms,p95_ms,stddev_ms,throughput,throughput_unit\n";
+
+    for (const BenchmarkResult& result : m_results)
+    {
+        QStringList fields;
+        fields << result.suite << result.name << QString::number(result.iterations)
+               << QString::number(result.minMs, 'f', 6) << QString::number(result.maxMs, 'f', 6)
+               << QString::number(result.meanMs, 'f', 6) << QString::number(result.medianMs, 'f', 6)
+               << QString::number(result.p95Ms, 'f', 6) << QString::number(result.stddevMs, 'f', 6)
+               << QString::number(result.throughput, 'f', 3) << result.throughputUnit;
+        csv += fields.join(",").toUtf8() + "\n";
+    }
+
+    return csv;
+}
+
+} // End Namespace
@@ -0,0 +1,79 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QVariantMap>
+#include <QRegularExpression>
+#include <functional>
+
+namespace dai {
+
+struct BenchmarkResult
+{
+    QString suite;
+    QString name;
+    int iterations = 0;
+    double minMs = 0;
+    double maxMs = 0;
+    double meanMs = 0;
+    double medianMs = 0;
+    double p95Ms = 0;
+    double stddevMs = 0;
+    double throughput = 0;   // Items per second (0 if it does not apply)
+    QString throughputUnit;
+    QVariantMap extra;       // Benchmark specific values
+};
+
+/**
+ * Runs the benchmarks and collects their results. Each benchmark is called until it has
+ * run at least minIterations times and minTime milliseconds (or maxIterations times).
+ * Every call is timed on its own, so percentiles are available.
+ *
+ * Results can be exported as JSON or CSV so they can be compared across releases.
+ *
+ * @brief The BenchmarkRunner class
+ */
+class BenchmarkRunner
+{
+public:
+    BenchmarkRunner();
+
+    void setFilter(const QString& pattern);
+    void setMinIterations(int iterations);
+    void setMaxIterations(int iterations);
+    void setMinTime(int ms);
+    bool isEnabled(const QString& suite, const QString& name) const;
+
+    /**
+     * Time func. itemsPerCall is used to report throughput (frames/s, pixels/s, ...)
+     */
+    void measure(const QString& suite, const QString& name, std::function<void ()> func,
+                 double itemsPerCall = 0, const QString& unit = QString());
+
+    /**
+     * Add a result measured by the caller (macro benchmarks). Samples are in nanoseconds.
+     */
+    void addResult(const QString& suite, const QString& name, QVector<qint64> samples,
+                   double throughput = 0, const QString& unit = QString(), const QVariantMap& extra = QVariantMap());
+
+    const QList<BenchmarkResult>& results() const;
+    QByteArray toJson() const;
+    QByteArray toCsv() const;
+
+    static QVariantMap environment();
+
+private:
+    void printResult(const BenchmarkResult& result) const;
+
+    QList<BenchmarkResult> m_results;
+    QRegularExpression m_filter;
+    int m_minIterations;
+    int m_maxIterations;
+    qint64 m_minTimeNs;
+};
+
+} // End Namespace
+
+#endif // BENCHMARKRUNNER_H
@@ -0,0 +1,128 @@
+!include(../common.pri) {
+    error("Couldn't find the common.pri file!")
+}
+
+QT += core quick gui concurrent
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = Benchmarks
+TEMPLATE = app
+CONFIG += console link_prl
+CONFIG -= app_bundle
+
+*-g++ {
+    QMAKE_CXXFLAGS += -Wno-unused-local-typedefs
+}
+
+INCLUDEPATH += $$PWD/../PersonReid $$PWD/../PrivacyFilterLib
+DEPENDPATH += $$PWD/../PersonReid $$PWD/../PrivacyFilterLib
+
+HEADERS += \
+    BenchmarkRunner.h \
+    SyntheticData.h \
+    Suites.h \
+    ../PersonReid/PersonReid.h \
+    ../PersonReid/Descriptor.h \
+    ../PersonReid/JointHistograms.h \
+    ../PersonReid/DistancesFeature.h \
+    ../PersonReid/RegionDescriptor.h \
+    ../PersonReid/DescriptorSet.h \
+    ../PersonReid/SkeletonFeatures.h \
+    ../PrivacyFilterLib/filters/PointCloudRenderer.h \
+    ../PrivacyFilterLib/filters/PrivacyPolicy.h
+
+SOURCES += main.cpp \
+    BenchmarkRunner.cpp \
+    SyntheticData.cpp \
+    FrameBenchmarks.cpp \
+    FeatureBenchmarks.cpp \
+    ImageKernelBenchmarks.cpp \
+    PlaybackBenchmarks.cpp \
+    OpenNIBenchmarks.cpp \
+    SegmentationBenchmarks.cpp \
+    RenderingBenchmarks.cpp \
+    CodecBenchmarks.cpp \
+    PolicyBenchmarks.cpp \
+    ../PersonReid/PersonReid.cpp \
+    ../PersonReid/Descriptor.cpp \
+    ../PersonReid/DistancesFeature.cpp \
+    ../PersonReid/RegionDescriptor.cpp \
+    ../PersonReid/DescriptorSet.cpp \
+    ../PersonReid/SkeletonFeatures.cpp \
+    ../PrivacyFilterLib/filters/PointCloudRenderer.cpp \
+    ../PrivacyFilterLib/filters/PrivacyPolicy.cpp
+
+
+unix {
+    # CoreLib
+    LIBS += -L$$BIN_PATH -lCoreLib
+    PRE_TARGETDEPS += $$BIN_PATH/libCoreLib.a
+    INCLUDEPATH += $$PWD/../CoreLib
+    DEPENDPATH += $$PWD/../CoreLib
+
+    # OpenNI2
+    LIBS += -L$$(OPENNI2_REDIST) -lOpenNI2
+    INCLUDEPATH += $$(OPENNI2_INCLUDE)
+    DEPENDPATH += $$(OPENNI2_INCLUDE)
+
+    # OpenCV2
+    LIBS += -lopencv_core -lopencv_imgproc -lopencv_highgui -lopencv_objdetect -lopencv_photo -lopencv_features2d -lopencv_nonfree -lopencv_flann
+}
+
+unix:!macx {
+    # NiTE2
+    INCLUDEPATH += /opt/NiTE-Linux-x64-2.2/Include
+    DEPENDPATH += /opt/NiTE-Linux-x64-2.2/Include
+}
+
+unix:macx {
+    # OpenCV2
+    INCLUDEPATH += $$(OPENCV2_INCLUDE)
+    DEPENDPATH += $$(OPENCV2_INCLUDE)
+
+    # Boost
+    INCLUDEPATH += $$(BOOST_INCLUDE)
+    DEPENDPATH += $$(BOOST_INCLUDE)
+}
+
+win32 {
+    # ensure QMAKE_MOC contains the moc executable path
+    load(moc)
+
+    INCLUDEPATH += $$PWD
+
+    # CoreLib
+    INCLUDEPATH += $$PWD/../CoreLib
+    DEPENDPATH += $$PWD/../CoreLib
+
+    # CoreLib Dynamic
+    LIBS += -L$$BIN_PATH/ -lCoreLib
+
+    # CoreLib Static
+    PRE_TARGETDEPS += $$BIN_PATH/CoreLib.lib
+
+    # Boost
+    BOOSTDIR = $$(BOOST_INCLUDEDIR)
+    BOOSTLIB = $$(BOOST_LIBRARYDIR)
+    !isEmpty(BOOSTDIR) {
+        INCLUDEPATH += $$BOOSTDIR
+        win32-g++:CONFIG(release, debug|release):LIBS += -L$$BOOSTLIB -lboost_date_time-mgw48-mt-1_56 -lboost_thread-mgw48-mt-1_56
+        else:win32-g++:CONFIG(debug, debug|release):LIBS += -L$$BOOSTLIB -lboost_date_time-mgw48-mt-d-1_56 -lboost_thread-mgw48-mt-d-1_56
+        else:CONFIG(release, debug|release):LIBS += -L$$BOOSTLIB -lboost_date_time-vc120-mt-1_56 -lboost_thread-vc120-mt-1_56
+        else:CONFIG(debug, debug|release):LIBS += -L$$BOOSTLIB -lboost_date_time-vc120-mt-gd-1_56 -lboost_thread-vc120-mt-gd-1_56
+    }
+
+    # OpenNI2
+    INCLUDEPATH += $$(OPENNI2_INCLUDE)
+    DEPENDPATH += $$(OPENNI2_INCLUDE)
+
+    # NiTE2
+    INCLUDEPATH += $$(NITE2_INCLUDE)
+    DEPENDPATH += $$(NITE2_INCLUDE)
+
+    # OpenCV2
+    INCLUDEPATH += $$(OPENCV2_INCLUDE)
+    DEPENDPATH += $$(OPENCV2_INCLUDE)
+    CONFIG(release, debug|release):LIBS += -L$$(OPENCV2_LIB) -lopencv_core2410 -lopencv_imgproc2410 -lopencv_highgui2410 -lopencv_objdetect2410 -lopencv_photo2410 -lopencv_features2d2410 -lopencv_nonfree2410 -lopencv_flann2410
+    else:CONFIG(debug, debug|release):LIBS += -L$$(OPENCV2_LIB) -lopencv_core2410d -lopencv_imgproc2410d -lopencv_highgui2410d -lopencv_objdetect2410d -lopencv_photo2410d -lopencv_features2d2410d -lopencv_nonfree2410d -lopencv_flann2410d
+}
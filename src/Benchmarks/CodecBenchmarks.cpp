@@ -0,0 +1,144 @@
+#include "Suites.h"
+#include "BenchmarkRunner.h"
+#include "SyntheticData.h"
+#include "types/FrameCodec.h"
+#include "dataset/IASLAB_RGBD_ID/IASLAB_RGBD_ID.h"
+#include "dataset/InstanceInfo.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <QDebug>
+
+namespace dai {
+
+/**
+ * Encoded size compared with toBinary() (what the datasets store) and with zlib
+ */
+template <class Frame>
+static QVariantMap compressionRatios(const Frame& frame, const QByteArray& encoded)
+{
+    const QByteArray binary = frame.toBinary();
+    QVariantMap extra;
+    extra["bytes"] = encoded.size();
+    extra["ratio"] = double(binary.size()) / encoded.size();
+    extra["ratio_zlib"] = double(binary.size()) / qCompress(binary).size();
+    return extra;
+}
+
+template <class Frame>
+static void runSyntheticCodec(BenchmarkRunner& runner, const QString& suite, const QString& name, const Frame& frame)
+{
+    const double pixels = frame.width() * frame.height();
+
+    for (int threads : {1, 0})
+    {
+        const QString suffix = threads == 1 ? "_1thread" : "";
+        QByteArray encoded;
+        Frame decoded;
+
+        runner.measure(suite, name + "_encode" + suffix, [&]() {
+            encoded = FrameCodec::encode(frame, threads);
+        }, pixels, "pixels/s");
+
+        runner.measure(suite, name + "_decode" + suffix, [&]() {
+            FrameCodec::decode(encoded, decoded, threads);
+        }, pixels, "pixels/s");
+    }
+
+    if (runner.isEnabled(suite, name + "_ratio")) {
+        runner.addResult(suite, name + "_ratio", {0}, 0, QString(),
+                         compressionRatios(frame, FrameCodec::encode(frame, 1)));
+    }
+}
+
+/**
+ * Depth frames and masks of IASLAB-RGBD-ID are encoded and decoded. Samples are the time
+ * to encode a depth frame and its mask; sizes are compared with the raw frames.
+ */
+static void runIaslabCodec(BenchmarkRunner& runner, const QString& suite, const QString& datasetPath)
+{
+    if (datasetPath.isEmpty() || !runner.isEnabled(suite, "IASLAB_RGBD_ID"))
+        return;
+
+    IASLAB_RGBD_ID dataset;
+    dataset.setPath(datasetPath);
+    const DatasetMetadata& metadata = dataset.getMetadata();
+    const QList<shared_ptr<InstanceInfo>> instances = metadata.instances(metadata.actors().keys(),
+                                                                          metadata.cameras().keys(),
+                                                                          DatasetMetadata::ANY_LABEL);
+    QVector<qint64> samples;
+    qint64 rawBytes = 0, encodedBytes = 0, zlibBytes = 0, decodeNs = 0;
+    int errors = 0;
+
+    for (shared_ptr<InstanceInfo> info : instances)
+    {
+        shared_ptr<StreamInstance> instance = dataset.getInstance(*info, DataFrame::Color);
+
+        if (!instance)
+            continue;
+
+        QHashDataFrames readFrames;
+        instance->open();
+        instance->readNextFrame(readFrames);
+        instance->close();
+
+        auto depthFrame = static_pointer_cast<DepthFrame>(readFrames.value(DataFrame::Depth));
+        auto maskFrame = static_pointer_cast<MaskFrame>(readFrames.value(DataFrame::Mask));
+
+        if (!depthFrame || !maskFrame)
+            continue;
+
+        QElapsedTimer timer;
+        timer.start();
+        const QByteArray depthData = FrameCodec::encode(*depthFrame, 1);
+        const QByteArray maskData = FrameCodec::encode(*maskFrame, 1);
+        samples << timer.nsecsElapsed();
+
+        DepthFrame depth;
+        MaskFrame mask;
+        timer.start();
+        const bool ok = FrameCodec::decode(depthData, depth, 1) && FrameCodec::decode(maskData, mask, 1);
+        decodeNs += timer.nsecsElapsed();
+
+        const QByteArray depthBinary = depthFrame->toBinary();
+        const QByteArray maskBinary = maskFrame->toBinary();
+
+        if (!ok || depth.toBinary() != depthBinary || mask.toBinary() != maskBinary)
+            errors++;
+
+        rawBytes += depthBinary.size() + maskBinary.size();
+        encodedBytes += depthData.size() + maskData.size();
+        zlibBytes += qCompress(depthBinary).size() + qCompress(maskBinary).size();
+    }
+
+    if (samples.isEmpty()) {
+        qWarning() << "No IASLAB-RGBD-ID frames were encoded in" << datasetPath;
+        return;
+    }
+
+    qint64 total = 0;
+
+    for (qint64 sample : samples)
+        total += sample;
+
+    QVariantMap extra;
+    extra["path"] = datasetPath;
+    extra["frames"] = samples.size();
+    extra["errors"] = errors;
+    extra["ratio"] = double(rawBytes) / encodedBytes;
+    extra["ratio_zlib"] = double(rawBytes) / zlibBytes;
+    extra["decode_ms_per_frame"] = decodeNs / 1000000.0 / samples.size();
+
+    runner.addResult(suite, "IASLAB_RGBD_ID", samples, samples.size() / (total / 1000000000.0), "frames/s", extra);
+}
+
+void runCodecBenchmarks(BenchmarkRunner& runner, const QString& iaslabPath)
+{
+    const QString suite = "Codec";
+    SyntheticScene scene = createSyntheticScene();
+
+    runSyntheticCodec(runner, suite, "FrameCodec_depth", *scene.depth);
+    runSyntheticCodec(runner, suite, "FrameCodec_mask", *scene.mask);
+    runIaslabCodec(runner, suite, iaslabPath);
+}
+
+} // End Namespace
@@ -0,0 +1,110 @@
+#include "Suites.h"
+#include "BenchmarkRunner.h"
+#include "SyntheticData.h"
+#include "PersonReid.h"
+#include "JointHistograms.h"
+#include "SkeletonFeatures.h"
+#include "opencv_utils.h"
+#include "ml/KMeans.h"
+#include "types/Histogram.h"
+
+namespace dai {
+
+// Histograms, Voronoi cells, re-identification features and clustering
+void runFeatureBenchmarks(BenchmarkRunner& runner)
+{
+    const QString suite = "Features";
+    SyntheticScene scene = createSyntheticScene();
+    const double pixels = scene.color->width() * scene.color->height();
+
+    cv::Mat color_mat(scene.color->height(), scene.color->width(), CV_8UC3,
+                      (void*) scene.color->getDataPtr(), scene.color->getStride());
+    cv::Mat mask_mat(scene.mask->height(), scene.mask->width(), CV_8UC1,
+                     (void*) scene.mask->getDataPtr(), scene.mask->getStride());
+    cv::Mat indexed_mat = convertRGB2Indexed884(color_mat);
+
+    // Histograms
+    shared_ptr<Histogram1c> hist1, hist2;
+
+    runner.measure(suite, "Histogram1c_create", [&]() {
+        hist1 = Histogram1c::create(indexed_mat, {0, 255}, mask_mat);
+    }, pixels, "pixels/s");
+
+    cv::Mat upper_mask, lower_mask;
+    computeUpperAndLowerMasks(color_mat, upper_mask, lower_mask, mask_mat);
+    hist1 = Histogram1c::create(indexed_mat, {0, 255}, upper_mask);
+    hist2 = Histogram1c::create(indexed_mat, {0, 255}, lower_mask);
+
+    runner.measure(suite, "Histogram1c_intersection", [&]() {
+        volatile double distance = Histogram1c::intersection(*hist1, *hist2);
+        Q_UNUSED(distance);
+    });
+
+    // Voronoi cells
+    runner.measure(suite, "getVoronoiCells", [&]() {
+        shared_ptr<MaskFrame> cells = PersonReid::getVoronoiCells(*scene.depth, *scene.mask, *scene.skeleton);
+    }, 1, "frames/s");
+
+    runner.measure(suite, "getVoronoiCellsParallel", [&]() {
+        shared_ptr<MaskFrame> cells = PersonReid::getVoronoiCellsParallel(*scene.depth, *scene.mask, *scene.skeleton);
+    }, 1, "frames/s");
+
+    // Features
+    PersonReid personReid;
+    InstanceInfo info;
+
+    runner.measure(suite, "feature_joints_hist", [&]() {
+        DescriptorPtr feature = personReid.feature_joints_hist(*scene.color, *scene.depth, *scene.mask, *scene.skeleton, info);
+    }, 1, "frames/s");
+
+    runner.measure(suite, "feature_2parts_hist", [&]() {
+        // It paints the masks over the given frame
+        shared_ptr<ColorFrame> color = static_pointer_cast<ColorFrame>(scene.color->clone());
+        DescriptorPtr feature = personReid.feature_2parts_hist(color, info);
+    }, 1, "frames/s");
+
+    // Anthropometric distances, one skeleton at a time and in batch
+    runner.measure(suite, "feature_skeleton_distances", [&]() {
+        DescriptorPtr feature = personReid.feature_skeleton_distances(*scene.color, *scene.skeleton, info);
+    }, 1, "skeletons/s");
+
+    SkeletonBatch batch;
+    batch.reserve(10000);
+
+    for (int i=0; i<10000; ++i) {
+        batch.append(*scene.skeleton, i % 10);
+    }
+
+    cv::Mat features;
+
+    runner.measure(suite, "SkeletonFeatures_computeBatch", [&]() {
+        SkeletonFeatures::computeBatch(batch, features);
+    }, batch.size(), "skeletons/s");
+
+    cv::Mat gallery = features.t();
+    cv::Mat queries = gallery.rowRange(0, 100);
+
+    runner.measure(suite, "SkeletonFeatures_distances", [&]() {
+        cv::Mat distances = SkeletonFeatures::distances(queries, gallery);
+    }, queries.rows * gallery.rows, "pairs/s");
+
+    // Clustering of upper and lower histograms of several scenes
+    QList<shared_ptr<Histogram1c>> samples;
+
+    for (unsigned int seed=1; seed<=20; ++seed)
+    {
+        SyntheticScene sample = createSyntheticScene(320, 240, seed);
+        cv::Mat sample_mat(sample.color->height(), sample.color->width(), CV_8UC3,
+                           (void*) sample.color->getDataPtr(), sample.color->getStride());
+        int upper_bins[256], lower_bins[256];
+        computeUpperAndLowerHist884(sample_mat, upper_mask, lower_mask, upper_bins, lower_bins);
+        samples << Histogram1c::createFromBins(upper_bins, 256, {0, 255})
+                << Histogram1c::createFromBins(lower_bins, 256, {0, 255});
+    }
+
+    runner.measure(suite, "KMeans_Histogram1c_k2", [&]() {
+        auto kmeans = KMeans<Histogram1c>::execute(samples, 2);
+    }, samples.size(), "samples/s");
+}
+
+} // End Namespace
@@ -0,0 +1,165 @@
+#include "Suites.h"
+#include "BenchmarkRunner.h"
+#include "SyntheticData.h"
+#include "dataset/IASLAB_RGBD_ID/IASLAB_RGBD_ID_Instance.h"
+#include "dataset/InstanceInfo.h"
+#include "playback/StreamRecording.h"
+#include "playback/RingRecorder.h"
+#include "playback/SharedFrameRing.h"
+#include "types/SkeletonFrame.h"
+#include <QMap>
+#include <QDir>
+
+namespace dai {
+
+// GenericFrame copies, sub frames and serialisation
+void runFrameBenchmarks(BenchmarkRunner& runner)
+{
+    const QString suite = "Frames";
+    SyntheticScene scene = createSyntheticScene();
+    const double pixels = scene.color->width() * scene.color->height();
+
+    // Copies (copy constructor allocates, operator= reuses the buffer)
+    runner.measure(suite, "ColorFrame_clone", [&]() {
+        shared_ptr<DataFrame> copy = scene.color->clone();
+    }, 1, "frames/s");
+
+    ColorFrame colorCopy;
+    runner.measure(suite, "ColorFrame_assign", [&]() {
+        colorCopy = *scene.color;
+    }, 1, "frames/s");
+
+    runner.measure(suite, "DepthFrame_clone", [&]() {
+        shared_ptr<DataFrame> copy = scene.depth->clone();
+    }, 1, "frames/s");
+
+    DepthFrame depthCopy;
+    runner.measure(suite, "DepthFrame_assign", [&]() {
+        depthCopy = *scene.depth;
+    }, 1, "frames/s");
+
+    MaskFrame maskCopy;
+    runner.measure(suite, "MaskFrame_assign", [&]() {
+        maskCopy = *scene.mask;
+    }, 1, "frames/s");
+
+    // Moves only transfer the buffer
+    DepthFrame depthA(*scene.depth), depthB;
+    runner.measure(suite, "DepthFrame_move", [&]() {
+        depthB = std::move(depthA);
+        depthA = std::move(depthB);
+    }, 2, "frames/s");
+
+    // Padded frames are copied row by row
+    shared_ptr<ColorFrame> colorRoi = scene.color->subFrame(60, 200, 240, 380);
+    runner.measure(suite, "ColorFrame_clone_padded", [&]() {
+        shared_ptr<DataFrame> copy = colorRoi->clone();
+    }, 1, "frames/s");
+
+    shared_ptr<DepthFrame> depthRoi = scene.depth->subFrame(60, 200, 240, 380);
+    runner.measure(suite, "DepthFrame_toBinary_padded", [&]() {
+        QByteArray buffer = depthRoi->toBinary();
+    }, 1, "frames/s");
+
+    // Sub frames (region of the user)
+    runner.measure(suite, "ColorFrame_subFrame", [&]() {
+        shared_ptr<ColorFrame> roi = scene.color->subFrame(60, 200, 240, 380);
+    }, 1, "frames/s");
+
+    runner.measure(suite, "DepthFrame_subFrame", [&]() {
+        shared_ptr<DepthFrame> roi = scene.depth->subFrame(60, 200, 240, 380);
+    }, 1, "frames/s");
+
+    // Serialisation
+    runner.measure(suite, "ColorFrame_toBinary", [&]() {
+        QByteArray buffer = scene.color->toBinary();
+    }, 1, "frames/s");
+
+    QByteArray colorBuffer = scene.color->toBinary();
+    runner.measure(suite, "ColorFrame_loadData", [&]() {
+        colorCopy.loadData(colorBuffer);
+    }, 1, "frames/s");
+
+    runner.measure(suite, "DepthFrame_toBinary", [&]() {
+        QByteArray buffer = scene.depth->toBinary();
+    }, 1, "frames/s");
+
+    QByteArray depthBuffer = scene.depth->toBinary();
+    runner.measure(suite, "DepthFrame_loadData", [&]() {
+        depthCopy.loadData(depthBuffer);
+    }, 1, "frames/s");
+
+    // Bundles of frames of a recording (StreamRecorder)
+    QHashDataFrames bundle;
+    SkeletonFramePtr skeletonFrame = make_shared<SkeletonFrame>(scene.depth->width(), scene.depth->height());
+    skeletonFrame->setSkeleton(1, scene.skeleton);
+    bundle.insert(DataFrame::Color, scene.color);
+    bundle.insert(DataFrame::Depth, scene.depth);
+    bundle.insert(DataFrame::Mask, scene.mask);
+    bundle.insert(DataFrame::Skeleton, skeletonFrame);
+
+    for (StreamRecording::Compression compression : {StreamRecording::COMPRESSION_NONE, StreamRecording::COMPRESSION_ZLIB,
+                                                     StreamRecording::COMPRESSION_CODEC})
+    {
+        const QString suffix = compression == StreamRecording::COMPRESSION_ZLIB ? "_zlib" :
+                               compression == StreamRecording::COMPRESSION_CODEC ? "_codec" : "";
+        QByteArray record;
+        QHashDataFrames decoded;
+
+        runner.measure(suite, "StreamRecording_encodeFrames" + suffix, [&]() {
+            record = StreamRecording::encodeFrames(bundle, 0, compression);
+        }, 1, "frames/s");
+
+        runner.measure(suite, "StreamRecording_decodeFrames" + suffix, [&]() {
+            StreamRecording::decodeFrames(record, decoded);
+        }, 1, "frames/s");
+    }
+
+    // Cost for the producer of an always-on ring (bundles are dropped while it's encoding)
+    RingRecorder ring("benchmark", QDir::tempPath());
+    runner.measure(suite, "RingRecorder_record", [&]() {
+        ring.record(bundle);
+    }, 1, "frames/s");
+
+    // Bundle published to another process and read back, as views of the ring or copied
+    shared_ptr<SharedFrameRing> writer = make_shared<SharedFrameRing>("benchmark");
+    shared_ptr<SharedFrameRing> reader = make_shared<SharedFrameRing>("benchmark");
+
+    if (writer->create(StreamRecording::headerOf(bundle), 8, SharedFrameRing::slotBytesFor(bundle) + 64 * 1024)
+            && reader->attach(false))
+    {
+        runner.measure(suite, "SharedFrameRing_write", [&]() {
+            writer->write(bundle, 0, SharedFrameRing::POLICY_DROP, 0);
+        }, 1, "frames/s");
+
+        for (bool zeroCopy : {true, false})
+        {
+            QHashDataFrames received;
+            runner.measure(suite, zeroCopy ? "SharedFrameRing_transfer" : "SharedFrameRing_transfer_copy", [&]() {
+                writer->write(bundle, 0, SharedFrameRing::POLICY_DROP, 0);
+                reader->read(received, nullptr, zeroCopy, 0);
+            }, 1, "frames/s");
+        }
+    }
+
+    // Depth
+    QMap<uint16_t, float> histogram;
+    runner.measure(suite, "DepthFrame_calculateHistogram", [&]() {
+        DepthFrame::calculateHistogram(histogram, *scene.depth);
+    }, pixels, "pixels/s");
+
+    // Registration of depth and mask to the color camera (IASLAB-RGBD-ID)
+    IASLAB_RGBD_ID_Instance instance((InstanceInfo()));
+    shared_ptr<DepthFrame> depth = make_shared<DepthFrame>();
+    shared_ptr<MaskFrame> mask = make_shared<MaskFrame>();
+    shared_ptr<Skeleton> skeleton = make_shared<Skeleton>();
+
+    runner.measure(suite, "depth2color", [&]() {
+        *depth = *scene.depth;
+        *mask = *scene.mask;
+        *skeleton = *scene.skeleton;
+        instance.depth2color(depth, mask, skeleton);
+    }, pixels, "pixels/s");
+}
+
+} // End Namespace
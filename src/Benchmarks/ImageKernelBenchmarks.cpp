@@ -0,0 +1,451 @@
+#include "Suites.h"
+#include "BenchmarkRunner.h"
+#include "SyntheticData.h"
+#include "opencv_utils.h"
+#include "opencv_utils_simd.h"
+#include "types/MaskFrame.h"
+#include <QVector>
+#include <QStringList>
+#include <QDebug>
+#include <functional>
+#include <cstring>
+#include <cmath>
+
+namespace dai {
+
+/*
+ * Reference implementations: the per-pixel loops opencv_utils used before the kernels
+ * were vectorised. Outputs of every SIMD level must be equal to these.
+ */
+static cv::Mat referenceIndexed884(const cv::Mat& inputImg)
+{
+    using namespace cv;
+
+    Mat outputImg = cv::Mat::zeros(inputImg.rows, inputImg.cols, CV_8UC1);
+
+    for (int i=0; i<inputImg.rows; ++i)
+    {
+        const Vec3b* in_pixel = inputImg.ptr<Vec3b>(i);
+        uchar* out_pixel = outputImg.ptr<uchar>(i);
+
+        for (int j=0; j<inputImg.cols; ++j)
+        {
+            uchar level_red = in_pixel[j][0] / 32; // 256 / 8
+            uchar level_green = in_pixel[j][1] / 32; // 256 / 8
+            uchar level_blue = in_pixel[j][2] / 64; // 256 / 4
+            out_pixel[j] = 32 * level_red + 4 * level_green + level_blue;
+        }
+    }
+
+    return outputImg;
+}
+
+static cv::Mat referenceIndexed161616(const cv::Mat& inputImg)
+{
+    using namespace cv;
+
+    Mat outputImg = cv::Mat::zeros(inputImg.rows, inputImg.cols, CV_16UC1);
+
+    for (int i=0; i<inputImg.rows; ++i)
+    {
+        const Vec3b* in_pixel = inputImg.ptr<Vec3b>(i);
+        ushort* out_pixel = outputImg.ptr<ushort>(i);
+
+        for (int j=0; j<inputImg.cols; ++j)
+        {
+            uchar level_red = in_pixel[j][0] / 16; // 256 / 16
+            uchar level_green = in_pixel[j][1] / 16; // 256 / 16
+            uchar level_blue = in_pixel[j][2] / 16; // 256 / 16
+            out_pixel[j] = 256 * level_red + 16 * level_green + level_blue;
+        }
+    }
+
+    return outputImg;
+}
+
+static cv::Mat referenceLog2D(const cv::Mat &inputImg)
+{
+    cv::Mat outputImg = cv::Mat::zeros(inputImg.rows, inputImg.cols, CV_32FC2);
+
+    for (int i=0; i<inputImg.rows; ++i)
+    {
+        const cv::Vec3b* inPixel = inputImg.ptr<cv::Vec3b>(i);
+        cv::Vec2f* outPixel = outputImg.ptr<cv::Vec2f>(i);
+
+        for (int j=0; j<inputImg.cols; ++j) {
+            outPixel[j][0] = std::log( float(inPixel[j][0]+1) / float(inPixel[j][1]+1) ); // log ( R/G )
+            outPixel[j][1] = std::log( float(inPixel[j][2]+1) / float(inPixel[j][1]+1) ); // log ( B/G )
+        }
+    }
+
+    return outputImg;
+}
+
+static cv::Mat referenceIntegralImage(const cv::Mat& image)
+{
+    using namespace cv;
+    Mat lookup = Mat::zeros(image.rows, image.cols, CV_32SC1);
+
+    // Compute first row
+    const Vec3b* pixel = image.ptr<Vec3b>(0);
+    uint32_t* value = lookup.ptr<uint32_t>(0);
+    value[0] = pixel[0][0];
+
+    for (int i=1; i<image.cols; ++i) {
+        value[i] = pixel[i][0] + value[i-1];
+    }
+
+    // Compute first column
+    for (int i=1; i<image.rows; ++i) {
+        lookup.at<uint32_t>(i, 0) = image.at<Vec3b>(i, 0)[0] + lookup.at<uint32_t>(i-1, 0);
+    }
+
+    uint32_t* prevMatrixRow = value;
+
+    // Compute Matrix
+    for (int i=1; i<image.rows; ++i)
+    {
+        const Vec3b* pPixelRow = image.ptr<Vec3b>(i);
+        uint32_t* pMatrixRow = lookup.ptr<uint32_t>(i);
+
+        for (int j=1; j<image.cols; ++j) {
+            pMatrixRow[j] = pPixelRow[j][0] + pMatrixRow[j-1] + prevMatrixRow[j] - prevMatrixRow[j-1];
+        }
+
+        prevMatrixRow = pMatrixRow;
+    }
+
+    return lookup;
+}
+
+static void referenceUpperAndLowerMasks(const cv::Mat& input_img, cv::Mat& upper_mask, cv::Mat& lower_mask, const cv::Mat mask)
+{
+    using namespace cv;
+
+    bool useMask = mask.rows > 0 && mask.cols > 0;
+    upper_mask = Mat::zeros(input_img.rows, input_img.cols, CV_8UC1);
+    lower_mask = Mat::zeros(input_img.rows, input_img.cols, CV_8UC1);
+
+    // For CAVIAR4REID
+    float margins[][2] = {
+        0.12f, 0.15f,
+        0.52f, 0.85f,
+        0.55f, 0.15f,
+        0.95f, 0.85f
+    };
+
+    for (int i=0; i<input_img.rows; ++i)
+    {
+        uchar* uMask = upper_mask.ptr<uchar>(i);
+        uchar* lMask = lower_mask.ptr<uchar>(i);
+        const uchar* maskPixel = useMask ? mask.ptr<uchar>(i) : nullptr;
+
+        for (int j=0; j<input_img.cols; ++j)
+        {
+            if (useMask && maskPixel[j] <= 0)
+                continue;
+
+            if (i >= input_img.rows * margins[0][0] && i < input_img.rows * margins[1][0]) {
+                if (j > input_img.cols * margins[0][1] && j < input_img.cols * margins[1][1]) {
+                    uMask[j] = 1;
+                }
+            } else if (i >= input_img.rows * margins[2][0] && i < input_img.rows * margins[3][0]) {
+                if (j > input_img.cols * margins[2][1] && j < input_img.cols * margins[3][1]) {
+                    lMask[j] = 1;
+                }
+            }
+        }
+    }
+}
+
+// Histogram of the indexed image under a binary mask (what Histogram1c::create counted)
+static void referenceHist884(const cv::Mat& indexed, const cv::Mat& mask, int hist[256])
+{
+    memset(hist, 0, 256 * sizeof(int));
+
+    for (int i=0; i<indexed.rows; ++i) {
+        const uchar* index = indexed.ptr<uchar>(i);
+        const uchar* select = mask.ptr<uchar>(i);
+        for (int j=0; j<indexed.cols; ++j)
+            hist[index[j]] += select[j];
+    }
+}
+
+static bool equalMats(const cv::Mat& a, const cv::Mat& b, double tolerance = 0.0)
+{
+    if (a.size() != b.size() || a.type() != b.type())
+        return false;
+
+    return cv::norm(a, b, cv::NORM_INF) <= tolerance;
+}
+
+/**
+ * Checks of the opencv_utils kernels and the row kernels with every SIMD level. The first
+ * ones are compared with the reference loops and the row kernels with SIMD_NONE. Inputs
+ * are the scene and a crop of it, so row padding and the scalar tails are covered too.
+ */
+static void runImageKernelChecks(BenchmarkRunner& runner, const QString& suite, const cv::Mat& color_mat,
+                                 const cv::Mat& mask_mat, const QVector<int16_t>& labels, const cv::Mat& depth_mat)
+{
+    if (!runner.isEnabled(suite, "checks"))
+        return;
+
+    const SimdLevel supportedLevel = simdSupportedLevel();
+    const cv::Rect crop(1, 1, color_mat.cols - 3, color_mat.rows - 2);
+    const QList<QPair<QString, cv::Mat>> colorInputs = {
+        qMakePair(QString("full"), color_mat),
+        qMakePair(QString("crop"), color_mat(crop))
+    };
+    const QList<QPair<QString, cv::Mat>> maskInputs = {
+        qMakePair(QString("full"), mask_mat),
+        qMakePair(QString("crop"), mask_mat(crop)),
+        qMakePair(QString("nomask"), cv::Mat())
+    };
+
+    // Row kernels run over the whole buffer, with an odd length
+    const cv::Mat rgb = color_mat.clone();
+    const int pixels = rgb.cols * rgb.rows - 1;
+    QVector<uint8_t> bgra(pixels * 4);
+    simd::rgb2BgraRow(rgb.ptr<uint8_t>(0), bgra.data(), pixels);
+
+    QVector<uint16_t> depth(depth_mat.cols * depth_mat.rows);
+    for (int i=0; i<depth_mat.rows; ++i)
+        memcpy(depth.data() + i * depth_mat.cols, depth_mat.ptr<uint16_t>(i), depth_mat.cols * sizeof(uint16_t));
+
+    QList<QPair<QString, std::function<bool ()>>> checks;
+
+    for (int l = SIMD_NONE; l <= supportedLevel; ++l)
+    {
+        const SimdLevel level = SimdLevel(l);
+        const QString suffix = QString("_") + simdLevelName(level);
+
+        for (const auto& input : colorInputs)
+        {
+            const cv::Mat image = input.second;
+            const QString name = suffix + "_" + input.first;
+
+            checks << qMakePair(QString("convertRGB2Indexed884") + name, std::function<bool ()>([=]() {
+                setSimdLevel(level);
+                return equalMats(convertRGB2Indexed884(image), referenceIndexed884(image));
+            }));
+
+            checks << qMakePair(QString("convertRGB2Indexed161616") + name, std::function<bool ()>([=]() {
+                setSimdLevel(level);
+                return equalMats(convertRGB2Indexed161616(image), referenceIndexed161616(image));
+            }));
+
+            // The scalar level uses a table of logarithms, so it may differ in the last bits
+            checks << qMakePair(QString("convertRGB2Log2DAsMat") + name, std::function<bool ()>([=]() {
+                setSimdLevel(level);
+                return equalMats(convertRGB2Log2DAsMat(image), referenceLog2D(image), 1e-5);
+            }));
+
+            checks << qMakePair(QString("computeIntegralImage") + name, std::function<bool ()>([=]() {
+                setSimdLevel(level);
+                return equalMats(computeIntegralImage(image), referenceIntegralImage(image));
+            }));
+        }
+
+        for (const auto& input : maskInputs)
+        {
+            const cv::Mat image = input.first == "crop" ? color_mat(crop) : color_mat;
+            const cv::Mat mask = input.second;
+            const QString name = suffix + "_" + input.first;
+
+            checks << qMakePair(QString("computeUpperAndLowerMasks") + name, std::function<bool ()>([=]() {
+                cv::Mat upper, lower, ref_upper, ref_lower;
+                setSimdLevel(level);
+                computeUpperAndLowerMasks(image, upper, lower, mask);
+                referenceUpperAndLowerMasks(image, ref_upper, ref_lower, mask);
+                return equalMats(upper, ref_upper) && equalMats(lower, ref_lower);
+            }));
+
+            checks << qMakePair(QString("computeUpperAndLowerHist884") + name, std::function<bool ()>([=]() {
+                cv::Mat upper, lower, ref_upper, ref_lower;
+                int upper_bins[256], lower_bins[256], ref_upper_bins[256], ref_lower_bins[256];
+                setSimdLevel(level);
+                computeUpperAndLowerHist884(image, upper, lower, upper_bins, lower_bins, mask);
+                referenceUpperAndLowerMasks(image, ref_upper, ref_lower, mask);
+                const cv::Mat indexed = referenceIndexed884(image);
+                referenceHist884(indexed, ref_upper, ref_upper_bins);
+                referenceHist884(indexed, ref_lower, ref_lower_bins);
+                return equalMats(upper, ref_upper) && equalMats(lower, ref_lower) &&
+                        memcmp(upper_bins, ref_upper_bins, sizeof(upper_bins)) == 0 &&
+                        memcmp(lower_bins, ref_lower_bins, sizeof(lower_bins)) == 0;
+            }));
+        }
+
+        if (level == SIMD_NONE)
+            continue;
+
+        // Row kernels against the scalar ones
+        auto sameAsScalar = [level](std::function<QByteArray ()> kernel) {
+            setSimdLevel(SIMD_NONE);
+            const QByteArray expected = kernel();
+            setSimdLevel(level);
+            return kernel() == expected;
+        };
+
+        checks << qMakePair(QString("narrowLabels") + suffix, std::function<bool ()>([=, &labels]() {
+            return sameAsScalar([&]() {
+                QByteArray out(labels.size() - 1, 0);
+                simd::narrowLabelsRow(labels.constData(), (uint8_t*) out.data(), out.size());
+                return out;
+            });
+        }));
+
+        checks << qMakePair(QString("rgb2Bgra") + suffix, std::function<bool ()>([=]() {
+            return sameAsScalar([&]() {
+                QByteArray out(pixels * 4, 0);
+                simd::rgb2BgraRow(rgb.ptr<uint8_t>(0), (uint8_t*) out.data(), pixels);
+                return out;
+            });
+        }));
+
+        checks << qMakePair(QString("bgra2Rgb") + suffix, std::function<bool ()>([=, &bgra]() {
+            return sameAsScalar([&]() {
+                QByteArray out(pixels * 3, 0);
+                simd::bgra2RgbRow(bgra.constData(), (uint8_t*) out.data(), pixels);
+                return out;
+            });
+        }));
+
+        // The second scale saturates the far pixels
+        checks << qMakePair(QString("scaleU16ToU8") + suffix, std::function<bool ()>([=, &depth]() {
+            return sameAsScalar([&]() {
+                QByteArray out((depth.size() - 1) * 2, 0);
+                simd::scaleU16ToU8Row(depth.constData(), (uint8_t*) out.data(), depth.size() - 1, 255.0f / 4500.0f);
+                simd::scaleU16ToU8Row(depth.constData(), (uint8_t*) out.data() + depth.size() - 1, depth.size() - 1, 255.0f / 1000.0f);
+                return out;
+            });
+        }));
+    }
+
+    QStringList failed;
+
+    for (const auto& check : checks) {
+        if (!check.second()) {
+            qWarning() << "Image kernel check failed:" << check.first;
+            failed << check.first;
+        }
+    }
+
+    setSimdLevel(supportedLevel);
+
+    QVariantMap extra;
+    extra["checks"] = checks.size();
+    extra["failed"] = failed.join(", ");
+
+    runner.addResult(suite, "checks", QVector<qint64>() << 0, 0, QString(), extra);
+}
+
+// opencv_utils kernels with every SIMD level supported by the CPU
+void runImageKernelBenchmarks(BenchmarkRunner& runner)
+{
+    const QString suite = "ImageKernels";
+    const SimdLevel supportedLevel = simdSupportedLevel();
+    SyntheticScene scene = createSyntheticScene();
+    const double pixels = scene.color->width() * scene.color->height();
+
+    cv::Mat color_mat(scene.color->height(), scene.color->width(), CV_8UC3,
+                      (void*) scene.color->getDataPtr(), scene.color->getStride());
+    cv::Mat mask_mat(scene.mask->height(), scene.mask->width(), CV_8UC1,
+                     (void*) scene.mask->getDataPtr(), scene.mask->getStride());
+
+    // NiTE user map (16 bits labels)
+    QVector<int16_t> labels(scene.mask->width() * scene.mask->height());
+
+    for (int i=0; i<scene.mask->height(); ++i) {
+        for (int j=0; j<scene.mask->width(); ++j)
+            labels[i * scene.mask->width() + j] = scene.mask->getRowPtr(i)[j];
+    }
+
+    // QImage::Format_RGB32 image and depth preview buffers
+    QVector<uint8_t> bgra(scene.color->width() * scene.color->height() * 4);
+    QVector<uint8_t> depthPreview(scene.depth->width() * scene.depth->height());
+
+    cv::Mat depth_mat(scene.depth->height(), scene.depth->width(), CV_16UC1,
+                      (void*) scene.depth->getDataPtr(), scene.depth->getStride());
+
+    runImageKernelChecks(runner, suite, color_mat, mask_mat, labels, depth_mat);
+
+    // Original per-pixel loops
+    runner.measure(suite, "convertRGB2Indexed884_reference", [&]() {
+        referenceIndexed884(color_mat);
+    }, pixels, "pixels/s");
+
+    runner.measure(suite, "convertRGB2Indexed161616_reference", [&]() {
+        referenceIndexed161616(color_mat);
+    }, pixels, "pixels/s");
+
+    runner.measure(suite, "convertRGB2Log2DAsMat_reference", [&]() {
+        referenceLog2D(color_mat);
+    }, pixels, "pixels/s");
+
+    runner.measure(suite, "computeIntegralImage_reference", [&]() {
+        referenceIntegralImage(color_mat);
+    }, pixels, "pixels/s");
+
+    runner.measure(suite, "computeUpperAndLowerMasks_reference", [&]() {
+        cv::Mat upper_mask, lower_mask;
+        referenceUpperAndLowerMasks(color_mat, upper_mask, lower_mask, mask_mat);
+    }, pixels, "pixels/s");
+
+    for (int level = SIMD_NONE; level <= supportedLevel; ++level)
+    {
+        setSimdLevel(SimdLevel(level));
+        const QString suffix = QString("_") + simdLevelName(SimdLevel(level));
+        cv::Mat output, upper_mask, lower_mask;
+
+        runner.measure(suite, "convertRGB2Indexed884" + suffix, [&]() {
+            output = convertRGB2Indexed884(color_mat);
+        }, pixels, "pixels/s");
+
+        runner.measure(suite, "convertRGB2Indexed161616" + suffix, [&]() {
+            output = convertRGB2Indexed161616(color_mat);
+        }, pixels, "pixels/s");
+
+        runner.measure(suite, "convertRGB2Log2DAsMat" + suffix, [&]() {
+            output = convertRGB2Log2DAsMat(color_mat);
+        }, pixels, "pixels/s");
+
+        runner.measure(suite, "computeIntegralImage" + suffix, [&]() {
+            output = computeIntegralImage(color_mat);
+        }, pixels, "pixels/s");
+
+        runner.measure(suite, "computeUpperAndLowerMasks" + suffix, [&]() {
+            computeUpperAndLowerMasks(color_mat, upper_mask, lower_mask, mask_mat);
+        }, pixels, "pixels/s");
+
+        runner.measure(suite, "computeUpperAndLowerHist884" + suffix, [&]() {
+            int upper_bins[256], lower_bins[256];
+            computeUpperAndLowerHist884(color_mat, upper_mask, lower_mask, upper_bins, lower_bins, mask_mat);
+        }, pixels, "pixels/s");
+
+        MaskFrame narrowed(scene.mask->width(), scene.mask->height());
+        runner.measure(suite, "narrowLabels" + suffix, [&]() {
+            for (int i=0; i<narrowed.height(); ++i)
+                simd::narrowLabelsRow(labels.constData() + i * narrowed.width(), narrowed.getRowPtr(i), narrowed.width());
+        }, pixels, "pixels/s");
+
+        runner.measure(suite, "rgb2Bgra" + suffix, [&]() {
+            for (int i=0; i<scene.color->height(); ++i)
+                simd::rgb2BgraRow((const uint8_t*) scene.color->getRowPtr(i), bgra.data() + i * scene.color->width() * 4, scene.color->width());
+        }, pixels, "pixels/s");
+
+        ColorFrame converted(scene.color->width(), scene.color->height());
+        runner.measure(suite, "bgra2Rgb" + suffix, [&]() {
+            for (int i=0; i<converted.height(); ++i)
+                simd::bgra2RgbRow(bgra.constData() + i * converted.width() * 4, (uint8_t*) converted.getRowPtr(i), converted.width());
+        }, pixels, "pixels/s");
+
+        runner.measure(suite, "scaleU16ToU8" + suffix, [&]() {
+            for (int i=0; i<scene.depth->height(); ++i)
+                simd::scaleU16ToU8Row(scene.depth->getRowPtr(i), depthPreview.data() + i * scene.depth->width(), scene.depth->width(), 255.0f / 4500.0f);
+        }, pixels, "pixels/s");
+    }
+
+    setSimdLevel(supportedLevel);
+}
+
+} // End Namespace
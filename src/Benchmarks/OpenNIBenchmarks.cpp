@@ -0,0 +1,130 @@
+#include "Suites.h"
+#include "BenchmarkRunner.h"
+#include "openni/OpenNIDevice.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <QDebug>
+
+namespace dai {
+
+// Sum of the visible pixels (padding is ignored)
+template <class T, DataFrame::FrameType frameType>
+static quint64 checksum(const GenericFrame<T, frameType>& frame)
+{
+    quint64 sum = 0;
+
+    for (int i=0; i<frame.height(); ++i) {
+        const uchar* row = (const uchar*) frame.getRowPtr(i);
+        for (size_t j=0; j<frame.width() * sizeof(T); ++j)
+            sum = sum * 31 + row[j];
+    }
+
+    return sum;
+}
+
+/**
+ * Ingestion of an ONI recording played as fast as possible. Color and depth are wrapped
+ * without copies, so the frames of the previous iteration are kept and checked after the
+ * next read: their data must still be valid while they are referenced.
+ */
+void runOpenNIBenchmarks(BenchmarkRunner& runner, const QString& oniFile)
+{
+    if (oniFile.isEmpty() || !runner.isEnabled("OpenNI", "ingest"))
+        return;
+
+    OpenNIDevice* device = OpenNIDevice::create(oniFile);
+
+    try {
+        device->open();
+    }
+    catch (int ex) {
+        qWarning() << "Cannot open" << oniFile << "error" << ex;
+        return;
+    }
+
+    if (!device->isFile()) {
+        qWarning() << oniFile << "is not a recording";
+        device->close();
+        return;
+    }
+
+    device->playbackControl()->setRepeatEnabled(false);
+    device->playbackControl()->setSpeed(-1);
+
+    // Two sets of frames, one is kept while the other is read
+    QHashDataFrames frames[2];
+
+    for (QHashDataFrames& set : frames) {
+        set.insert(DataFrame::Color, make_shared<ColorFrame>());
+        set.insert(DataFrame::Depth, make_shared<DepthFrame>());
+        set.insert(DataFrame::Mask, make_shared<MaskFrame>(640, 480));
+        set.insert(DataFrame::Skeleton, make_shared<SkeletonFrame>());
+        set.insert(DataFrame::Metadata, make_shared<MetadataFrame>());
+    }
+
+    QVector<qint64> samples;
+    quint64 previousColor = 0, previousDepth = 0;
+    int corrupted = 0, paddedFrames = 0, users = 0;
+    QElapsedTimer timer, total;
+    total.start();
+
+    while (device->hasNext())
+    {
+        QHashDataFrames& current = frames[samples.size() % 2];
+        const QHashDataFrames& previous = frames[(samples.size() + 1) % 2];
+        shared_ptr<ColorFrame> color = static_pointer_cast<ColorFrame>(current.value(DataFrame::Color));
+        shared_ptr<DepthFrame> depth = static_pointer_cast<DepthFrame>(current.value(DataFrame::Depth));
+        shared_ptr<MaskFrame> mask = static_pointer_cast<MaskFrame>(current.value(DataFrame::Mask));
+        shared_ptr<SkeletonFrame> skeleton = static_pointer_cast<SkeletonFrame>(current.value(DataFrame::Skeleton));
+        shared_ptr<MetadataFrame> metadata = static_pointer_cast<MetadataFrame>(current.value(DataFrame::Metadata));
+
+        timer.start();
+
+        try {
+            device->readColorFrame(color);
+#ifndef __APPLE__
+            device->readUserTrackerFrame(depth, mask, skeleton, metadata);
+#else
+            device->readDepthFrame(depth);
+#endif
+        }
+        catch (int ex) {
+            qWarning() << "Read error" << ex << "at frame" << samples.size();
+            break;
+        }
+
+        samples << timer.nsecsElapsed();
+
+        // Frames read before must not have been overwritten by the driver
+        if (samples.size() > 1) {
+            if (checksum(*static_pointer_cast<ColorFrame>(previous.value(DataFrame::Color))) != previousColor ||
+                    checksum(*static_pointer_cast<DepthFrame>(previous.value(DataFrame::Depth))) != previousDepth)
+                corrupted++;
+        }
+
+        previousColor = checksum(*color);
+        previousDepth = checksum(*depth);
+
+        if (color->getStride() != color->width() * sizeof(RGBColor) || depth->getStride() != depth->width() * sizeof(uint16_t))
+            paddedFrames++;
+
+        users += skeleton->usersCount();
+    }
+
+    const double seconds = total.nsecsElapsed() / 1000000000.0;
+    device->close();
+
+    if (samples.isEmpty())
+        return;
+
+    QVariantMap extra;
+    extra["file"] = oniFile;
+    extra["frames"] = samples.size();
+    extra["padded_frames"] = paddedFrames;
+    extra["retained_frames_corrupted"] = corrupted;
+    extra["mean_users"] = double(users) / samples.size();
+
+    runner.addResult("OpenNI", "ingest", samples, samples.size() / seconds, "frames/s", extra);
+}
+
+} // End Namespace
@@ -0,0 +1,396 @@
+#include "Suites.h"
+#include "BenchmarkRunner.h"
+#include "SyntheticData.h"
+#include "playback/PlaybackControl.h"
+#include "playback/Pacing.h"
+#include "playback/FrameGenerator.h"
+#include "playback/FrameListener.h"
+#include "playback/Tracer.h"
+#include "types/StreamInstance.h"
+#include "types/SkeletonFrame.h"
+#include "types/MemoryTracker.h"
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QMutex>
+#include <QDebug>
+#include <QVector>
+#include <algorithm>
+
+namespace dai {
+
+/**
+ * Stream that replays the same synthetic frames, like a dataset instance that is read
+ * from a warm disk cache.
+ */
+class SyntheticInstance : public StreamInstance
+{
+public:
+    SyntheticInstance(const SyntheticScene& scene, int numFrames)
+        : StreamInstance(DataFrame::Color | DataFrame::Depth | DataFrame::Mask | DataFrame::Skeleton,
+                         scene.color->width(), scene.color->height())
+        , m_scene(scene)
+        , m_numFrames(numFrames)
+        , m_counter(0)
+        , m_open(false)
+    {
+    }
+
+    bool is_open() const override {return m_open;}
+    bool hasNext() const override {return m_open && m_counter < m_numFrames;}
+
+protected:
+    bool openInstance() override {
+        m_open = true;
+        m_counter = 0;
+        return true;
+    }
+
+    void closeInstance() override {m_open = false;}
+    void restartInstance() override {m_counter = 0;}
+
+    void nextFrame(QHashDataFrames& output) override
+    {
+        shared_ptr<ColorFrame> color = static_pointer_cast<ColorFrame>(output.value(DataFrame::Color));
+        shared_ptr<DepthFrame> depth = static_pointer_cast<DepthFrame>(output.value(DataFrame::Depth));
+        shared_ptr<MaskFrame> mask = static_pointer_cast<MaskFrame>(output.value(DataFrame::Mask));
+        shared_ptr<SkeletonFrame> skeleton = static_pointer_cast<SkeletonFrame>(output.value(DataFrame::Skeleton));
+
+        *color = *m_scene.color;
+        *depth = *m_scene.depth;
+        *mask = *m_scene.mask;
+        skeleton->clear();
+        skeleton->setSkeleton(1, m_scene.skeleton);
+
+        color->setIndex(m_counter);
+        m_counter++;
+    }
+
+private:
+    SyntheticScene m_scene;
+    int m_numFrames;
+    int m_counter;
+    bool m_open;
+};
+
+/**
+ * Records when each frame is received and stops once the last frame has arrived
+ */
+class ThroughputListener : public FrameListener
+{
+public:
+    ThroughputListener(const QElapsedTimer& clock, int lastFrame)
+        : m_clock(clock)
+        , m_lastFrame(lastFrame)
+    {
+    }
+
+    void waitUntilDone(int timeout) {m_done.tryAcquire(1, timeout);}
+    const QVector<qint64>& arrivals() const {return m_arrivals;}
+
+protected:
+    void newFrames(const QHashDataFrames dataFrames) override
+    {
+        m_arrivals << m_clock.nsecsElapsed();
+
+        if (int(dataFrames.value(DataFrame::Color)->getIndex()) >= m_lastFrame)
+            stopListener();
+    }
+
+    void afterStop() override {
+        m_done.release();
+    }
+
+private:
+    const QElapsedTimer& m_clock;
+    const int m_lastFrame;
+    QVector<qint64> m_arrivals;
+    QSemaphore m_done;
+};
+
+/**
+ * Generator that stamps the time just before its listeners are notified
+ */
+class StampGenerator : public FrameGenerator
+{
+public:
+    StampGenerator(const SyntheticScene& scene, const QElapsedTimer& clock)
+        : m_scene(scene), m_clock(clock), m_stamp(0) {}
+
+    qint64 stamp() const {return m_stamp;}
+
+protected:
+    shared_ptr<QHashDataFrames> allocateMemory() override {
+        shared_ptr<QHashDataFrames> result = make_shared<QHashDataFrames>();
+        result->insert(DataFrame::Color, m_scene.color->clone());
+        return result;
+    }
+
+    void produceFrames(QHashDataFrames& output) override {
+        Q_UNUSED(output);
+        m_stamp = m_clock.nsecsElapsed();
+    }
+
+private:
+    SyntheticScene m_scene;
+    const QElapsedTimer& m_clock;
+    qint64 m_stamp;
+};
+
+class LatencyListener : public FrameListener
+{
+public:
+    LatencyListener(const StampGenerator& generator, const QElapsedTimer& clock, QSemaphore& received)
+        : m_generator(generator), m_clock(clock), m_received(received) {}
+
+    const QVector<qint64>& latencies() const {return m_latencies;}
+
+protected:
+    void newFrames(const QHashDataFrames dataFrames) override {
+        Q_UNUSED(dataFrames);
+        m_latencies << m_clock.nsecsElapsed() - m_generator.stamp();
+        m_received.release();
+    }
+
+private:
+    const StampGenerator& m_generator;
+    const QElapsedTimer& m_clock;
+    QSemaphore& m_received;
+    QVector<qint64> m_latencies;
+};
+
+/**
+ * Listener that keeps a copy of every frame received. If releases is set, the copies are
+ * released when the notifier asks for it.
+ */
+class CachingListener : public FrameListener
+{
+public:
+    CachingListener(bool releases, QSemaphore& received)
+        : m_releases(releases), m_received(received), m_delivered(0) {}
+
+    const char* listenerName() const override {return m_releases ? "BudgetCache" : "BudgetHolder";}
+    int delivered() const {return m_delivered;}
+
+protected:
+    void newFrames(const QHashDataFrames dataFrames) override {
+        QMutexLocker locker(&m_lock);
+        m_cache << dataFrames.value(DataFrame::Color)->clone();
+        m_delivered++;
+        m_received.release();
+    }
+
+    void releaseMemory() override {
+        QMutexLocker locker(&m_lock);
+        if (m_releases)
+            m_cache.clear();
+    }
+
+private:
+    const bool m_releases;
+    QSemaphore& m_received;
+    QMutex m_lock;
+    QList<DataFramePtr> m_cache;
+    int m_delivered;
+};
+
+static const char* policyName(PacingPolicy policy)
+{
+    switch (policy) {
+    case PACING_DROP:     return "drop";
+    case PACING_SLOWDOWN: return "slowdown";
+    case PACING_REALTIME: return "realtime";
+    default:              return "none";
+    }
+}
+
+static void runPlaybackThroughput(BenchmarkRunner& runner, const SyntheticScene& scene, float fps, int seconds,
+                                  PacingPolicy policy)
+{
+    const QString name = QString("PlaybackWorker_%1fps_%2").arg(fps).arg(policyName(policy));
+
+    if (!runner.isEnabled("Playback", name))
+        return;
+
+    const int numFrames = fps * seconds;
+    QElapsedTimer clock;
+    PlaybackControl playback; // Declared first so it outlives the listener
+    ThroughputListener listener(clock, numFrames - 1);
+
+    playback.addInstance(make_shared<SyntheticInstance>(scene, numFrames));
+    playback.addListener(&listener);
+    playback.setFPS(fps);
+    playback.setPacingPolicy(policy);
+
+    clock.start();
+    playback.play();
+    listener.waitUntilDone(seconds * 1000 * 10);
+    playback.stop();
+
+    const PacingStats stats = playback.pacingStats();
+
+    const QVector<qint64>& arrivals = listener.arrivals();
+
+    if (arrivals.size() < 2)
+        return;
+
+    // Time between two delivered frames
+    QVector<qint64> intervals;
+
+    for (int i=1; i<arrivals.size(); ++i)
+        intervals << arrivals[i] - arrivals[i-1];
+
+    const double totalTime = (arrivals.last() - arrivals.first()) / 1000000000.0;
+    const double achievedFps = (arrivals.size() - 1) / totalTime;
+
+    QVariantMap extra;
+    extra["target_fps"] = fps;
+    extra["frames_produced"] = numFrames;
+    extra["frames_delivered"] = arrivals.size();
+    extra["frames_dropped"] = stats.framesDropped;
+    extra["mean_lateness_ms"] = stats.meanLatenessMs;
+    extra["jitter_ms"] = stats.jitterMs;
+    extra["max_lateness_ms"] = stats.maxLatenessMs;
+
+    runner.addResult("Playback", name, intervals, achievedFps, "frames/s", extra);
+}
+
+static void runNotifierLatency(BenchmarkRunner& runner, const SyntheticScene& scene, int numListeners, int numFrames)
+{
+    const QString name = QString("FrameNotifier_latency_%1listeners").arg(numListeners);
+
+    if (!runner.isEnabled("Playback", name))
+        return;
+
+    QElapsedTimer clock;
+    QSemaphore received;
+    StampGenerator generator(scene, clock);
+    QList<LatencyListener*> listeners;
+
+    clock.start();
+    generator.begin();
+
+    for (int i=0; i<numListeners; ++i) {
+        LatencyListener* listener = new LatencyListener(generator, clock, received);
+        generator.addListener(listener);
+        listeners << listener;
+    }
+
+    // A new frame is generated once every listener got the previous one, so none is dropped
+    for (int i=0; i<numFrames; ++i) {
+        generator.generate();
+        received.acquire(numListeners);
+    }
+
+    QVector<qint64> latencies;
+    QVector<qint64> fanout(numFrames, 0); // Time until the last listener is notified
+
+    for (LatencyListener* listener : listeners)
+    {
+        generator.removeListener(listener);
+        latencies << listener->latencies();
+
+        for (int i=0; i<listener->latencies().size() && i<numFrames; ++i)
+            fanout[i] = std::max(fanout[i], listener->latencies().at(i));
+
+        delete listener;
+    }
+
+    std::sort(fanout.begin(), fanout.end());
+
+    QVariantMap extra;
+    extra["listeners"] = numListeners;
+    extra["fanout_median_ms"] = fanout[fanout.size() / 2] / 1000000.0;
+    extra["fanout_max_ms"] = fanout.last() / 1000000.0;
+
+    runner.addResult("Playback", name, latencies, 0, QString(), extra);
+}
+
+/**
+ * A listener goes over a budget of BUDGET_DROP once and must get frames again, either
+ * because it releases its copies or, if it doesn't, once dropping has been given up.
+ */
+static void runMemoryBudget(BenchmarkRunner& runner, const SyntheticScene& scene, bool releases, int numFrames)
+{
+    const QString name = releases ? "MemoryBudget_release" : "MemoryBudget_no_release";
+
+    if (!runner.isEnabled("Playback", name))
+        return;
+
+    QElapsedTimer clock;
+    QSemaphore received;
+    StampGenerator generator(scene, clock);
+    CachingListener listener(releases, received);
+    const qint64 frameBytes = qint64(scene.color->width()) * scene.color->height() * sizeof(RGBColor);
+
+    MemoryTracker::setBudget(listener.listenerName(), 20 * frameBytes, MemoryTracker::BUDGET_DROP);
+    clock.start();
+    generator.begin();
+    generator.addListener(&listener);
+
+    QVector<qint64> samples;
+    int deliveredAtFirstDrop = -1;
+
+    for (int i=0; i<numFrames; ++i)
+    {
+        const qint64 start = clock.nsecsElapsed();
+        generator.generate();
+
+        // Dropped frames never arrive
+        if (!received.tryAcquire(1, 20) && deliveredAtFirstDrop < 0)
+            deliveredAtFirstDrop = listener.delivered();
+
+        samples << clock.nsecsElapsed() - start;
+    }
+
+    generator.removeListener(&listener);
+    MemoryTracker::setBudget(listener.listenerName(), 0);
+
+    const bool resumed = deliveredAtFirstDrop >= 0 && listener.delivered() > deliveredAtFirstDrop;
+
+    if (!resumed)
+        qWarning() << name << "- Frames weren't delivered again after the memory budget was exceeded";
+
+    QVariantMap extra;
+    extra["frames_produced"] = numFrames;
+    extra["frames_delivered"] = listener.delivered();
+    extra["delivered_at_first_drop"] = deliveredAtFirstDrop;
+    extra["resumed"] = resumed;
+
+    runner.addResult("Playback", name, samples, 0, QString(), extra);
+}
+
+// PlaybackWorker pacing and throughput, FrameNotifier wake up latency
+void runPlaybackBenchmarks(BenchmarkRunner& runner)
+{
+    SyntheticScene scene = createSyntheticScene();
+
+    for (PacingPolicy policy : {PACING_DROP, PACING_SLOWDOWN, PACING_REALTIME}) {
+        runPlaybackThroughput(runner, scene, 25, 4, policy);
+        runPlaybackThroughput(runner, scene, 120, 2, policy);
+    }
+
+    for (int listeners : {1, 2, 4, 8}) {
+        runNotifierLatency(runner, scene, listeners, 500);
+    }
+
+    // Drop policy of the memory budgets
+    runMemoryBudget(runner, scene, true, 200);
+    runMemoryBudget(runner, scene, false, 200);
+
+    // Cost of a traced stage (1000 scopes per call)
+    for (bool enabled : {false, true})
+    {
+        Tracer::setEnabled(enabled);
+
+        runner.measure("Playback", enabled ? "TraceScope_enabled" : "TraceScope_disabled", [&]() {
+            for (int i=0; i<1000; ++i) {
+                TraceScope scope("Benchmarks", "scope", i);
+            }
+        }, 1000, "events/s");
+    }
+
+    Tracer::setEnabled(false);
+    Tracer::clear();
+}
+
+} // End Namespace
@@ -0,0 +1,253 @@
+#include "Suites.h"
+#include "BenchmarkRunner.h"
+#include "filters/PrivacyPolicy.h"
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QDebug>
+#include <functional>
+
+namespace dai {
+
+/**
+ * Mask of 100x100 with three users in vertical bands: 1 (x 0-19), 2 (x 40-59) and
+ * 3 (x 80-99).
+ */
+static MaskFrame createPolicyMask()
+{
+    MaskFrame mask(100, 100);
+
+    for (int i=0; i<mask.height(); ++i) {
+        for (int j=0; j<20; ++j) {
+            mask.at(i, j) = 1;
+            mask.at(i, j + 40) = 2;
+            mask.at(i, j + 80) = 3;
+        }
+    }
+
+    return mask;
+}
+
+// Filter that got the pixel, -1 if none
+static int filterAt(const QList<PrivacyPolicy::Assignment>& assignments, int x, int y)
+{
+    for (const PrivacyPolicy::Assignment& assignment : assignments) {
+        if (assignment.mask->at(y, x) > 0)
+            return assignment.filter;
+    }
+
+    return -1;
+}
+
+// Filter of the pixels of each user (x of the band, top and bottom halves)
+static bool expectUsers(const QList<PrivacyPolicy::Assignment>& assignments,
+                        const QList<int>& top, const QList<int>& bottom)
+{
+    const int columns[] = {10, 50, 90};
+
+    for (int user=0; user<3; ++user) {
+        if (filterAt(assignments, columns[user], 10) != top[user] ||
+                filterAt(assignments, columns[user], 90) != bottom[user])
+            return false;
+    }
+
+    return true;
+}
+
+static PrivacyPolicy::Rule makeRule(ColorFilter filter)
+{
+    PrivacyPolicy::Rule rule;
+    rule.filter = filter;
+    return rule;
+}
+
+static PrivacyPolicyPtr loadPolicyText(const QString& fileName, const QByteArray& text)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return nullptr;
+
+    file.write(text);
+    file.close();
+
+    PrivacyPolicyPtr result = PrivacyPolicy::load(fileName);
+    QFile::remove(fileName);
+    return result;
+}
+
+/**
+ * Deterministic checks of PrivacyPolicy: precedence of the rules (user, region, distance and
+ * the default rule) and errors of the INI files. Failed checks are logged and
+ * listed in the result.
+ */
+static void runPolicyChecks(BenchmarkRunner& runner, const QString& suite, const MaskFrame& mask)
+{
+    if (!runner.isEnabled(suite, "checks"))
+        return;
+
+    QList<QPair<QString, std::function<bool ()>>> checks;
+
+    checks << qMakePair(QString("default_rule"), std::function<bool ()>([&]() {
+        PrivacyPolicy policy(FILTER_BLUR);
+        const auto result = policy.apply(mask, nullptr);
+        return result.size() == 1 && result[0].users == (QList<int>() << 1 << 2 << 3) &&
+                expectUsers(result, {FILTER_BLUR, FILTER_BLUR, FILTER_BLUR}, {FILTER_BLUR, FILTER_BLUR, FILTER_BLUR});
+    }));
+
+    checks << qMakePair(QString("user_rule"), std::function<bool ()>([&]() {
+        PrivacyPolicy policy(FILTER_BLUR);
+        PrivacyPolicy::Rule rule = makeRule(FILTER_SKELETON);
+        rule.user = 2;
+        policy.addRule(rule);
+        const auto result = policy.apply(mask, nullptr);
+        return expectUsers(result, {FILTER_BLUR, FILTER_SKELETON, FILTER_BLUR}, {FILTER_BLUR, FILTER_SKELETON, FILTER_BLUR});
+    }));
+
+    checks << qMakePair(QString("first_rule_wins"), std::function<bool ()>([&]() {
+        PrivacyPolicy policy(FILTER_BLUR);
+        PrivacyPolicy::Rule rule = makeRule(FILTER_DISABLED);
+        rule.user = 2;
+        policy.addRule(rule);
+        policy.addRule(makeRule(FILTER_SKELETON));
+        rule.filter = FILTER_EMBOSS; // Never reached
+        policy.addRule(rule);
+        const auto result = policy.apply(mask, nullptr);
+        return expectUsers(result, {FILTER_SKELETON, FILTER_DISABLED, FILTER_SKELETON},
+                           {FILTER_SKELETON, FILTER_DISABLED, FILTER_SKELETON});
+    }));
+
+    checks << qMakePair(QString("region_pixels"), std::function<bool ()>([&]() {
+        PrivacyPolicy policy(FILTER_BLUR);
+        PrivacyPolicy::Rule rule = makeRule(FILTER_SILHOUETTE);
+        rule.region = QRect(0, 0, 100, 50);
+        policy.addRule(rule);
+        const auto result = policy.apply(mask, nullptr);
+        return expectUsers(result, {FILTER_SILHOUETTE, FILTER_SILHOUETTE, FILTER_SILHOUETTE},
+                           {FILTER_BLUR, FILTER_BLUR, FILTER_BLUR});
+    }));
+
+    // Pixels of a region go to the next matching rule, not to the default one
+    checks << qMakePair(QString("region_then_user"), std::function<bool ()>([&]() {
+        PrivacyPolicy policy(FILTER_BLUR);
+        PrivacyPolicy::Rule rule = makeRule(FILTER_INVISIBILITY);
+        rule.region = QRect(0, 0, 100, 50);
+        policy.addRule(rule);
+        rule = makeRule(FILTER_DISABLED);
+        rule.user = 1;
+        policy.addRule(rule);
+        const auto result = policy.apply(mask, nullptr);
+        return expectUsers(result, {FILTER_INVISIBILITY, FILTER_INVISIBILITY, FILTER_INVISIBILITY},
+                           {FILTER_DISABLED, FILTER_BLUR, FILTER_BLUR});
+    }));
+
+    checks << qMakePair(QString("region_whole_user"), std::function<bool ()>([&]() {
+        PrivacyPolicy policy(FILTER_BLUR);
+        PrivacyPolicy::Rule rule = makeRule(FILTER_SKELETON);
+        rule.region = QRect(30, 0, 40, 60); // Centre of user 2 only
+        rule.wholeUser = true;
+        policy.addRule(rule);
+        const auto result = policy.apply(mask, nullptr);
+        return expectUsers(result, {FILTER_BLUR, FILTER_SKELETON, FILTER_BLUR}, {FILTER_BLUR, FILTER_SKELETON, FILTER_BLUR});
+    }));
+
+    // User 1 at 1 m, user 2 at 3 m and user 3 without a bounding box
+    checks << qMakePair(QString("distance_rule"), std::function<bool ()>([&]() {
+        PrivacyPolicy policy(FILTER_BLUR);
+        PrivacyPolicy::Rule rule = makeRule(FILTER_SKELETON);
+        rule.maxDistance = 2500;
+        policy.addRule(rule);
+        rule.minDistance = 2500;
+        rule.maxDistance = 0;
+        rule.filter = FILTER_EMBOSS;
+        policy.addRule(rule);
+
+        MetadataFrame metadata;
+        metadata.addBoundingBox(BoundingBox(Point3f(0.0f, 0.0f, 900.0f), Point3f(19.0f, 99.0f, 1100.0f)));
+        metadata.addBoundingBox(BoundingBox(Point3f(40.0f, 0.0f, 2900.0f), Point3f(59.0f, 99.0f, 3100.0f)));
+
+        const auto result = policy.apply(mask, &metadata);
+        const auto noMetadata = policy.apply(mask, nullptr);
+        return expectUsers(result, {FILTER_SKELETON, FILTER_EMBOSS, FILTER_BLUR}, {FILTER_SKELETON, FILTER_EMBOSS, FILTER_BLUR}) &&
+                expectUsers(noMetadata, {FILTER_BLUR, FILTER_BLUR, FILTER_BLUR}, {FILTER_BLUR, FILTER_BLUR, FILTER_BLUR});
+    }));
+
+    // INI files
+    const QString fileName = QDir::temp().filePath("benchmark_policy.ini");
+
+    checks << qMakePair(QString("ini_valid"), std::function<bool ()>([&]() {
+        PrivacyPolicyPtr policy = loadPolicyText(fileName,
+            "[General]\ndefault=pixelation\n\n"
+            "[rule10]\nuser=2\nfilter=skeleton\n\n"
+            "[rule02]\nregion=0, 0, 320, 240\nmatch=user\ndistance=0, 2500\nfilter=disabled\n");
+
+        if (!policy || policy->defaultFilter() != FILTER_PIXELATION || policy->rules().size() != 2)
+            return false;
+
+        const PrivacyPolicy::Rule& first = policy->rules()[0];
+        const PrivacyPolicy::Rule& second = policy->rules()[1];
+        return first.filter == FILTER_DISABLED && first.region == QRect(0, 0, 320, 240) && first.wholeUser &&
+                first.maxDistance == 2500 &&
+                second.filter == FILTER_SKELETON && second.user == 2 && second.region.isNull();
+    }));
+
+    const QList<QPair<QString, QByteArray>> invalidFiles = {
+        qMakePair(QString("ini_unknown_default"), QByteArray("[General]\ndefault=foo\n")),
+        qMakePair(QString("ini_unknown_filter"), QByteArray("[rule01]\nfilter=foo\n")),
+        qMakePair(QString("ini_missing_filter"), QByteArray("[rule01]\nuser=1\n")),
+        qMakePair(QString("ini_bad_region"), QByteArray("[rule01]\nregion=0, 0, 10\nfilter=blur\n")),
+        qMakePair(QString("ini_bad_match"), QByteArray("[rule01]\nregion=0, 0, 10, 10\nmatch=foo\nfilter=blur\n")),
+        qMakePair(QString("ini_bad_distance"), QByteArray("[rule01]\ndistance=2500\nfilter=blur\n")),
+        qMakePair(QString("ini_identity"), QByteArray("[rule01]\nidentity=alice\nfilter=blur\n"))
+    };
+
+    for (const auto& invalid : invalidFiles) {
+        const QByteArray text = invalid.second;
+        checks << qMakePair(invalid.first, std::function<bool ()>([&fileName, text]() {
+            return loadPolicyText(fileName, text) == nullptr;
+        }));
+    }
+
+    checks << qMakePair(QString("ini_missing_file"), std::function<bool ()>([&]() {
+        return PrivacyPolicy::load(QDir::temp().filePath("benchmark_policy_missing.ini")) == nullptr;
+    }));
+
+    QStringList failed;
+
+    for (const auto& check : checks) {
+        if (!check.second()) {
+            qWarning() << "Policy check failed:" << check.first;
+            failed << check.first;
+        }
+    }
+
+    QVariantMap extra;
+    extra["checks"] = checks.size();
+    extra["failed"] = failed.join(", ");
+
+    runner.addResult(suite, "checks", QVector<qint64>() << 0, 0, QString(), extra);
+}
+
+// Rule matching of PrivacyPolicy
+void runPolicyBenchmarks(BenchmarkRunner& runner)
+{
+    const QString suite = "Policy";
+    const MaskFrame mask = createPolicyMask();
+
+    runPolicyChecks(runner, suite, mask);
+
+    // Cost of splitting the users of a frame with a region rule followed by a user rule
+    PrivacyPolicy policy(FILTER_BLUR);
+    PrivacyPolicy::Rule rule = makeRule(FILTER_INVISIBILITY);
+    rule.region = QRect(0, 0, 100, 50);
+    policy.addRule(rule);
+    rule = makeRule(FILTER_DISABLED);
+    rule.user = 1;
+    policy.addRule(rule);
+
+    runner.measure(suite, "apply", [&]() {
+        policy.apply(mask, nullptr);
+    }, 1, "frames/s");
+}
+
+} // End Namespace
@@ -0,0 +1,43 @@
+#include "Suites.h"
+#include "BenchmarkRunner.h"
+#include "SyntheticData.h"
+#include "filters/PointCloudRenderer.h"
+#include <QThread>
+
+namespace dai {
+
+// CPU point cloud privacy level at 640x480, the target is 30 frames/s
+void runRenderingBenchmarks(BenchmarkRunner& runner)
+{
+    const QString suite = "Rendering";
+    SyntheticScene scene = createSyntheticScene();
+    ColorFrame target(scene.color->width(), scene.color->height());
+    PointCloudRenderer renderer;
+    PointCloudRenderer::Settings settings;
+
+    // Same view as the sensor
+    renderer.setSettings(settings);
+
+    runner.measure(suite, "pointCloud", [&]() {
+        renderer.render(*scene.depth, *scene.mask, target, scene.color.get());
+    }, 1, "frames/s");
+
+    // Turned camera, so splats overlap and the depth test matters
+    settings.yaw = 30.0f;
+    settings.pitch = 10.0f;
+    renderer.setSettings(settings);
+
+    runner.measure(suite, "pointCloud_turned", [&]() {
+        renderer.render(*scene.depth, *scene.mask, target, scene.color.get());
+    }, 1, "frames/s");
+
+    renderer.setThreadsCount(1);
+
+    runner.measure(suite, "pointCloud_turned_1thread", [&]() {
+        renderer.render(*scene.depth, *scene.mask, target, scene.color.get());
+    }, 1, "frames/s");
+
+    renderer.setThreadsCount(QThread::idealThreadCount());
+}
+
+} // End Namespace
@@ -0,0 +1,218 @@
+#include "Suites.h"
+#include "BenchmarkRunner.h"
+#include "SyntheticData.h"
+#include "playback/DepthSegmenter.h"
+#include "dataset/IASLAB_RGBD_ID/IASLAB_RGBD_ID.h"
+#include "dataset/InstanceInfo.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+
+namespace dai {
+
+/**
+ * Pixels of users (any label) found by the segmentation compared with the reference.
+ */
+struct SegmentationScore
+{
+    quint64 truePositives = 0;
+    quint64 falsePositives = 0;
+    quint64 falseNegatives = 0;
+
+    void add(const MaskFrame& result, const MaskFrame& reference)
+    {
+        for (int i=0; i<result.height(); ++i)
+        {
+            const uint8_t* pResult = result.getRowPtr(i);
+            const uint8_t* pReference = reference.getRowPtr(i);
+
+            for (int j=0; j<result.width(); ++j) {
+                const bool user = pResult[j] > 0;
+                const bool expected = pReference[j] > 0;
+                truePositives += user && expected;
+                falsePositives += user && !expected;
+                falseNegatives += !user && expected;
+            }
+        }
+    }
+
+    void addTo(QVariantMap& extra) const
+    {
+        const double tp = truePositives;
+        extra["precision"] = tp + falsePositives > 0 ? tp / (tp + falsePositives) : 0.0;
+        extra["recall"] = tp + falseNegatives > 0 ? tp / (tp + falseNegatives) : 0.0;
+        extra["iou"] = tp + falsePositives + falseNegatives > 0 ? tp / (tp + falsePositives + falseNegatives) : 0.0;
+    }
+};
+
+// Most frequent user label of result inside the reference mask, 0 if there is none
+static int dominantLabel(const MaskFrame& result, const MaskFrame& reference)
+{
+    int count[256] = {0};
+
+    for (int i=0; i<result.height(); ++i) {
+        for (int j=0; j<result.width(); ++j) {
+            if (reference.getRowPtr(i)[j] > 0)
+                count[result.getRowPtr(i)[j]]++;
+        }
+    }
+
+    count[0] = 0;
+    return int(std::max_element(count, count + 256) - count);
+}
+
+// Synthetic user in front of a wall, after the empty wall has been learned
+static void runSyntheticSegmentation(BenchmarkRunner& runner, const QString& suite)
+{
+    if (!runner.isEnabled(suite, "synthetic"))
+        return;
+
+    SyntheticScene scene = createSyntheticScene();
+    DepthFrame background = *scene.depth;
+
+    for (int i=0; i<background.height(); ++i) {
+        for (int j=0; j<background.width(); ++j) {
+            if (scene.mask->getRowPtr(i)[j] > 0)
+                background.getRowPtr(i)[j] = 4000;
+        }
+    }
+
+    DepthSegmenter segmenter;
+    MaskFrame mask;
+
+    for (int i=0; i<segmenter.settings().learningFrames; ++i)
+        segmenter.segment(background, mask);
+
+    const int numFrames = 100;
+    QVector<qint64> samples;
+    QElapsedTimer timer;
+
+    for (int i=0; i<numFrames; ++i) {
+        timer.start();
+        segmenter.segment(*scene.depth, mask);
+        samples << timer.nsecsElapsed();
+    }
+
+    SegmentationScore score;
+    score.add(mask, *scene.mask);
+
+    QVariantMap extra;
+    extra["users"] = segmenter.usersCount();
+    score.addTo(extra);
+
+    qint64 total = 0;
+
+    for (qint64 sample : samples)
+        total += sample;
+
+    runner.addResult(suite, "synthetic", samples, numFrames / (total / 1000000000.0), "frames/s", extra);
+}
+
+/**
+ * Every sequence (actor and camera) of IASLAB-RGBD-ID is segmented from the start, and
+ * the result is compared with the masks of the dataset once the background has been
+ * learned. A label switch is counted when the label of the user changes between frames.
+ */
+static void runIaslabSegmentation(BenchmarkRunner& runner, const QString& suite, const QString& datasetPath)
+{
+    if (datasetPath.isEmpty() || !runner.isEnabled(suite, "IASLAB_RGBD_ID"))
+        return;
+
+    IASLAB_RGBD_ID dataset;
+    dataset.setPath(datasetPath);
+    const DatasetMetadata& metadata = dataset.getMetadata();
+
+    SegmentationScore score;
+    QVector<qint64> samples;
+    int frames = 0, switches = 0, missed = 0;
+
+    for (int actor : metadata.actors().keys())
+    {
+        for (int camera : metadata.cameras().keys())
+        {
+            QList<shared_ptr<InstanceInfo>> instances = metadata.instances({actor}, {camera}, DatasetMetadata::ANY_LABEL);
+
+            std::sort(instances.begin(), instances.end(), [](const shared_ptr<InstanceInfo>& a, const shared_ptr<InstanceInfo>& b) {
+                return a->getSample() < b->getSample();
+            });
+
+            DepthSegmenter segmenter;
+            MaskFrame mask;
+            int lastLabel = 0;
+
+            for (shared_ptr<InstanceInfo> info : instances)
+            {
+                shared_ptr<StreamInstance> instance = dataset.getInstance(*info, DataFrame::Color);
+
+                if (!instance) {
+                    qWarning() << "Couldn't read sample" << info->getSample() << "of actor" << actor;
+                    continue;
+                }
+
+                QHashDataFrames readFrames;
+                instance->open();
+                instance->readNextFrame(readFrames);
+                instance->close();
+
+                auto depthFrame = static_pointer_cast<DepthFrame>(readFrames.value(DataFrame::Depth));
+                auto maskFrame = static_pointer_cast<MaskFrame>(readFrames.value(DataFrame::Mask));
+
+                if (!depthFrame || !maskFrame)
+                    continue;
+
+                const bool learning = segmenter.isLearning();
+                QElapsedTimer timer;
+                timer.start();
+                segmenter.segment(*depthFrame, mask);
+                const qint64 elapsed = timer.nsecsElapsed();
+
+                if (learning)
+                    continue;
+
+                samples << elapsed;
+                score.add(mask, *maskFrame);
+                frames++;
+
+                const int label = dominantLabel(mask, *maskFrame);
+
+                if (label == 0)
+                    missed++;
+                else if (lastLabel != 0 && label != lastLabel)
+                    switches++;
+
+                if (label != 0)
+                    lastLabel = label;
+            }
+        }
+    }
+
+    if (samples.isEmpty()) {
+        qWarning() << "No IASLAB-RGBD-ID frames were segmented in" << datasetPath;
+        return;
+    }
+
+    QVariantMap extra;
+    extra["path"] = datasetPath;
+    extra["frames"] = frames;
+    extra["label_switches"] = switches;
+    extra["missed_users"] = missed;
+    score.addTo(extra);
+
+    qint64 total = 0;
+
+    for (qint64 sample : samples)
+        total += sample;
+
+    runner.addResult(suite, "IASLAB_RGBD_ID", samples, samples.size() / (total / 1000000000.0), "frames/s", extra);
+}
+
+// Throughput and accuracy of the depth-only user segmentation
+void runSegmentationBenchmarks(BenchmarkRunner& runner, const QString& iaslabPath)
+{
+    const QString suite = "Segmentation";
+    runSyntheticSegmentation(runner, suite);
+    runIaslabSegmentation(runner, suite, iaslabPath);
+}
+
+} // End Namespace
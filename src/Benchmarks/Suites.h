@@ -0,0 +1,25 @@
+#ifndef SUITES_H
+#define SUITES_H
+
+#include <QString>
+
+namespace dai {
+
+class BenchmarkRunner;
+
+// Micro benchmarks
+void runFrameBenchmarks(BenchmarkRunner& runner);
+void runFeatureBenchmarks(BenchmarkRunner& runner);
+void runImageKernelBenchmarks(BenchmarkRunner& runner);
+
+// Macro benchmarks
+void runPlaybackBenchmarks(BenchmarkRunner& runner);
+void runOpenNIBenchmarks(BenchmarkRunner& runner, const QString& oniFile); // Skipped if oniFile is empty
+void runSegmentationBenchmarks(BenchmarkRunner& runner, const QString& iaslabPath); // IASLAB skipped if path is empty
+void runRenderingBenchmarks(BenchmarkRunner& runner);
+void runCodecBenchmarks(BenchmarkRunner& runner, const QString& iaslabPath); // IASLAB skipped if path is empty
+void runPolicyBenchmarks(BenchmarkRunner& runner);
+
+} // End Namespace
+
+#endif // SUITES_H
@@ -0,0 +1,112 @@
+#include "SyntheticData.h"
+#include <opencv2/opencv.hpp>
+#include <random>
+#include <algorithm>
+
+namespace dai {
+
+static const float USER_DEPTH = 2500.0f;  // Milimeters
+static const float WALL_DEPTH = 4000.0f;
+
+// OpenNI joints in image coordinates (fraction of width and height)
+static const struct {
+    SkeletonJoint::JointType type;
+    float x;
+    float y;
+} syntheticPose[] = {
+    {SkeletonJoint::JOINT_HEAD,            0.50f, 0.16f},
+    {SkeletonJoint::JOINT_CENTER_SHOULDER, 0.50f, 0.27f},
+    {SkeletonJoint::JOINT_LEFT_SHOULDER,   0.44f, 0.28f},
+    {SkeletonJoint::JOINT_RIGHT_SHOULDER,  0.56f, 0.28f},
+    {SkeletonJoint::JOINT_LEFT_ELBOW,      0.40f, 0.40f},
+    {SkeletonJoint::JOINT_RIGHT_ELBOW,     0.60f, 0.40f},
+    {SkeletonJoint::JOINT_LEFT_HAND,       0.38f, 0.52f},
+    {SkeletonJoint::JOINT_RIGHT_HAND,      0.63f, 0.50f},
+    {SkeletonJoint::JOINT_SPINE,           0.50f, 0.40f},
+    {SkeletonJoint::JOINT_LEFT_HIP,        0.46f, 0.53f},
+    {SkeletonJoint::JOINT_RIGHT_HIP,       0.54f, 0.53f},
+    {SkeletonJoint::JOINT_LEFT_KNEE,       0.46f, 0.70f},
+    {SkeletonJoint::JOINT_RIGHT_KNEE,      0.55f, 0.70f},
+    {SkeletonJoint::JOINT_LEFT_FOOT,       0.45f, 0.88f},
+    {SkeletonJoint::JOINT_RIGHT_FOOT,      0.56f, 0.88f}
+};
+
+SyntheticScene createSyntheticScene(int width, int height, unsigned int seed)
+{
+    SyntheticScene scene;
+    scene.color = make_shared<ColorFrame>(width, height);
+    scene.depth = make_shared<DepthFrame>(width, height);
+    scene.mask = make_shared<MaskFrame>(width, height);
+    scene.skeleton = make_shared<Skeleton>(Skeleton::SKELETON_OPENNI);
+    scene.depth->setDistanceUnits(DISTANCE_MILIMETERS);
+
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> noise(-12, 12);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    // Skeleton
+    QMap<SkeletonJoint::JointType, cv::Point> jointPixels;
+
+    for (const auto& item : syntheticPose)
+    {
+        cv::Point pixel(item.x * width, item.y * height);
+        Point3f position(0.0f, 0.0f, USER_DEPTH);
+        scene.depth->convertCoordinatesToWorld(pixel.x, pixel.y, USER_DEPTH, &position[0], &position[1]);
+
+        SkeletonJoint joint(position, item.type);
+        joint.setPositionConfidence(1.0f);
+        scene.skeleton->setJoint(item.type, joint);
+        jointPixels.insert(item.type, pixel);
+    }
+
+    scene.skeleton->setDistanceUnits(DISTANCE_MILIMETERS);
+
+    // Silhouette: thick limbs and a torso
+    cv::Mat mask_mat(height, width, CV_8UC1, (void*) scene.mask->getDataPtr(), scene.mask->getStride());
+    const int thickness = std::max(3, width / 28);
+    const Skeleton::SkeletonLimb* limbs = scene.skeleton->getLimbsMap();
+
+    for (int i=0; i<scene.skeleton->getLimbsCount(); ++i) {
+        cv::line(mask_mat, jointPixels.value(limbs[i].joint1), jointPixels.value(limbs[i].joint2),
+                 cv::Scalar(1), thickness);
+    }
+
+    cv::Point torso[] = {
+        jointPixels.value(SkeletonJoint::JOINT_LEFT_SHOULDER), jointPixels.value(SkeletonJoint::JOINT_RIGHT_SHOULDER),
+        jointPixels.value(SkeletonJoint::JOINT_RIGHT_HIP), jointPixels.value(SkeletonJoint::JOINT_LEFT_HIP)
+    };
+
+    cv::fillConvexPoly(mask_mat, torso, 4, cv::Scalar(1));
+    cv::circle(mask_mat, jointPixels.value(SkeletonJoint::JOINT_HEAD), thickness, cv::Scalar(1), -1);
+
+    // Depth, colour: wall with some holes, user with shirt and trousers
+    const int hipRow = jointPixels.value(SkeletonJoint::JOINT_LEFT_HIP).y;
+
+    for (int i=0; i<height; ++i)
+    {
+        const uint8_t* pMask = scene.mask->getRowPtr(i);
+        uint16_t* pDepth = scene.depth->getRowPtr(i);
+        RGBColor* pColor = scene.color->getRowPtr(i);
+
+        for (int j=0; j<width; ++j)
+        {
+            RGBColor color;
+
+            if (pMask[j] > 0) {
+                pDepth[j] = USER_DEPTH + noise(generator);
+                color = i < hipRow ? RGBColor{180, 40, 40} : RGBColor{40, 50, 120};
+            } else {
+                pDepth[j] = percent(generator) < 3 ? 0 : WALL_DEPTH + 4 * noise(generator);
+                color = (i / 32 + j / 32) % 2 ? RGBColor{200, 200, 190} : RGBColor{150, 160, 150};
+            }
+
+            pColor[j].red = cv::saturate_cast<uchar>(color.red + noise(generator));
+            pColor[j].green = cv::saturate_cast<uchar>(color.green + noise(generator));
+            pColor[j].blue = cv::saturate_cast<uchar>(color.blue + noise(generator));
+        }
+    }
+
+    return scene;
+}
+
+} // End Namespace
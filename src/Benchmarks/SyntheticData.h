@@ -0,0 +1,32 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include "types/ColorFrame.h"
+#include "types/DepthFrame.h"
+#include "types/MaskFrame.h"
+#include "types/Skeleton.h"
+
+namespace dai {
+
+/**
+ * A single user standing in front of a wall. Frames are generated from a fixed seed, so
+ * every run of the benchmarks works with the same input.
+ *
+ * Depth is in millimeters and the skeleton uses the same real world coordinates that
+ * DepthFrame::convertCoordinatesToWorld() returns.
+ *
+ * @brief The SyntheticScene struct
+ */
+struct SyntheticScene
+{
+    shared_ptr<ColorFrame> color;
+    shared_ptr<DepthFrame> depth;
+    shared_ptr<MaskFrame> mask;
+    shared_ptr<Skeleton> skeleton;
+};
+
+SyntheticScene createSyntheticScene(int width = 640, int height = 480, unsigned int seed = 1234);
+
+} // End Namespace
+
+#endif // SYNTHETICDATA_H
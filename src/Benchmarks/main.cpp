@@ -0,0 +1,80 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QDebug>
+#include <iostream>
+#include "Config.h"
+#include "BenchmarkRunner.h"
+#include "Suites.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    CoreLib_InitResources();
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("Benchmarks");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Micro and macro benchmarks with synthetic input");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"format", "Output format: json or csv", "format", "json"},
+        {"output", "Write results to file instead of stdout", "file"},
+        {"filter", "Only run benchmarks whose suite/name matches the regular expression", "regex"},
+        {"min-time", "Minimum time per benchmark in milliseconds", "ms", "500"},
+        {"quick", "Few iterations, only to check that everything runs"},
+        {"oni", "ONI recording used to benchmark OpenNI ingestion", "file"},
+        {"iaslab", "IASLAB-RGBD-ID path used to measure the depth segmentation and the frame codec", "path"}
+    });
+    parser.process(a);
+
+    dai::BenchmarkRunner runner;
+    runner.setMinTime(parser.value("min-time").toInt());
+
+    if (parser.isSet("filter"))
+        runner.setFilter(parser.value("filter"));
+
+    if (parser.isSet("quick")) {
+        runner.setMinIterations(2);
+        runner.setMaxIterations(5);
+        runner.setMinTime(0);
+    }
+
+    const QString format = parser.value("format");
+
+    if (format != "json" && format != "csv") {
+        qCritical() << "Unknown format" << format;
+        return 1;
+    }
+
+    dai::runFrameBenchmarks(runner);
+    dai::runFeatureBenchmarks(runner);
+    dai::runImageKernelBenchmarks(runner);
+    dai::runPlaybackBenchmarks(runner);
+    dai::runOpenNIBenchmarks(runner, parser.value("oni"));
+    dai::runSegmentationBenchmarks(runner, parser.value("iaslab"));
+    dai::runRenderingBenchmarks(runner);
+    dai::runCodecBenchmarks(runner, parser.value("iaslab"));
+    dai::runPolicyBenchmarks(runner);
+
+    const QByteArray output = format == "json" ? runner.toJson() : runner.toCsv();
+
+    if (parser.isSet("output"))
+    {
+        QFile file(parser.value("output"));
+
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical() << "Couldn't open" << file.fileName();
+            return 1;
+        }
+
+        file.write(output);
+        file.close();
+    }
+    else {
+        cout << output.constData() << endl;
+    }
+
+    return 0;
+}
@@ -38,6 +38,7 @@ SOURCES += \
     InstanceWidgetItem.cpp \
     dataset/MSRDaily/MSRDailyColorInstance.cpp \
     Config.cpp \
+    Parallel.cpp \
     viewer/ViewerEngine.cpp \
     viewer/ViewerRenderer.cpp \
     playback/PlaybackWorker.cpp \
@@ -46,8 +47,24 @@ SOURCES += \
     playback/FrameGenerator.cpp \
     playback/FrameListener.cpp \
     playback/FrameNotifier.cpp \
+    playback/VideoWriterListener.cpp \
+    playback/Tracer.cpp \
+    playback/InstanceSynchroniser.cpp \
+    playback/SkeletonSmoother.cpp \
+    playback/SkeletonFilter.cpp \
+    playback/DepthSegmenter.cpp \
+    playback/SegmentationFilter.cpp \
+    playback/StreamRecording.cpp \
+    playback/StreamRecorder.cpp \
+    playback/RecordingInstance.cpp \
+    playback/RingRecorder.cpp \
+    playback/SharedFrameRing.cpp \
+    playback/SharedMemoryPublisher.cpp \
+    playback/SharedMemoryInstance.cpp \
     viewer/DepthFilter.cpp \
     types/MetadataFrame.cpp \
+    types/FrameCodec.cpp \
+    types/MemoryTracker.cpp \
     types/BoundingBox.cpp \
     dataset/HuDaAct/HuDaAct.cpp \
     openni/OpenNIColorInstance.cpp \
@@ -62,7 +79,8 @@ SOURCES += \
     dataset/DAI4REID_Parsed/DAI4REID_ParsedInstance.cpp \
     dataset/IASLAB_RGBD_ID/IASLAB_RGBD_ID.cpp \
     dataset/IASLAB_RGBD_ID/IASLAB_RGBD_ID_Instance.cpp \
-    opencv_utils.cpp
+    opencv_utils.cpp \
+    opencv_utils_simd.cpp
 
 HEADERS += \
     types/Vector3D.h \
@@ -89,6 +107,7 @@ HEADERS += \
     dataset/MSRDaily/MSRDailyDepthInstance.h \
     dataset/MSRDaily/MSRDailyActivity3D.h \
     Utils.h \
+    Parallel.h \
     playback/PlaybackControl.h \
     viewer/SkeletonItem.h \
     viewer/SilhouetteItem.h \
@@ -110,9 +129,26 @@ HEADERS += \
     playback/FrameGenerator.h \
     playback/FrameListener.h \
     playback/FrameNotifier.h \
+    playback/VideoWriterListener.h \
+    playback/Tracer.h \
+    playback/Pacing.h \
+    playback/InstanceSynchroniser.h \
+    playback/SkeletonSmoother.h \
+    playback/SkeletonFilter.h \
+    playback/DepthSegmenter.h \
+    playback/SegmentationFilter.h \
+    playback/StreamRecording.h \
+    playback/StreamRecorder.h \
+    playback/RecordingInstance.h \
+    playback/RingRecorder.h \
+    playback/SharedFrameRing.h \
+    playback/SharedMemoryPublisher.h \
+    playback/SharedMemoryInstance.h \
     viewer/DepthFilter.h \
     viewer/types.h \
     types/MetadataFrame.h \
+    types/FrameCodec.h \
+    types/MemoryTracker.h \
     types/BoundingBox.h \
     dataset/HuDaAct/HuDaAct.h \
     openni/OpenNIColorInstance.h \
@@ -126,6 +162,7 @@ HEADERS += \
     dataset/CAVIAR4REID/CAVIAR4REID.h \
     dataset/CAVIAR4REID/CAVIAR4REIDInstance.h \
     opencv_utils.h \
+    opencv_utils_simd.h \
     types/Enums.h \
     dataset/DAI4REID/DAI4REID.h \
     dataset/DAI4REID_Parsed/DAI4REID_Parsed.h \
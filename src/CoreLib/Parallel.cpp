@@ -0,0 +1,49 @@
+#include "Parallel.h"
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+
+namespace dai {
+
+class ParallelTask : public QRunnable
+{
+public:
+    ParallelTask(const std::function<void ()>& worker, QSemaphore* done)
+        : m_worker(worker)
+        , m_done(done)
+    {
+    }
+
+    void run() override {
+        m_worker();
+        m_done->release();
+    }
+
+private:
+    const std::function<void ()>& m_worker;
+    QSemaphore* m_done;
+};
+
+void runParallel(int threads, const std::function<void ()>& worker)
+{
+    QThreadPool* pool = QThreadPool::globalInstance();
+    QSemaphore done;
+    int started = 0;
+
+    for (int i=1; i<threads; ++i)
+    {
+        ParallelTask* task = new ParallelTask(worker, &done);
+
+        if (!pool->tryStart(task)) {
+            delete task;
+            break;
+        }
+
+        started++;
+    }
+
+    worker();
+    done.acquire(started);
+}
+
+} // End Namespace
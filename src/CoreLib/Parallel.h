@@ -0,0 +1,18 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <functional>
+
+namespace dai {
+
+/**
+ * Run worker in the calling thread and in up to threads - 1 idle threads of the shared
+ * pool (QThreadPool::globalInstance()), and wait until every copy returns. Workers must
+ * take their work from a shared counter: when the pool is busy the calling thread does
+ * all of it, so callers never block on the pool nor start threads of their own.
+ */
+void runParallel(int threads, const std::function<void ()>& worker);
+
+} // End Namespace
+
+#endif // PARALLEL_H
@@ -4,8 +4,10 @@
 #include "types/DepthFrame.h"
 #include "types/MaskFrame.h"
 #include "types/SkeletonFrame.h"
+#include "types/FrameCodec.h"
 #include <opencv2/opencv.hpp>
 #include <QFile>
+#include <QDebug>
 #include "Utils.h"
 
 namespace dai {
@@ -78,7 +80,11 @@ void DAI4REID_ParsedInstance::nextFrame(QHashDataFrames &output)
     QByteArray buffer = depthFile.readAll();
     depthFile.close();
     shared_ptr<DepthFrame> depthFrame = make_shared<DepthFrame>();
-    depthFrame->loadData(buffer);
+
+    // toBinary() or FrameCodec
+    if (!FrameCodec::load(buffer, *depthFrame))
+        qDebug() << "Corrupt depth file" << instancePath;
+
     depthFrame->setDistanceUnits(dai::DISTANCE_MILIMETERS);
     depthFrame->setCameraIntrinsics(594.21434211923247, 320.0, -591.04053696870778, 240.0);
     output.insert(DataFrame::Depth, depthFrame);
@@ -102,7 +108,10 @@ void DAI4REID_ParsedInstance::nextFrame(QHashDataFrames &output)
     buffer = maskFile.readAll();
     maskFile.close();
     shared_ptr<MaskFrame> maskFrame = make_shared<MaskFrame>();
-    maskFrame->loadData(buffer);
+
+    if (!FrameCodec::load(buffer, *maskFrame))
+        qDebug() << "Corrupt mask file" << instancePath;
+
     output.insert(DataFrame::Mask, maskFrame);
 
     // Read Skeleton File
@@ -34,4 +34,21 @@ bool DataInstance::hasNext() const
     return false;
 }
 
+unsigned int DataInstance::skipFrames(unsigned int count, QHashDataFrames& scratch)
+{
+    return StreamInstance::skipFrames(skippableFrames(count), scratch);
+}
+
+// Never skip beyond the last frame, it is kept so it is still read
+unsigned int DataInstance::skippableFrames(unsigned int count) const
+{
+    const unsigned int read = this->getFrameCounter() + 1;
+    const unsigned int remaining = m_nFrames > read ? m_nFrames - read : 0;
+
+    if (!this->is_open() || remaining == 0)
+        return 0;
+
+    return qMin(count, remaining - 1);
+}
+
 } // End Namespace
@@ -15,6 +15,8 @@ public:
     const InstanceInfo& getMetadata() const;
     unsigned int getTotalFrames() const;
     bool hasNext() const override;
+    unsigned int skipFrames(unsigned int count, QHashDataFrames& scratch) override;
+    unsigned int skippableFrames(unsigned int count) const override;
 
 protected:
     InstanceInfo m_info;
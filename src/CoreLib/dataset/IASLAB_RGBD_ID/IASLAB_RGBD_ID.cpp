@@ -12,10 +12,15 @@ shared_ptr<StreamInstance> IASLAB_RGBD_ID::instance(int actor, int camera, int s
 {
     const shared_ptr<InstanceInfo> instanceInfo = m_metadata->instance(actor, camera, sample, label, type);
 
-    if (type == DataFrame::Color || type == DataFrame::Depth || type == DataFrame::Mask || type == DataFrame::Skeleton)
+    if (type == DataFrame::Color || type == DataFrame::Depth || type == DataFrame::Mask)
     {
          return make_shared<IASLAB_RGBD_ID_Instance>(*instanceInfo);
     }
+    else if (type == DataFrame::Skeleton)
+    {
+        // Only reads the skeleton file
+        return make_shared<IASLAB_RGBD_ID_Instance>(*instanceInfo, true);
+    }
 
     return nullptr;
 }
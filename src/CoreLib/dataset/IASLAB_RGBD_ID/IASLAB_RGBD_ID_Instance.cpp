@@ -4,6 +4,7 @@
 #include "types/DepthFrame.h"
 #include "types/MaskFrame.h"
 #include "types/SkeletonFrame.h"
+#include "types/FrameCodec.h"
 #include "openni/OpenNIDevice.h"
 #include <opencv2/opencv.hpp>
 #include <QFile>
@@ -36,12 +37,13 @@ SkeletonJoint::JointType IASLAB_RGBD_ID_Instance::_staticMap[20] = {
     SkeletonJoint::JOINT_RIGHT_FOOT        // 19
 };
 
-IASLAB_RGBD_ID_Instance::IASLAB_RGBD_ID_Instance(const InstanceInfo &info)
-    : DataInstance(info, DataFrame::Color, -1, -1)
+IASLAB_RGBD_ID_Instance::IASLAB_RGBD_ID_Instance(const InstanceInfo &info, bool skeletonOnly)
+    : DataInstance(info, skeletonOnly ? DataFrame::Skeleton : DataFrame::Color, -1, -1)
 {
     m_width = 640;
     m_height = 480;
     m_open = false;
+    m_skeletonOnly = skeletonOnly;
 }
 
 IASLAB_RGBD_ID_Instance::~IASLAB_RGBD_ID_Instance()
@@ -58,6 +60,10 @@ bool IASLAB_RGBD_ID_Instance::is_open() const
 
 bool IASLAB_RGBD_ID_Instance::hasNext() const
 {
+    // Skeleton-only instances are read once (every sample is a single frame)
+    if (m_skeletonOnly)
+        return DataInstance::hasNext();
+
     return true;
 }
 
@@ -66,6 +72,12 @@ bool IASLAB_RGBD_ID_Instance::openInstance()
     bool result = false;
     QString instancePath = m_info.parent().getPath() + "/";
 
+    if (m_skeletonOnly) {
+        m_open = QFile::exists(instancePath + m_info.getFileName(DataFrame::Skeleton));
+        m_nFrames = 1;
+        return m_open;
+    }
+
     if (QFile::exists(instancePath + m_info.getFileName(DataFrame::Color)) &&
             QFile::exists(instancePath + m_info.getFileName(DataFrame::Depth)) &&
                 QFile::exists(instancePath + m_info.getFileName(DataFrame::Mask)) &&
@@ -88,6 +100,15 @@ void IASLAB_RGBD_ID_Instance::restartInstance()
 
 void IASLAB_RGBD_ID_Instance::nextFrame(QHashDataFrames &output)
 {
+    if (m_skeletonOnly) {
+        shared_ptr<Skeleton> skeleton = readSkeleton();
+        registerSkeleton(*skeleton);
+        shared_ptr<SkeletonFrame> skeletonFrame = make_shared<SkeletonFrame>();
+        skeletonFrame->setSkeleton(1, skeleton);
+        output.insert(DataFrame::Skeleton, skeletonFrame);
+        return;
+    }
+
     // Read Color File
     QString instancePath = m_info.parent().getPath() + "/" + m_info.getFileName(DataFrame::Color);
     cv::Mat color_mat = cv::imread(instancePath.toStdString());
@@ -103,8 +124,18 @@ void IASLAB_RGBD_ID_Instance::nextFrame(QHashDataFrames &output)
     depthFile.open(QIODevice::ReadOnly);
     QByteArray buffer = depthFile.readAll();
     depthFile.close();
-    shared_ptr<DepthFrame> depthFrame_tmp = make_shared<DepthFrame>(640, 480, (uint16_t*) (buffer.data() + 16));
-    shared_ptr<DepthFrame> depthFrame = shared_ptr<DepthFrame>(new DepthFrame(*depthFrame_tmp)); // Clone!
+    shared_ptr<DepthFrame> depthFrame = make_shared<DepthFrame>();
+
+    // PGM of the dataset, or the same frame compressed with FrameCodec (DatasetParser compress)
+    if (FrameCodec::isEncoded(buffer)) {
+        if (!FrameCodec::decode(buffer, *depthFrame, 1))
+            qDebug() << "Corrupt depth file" << instancePath;
+    }
+    else {
+        DepthFrame depthFrame_tmp(640, 480, (uint16_t*) (buffer.data() + 16));
+        *depthFrame = depthFrame_tmp; // Clone!
+    }
+
     depthFrame->setDistanceUnits(dai::DISTANCE_MILIMETERS);
     // Set Depth intrinsics of the camera that generated this frame
     depthFrame->setCameraIntrinsics(fx_d, cx_d, fy_d, cy_d);
@@ -116,10 +147,31 @@ void IASLAB_RGBD_ID_Instance::nextFrame(QHashDataFrames &output)
     maskFile.open(QIODevice::ReadOnly);
     buffer = maskFile.readAll();
     maskFile.close();
-    shared_ptr<MaskFrame> maskFrame_tmp = make_shared<MaskFrame>(640, 480, (uint8_t*) (buffer.data() + 14));
-    shared_ptr<MaskFrame> maskFrame = shared_ptr<MaskFrame>(new MaskFrame(*maskFrame_tmp)); // Clone!
+    shared_ptr<MaskFrame> maskFrame = make_shared<MaskFrame>();
+
+    if (FrameCodec::isEncoded(buffer)) {
+        if (!FrameCodec::decode(buffer, *maskFrame, 1))
+            qDebug() << "Corrupt mask file" << instancePath;
+    }
+    else {
+        MaskFrame maskFrame_tmp(640, 480, (uint8_t*) (buffer.data() + 14));
+        *maskFrame = maskFrame_tmp; // Clone!
+    }
+
     output.insert(DataFrame::Mask, maskFrame);
 
+    // Read Skeleton
+    shared_ptr<Skeleton> skeleton = readSkeleton();
+    shared_ptr<SkeletonFrame> skeletonFrame = make_shared<SkeletonFrame>();
+    skeletonFrame->setSkeleton(1, skeleton);
+    output.insert(DataFrame::Skeleton, skeletonFrame);
+
+    // Register depth to color
+    depth2color(depthFrame, maskFrame, skeleton);
+}
+
+shared_ptr<Skeleton> IASLAB_RGBD_ID_Instance::readSkeleton() const
+{
     // Read Skeleton txt file (line by line)
     /*For every frame, a skeleton file is available. For every joint, a row with the following information is written to the skeleton file:
     [id]: person ID,
@@ -168,12 +220,7 @@ void IASLAB_RGBD_ID_Instance::nextFrame(QHashDataFrames &output)
 
     // Set intrinsics of the camera that generated this frame (depth camera in this case)
     skeleton->setCameraIntrinsics(fx_d, cx_d, fy_d, cy_d);
-    shared_ptr<SkeletonFrame> skeletonFrame = make_shared<SkeletonFrame>();
-    skeletonFrame->setSkeleton(1, skeleton);
-    output.insert(DataFrame::Skeleton, skeletonFrame);
-
-    // Register depth to color
-    depth2color(depthFrame, maskFrame, skeleton);
+    return skeleton;
 }
 
 void IASLAB_RGBD_ID_Instance::depth2color(shared_ptr<DepthFrame> depthFrame, shared_ptr<MaskFrame> mask, shared_ptr<Skeleton> skeleton) const
@@ -222,16 +269,29 @@ void IASLAB_RGBD_ID_Instance::depth2color(shared_ptr<DepthFrame> depthFrame, sha
             p2d.y = (p3d.y * fy_rgb / p3d.z) + cy_rgb;
 
             if (p2d.x >= 0 && p2d.y >= 0 && p2d.x < 640 && p2d.y < 480) {
-                outputDepth->setItem(p2d.y, p2d.x, pDepth[j]);
-                outputMask->setItem(p2d.y, p2d.x, pMask[j]);
+                outputDepth->at(int(p2d.y), int(p2d.x)) = pDepth[j];
+                outputMask->at(int(p2d.y), int(p2d.x)) = pMask[j];
             }
         }
     }
 
     // Transform skeleton
-    skeleton->setCameraIntrinsics(fx_rgb, cx_rgb, fy_rgb, cy_rgb);
+    registerSkeleton(*skeleton);
+
+    *depthFrame = *outputDepth; // Copy
+    *mask = *outputMask; // Copy
+}
 
-    for (SkeletonJoint& joint : skeleton->joints())
+void IASLAB_RGBD_ID_Instance::registerSkeleton(Skeleton& skeleton) const
+{
+    // Translation Transform (millimeters)
+    const glm::vec3 t_vector = {
+        25, 0.0, 0.0
+    };
+
+    skeleton.setCameraIntrinsics(fx_rgb, cx_rgb, fy_rgb, cy_rgb);
+
+    for (SkeletonJoint& joint : skeleton.joints())
     {
         glm::vec3 p3d_skel;
         p3d_skel.x = joint.getPosition()[0];
@@ -240,11 +300,8 @@ void IASLAB_RGBD_ID_Instance::depth2color(shared_ptr<DepthFrame> depthFrame, sha
         // Translate (there is no rotation in this dataset)
         p3d_skel = p3d_skel + t_vector;
         joint.setPosition(Point3f(p3d_skel.x, p3d_skel.y, p3d_skel.z));
-        skeleton->setJoint(joint.getType(), joint);
+        skeleton.setJoint(joint.getType(), joint);
     }
-
-    *depthFrame = *outputDepth; // Copy
-    *mask = *outputMask; // Copy
 }
 
 } // End namespace
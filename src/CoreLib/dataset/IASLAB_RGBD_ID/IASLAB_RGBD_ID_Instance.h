@@ -15,13 +15,18 @@ class IASLAB_RGBD_ID_Instance : public DataInstance
     int  m_width;
     int  m_height;
     bool m_open;
+    bool m_skeletonOnly;
 
 public:
-    explicit IASLAB_RGBD_ID_Instance(const InstanceInfo& info);
+    // A skeleton-only instance does not read the images, it produces only the skeleton frame
+    explicit IASLAB_RGBD_ID_Instance(const InstanceInfo& info, bool skeletonOnly = false);
     virtual ~IASLAB_RGBD_ID_Instance();
     bool is_open() const override;
     bool hasNext() const override;
 
+    // Register depth, mask and skeleton to the colour camera
+    void depth2color(shared_ptr<DepthFrame> depthFrame, shared_ptr<MaskFrame> mask, shared_ptr<Skeleton> skeleton) const;
+
 protected:
     bool openInstance() override;
     void closeInstance() override;
@@ -29,8 +34,8 @@ protected:
     void nextFrame(QHashDataFrames& output) override;
 
 private:
-
-    void depth2color(shared_ptr<DepthFrame> depthFrame, shared_ptr<MaskFrame> mask, shared_ptr<Skeleton> skeleton) const;
+    shared_ptr<Skeleton> readSkeleton() const;
+    void registerSkeleton(Skeleton& skeleton) const;
 
     // RGB Intrinsics
     const double fx_rgb = 525.0f;
@@ -80,6 +80,16 @@ void MSRActionDepthInstance::restartInstance()
     }
 }
 
+// Frames have a fixed size
+bool MSRActionDepthInstance::seekInstance(unsigned int count)
+{
+    if (!m_file.is_open())
+        return false;
+
+    m_file.seekg(streamoff(count) * sizeof(m_readBuffer), ios_base::cur);
+    return m_file.good();
+}
+
 void MSRActionDepthInstance::nextFrame(QHashDataFrames &output)
 {
     Q_ASSERT(output.size() > 0);
@@ -90,6 +100,8 @@ void MSRActionDepthInstance::nextFrame(QHashDataFrames &output)
     m_file.read( (char *) m_readBuffer, sizeof(m_readBuffer) );
 
     for (int y=0; y<m_height; ++y) {
+        uint16_t* outRow = depthFrame->getRowPtr(y);
+
         for (int x=0; x<m_width; ++x)
         {
             // MSR Action3d data is captured from a Kinect like device
@@ -113,7 +125,7 @@ void MSRActionDepthInstance::nextFrame(QHashDataFrames &output)
                 value = 2.0 + normalise<float>(m_readBuffer[y].depthRow[x], 290, 649, 0, 0.9f);
             }*/
 
-            depthFrame->setItem(y, x, value);
+            outRow[x] = value;
         }
     }
 }
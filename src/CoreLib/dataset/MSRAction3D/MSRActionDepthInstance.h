@@ -28,6 +28,7 @@ protected:
     void closeInstance() override;
     void restartInstance() override;
     void nextFrame(QHashDataFrames& output) override;
+    bool seekInstance(unsigned int count) override;
 
 private:
     static uint16_t _distances_table[2048];
@@ -71,6 +71,7 @@ void MSRDailyColorInstance::nextFrame(QHashDataFrames &output)
     QMutexLocker locker(&m_lockFrame);
 
     if (m_readFrame->isValid()) {
+        setTimestamp(m_readFrame->startTime()); // -1 if the decoder does not provide it
         m_readFrame->map(QAbstractVideoBuffer::ReadOnly);
         if (m_readFrame->isMapped()) {
             memcpy( (void*) colorFrame->getDataPtr(), m_readFrame->bits(), m_readFrame->mappedBytes());
@@ -69,6 +69,16 @@ void MSRDailyDepthInstance::restartInstance()
     }
 }
 
+// Frames have a fixed size
+bool MSRDailyDepthInstance::seekInstance(unsigned int count)
+{
+    if (!m_file.is_open())
+        return false;
+
+    m_file.seekg(streamoff(count) * sizeof(m_readBuffer), ios_base::cur);
+    return m_file.good();
+}
+
 void MSRDailyDepthInstance::nextFrame(QHashDataFrames &output)
 {
     Q_ASSERT(output.size() > 0);
@@ -79,11 +89,13 @@ void MSRDailyDepthInstance::nextFrame(QHashDataFrames &output)
     m_file.read( (char *) m_readBuffer, sizeof(m_readBuffer) );
 
     for (int y=0; y<m_height; ++y) {
+        uint16_t* outRow = depthFrame->getRowPtr(y);
+
         for (int x=0; x<m_width; ++x)
         {
             // I assume data is captured with Kinect SDK, so...
             // Kinect SDK provide depth values between 0 and 4000 in mm.
-            depthFrame->setItem(y, x, m_readBuffer[y].depthRow[x]);
+            outRow[x] = m_readBuffer[y].depthRow[x];
         }
     }
 }
@@ -28,6 +28,7 @@ protected:
     void closeInstance() override;
     void restartInstance() override;
     void nextFrame(QHashDataFrames& output) override;
+    bool seekInstance(unsigned int count) override;
 
 private:
     ifstream    m_file;
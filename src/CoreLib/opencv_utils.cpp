@@ -1,4 +1,6 @@
 #include "opencv_utils.h"
+#include "opencv_utils_simd.h"
+#include <cstring>
 
 namespace dai {
 
@@ -32,34 +34,14 @@ void colorImageWithMask(cv::Mat input_img, cv::Mat output_img, cv::Mat upper_mas
 cv::Mat computeIntegralImage(cv::Mat image)
 {
     using namespace cv;
-    Mat lookup = Mat::zeros(image.rows, image.cols, CV_32SC1);
+    Mat lookup(image.rows, image.cols, CV_32SC1);
+    const int32_t* prevMatrixRow = nullptr;
 
-    // Compute first row
-    Vec3b* pixel = image.ptr<Vec3b>(0);
-    uint32_t* value = lookup.ptr<uint32_t>(0);
-    value[0] = pixel[0][0];
-
-    for (int i=1; i<image.cols; ++i) {
-        value[i] = pixel[i][0] + value[i-1];
-    }
-
-    // Compute first column
-    for (int i=1; i<image.rows; ++i) {
-        lookup.at<uint32_t>(i, 0) = image.at<Vec3b>(i, 0)[0] + lookup.at<uint32_t>(i-1, 0);
-    }
-
-    uint32_t* prevMatrixRow = value;
-
-    // Compute Matrix
-    for (int i=1; i<image.rows; ++i)
+    // Each row is the prefix sum of the row plus the previous row
+    for (int i=0; i<image.rows; ++i)
     {
-        Vec3b* pPixelRow = image.ptr<Vec3b>(i);
-        uint32_t* pMatrixRow = lookup.ptr<uint32_t>(i);
-
-        for (int j=1; j<image.cols; ++j) {
-            pMatrixRow[j] = pPixelRow[j][0] + pMatrixRow[j-1] + prevMatrixRow[j] - prevMatrixRow[j-1];
-        }
-
+        int32_t* pMatrixRow = lookup.ptr<int32_t>(i);
+        simd::integralImageRow(image.ptr<uchar>(i), prevMatrixRow, pMatrixRow, image.cols);
         prevMatrixRow = pMatrixRow;
     }
 
@@ -90,16 +72,9 @@ double computeOccupancy(shared_ptr<MaskFrame> mask, int *outNumPixels)
     return occupancy;
 }
 
-void computeUpperAndLowerMasks(const cv::Mat& input_img, cv::Mat& upper_mask, cv::Mat& lower_mask, const cv::Mat mask)
+// Rows and columns (as [begin, end) ranges) of the upper and lower parts of the body
+static void computeBodyRegions(int rows, int cols, int upper[4], int lower[4])
 {
-    Q_ASSERT( (mask.rows == 0 && mask.cols == 0) || (mask.rows == input_img.rows && mask.cols == input_img.cols) );
-
-    using namespace cv;
-
-    bool useMask = mask.rows > 0 && mask.cols > 0;
-    upper_mask = Mat::zeros(input_img.rows, input_img.cols, CV_8UC1);
-    lower_mask = Mat::zeros(input_img.rows, input_img.cols, CV_8UC1);
-
     // For My Capture
     /*float margins[][2] = {
         0.24f, 0.17f,
@@ -116,30 +91,83 @@ void computeUpperAndLowerMasks(const cv::Mat& input_img, cv::Mat& upper_mask, cv
         0.95f, 0.85f
     };
 
+    // Same comparisons as before: row >= rows*m0 && row < rows*m1, col > cols*m0 && col < cols*m1
+    int* regions[] = {upper, lower};
+
+    for (int k=0; k<2; ++k) {
+        regions[k][0] = dai::max<int>(0, std::ceil(rows * margins[2*k][0]));
+        regions[k][1] = dai::min<int>(rows, std::ceil(rows * margins[2*k+1][0]));
+        regions[k][2] = dai::max<int>(0, std::floor(cols * margins[2*k][1]) + 1);
+        regions[k][3] = dai::min<int>(cols, std::ceil(cols * margins[2*k+1][1]));
+    }
+}
+
+// When histograms are given, the 8-8-4 indexed histogram of each part is accumulated in the
+// same pass, so neither the indexed image nor a second scan of the masks is needed
+static void computeBodyMasks(const cv::Mat& input_img, cv::Mat& upper_mask, cv::Mat& lower_mask, const cv::Mat& mask,
+                             int* upper_hist, int* lower_hist)
+{
+    using namespace cv;
+
+    bool useMask = mask.rows > 0 && mask.cols > 0;
+    upper_mask = Mat::zeros(input_img.rows, input_img.cols, CV_8UC1);
+    lower_mask = Mat::zeros(input_img.rows, input_img.cols, CV_8UC1);
+
+    int upper[4], lower[4];
+    computeBodyRegions(input_img.rows, input_img.cols, upper, lower);
+
     for (int i=0; i<input_img.rows; ++i)
     {
-        uchar* uMask = upper_mask.ptr<uchar>(i);
-        uchar* lMask = lower_mask.ptr<uchar>(i);
-        const uchar* maskPixel = useMask ? mask.ptr<uchar>(i) : nullptr;
-
-        for (int j=0; j<input_img.cols; ++j)
-        {
-            if (useMask && maskPixel[j] <= 0)
-                continue;
-
-            if (i >= input_img.rows * margins[0][0] && i < input_img.rows * margins[1][0]) {
-                if (j > input_img.cols * margins[0][1] && j < input_img.cols * margins[1][1]) {
-                    uMask[j] = 1;
-                }
-            } else if (i >= input_img.rows * margins[2][0] && i < input_img.rows * margins[3][0]) {
-                if (j > input_img.cols * margins[2][1] && j < input_img.cols * margins[3][1]) {
-                    lMask[j] = 1;
-                }
-            }
+        const int* region;
+        uchar* outMask;
+        int* hist;
+
+        // Upper part has priority when both overlap
+        if (i >= upper[0] && i < upper[1]) {
+            region = upper;
+            outMask = upper_mask.ptr<uchar>(i);
+            hist = upper_hist;
+        } else if (i >= lower[0] && i < lower[1]) {
+            region = lower;
+            outMask = lower_mask.ptr<uchar>(i);
+            hist = lower_hist;
+        } else {
+            continue;
         }
+
+        const int begin = region[2];
+        const int length = region[3] - begin;
+
+        if (length <= 0)
+            continue;
+
+        if (useMask)
+            simd::binaryMaskRow(mask.ptr<uchar>(i) + begin, outMask + begin, length);
+        else
+            memset(outMask + begin, 1, length);
+
+        if (hist)
+            simd::accumulateIndexed884Row(input_img.ptr<uchar>(i) + 3 * begin, outMask + begin, length, hist);
     }
 }
 
+void computeUpperAndLowerMasks(const cv::Mat& input_img, cv::Mat& upper_mask, cv::Mat& lower_mask, const cv::Mat mask)
+{
+    Q_ASSERT( (mask.rows == 0 && mask.cols == 0) || (mask.rows == input_img.rows && mask.cols == input_img.cols) );
+    computeBodyMasks(input_img, upper_mask, lower_mask, mask, nullptr, nullptr);
+}
+
+void computeUpperAndLowerHist884(const cv::Mat& input_img, cv::Mat& upper_mask, cv::Mat& lower_mask,
+                                 int upper_hist[256], int lower_hist[256], const cv::Mat mask)
+{
+    Q_ASSERT(input_img.type() == CV_8UC3);
+    Q_ASSERT( (mask.rows == 0 && mask.cols == 0) || (mask.rows == input_img.rows && mask.cols == input_img.cols) );
+
+    memset(upper_hist, 0, 256 * sizeof(int));
+    memset(lower_hist, 0, 256 * sizeof(int));
+    computeBodyMasks(input_img, upper_mask, lower_mask, mask, upper_hist, lower_hist);
+}
+
 void convertIndexed8842RGB(const cv::Mat& indexed_img, cv::Mat& output_img)
 {
     Q_ASSERT(output_img.data == nullptr ||
@@ -199,22 +227,10 @@ void convertIndexed1616162RGB(const cv::Mat& indexed_img, cv::Mat& output_img)
 // Convert a RGB image to 8-8-4 levels RGB
 cv::Mat convertRGB2Indexed884(const cv::Mat& inputImg)
 {
-    using namespace cv;
-
-    Mat outputImg = cv::Mat::zeros(inputImg.rows, inputImg.cols, CV_8UC1);
-
-    for (int i=0; i<inputImg.rows; ++i)
-    {
-        const Vec3b* in_pixel = inputImg.ptr<Vec3b>(i);
-        uchar* out_pixel = outputImg.ptr<uchar>(i);
+    cv::Mat outputImg(inputImg.rows, inputImg.cols, CV_8UC1);
 
-        for (int j=0; j<inputImg.cols; ++j)
-        {
-            uchar level_red = in_pixel[j][0] / 32; // 256 / 8
-            uchar level_green = in_pixel[j][1] / 32; // 256 / 8
-            uchar level_blue = in_pixel[j][2] / 64; // 256 / 4
-            out_pixel[j] = 32 * level_red + 4 * level_green + level_blue;
-        }
+    for (int i=0; i<inputImg.rows; ++i) {
+        simd::rgb2Indexed884Row(inputImg.ptr<uchar>(i), outputImg.ptr<uchar>(i), inputImg.cols);
     }
 
     return outputImg;
@@ -223,22 +239,10 @@ cv::Mat convertRGB2Indexed884(const cv::Mat& inputImg)
 // Convert a RGB image to 16-16-16 levels RGB
 cv::Mat convertRGB2Indexed161616(const cv::Mat& inputImg)
 {
-    using namespace cv;
+    cv::Mat outputImg(inputImg.rows, inputImg.cols, CV_16UC1);
 
-    Mat outputImg = cv::Mat::zeros(inputImg.rows, inputImg.cols, CV_16UC1);
-
-    for (int i=0; i<inputImg.rows; ++i)
-    {
-        const Vec3b* in_pixel = inputImg.ptr<Vec3b>(i);
-        ushort* out_pixel = outputImg.ptr<ushort>(i);
-
-        for (int j=0; j<inputImg.cols; ++j)
-        {
-            uchar level_red = in_pixel[j][0] / 16; // 256 / 16
-            uchar level_green = in_pixel[j][1] / 16; // 256 / 16
-            uchar level_blue = in_pixel[j][2] / 16; // 256 / 16
-            out_pixel[j] = 256 * level_red + 16 * level_green + level_blue;
-        }
+    for (int i=0; i<inputImg.rows; ++i) {
+        simd::rgb2Indexed161616Row(inputImg.ptr<uchar>(i), outputImg.ptr<ushort>(i), inputImg.cols);
     }
 
     return outputImg;
@@ -246,20 +250,13 @@ cv::Mat convertRGB2Indexed161616(const cv::Mat& inputImg)
 
 cv::Mat convertRGB2Log2DAsMat(const cv::Mat &inputImg)
 {
-    cv::Mat outputImg = cv::Mat::zeros(inputImg.rows, inputImg.cols, CV_32FC2);
+    cv::Mat outputImg(inputImg.rows, inputImg.cols, CV_32FC2);
 
-    for (int i=0; i<inputImg.rows; ++i)
-    {
-        const cv::Vec3b* inPixel = inputImg.ptr<cv::Vec3b>(i);
-        cv::Vec2f* outPixel = outputImg.ptr<cv::Vec2f>(i);
-
-        for (int j=0; j<inputImg.cols; ++j) {
-            // Approach: Consider RGB colors from 1 to 256
-            // min color: log(1/256) ~ -5.6
-            // max color: log(256/1) ~ 5.6
-            outPixel[j][0] = std::log( float(inPixel[j][0]+1) / float(inPixel[j][1]+1) ); // log ( R/G )
-            outPixel[j][1] = std::log( float(inPixel[j][2]+1) / float(inPixel[j][1]+1) ); // log ( B/G )
-        }
+    // Approach: Consider RGB colors from 1 to 256
+    // min color: log(1/256) ~ -5.6
+    // max color: log(256/1) ~ 5.6
+    for (int i=0; i<inputImg.rows; ++i) {
+        simd::rgb2Log2DRow(inputImg.ptr<uchar>(i), outputImg.ptr<float>(i), inputImg.cols);
     }
 
     return outputImg;
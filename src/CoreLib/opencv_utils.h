@@ -21,6 +21,11 @@ double computeOccupancy(shared_ptr<MaskFrame> mask, int *outNumPixels = nullptr)
 
 void computeUpperAndLowerMasks(const cv::Mat& input_img, cv::Mat& upper_mask, cv::Mat& lower_mask, const cv::Mat mask = cv::Mat());
 
+// Same masks as computeUpperAndLowerMasks() plus the 8-8-4 indexed histogram (256 bins) of each
+// part, computed in a single pass over the image
+void computeUpperAndLowerHist884(const cv::Mat& input_img, cv::Mat& upper_mask, cv::Mat& lower_mask,
+                                 int upper_hist[256], int lower_hist[256], const cv::Mat mask = cv::Mat());
+
 void convertIndexed8842RGB(const cv::Mat& indexed_img, cv::Mat& output_img);
 
 void convertIndexed1616162RGB(const cv::Mat& indexed_img, cv::Mat& output_img);
@@ -0,0 +1,743 @@
+#include "opencv_utils_simd.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DAI_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need the target attribute to emit SSSE3/AVX2 code without compiling the
+// whole library with -mavx2. MSVC emits any intrinsic.
+#if defined(__GNUC__)
+#define DAI_TARGET(x) __attribute__((target(x)))
+#else
+#define DAI_TARGET(x)
+#endif
+
+namespace dai {
+
+namespace {
+
+struct SimdKernels {
+    void (*rgb2Indexed884)(const uint8_t*, uint8_t*, int);
+    void (*rgb2Indexed161616)(const uint8_t*, uint16_t*, int);
+    void (*rgb2Log2D)(const uint8_t*, float*, int);
+    void (*integralImage)(const uint8_t*, const int32_t*, int32_t*, int);
+    void (*binaryMask)(const uint8_t*, uint8_t*, int);
+    void (*narrowLabels)(const int16_t*, uint8_t*, int);
+    void (*bgra2Rgb)(const uint8_t*, uint8_t*, int);
+    void (*rgb2Bgra)(const uint8_t*, uint8_t*, int);
+    void (*scaleU16ToU8)(const uint16_t*, uint8_t*, int, float);
+};
+
+// log(k+1) for every possible channel value, so log(a/b) = logTable[a] - logTable[b]
+struct LogTable {
+    float values[256];
+    LogTable() {
+        for (int i=0; i<256; ++i)
+            values[i] = std::log(float(i+1));
+    }
+};
+
+const float* logTable()
+{
+    static const LogTable table;
+    return table.values;
+}
+
+/* Scalar (reference) kernels */
+void rgb2Indexed884_scalar(const uint8_t* rgb, uint8_t* out, int n)
+{
+    for (int j=0; j<n; ++j, rgb+=3)
+        out[j] = 32 * (rgb[0] / 32) + 4 * (rgb[1] / 32) + rgb[2] / 64;
+}
+
+void rgb2Indexed161616_scalar(const uint8_t* rgb, uint16_t* out, int n)
+{
+    for (int j=0; j<n; ++j, rgb+=3)
+        out[j] = 256 * (rgb[0] / 16) + 16 * (rgb[1] / 16) + rgb[2] / 16;
+}
+
+void rgb2Log2D_scalar(const uint8_t* rgb, float* out, int n)
+{
+    for (int j=0; j<n; ++j, rgb+=3) {
+        out[2*j] = std::log( float(rgb[0]+1) / float(rgb[1]+1) );
+        out[2*j+1] = std::log( float(rgb[2]+1) / float(rgb[1]+1) );
+    }
+}
+
+void rgb2Log2D_table(const uint8_t* rgb, float* out, int n)
+{
+    const float* table = logTable();
+
+    for (int j=0; j<n; ++j, rgb+=3) {
+        out[2*j] = table[rgb[0]] - table[rgb[1]];
+        out[2*j+1] = table[rgb[2]] - table[rgb[1]];
+    }
+}
+
+void integralImage_scalar(const uint8_t* rgb, const int32_t* prev, int32_t* out, int n)
+{
+    uint32_t sum = 0;
+
+    for (int j=0; j<n; ++j, rgb+=3) {
+        sum += rgb[0];
+        out[j] = prev ? int32_t(sum + uint32_t(prev[j])) : int32_t(sum);
+    }
+}
+
+void binaryMask_scalar(const uint8_t* mask, uint8_t* out, int n)
+{
+    for (int j=0; j<n; ++j)
+        out[j] = mask[j] > 0 ? 1 : 0;
+}
+
+void narrowLabels_scalar(const int16_t* labels, uint8_t* out, int n)
+{
+    for (int j=0; j<n; ++j)
+        out[j] = uint8_t(labels[j]);
+}
+
+void bgra2Rgb_scalar(const uint8_t* bgra, uint8_t* rgb, int n)
+{
+    for (int j=0; j<n; ++j, bgra+=4, rgb+=3) {
+        rgb[0] = bgra[2];
+        rgb[1] = bgra[1];
+        rgb[2] = bgra[0];
+    }
+}
+
+void rgb2Bgra_scalar(const uint8_t* rgb, uint8_t* bgra, int n)
+{
+    for (int j=0; j<n; ++j, rgb+=3, bgra+=4) {
+        bgra[0] = rgb[2];
+        bgra[1] = rgb[1];
+        bgra[2] = rgb[0];
+        bgra[3] = 255;
+    }
+}
+
+// Rounded to nearest even, as the SIMD conversions do
+void scaleU16ToU8_scalar(const uint16_t* in, uint8_t* out, int n, float scale)
+{
+    for (int j=0; j<n; ++j) {
+        const float value = float(in[j]) * scale;
+        out[j] = uint8_t(std::lrint(value < 255.0f ? value : 255.0f));
+    }
+}
+
+const SimdKernels scalarKernels = {
+    rgb2Indexed884_scalar,
+    rgb2Indexed161616_scalar,
+    rgb2Log2D_scalar,
+    integralImage_scalar,
+    binaryMask_scalar,
+    narrowLabels_scalar,
+    bgra2Rgb_scalar,
+    rgb2Bgra_scalar,
+    scaleU16ToU8_scalar
+};
+
+#ifdef DAI_SIMD_X86
+
+/* SSSE3 kernels */
+
+// Split 16 packed RGB pixels (48 bytes) into three planes
+DAI_TARGET("ssse3")
+inline void deinterleave16(const uint8_t* rgb, __m128i& r, __m128i& g, __m128i& b)
+{
+    const __m128i a0 = _mm_loadu_si128((const __m128i*) rgb);
+    const __m128i a1 = _mm_loadu_si128((const __m128i*) (rgb + 16));
+    const __m128i a2 = _mm_loadu_si128((const __m128i*) (rgb + 32));
+
+    r = _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+        _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+
+    g = _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(a0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+        _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+
+    b = _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(a0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+        _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+// First channel of 16 packed RGB pixels
+DAI_TARGET("ssse3")
+inline __m128i firstChannel16(const uint8_t* rgb)
+{
+    const __m128i a0 = _mm_loadu_si128((const __m128i*) rgb);
+    const __m128i a1 = _mm_loadu_si128((const __m128i*) (rgb + 16));
+    const __m128i a2 = _mm_loadu_si128((const __m128i*) (rgb + 32));
+
+    return _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+        _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+}
+
+// SSE has no 8 bits shifts. 16 bits shifts are used and bits coming from the
+// neighbour byte are removed with the mask.
+DAI_TARGET("ssse3")
+void rgb2Indexed884_ssse3(const uint8_t* rgb, uint8_t* out, int n)
+{
+    const __m128i maskRed = _mm_set1_epi8(char(0xE0));
+    const __m128i maskGreen = _mm_set1_epi8(0x1C);
+    const __m128i maskBlue = _mm_set1_epi8(0x03);
+    int j = 0;
+
+    for (; j+16 <= n; j+=16) {
+        __m128i r, g, b;
+        deinterleave16(rgb + 3*j, r, g, b);
+        __m128i value = _mm_or_si128(_mm_and_si128(r, maskRed),
+                        _mm_or_si128(_mm_and_si128(_mm_srli_epi16(g, 3), maskGreen),
+                                     _mm_and_si128(_mm_srli_epi16(b, 6), maskBlue)));
+        _mm_storeu_si128((__m128i*) (out + j), value);
+    }
+
+    rgb2Indexed884_scalar(rgb + 3*j, out + j, n - j);
+}
+
+DAI_TARGET("ssse3")
+void rgb2Indexed161616_ssse3(const uint8_t* rgb, uint16_t* out, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maskLevel = _mm_set1_epi16(0xF0);
+    int j = 0;
+
+    for (; j+16 <= n; j+=16) {
+        __m128i r, g, b;
+        deinterleave16(rgb + 3*j, r, g, b);
+
+        __m128i r16 = _mm_unpacklo_epi8(r, zero);
+        __m128i g16 = _mm_unpacklo_epi8(g, zero);
+        __m128i b16 = _mm_unpacklo_epi8(b, zero);
+        __m128i value = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(r16, maskLevel), 4),
+                        _mm_or_si128(_mm_and_si128(g16, maskLevel), _mm_srli_epi16(b16, 4)));
+        _mm_storeu_si128((__m128i*) (out + j), value);
+
+        r16 = _mm_unpackhi_epi8(r, zero);
+        g16 = _mm_unpackhi_epi8(g, zero);
+        b16 = _mm_unpackhi_epi8(b, zero);
+        value = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(r16, maskLevel), 4),
+                _mm_or_si128(_mm_and_si128(g16, maskLevel), _mm_srli_epi16(b16, 4)));
+        _mm_storeu_si128((__m128i*) (out + j + 8), value);
+    }
+
+    rgb2Indexed161616_scalar(rgb + 3*j, out + j, n - j);
+}
+
+// Prefix sum of four int32 plus the carry of the previous ones
+DAI_TARGET("ssse3")
+inline __m128i prefixSum4(__m128i x, __m128i carry)
+{
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+    return _mm_add_epi32(x, carry);
+}
+
+DAI_TARGET("ssse3")
+void integralImage_ssse3(const uint8_t* rgb, const int32_t* prev, int32_t* out, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i carry = zero;
+    int j = 0;
+
+    for (; j+16 <= n; j+=16)
+    {
+        const __m128i channel = firstChannel16(rgb + 3*j);
+        const __m128i lo = _mm_unpacklo_epi8(channel, zero);
+        const __m128i hi = _mm_unpacklo_epi8(_mm_srli_si128(channel, 8), zero);
+        __m128i values[4] = {
+            _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+            _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)
+        };
+
+        for (int k=0; k<4; ++k) {
+            __m128i sum = prefixSum4(values[k], carry);
+            carry = _mm_shuffle_epi32(sum, 0xFF);
+
+            if (prev)
+                sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i*) (prev + j + 4*k)));
+
+            _mm_storeu_si128((__m128i*) (out + j + 4*k), sum);
+        }
+    }
+
+    // Remaining pixels
+    uint32_t sum = uint32_t(_mm_cvtsi128_si32(carry));
+
+    for (; j<n; ++j) {
+        sum += rgb[3*j];
+        out[j] = prev ? int32_t(sum + uint32_t(prev[j])) : int32_t(sum);
+    }
+}
+
+DAI_TARGET("ssse3")
+void binaryMask_ssse3(const uint8_t* mask, uint8_t* out, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    int j = 0;
+
+    for (; j+16 <= n; j+=16) {
+        __m128i isZero = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (mask + j)), zero);
+        _mm_storeu_si128((__m128i*) (out + j), _mm_andnot_si128(isZero, one));
+    }
+
+    binaryMask_scalar(mask + j, out + j, n - j);
+}
+
+// The high byte is cleared first, so the saturated pack truncates as the scalar version
+DAI_TARGET("ssse3")
+void narrowLabels_ssse3(const int16_t* labels, uint8_t* out, int n)
+{
+    const __m128i lowByte = _mm_set1_epi16(0xFF);
+    int j = 0;
+
+    for (; j+16 <= n; j+=16) {
+        const __m128i lo = _mm_and_si128(_mm_loadu_si128((const __m128i*) (labels + j)), lowByte);
+        const __m128i hi = _mm_and_si128(_mm_loadu_si128((const __m128i*) (labels + j + 8)), lowByte);
+        _mm_storeu_si128((__m128i*) (out + j), _mm_packus_epi16(lo, hi));
+    }
+
+    narrowLabels_scalar(labels + j, out + j, n - j);
+}
+
+// 4 pixels are shuffled into 12 bytes and the 4 results are merged into 48 bytes
+DAI_TARGET("ssse3")
+void bgra2Rgb_ssse3(const uint8_t* bgra, uint8_t* rgb, int n)
+{
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    int j = 0;
+
+    for (; j+16 <= n; j+=16, bgra+=64, rgb+=48) {
+        const __m128i p0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) bgra), shuffle);
+        const __m128i p1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (bgra + 16)), shuffle);
+        const __m128i p2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (bgra + 32)), shuffle);
+        const __m128i p3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (bgra + 48)), shuffle);
+        _mm_storeu_si128((__m128i*) rgb, _mm_or_si128(p0, _mm_slli_si128(p1, 12)));
+        _mm_storeu_si128((__m128i*) (rgb + 16), _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8)));
+        _mm_storeu_si128((__m128i*) (rgb + 32), _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4)));
+    }
+
+    bgra2Rgb_scalar(bgra, rgb, n - j);
+}
+
+DAI_TARGET("ssse3")
+void rgb2Bgra_ssse3(const uint8_t* rgb, uint8_t* bgra, int n)
+{
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i alpha = _mm_set1_epi32(int(0xFF000000));
+    int j = 0;
+
+    for (; j+16 <= n; j+=16, rgb+=48, bgra+=64) {
+        const __m128i a0 = _mm_loadu_si128((const __m128i*) rgb);
+        const __m128i a1 = _mm_loadu_si128((const __m128i*) (rgb + 16));
+        const __m128i a2 = _mm_loadu_si128((const __m128i*) (rgb + 32));
+        const __m128i p0 = a0;
+        const __m128i p1 = _mm_alignr_epi8(a1, a0, 12);
+        const __m128i p2 = _mm_alignr_epi8(a2, a1, 8);
+        const __m128i p3 = _mm_srli_si128(a2, 4);
+        _mm_storeu_si128((__m128i*) bgra, _mm_or_si128(_mm_shuffle_epi8(p0, shuffle), alpha));
+        _mm_storeu_si128((__m128i*) (bgra + 16), _mm_or_si128(_mm_shuffle_epi8(p1, shuffle), alpha));
+        _mm_storeu_si128((__m128i*) (bgra + 32), _mm_or_si128(_mm_shuffle_epi8(p2, shuffle), alpha));
+        _mm_storeu_si128((__m128i*) (bgra + 48), _mm_or_si128(_mm_shuffle_epi8(p3, shuffle), alpha));
+    }
+
+    rgb2Bgra_scalar(rgb, bgra, n - j);
+}
+
+// Values are clamped as floats, so the saturated packs never see out of range numbers
+DAI_TARGET("ssse3")
+void scaleU16ToU8_ssse3(const uint16_t* in, uint8_t* out, int n, float scale)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 factor = _mm_set1_ps(scale);
+    const __m128 maxValue = _mm_set1_ps(255.0f);
+    int j = 0;
+
+    for (; j+16 <= n; j+=16) {
+        const __m128i v0 = _mm_loadu_si128((const __m128i*) (in + j));
+        const __m128i v1 = _mm_loadu_si128((const __m128i*) (in + j + 8));
+        __m128i r[4];
+        const __m128i words[4] = {_mm_unpacklo_epi16(v0, zero), _mm_unpackhi_epi16(v0, zero),
+                                  _mm_unpacklo_epi16(v1, zero), _mm_unpackhi_epi16(v1, zero)};
+
+        for (int k=0; k<4; ++k) {
+            const __m128 value = _mm_min_ps(_mm_mul_ps(_mm_cvtepi32_ps(words[k]), factor), maxValue);
+            r[k] = _mm_cvtps_epi32(value);
+        }
+
+        const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(r[0], r[1]), _mm_packs_epi32(r[2], r[3]));
+        _mm_storeu_si128((__m128i*) (out + j), packed);
+    }
+
+    scaleU16ToU8_scalar(in + j, out + j, n - j, scale);
+}
+
+const SimdKernels ssse3Kernels = {
+    rgb2Indexed884_ssse3,
+    rgb2Indexed161616_ssse3,
+    rgb2Log2D_table,
+    integralImage_ssse3,
+    binaryMask_ssse3,
+    narrowLabels_ssse3,
+    bgra2Rgb_ssse3,
+    rgb2Bgra_ssse3,
+    scaleU16ToU8_ssse3
+};
+
+/* AVX2 kernels */
+
+DAI_TARGET("avx2")
+inline __m256i combine128(__m128i lo, __m128i hi)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+DAI_TARGET("avx2")
+void rgb2Indexed884_avx2(const uint8_t* rgb, uint8_t* out, int n)
+{
+    const __m256i maskRed = _mm256_set1_epi8(char(0xE0));
+    const __m256i maskGreen = _mm256_set1_epi8(0x1C);
+    const __m256i maskBlue = _mm256_set1_epi8(0x03);
+    int j = 0;
+
+    for (; j+32 <= n; j+=32) {
+        __m128i r0, g0, b0, r1, g1, b1;
+        deinterleave16(rgb + 3*j, r0, g0, b0);
+        deinterleave16(rgb + 3*j + 48, r1, g1, b1);
+        const __m256i r = combine128(r0, r1);
+        const __m256i g = combine128(g0, g1);
+        const __m256i b = combine128(b0, b1);
+        __m256i value = _mm256_or_si256(_mm256_and_si256(r, maskRed),
+                        _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(g, 3), maskGreen),
+                                        _mm256_and_si256(_mm256_srli_epi16(b, 6), maskBlue)));
+        _mm256_storeu_si256((__m256i*) (out + j), value);
+    }
+
+    rgb2Indexed884_ssse3(rgb + 3*j, out + j, n - j);
+}
+
+DAI_TARGET("avx2")
+void rgb2Indexed161616_avx2(const uint8_t* rgb, uint16_t* out, int n)
+{
+    const __m256i maskLevel = _mm256_set1_epi16(0xF0);
+    int j = 0;
+
+    for (; j+16 <= n; j+=16) {
+        __m128i r, g, b;
+        deinterleave16(rgb + 3*j, r, g, b);
+        const __m256i r16 = _mm256_cvtepu8_epi16(r);
+        const __m256i g16 = _mm256_cvtepu8_epi16(g);
+        const __m256i b16 = _mm256_cvtepu8_epi16(b);
+        __m256i value = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(r16, maskLevel), 4),
+                        _mm256_or_si256(_mm256_and_si256(g16, maskLevel), _mm256_srli_epi16(b16, 4)));
+        _mm256_storeu_si256((__m256i*) (out + j), value);
+    }
+
+    rgb2Indexed161616_scalar(rgb + 3*j, out + j, n - j);
+}
+
+// Log table is gathered for 8 pixels at a time
+DAI_TARGET("avx2")
+void rgb2Log2D_avx2(const uint8_t* rgb, float* out, int n)
+{
+    const float* table = logTable();
+    int j = 0;
+
+    for (; j+16 <= n; j+=16)
+    {
+        __m128i r, g, b;
+        deinterleave16(rgb + 3*j, r, g, b);
+
+        for (int half=0; half<2; ++half)
+        {
+            const __m256 logR = _mm256_i32gather_ps(table, _mm256_cvtepu8_epi32(r), 4);
+            const __m256 logG = _mm256_i32gather_ps(table, _mm256_cvtepu8_epi32(g), 4);
+            const __m256 logB = _mm256_i32gather_ps(table, _mm256_cvtepu8_epi32(b), 4);
+            const __m256 rg = _mm256_sub_ps(logR, logG);
+            const __m256 bg = _mm256_sub_ps(logB, logG);
+
+            // Interleave as (R/G, B/G) pairs
+            const __m256 lo = _mm256_unpacklo_ps(rg, bg);
+            const __m256 hi = _mm256_unpackhi_ps(rg, bg);
+            float* dst = out + 2*(j + 8*half);
+            _mm256_storeu_ps(dst, _mm256_permute2f128_ps(lo, hi, 0x20));
+            _mm256_storeu_ps(dst + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+
+            r = _mm_srli_si128(r, 8);
+            g = _mm_srli_si128(g, 8);
+            b = _mm_srli_si128(b, 8);
+        }
+    }
+
+    rgb2Log2D_table(rgb + 3*j, out + 2*j, n - j);
+}
+
+DAI_TARGET("avx2")
+void binaryMask_avx2(const uint8_t* mask, uint8_t* out, int n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    int j = 0;
+
+    for (; j+32 <= n; j+=32) {
+        __m256i isZero = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (mask + j)), zero);
+        _mm256_storeu_si256((__m256i*) (out + j), _mm256_andnot_si256(isZero, one));
+    }
+
+    binaryMask_scalar(mask + j, out + j, n - j);
+}
+
+// AVX2 packs each 128 bits lane on its own, the permutation puts the lanes back in order
+DAI_TARGET("avx2")
+void narrowLabels_avx2(const int16_t* labels, uint8_t* out, int n)
+{
+    const __m256i lowByte = _mm256_set1_epi16(0xFF);
+    int j = 0;
+
+    for (; j+32 <= n; j+=32) {
+        const __m256i lo = _mm256_and_si256(_mm256_loadu_si256((const __m256i*) (labels + j)), lowByte);
+        const __m256i hi = _mm256_and_si256(_mm256_loadu_si256((const __m256i*) (labels + j + 16)), lowByte);
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+        _mm256_storeu_si256((__m256i*) (out + j), packed);
+    }
+
+    narrowLabels_ssse3(labels + j, out + j, n - j);
+}
+
+DAI_TARGET("avx2")
+void scaleU16ToU8_avx2(const uint16_t* in, uint8_t* out, int n, float scale)
+{
+    const __m256 factor = _mm256_set1_ps(scale);
+    const __m256 maxValue = _mm256_set1_ps(255.0f);
+    int j = 0;
+
+    for (; j+16 <= n; j+=16) {
+        const __m256i lo = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (in + j)));
+        const __m256i hi = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (in + j + 8)));
+        const __m256i r0 = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(lo), factor), maxValue));
+        const __m256i r1 = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(hi), factor), maxValue));
+        // Packs work per lane, so the 64 bits blocks are reordered after each one
+        const __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(r0, r1), 0xD8);
+        const __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+        _mm_storeu_si128((__m128i*) (out + j), _mm256_castsi256_si128(bytes));
+    }
+
+    scaleU16ToU8_ssse3(in + j, out + j, n - j, scale);
+}
+
+// The integral image is bound by the prefix dependency, AVX2 doesn't improve SSSE3 there.
+// Neither do the BGRA conversions, which are bound by memory
+const SimdKernels avx2Kernels = {
+    rgb2Indexed884_avx2,
+    rgb2Indexed161616_avx2,
+    rgb2Log2D_avx2,
+    integralImage_ssse3,
+    binaryMask_avx2,
+    narrowLabels_avx2,
+    bgra2Rgb_ssse3,
+    rgb2Bgra_ssse3,
+    scaleU16ToU8_avx2
+};
+
+SimdLevel detectSimdLevel()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    else if (__builtin_cpu_supports("ssse3"))
+        return SIMD_SSSE3;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+
+    if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+            return SIMD_AVX2;
+    }
+
+    if (ssse3)
+        return SIMD_SSSE3;
+#endif
+    return SIMD_NONE;
+}
+
+#else
+
+SimdLevel detectSimdLevel()
+{
+    return SIMD_NONE;
+}
+
+#endif // DAI_SIMD_X86
+
+const SimdKernels* kernelsForLevel(SimdLevel level)
+{
+    const SimdKernels* result = &scalarKernels;
+
+#ifdef DAI_SIMD_X86
+    switch (level) {
+    case SIMD_AVX2:
+        result = &avx2Kernels;
+        break;
+    case SIMD_SSSE3:
+        result = &ssse3Kernels;
+        break;
+    default:
+        break;
+    }
+#endif
+
+    return result;
+}
+
+struct SimdState {
+    SimdLevel supported;
+    std::atomic<int> level;
+    std::atomic<const SimdKernels*> kernels;
+
+    SimdState() : supported(detectSimdLevel()) {
+        level = supported;
+        kernels = kernelsForLevel(supported);
+    }
+};
+
+SimdState& simdState()
+{
+    static SimdState state;
+    return state;
+}
+
+inline const SimdKernels* kernels()
+{
+    return simdState().kernels.load(std::memory_order_relaxed);
+}
+
+} // End anonymous namespace
+
+SimdLevel simdSupportedLevel()
+{
+    return simdState().supported;
+}
+
+SimdLevel simdLevel()
+{
+    return SimdLevel(simdState().level.load());
+}
+
+void setSimdLevel(SimdLevel level)
+{
+    SimdState& state = simdState();
+
+    if (level > state.supported)
+        level = state.supported;
+
+    state.level = level;
+    state.kernels = kernelsForLevel(level);
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+    const char* result;
+
+    switch (level) {
+    case SIMD_AVX2:
+        result = "AVX2";
+        break;
+    case SIMD_SSSE3:
+        result = "SSSE3";
+        break;
+    default:
+        result = "Scalar";
+    }
+
+    return result;
+}
+
+namespace simd {
+
+void rgb2Indexed884Row(const uint8_t* rgb, uint8_t* out, int n)
+{
+    kernels()->rgb2Indexed884(rgb, out, n);
+}
+
+void rgb2Indexed161616Row(const uint8_t* rgb, uint16_t* out, int n)
+{
+    kernels()->rgb2Indexed161616(rgb, out, n);
+}
+
+void rgb2Log2DRow(const uint8_t* rgb, float* out, int n)
+{
+    kernels()->rgb2Log2D(rgb, out, n);
+}
+
+void integralImageRow(const uint8_t* rgb, const int32_t* prev, int32_t* out, int n)
+{
+    kernels()->integralImage(rgb, prev, out, n);
+}
+
+void binaryMaskRow(const uint8_t* mask, uint8_t* out, int n)
+{
+    kernels()->binaryMask(mask, out, n);
+}
+
+void narrowLabelsRow(const int16_t* labels, uint8_t* out, int n)
+{
+    kernels()->narrowLabels(labels, out, n);
+}
+
+void bgra2RgbRow(const uint8_t* bgra, uint8_t* rgb, int n)
+{
+    kernels()->bgra2Rgb(bgra, rgb, n);
+}
+
+void rgb2BgraRow(const uint8_t* rgb, uint8_t* bgra, int n)
+{
+    kernels()->rgb2Bgra(rgb, bgra, n);
+}
+
+void scaleU16ToU8Row(const uint16_t* in, uint8_t* out, int n, float scale)
+{
+    kernels()->scaleU16ToU8(in, out, n, scale);
+}
+
+void accumulateIndexed884Row(const uint8_t* rgb, const uint8_t* select, int n, int* hist)
+{
+    const SimdKernels* k = kernels();
+    const int chunkSize = 256;
+    uint8_t indexed[chunkSize];
+
+    for (int j=0; j<n; j+=chunkSize)
+    {
+        const int length = n - j < chunkSize ? n - j : chunkSize;
+        k->rgb2Indexed884(rgb + 3*j, indexed, length);
+
+        // Branchless, select is 0 or 1
+        for (int i=0; i<length; ++i)
+            hist[indexed[i]] += select[j+i];
+    }
+}
+
+} // End Namespace simd
+
+} // End Namespace
@@ -0,0 +1,69 @@
+#ifndef OPENCV_UTILS_SIMD_H
+#define OPENCV_UTILS_SIMD_H
+
+#include <cstdint>
+
+namespace dai {
+
+/**
+ * Instruction sets used by the vectorised image kernels. SIMD_SSSE3 is needed (and not
+ * only SSE2) because packed RGB pixels are deinterleaved with byte shuffles.
+ */
+enum SimdLevel {
+    SIMD_NONE,
+    SIMD_SSSE3,
+    SIMD_AVX2
+};
+
+// Best level supported by the CPU (detected at runtime)
+SimdLevel simdSupportedLevel();
+
+// Level currently used by the kernels. By default it is simdSupportedLevel()
+SimdLevel simdLevel();
+
+// Force a level (it is clamped to the supported one). Mainly useful for benchmarks
+void setSimdLevel(SimdLevel level);
+
+const char* simdLevelName(SimdLevel level);
+
+/**
+ * Row kernels used by opencv_utils. RGB input is packed (3 bytes per pixel) and n is the
+ * number of pixels. They are dispatched to the implementation of simdLevel().
+ */
+namespace simd {
+
+// out[j] = 32*(R/32) + 4*(G/32) + B/64
+void rgb2Indexed884Row(const uint8_t* rgb, uint8_t* out, int n);
+
+// out[j] = 256*(R/16) + 16*(G/16) + B/16
+void rgb2Indexed161616Row(const uint8_t* rgb, uint16_t* out, int n);
+
+// out[2j] = log((R+1)/(G+1)), out[2j+1] = log((B+1)/(G+1))
+void rgb2Log2DRow(const uint8_t* rgb, float* out, int n);
+
+// Integral image row of the first channel: out[j] = sum(rgb[0..j][0]) + prev[j]. prev may be null
+void integralImageRow(const uint8_t* rgb, const int32_t* prev, int32_t* out, int n);
+
+// out[j] = mask[j] > 0 ? 1 : 0
+void binaryMaskRow(const uint8_t* mask, uint8_t* out, int n);
+
+// out[j] = uint8_t(labels[j]), low byte of each label (NiTE user map to MaskFrame)
+void narrowLabelsRow(const int16_t* labels, uint8_t* out, int n);
+
+// QImage::Format_RGB32 (BGRA in memory) to packed RGB
+void bgra2RgbRow(const uint8_t* bgra, uint8_t* rgb, int n);
+
+// Packed RGB to QImage::Format_RGB32 (BGRA in memory, alpha is 255)
+void rgb2BgraRow(const uint8_t* rgb, uint8_t* bgra, int n);
+
+// out[j] = min(round(in[j] * scale), 255), i.e. depth to an 8 bits preview. scale must be >= 0
+void scaleU16ToU8Row(const uint16_t* in, uint8_t* out, int n, float scale);
+
+// hist[index884(pixel j)] += select[j], select must be 0 or 1
+void accumulateIndexed884Row(const uint8_t* rgb, const uint8_t* select, int n, int* hist);
+
+} // End Namespace simd
+
+} // End Namespace
+
+#endif // OPENCV_UTILS_SIMD_H
@@ -75,6 +75,14 @@ void OpenNIColorInstance::nextFrame(QHashDataFrames &output)
     Q_ASSERT(output.size() > 0);
     shared_ptr<ColorFrame> colorFrame = static_pointer_cast<ColorFrame>(output.value(DataFrame::Color));
     m_device->readColorFrame(colorFrame);
+    setTimestamp(m_device->colorTimestamp());
+}
+
+// A live device always delivers its newest frame, there is nothing to skip
+bool OpenNIColorInstance::seekInstance(unsigned int count)
+{
+    Q_UNUSED(count);
+    return !m_device->isFile();
 }
 
 } // End namespace
@@ -60,6 +60,14 @@ void OpenNIDepthInstance::nextFrame(QHashDataFrames &output)
     Q_ASSERT(output.size() > 0);
     shared_ptr<DepthFrame> depthFrame = static_pointer_cast<DepthFrame>(output.value(DataFrame::Depth));
     m_device->readDepthFrame(depthFrame);
+    setTimestamp(m_device->depthTimestamp());
+}
+
+// A live device always delivers its newest frame, there is nothing to skip
+bool OpenNIDepthInstance::seekInstance(unsigned int count)
+{
+    Q_UNUSED(count);
+    return !m_device->isFile();
 }
 
 } // End namespace
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <glm/glm.hpp>
 #include "Utils.h"
+#include "opencv_utils_simd.h"
 
 using namespace std;
 
@@ -36,6 +37,10 @@ OpenNIDevice::OpenNIDevice(const QString devicePath)
     : m_devicePath(devicePath)
     , m_opened(false)
     , m_manual_registration(false)
+    , m_lastFrame(0)
+    , m_colorTimestamp(-1)
+    , m_depthTimestamp(-1)
+    , m_userTimestamp(-1)
 {
     // Init OpenNI
     _mutex_counter.lock();
@@ -132,6 +137,9 @@ void OpenNIDevice::open()
 
         // Start
         m_lastFrame = 0;
+        m_colorTimestamp = -1;
+        m_depthTimestamp = -1;
+        m_userTimestamp = -1;
 
         if (m_oniColorStream.start() != openni::STATUS_OK)
             throw 6;
@@ -219,15 +227,11 @@ void OpenNIDevice::readColorFrame(shared_ptr<ColorFrame> colorFrame)
         throw 2;
 
     m_lastFrame = dai::max<int>(m_lastFrame, m_oniColorFrame.getFrameIndex());
+    m_colorTimestamp = m_oniColorFrame.getTimestamp();
 
-    int stride = m_oniColorFrame.getStrideInBytes() / sizeof(openni::RGB888Pixel) - m_oniColorFrame.getWidth();
-
-    if (stride > 0) {
-        qWarning() << "WARNING: OpenNIDevice - Not managed color stride!!!";
-        throw 3;
-    }
-
-    colorFrame->setDataPtr(640, 480, (RGBColor*) m_oniColorFrame.getData());
+    // No copy, colorFrame keeps a reference to the OpenNI frame
+    colorFrame->setDataPtr(m_oniColorFrame.getWidth(), m_oniColorFrame.getHeight(), (RGBColor*) m_oniColorFrame.getData(),
+                           m_oniColorFrame.getStrideInBytes(), make_shared<openni::VideoFrameRef>(m_oniColorFrame));
     colorFrame->setIndex(m_oniColorFrame.getFrameIndex());
 }
 
@@ -247,23 +251,24 @@ void OpenNIDevice::readDepthFrame(shared_ptr<DepthFrame> depthFrame)
     }
 
     m_lastFrame = dai::max<int>(m_lastFrame, m_oniDepthFrame.getFrameIndex());
+    m_depthTimestamp = m_oniDepthFrame.getTimestamp();
 
-    int strideDepth = m_oniDepthFrame.getStrideInBytes() / sizeof(openni::DepthPixel) - m_oniDepthFrame.getWidth();
-
-    if (strideDepth > 0) {
-        qWarning() << "WARNING: OpenNIDevice - Not managed depth stride!!!";
-        throw 3;
-    }
-
-    depthFrame->setDataPtr(640, 480, (uint16_t*) m_oniDepthFrame.getData());
-    depthFrame->setIndex(m_oniDepthFrame.getFrameIndex());
-    depthFrame->setDistanceUnits(dai::DISTANCE_MILIMETERS);
+    wrapDepthFrame(m_oniDepthFrame, depthFrame);
 
     if (m_manual_registration) {
         depth2color(depthFrame);
     }
 }
 
+void OpenNIDevice::wrapDepthFrame(const openni::VideoFrameRef& oniDepthFrame, shared_ptr<DepthFrame> depthFrame) const
+{
+    // No copy, depthFrame keeps a reference to the OpenNI frame
+    depthFrame->setDataPtr(oniDepthFrame.getWidth(), oniDepthFrame.getHeight(), (uint16_t*) oniDepthFrame.getData(),
+                           oniDepthFrame.getStrideInBytes(), make_shared<openni::VideoFrameRef>(oniDepthFrame));
+    depthFrame->setIndex(oniDepthFrame.getFrameIndex());
+    depthFrame->setDistanceUnits(dai::DISTANCE_MILIMETERS);
+}
+
 /* Old Version
  * shared_ptr<DepthFrame> OpenNIDevice::readDepthFrame()
 {
@@ -317,42 +322,26 @@ void OpenNIDevice::readUserTrackerFrame(shared_ptr<DepthFrame> depthFrame, share
     }
 
     m_lastFrame = dai::max<int>(m_lastFrame, oniUserTrackerFrame.getFrameIndex());
+    m_userTimestamp = oniUserTrackerFrame.getTimestamp();
 
     // Depth Frame
     if (depthFrame) {
         m_oniDepthFrame = oniUserTrackerFrame.getDepthFrame();
-
-        int strideDepth = m_oniDepthFrame.getStrideInBytes() / sizeof(openni::DepthPixel) - m_oniDepthFrame.getWidth();
-
-        if (strideDepth > 0) {
-            qWarning() << "WARNING: OpenNIDevice - Not managed depth stride!!!";
-            throw 3;
-        }
-
-        depthFrame->setDataPtr(640, 480, (uint16_t*) m_oniDepthFrame.getData());
-        depthFrame->setIndex(m_oniDepthFrame.getFrameIndex());
-        depthFrame->setDistanceUnits(dai::DISTANCE_MILIMETERS);
+        wrapDepthFrame(m_oniDepthFrame, depthFrame);
     }
 
-    // Load User Labels (copy)
+    // Load User Labels (copy, as MaskFrame has 8 bits labels and NiTE 16 bits)
     if (maskFrame) {
+        static_assert(sizeof(nite::UserId) == sizeof(int16_t), "nite::UserId must be 16 bits");
         const nite::UserMap& userMap = oniUserTrackerFrame.getUserMap();
+        const uchar* pLabels = (const uchar*) userMap.getPixels();
 
-        int strideUser = userMap.getStride() / sizeof(nite::UserId) - userMap.getWidth();
-
-        if (strideUser > 0) {
-            qWarning() << "WARNING: OpenNIRuntime - Not managed user stride!!!";
-            throw 1;
-        }
-
-        const nite::UserId* pLabel = userMap.getPixels();
+        if (maskFrame->width() != userMap.getWidth() || maskFrame->height() != userMap.getHeight())
+            *maskFrame = MaskFrame(userMap.getWidth(), userMap.getHeight());
 
         for (int i=0; i < userMap.getHeight(); ++i) {
-            uint8_t* pMask = maskFrame->getRowPtr(i);
-            for (int j=0; j < userMap.getWidth(); ++j) {
-                pMask[j] = *pLabel;
-                pLabel++;
-            }
+            simd::narrowLabelsRow((const int16_t*) (pLabels + i * userMap.getStride()),
+                                  maskFrame->getRowPtr(i), userMap.getWidth());
         }
 
         maskFrame->setIndex(oniUserTrackerFrame.getFrameIndex());
@@ -402,13 +391,8 @@ void OpenNIDevice::readUserTrackerFrame(shared_ptr<DepthFrame> depthFrame, share
 
                 if (oniSkeleton.getState() == nite::SKELETON_TRACKED && head.getPositionConfidence() > 0.5)
                 {
-                    auto daiSkeleton = skeletonFrame->getSkeleton(user.getId());
-
-                    if (daiSkeleton == nullptr) {
-                        daiSkeleton = make_shared<dai::Skeleton>(dai::Skeleton::SKELETON_OPENNI);
-                        daiSkeleton->setDistanceUnits(dai::DISTANCE_MILIMETERS);
-                        skeletonFrame->setSkeleton(user.getId(), daiSkeleton);
-                    }
+                    auto daiSkeleton = skeletonFrame->reuseSkeleton(user.getId(), dai::Skeleton::SKELETON_OPENNI);
+                    daiSkeleton->setDistanceUnits(dai::DISTANCE_MILIMETERS);
 
                     OpenNIDevice::copySkeleton(oniSkeleton, *(daiSkeleton.get()));
                     //daiSkeleton->computeQuaternions();
@@ -500,9 +484,9 @@ void OpenNIDevice::depth2color(shared_ptr<DepthFrame> depthFrame, shared_ptr<Mas
             p2d.y = (p3d.y * fy_rgb / p3d.z) + cy_rgb;
 
             if (p2d.x >= 0 && p2d.y >= 0 && p2d.x < 640 && p2d.y < 480) {
-                outputDepth->setItem(p2d.y, p2d.x, pDepth[j]);
+                outputDepth->at(int(p2d.y), int(p2d.x)) = pDepth[j];
                 if (outputMask) {
-                    outputMask->setItem(p2d.y, p2d.x, pMask[j]);
+                    outputMask->at(int(p2d.y), int(p2d.x)) = pMask[j];
                 }
             }
         }
@@ -598,6 +582,21 @@ bool OpenNIDevice::isFile() const
     return m_device.isFile();
 }
 
+qint64 OpenNIDevice::colorTimestamp() const
+{
+    return m_colorTimestamp;
+}
+
+qint64 OpenNIDevice::depthTimestamp() const
+{
+    return m_depthTimestamp;
+}
+
+qint64 OpenNIDevice::userTrackerTimestamp() const
+{
+    return m_userTimestamp;
+}
+
 int OpenNIDevice::getTotalFrames()
 {
     int result = 0;
@@ -42,6 +42,9 @@ class OpenNIDevice
     bool                       m_opened;
     bool                       m_manual_registration;
     int                        m_lastFrame;
+    qint64                     m_colorTimestamp;  // Each stream is read from its own thread when
+    qint64                     m_depthTimestamp;  // the playback is synchronised
+    qint64                     m_userTimestamp;
 
 public:
     static SkeletonJoint::JointType _staticMap[15];
@@ -65,6 +68,9 @@ public:
     openni::PlaybackControl* playbackControl();
     bool isFile() const;
     int getTotalFrames();
+    qint64 colorTimestamp() const; // Microseconds
+    qint64 depthTimestamp() const;
+    qint64 userTrackerTimestamp() const;
     void setRegistration(bool flag);
 #ifndef __APPLE__
     void convertJointCoordinatesToDepth(float x, float y, float z, float* pOutX, float* pOutY) const;
@@ -76,6 +82,7 @@ private:
     void initOpenNI();
     void shutdownOpenNI();
     void depth2color(shared_ptr<DepthFrame> depthFrame, shared_ptr<MaskFrame> mask = nullptr) const;
+    void wrapDepthFrame(const openni::VideoFrameRef& oniDepthFrame, shared_ptr<DepthFrame> depthFrame) const;
 };
 
 } // End Namespace
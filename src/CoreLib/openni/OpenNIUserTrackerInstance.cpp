@@ -64,9 +64,17 @@ void OpenNIUserTrackerInstance::nextFrame(QHashDataFrames& output)
     shared_ptr<SkeletonFrame> skeletonFrame = static_pointer_cast<SkeletonFrame>(output.value(DataFrame::Skeleton));
     shared_ptr<MetadataFrame> metadataFrame = static_pointer_cast<MetadataFrame>(output.value(DataFrame::Metadata));
     m_device->readUserTrackerFrame(depthFrame, maskFrame, skeletonFrame, metadataFrame);
+    setTimestamp(m_device->userTrackerTimestamp());
 #else
     Q_UNUSED(output);
 #endif
 }
 
+// A live device always delivers its newest frame, there is nothing to skip
+bool OpenNIUserTrackerInstance::seekInstance(unsigned int count)
+{
+    Q_UNUSED(count);
+    return !m_device->isFile();
+}
+
 } // End Namespace
@@ -23,6 +23,7 @@ protected:
     void closeInstance() override;
     void restartInstance() override;
     void nextFrame(QHashDataFrames& output) override;
+    bool seekInstance(unsigned int count) override;
 
 private:
     OpenNIDevice* m_device;
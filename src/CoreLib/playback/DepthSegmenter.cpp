@@ -0,0 +1,434 @@
+#include "DepthSegmenter.h"
+#include <QSet>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <climits>
+
+namespace dai {
+
+DepthSegmenter::DepthSegmenter()
+    : m_width(0)
+    , m_height(0)
+    , m_frameCount(0)
+    , m_hasFloor(false)
+{
+}
+
+void DepthSegmenter::setSettings(const Settings& settings)
+{
+    m_settings = settings;
+}
+
+void DepthSegmenter::reset()
+{
+    m_width = 0;
+    m_height = 0;
+    m_frameCount = 0;
+    m_hasFloor = false;
+    m_tracks.clear();
+    m_components.clear();
+}
+
+int DepthSegmenter::usersCount() const
+{
+    int count = 0;
+
+    for (const Track& track : m_tracks) {
+        if (track.lost == 0)
+            count++;
+    }
+
+    return count;
+}
+
+void DepthSegmenter::segment(const DepthFrame& depth, MaskFrame& mask, MetadataFrame* metadata)
+{
+    const int width = depth.width();
+    const int height = depth.height();
+
+    if (width != m_width || height != m_height)
+    {
+        reset();
+        m_width = width;
+        m_height = height;
+        m_background.fill(0.0f, width * height);
+        m_foreground.fill(0, width * height);
+        m_labels.fill(0, width * height);
+    }
+
+    if (mask.width() != width || mask.height() != height)
+        mask = MaskFrame(width, height);
+
+    if (isLearning())
+    {
+        learn(depth);
+
+        if (++m_frameCount == m_settings.learningFrames)
+            estimateFloor(depth);
+
+        for (int i=0; i<height; ++i)
+            memset(mask.getRowPtr(i), 0, width);
+
+        return;
+    }
+
+    // Foreground: closer than the background and not on the floor
+    for (int i=0; i<height; ++i)
+    {
+        const uint16_t* pDepth = depth.getRowPtr(i);
+        const float* pBackground = m_background.constData() + i * width;
+        uint8_t* pForeground = m_foreground.data() + i * width;
+
+        for (int j=0; j<width; ++j)
+        {
+            const uint16_t z = pDepth[j];
+            const float background = pBackground[j];
+            bool foreground = z > 0 && (background == 0 ||
+                    background - z > qMax(m_settings.minDifference, m_settings.relativeDifference * background));
+
+            if (foreground && m_hasFloor && isFloor(depth, j, i, z))
+                foreground = false;
+
+            pForeground[j] = foreground;
+        }
+    }
+
+    findComponents(depth);
+    assignLabels();
+
+    // Output
+    m_labels.fill(0);
+
+    for (const Component& component : m_components)
+    {
+        if (component.label == 0)
+            continue;
+
+        for (int k=component.first; k<component.first + component.size; ++k)
+            m_labels[m_pixels[k]] = component.label;
+
+        if (metadata) {
+            metadata->addBoundingBox(BoundingBox(Point3f(component.minX, component.minY, component.minZ),
+                                                 Point3f(component.maxX, component.maxY, component.maxZ)));
+        }
+    }
+
+    for (int i=0; i<height; ++i)
+        memcpy(mask.getRowPtr(i), m_labels.constData() + i * width, width);
+
+    updateBackground(depth);
+}
+
+// The background is the farthest depth seen in each pixel
+void DepthSegmenter::learn(const DepthFrame& depth)
+{
+    for (int i=0; i<m_height; ++i)
+    {
+        const uint16_t* pDepth = depth.getRowPtr(i);
+        float* pBackground = m_background.data() + i * m_width;
+
+        for (int j=0; j<m_width; ++j) {
+            if (pDepth[j] > pBackground[j])
+                pBackground[j] = pDepth[j];
+        }
+    }
+}
+
+/**
+ * RANSAC fit of a plane to the lower half of the background. Only planes whose normal
+ * is close to the vertical axis of the camera are considered floors.
+ */
+void DepthSegmenter::estimateFloor(const DepthFrame& depth)
+{
+    m_hasFloor = false;
+
+    if (m_settings.floorDistance <= 0)
+        return;
+
+    QVector<Point3f> points;
+
+    for (int i=m_height/2; i<m_height; i+=4)
+    {
+        const float* pBackground = m_background.constData() + i * m_width;
+
+        for (int j=0; j<m_width; j+=4) {
+            if (pBackground[j] > 0) {
+                Point3f point(0, 0, pBackground[j]);
+                depth.convertCoordinatesToWorld(j, i, point[2], &point[0], &point[1]);
+                points << point;
+            }
+        }
+    }
+
+    if (points.size() < 100)
+        return;
+
+    std::mt19937 generator(1234);
+    std::uniform_int_distribution<int> random(0, points.size() - 1);
+    int bestInliers = 0;
+
+    for (int iteration=0; iteration<200; ++iteration)
+    {
+        const Point3f& p1 = points[random(generator)];
+        const Point3f& p2 = points[random(generator)];
+        const Point3f& p3 = points[random(generator)];
+        const float u[3] = {p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2]};
+        const float v[3] = {p3[0] - p1[0], p3[1] - p1[1], p3[2] - p1[2]};
+        float plane[4] = {u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0], 0};
+        const float norm = std::sqrt(plane[0]*plane[0] + plane[1]*plane[1] + plane[2]*plane[2]);
+
+        if (norm < 1e-3f)
+            continue;
+
+        for (int k=0; k<3; ++k)
+            plane[k] /= norm;
+
+        if (std::fabs(plane[1]) < 0.7f)
+            continue;
+
+        plane[3] = -(plane[0]*p1[0] + plane[1]*p1[1] + plane[2]*p1[2]);
+        int inliers = 0;
+
+        for (const Point3f& point : points) {
+            if (std::fabs(plane[0]*point[0] + plane[1]*point[1] + plane[2]*point[2] + plane[3]) < m_settings.floorDistance)
+                inliers++;
+        }
+
+        if (inliers > bestInliers) {
+            bestInliers = inliers;
+            memcpy(m_floor, plane, sizeof(m_floor));
+        }
+    }
+
+    m_hasFloor = bestInliers > points.size() * 0.15f;
+}
+
+bool DepthSegmenter::isFloor(const DepthFrame& depth, int x, int y, uint16_t z) const
+{
+    float worldX, worldY;
+    depth.convertCoordinatesToWorld(x, y, z, &worldX, &worldY);
+    return std::fabs(m_floor[0]*worldX + m_floor[1]*worldY + m_floor[2]*z + m_floor[3]) < m_settings.floorDistance;
+}
+
+/**
+ * Group the foreground in 4-connected components of similar depth. m_pixels is used as
+ * the queue of the flood fill, so it ends with the pixels of each component together.
+ * Components smaller than minPixels are dropped.
+ */
+void DepthSegmenter::findComponents(const DepthFrame& depth)
+{
+    const int minPixels = qMax(1, int(m_settings.minPixels * float(m_width * m_height) / (640 * 480)));
+    uint8_t* foreground = m_foreground.data();
+
+    m_pixels.clear();
+    m_components.clear();
+
+    for (int start=0; start<m_width * m_height; ++start)
+    {
+        if (!foreground[start])
+            continue;
+
+        Component component;
+        component.first = m_pixels.size();
+        component.minX = component.minY = INT_MAX;
+        component.maxX = component.maxY = 0;
+        component.minZ = 0xFFFF;
+        component.maxZ = 0;
+        component.label = 0;
+
+        double sumX = 0, sumY = 0, sumZ = 0;
+        foreground[start] = 0;
+        m_pixels << start;
+
+        for (int k=component.first; k<m_pixels.size(); ++k)
+        {
+            const int index = m_pixels[k];
+            const int x = index % m_width;
+            const int y = index / m_width;
+            const uint16_t z = depth.getRowPtr(y)[x];
+            const float jump = qMax(m_settings.depthJump, m_settings.relativeDifference * z);
+
+            sumX += x;
+            sumY += y;
+            sumZ += z;
+            component.minX = qMin(component.minX, x);
+            component.maxX = qMax(component.maxX, x);
+            component.minY = qMin(component.minY, y);
+            component.maxY = qMax(component.maxY, y);
+            component.minZ = qMin(component.minZ, z);
+            component.maxZ = qMax(component.maxZ, z);
+
+            const int neighbours[4][2] = {{x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+
+            for (const auto& neighbour : neighbours)
+            {
+                const int nx = neighbour[0];
+                const int ny = neighbour[1];
+
+                if (nx < 0 || ny < 0 || nx >= m_width || ny >= m_height)
+                    continue;
+
+                const int other = ny * m_width + nx;
+
+                if (foreground[other] && std::abs(int(depth.getRowPtr(ny)[nx]) - int(z)) <= jump) {
+                    foreground[other] = 0;
+                    m_pixels << other;
+                }
+            }
+        }
+
+        component.size = m_pixels.size() - component.first;
+
+        if (component.size < minPixels) {
+            m_pixels.resize(component.first);
+            continue;
+        }
+
+        component.centroid[2] = sumZ / component.size;
+        depth.convertCoordinatesToWorld(sumX / component.size, sumY / component.size, component.centroid[2],
+                                        &component.centroid[0], &component.centroid[1]);
+        m_components << component;
+    }
+}
+
+/**
+ * Components take the label of the user of the previous frame they overlap the most.
+ * The rest take the label of the nearest lost user, or a new one.
+ */
+void DepthSegmenter::assignLabels()
+{
+    struct Match {
+        int overlap;
+        int component;
+        int label;
+    };
+
+    QList<Match> matches;
+
+    for (int i=0; i<m_components.size(); ++i)
+    {
+        const Component& component = m_components[i];
+        int overlap[256] = {0};
+
+        for (int k=component.first; k<component.first + component.size; ++k)
+            overlap[m_labels[m_pixels[k]]]++;
+
+        for (int label=1; label<255; ++label) {
+            if (overlap[label] > 0 && m_tracks.contains(label))
+                matches << Match{overlap[label], i, label};
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.overlap > b.overlap;
+    });
+
+    QSet<int> assigned;
+
+    for (const Match& match : matches) {
+        Component& component = m_components[match.component];
+
+        if (component.label == 0 && !assigned.contains(match.label)) {
+            component.label = match.label;
+            assigned << match.label;
+        }
+    }
+
+    // Lost users that appear again near where they were
+    for (Component& component : m_components)
+    {
+        if (component.label != 0)
+            continue;
+
+        float bestDistance = m_settings.maxCentroidDistance;
+
+        for (auto it = m_tracks.constBegin(); it != m_tracks.constEnd(); ++it)
+        {
+            if (assigned.contains(it.key()))
+                continue;
+
+            const Track& track = it.value();
+            float distance = 0;
+
+            for (int k=0; k<3; ++k)
+                distance += (track.centroid[k] - component.centroid[k]) * (track.centroid[k] - component.centroid[k]);
+
+            distance = std::sqrt(distance);
+
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                component.label = it.key();
+            }
+        }
+
+        if (component.label != 0)
+            assigned << component.label;
+    }
+
+    // New users
+    for (Component& component : m_components)
+    {
+        if (component.label != 0)
+            continue;
+
+        for (int label=1; label<255; ++label) {
+            if (!m_tracks.contains(label) && !assigned.contains(label)) {
+                component.label = label;
+                assigned << label;
+                break;
+            }
+        }
+    }
+
+    // Update tracks
+    auto it = m_tracks.begin();
+
+    while (it != m_tracks.end()) {
+        if (!assigned.contains(it.key()) && ++it.value().lost > m_settings.maxLost)
+            it = m_tracks.erase(it);
+        else
+            ++it;
+    }
+
+    for (const Component& component : m_components)
+    {
+        if (component.label == 0)
+            continue;
+
+        Track& track = m_tracks[component.label];
+        memcpy(track.centroid, component.centroid, sizeof(track.centroid));
+        track.lost = 0;
+    }
+}
+
+/**
+ * Pixels that aren't users adapt the background. Background that appears behind
+ * something (a user that stood still while learning) is learned quickly, and objects
+ * that are placed in the scene slowly.
+ */
+void DepthSegmenter::updateBackground(const DepthFrame& depth)
+{
+    for (int i=0; i<m_height; ++i)
+    {
+        const uint16_t* pDepth = depth.getRowPtr(i);
+        const uint8_t* pLabels = m_labels.constData() + i * m_width;
+        float* pBackground = m_background.data() + i * m_width;
+
+        for (int j=0; j<m_width; ++j)
+        {
+            const uint16_t z = pDepth[j];
+
+            if (z == 0 || pLabels[j] != 0)
+                continue;
+
+            if (pBackground[j] == 0)
+                pBackground[j] = z;
+            else
+                pBackground[j] += (z > pBackground[j] ? 0.5f : m_settings.adaptationRate) * (z - pBackground[j]);
+        }
+    }
+}
+
+} // End Namespace
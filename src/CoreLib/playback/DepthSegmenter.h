@@ -0,0 +1,98 @@
+#ifndef DEPTHSEGMENTER_H
+#define DEPTHSEGMENTER_H
+
+#include "types/DepthFrame.h"
+#include "types/MaskFrame.h"
+#include "types/MetadataFrame.h"
+#include <QVector>
+#include <QMap>
+
+namespace dai {
+
+/**
+ * User segmentation from depth alone, so masks don't require NiTE. The first
+ * learningFrames frames are used to learn the background (the farthest depth seen in
+ * each pixel). Afterwards, pixels closer than the background are grouped into connected
+ * components of similar depth, and components big enough are users.
+ *
+ * Users keep their label while they are visible: components are matched with the users
+ * of the previous frame by their overlap, or by the distance between centroids when a
+ * user reappears after being lost for less than maxLost frames.
+ *
+ * When the floor is visible during learning, its plane is estimated and the pixels that
+ * lie on it are removed, so feet don't join users through the floor. The background
+ * keeps adapting to the pixels that don't belong to users.
+ *
+ * Depth is expected in millimeters. Labels are 1..254, as 255 is the mask border.
+ *
+ * @brief The DepthSegmenter class
+ */
+class DepthSegmenter
+{
+public:
+    struct Settings {
+        int learningFrames = 30;            // Frames to learn the background
+        float minDifference = 80.0f;        // mm closer than the background to be foreground
+        float relativeDifference = 0.03f;   // Same, proportional to depth (noise grows with it)
+        float depthJump = 60.0f;            // mm between neighbours of the same user
+        int minPixels = 1200;               // Smallest user, at 640x480
+        float floorDistance = 60.0f;        // mm to the floor plane to be floor, 0 disables it
+        float adaptationRate = 0.02f;       // Background update when something gets closer
+        float maxCentroidDistance = 600.0f; // mm a lost user may move and keep its label
+        int maxLost = 15;                   // Frames a lost user keeps its label
+    };
+
+    DepthSegmenter();
+    void setSettings(const Settings& settings);
+    const Settings& settings() const {return m_settings;}
+
+    /**
+     * Write the labels of the users of depth to mask (resized if needed). Bounding boxes
+     * of the users are added to metadata, if not null, with x, y in pixels and z in mm.
+     * While the background is learned the mask is empty.
+     */
+    void segment(const DepthFrame& depth, MaskFrame& mask, MetadataFrame* metadata = nullptr);
+    void reset();
+    bool isLearning() const {return m_frameCount < m_settings.learningFrames;}
+    bool hasFloor() const {return m_hasFloor;}
+    int usersCount() const;
+
+private:
+    struct Component {
+        int first;          // First pixel in m_pixels
+        int size;
+        float centroid[3];  // Real world, mm
+        int minX, minY, maxX, maxY;
+        uint16_t minZ, maxZ;
+        int label;
+    };
+
+    struct Track {
+        float centroid[3];
+        int lost;
+    };
+
+    void learn(const DepthFrame& depth);
+    void estimateFloor(const DepthFrame& depth);
+    bool isFloor(const DepthFrame& depth, int x, int y, uint16_t z) const;
+    void findComponents(const DepthFrame& depth);
+    void assignLabels();
+    void updateBackground(const DepthFrame& depth);
+
+    Settings m_settings;
+    int m_width;
+    int m_height;
+    int m_frameCount;
+    QVector<float> m_background;        // mm, 0 = unknown
+    QVector<uint8_t> m_foreground;
+    QVector<uint8_t> m_labels;          // Labels of the last frame
+    QVector<int> m_pixels;              // Pixels of every component, one after another
+    QList<Component> m_components;
+    QMap<int, Track> m_tracks;
+    float m_floor[4];                   // Plane a*x + b*y + c*z + d = 0, (a, b, c) normalised
+    bool m_hasFloor;
+};
+
+} // End Namespace
+
+#endif // DEPTHSEGMENTER_H
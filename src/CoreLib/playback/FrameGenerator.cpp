@@ -1,6 +1,8 @@
 #include "FrameGenerator.h"
 #include "FrameListener.h"
 #include "FrameNotifier.h"
+#include "Tracer.h"
+#include "types/MemoryTracker.h"
 
 
 namespace dai {
@@ -13,6 +15,7 @@ FrameGenerator::FrameGenerator()
     m_readBuffer = nullptr;
     m_writeBuffer = nullptr;
     m_initialised = false;
+    m_memoryOwner = 0;
 }
 
 FrameGenerator::~FrameGenerator()
@@ -49,7 +52,7 @@ void FrameGenerator::removeListener(FrameListener* listener)
     }
 }
 
-void FrameGenerator::notifyListeners(const QHashDataFrames& dataFrames, qint64 frameId)
+void FrameGenerator::notifyListeners(const QHashDataFrames& dataFrames, const FrameInfo& info)
 {
     // Notify listeners (Time is measured since this method is called and until the notification is received)
     // signals and slots, debug,   25 fps, Max 29.46 (ms), Min 0.05 (ms), Avg 14.44 (ms)
@@ -58,12 +61,16 @@ void FrameGenerator::notifyListeners(const QHashDataFrames& dataFrames, qint64 f
 
     foreach (FrameListener* listener, m_listeners.keys()) {
         FrameNotifier* notifier = m_listeners.value(listener);
-        notifier->notifyListener(dataFrames, frameId);
+        notifier->notifyListener(dataFrames, info);
     }
 }
 
 void FrameGenerator::begin(bool doubleBuffer)
 {
+    // Frames allocated by the generator are charged to it
+    m_memoryOwner = MemoryTracker::registerOwner(generatorName(), MemoryTracker::OWNER_GENERATOR);
+    MemoryScope memoryScope(m_memoryOwner);
+
     if (doubleBuffer) {
         m_readBuffer = allocateMemory();
         m_writeBuffer = allocateMemory();
@@ -87,9 +94,20 @@ bool FrameGenerator::generate()
     m_timer.start();
     m_productionRate = 1000000000.0f / timeBetweenInvocations;
 
+    // Frames produced from a received frame keep the id of the source frame
+    const bool tracing = Tracer::isEnabled();
+    const qint64 sourceFrame = tracing ? Tracer::currentFrame() : -1;
+    const qint64 traceId = sourceFrame >= 0 ? sourceFrame : m_frameCounter + 1;
+
+    if (tracing)
+        Tracer::setCurrentFrame(traceId);
+
+    MemoryScope memoryScope(m_memoryOwner);
+
     // Frames counter
     if (m_doubleBuffer)
     {
+        TraceScope scope(generatorName(), "produceFrames", traceId);
         produceFrames(*m_writeBuffer);
         m_counterLock.lockForWrite();
         swapBuffers();
@@ -100,15 +118,25 @@ bool FrameGenerator::generate()
         m_counterLock.lockForWrite();
         m_frameCounter++;
         m_counterLock.unlock();
+        TraceScope scope(generatorName(), "produceFrames", traceId);
         produceFrames(*m_readBuffer);
     }
 
     // Notify listeners
     if (m_readBuffer->size() > 0) {
-        notifyListeners(*m_readBuffer, m_frameCounter);
+        FrameInfo info;
+        info.frameId = m_frameCounter;
+        info.traceId = traceId;
+        describeFrame(info);
+
+        TraceScope scope(generatorName(), "notifyListeners", traceId);
+        notifyListeners(*m_readBuffer, info);
         hasProduced = true;
     }
 
+    if (tracing)
+        Tracer::setCurrentFrame(sourceFrame);
+
     // Stats 2
     qint64 spentTime = m_timer.nsecsElapsed();
     m_instantProductionRate = 1000000000.0f / spentTime;
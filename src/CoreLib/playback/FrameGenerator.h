@@ -2,6 +2,7 @@
 #define NODEPRODUCER_H
 
 #include "types/DataFrame.h"
+#include "playback/Pacing.h"
 #include <QHash>
 #include <QReadWriteLock>
 #include <QElapsedTimer>
@@ -31,6 +32,7 @@ class FrameGenerator
     shared_ptr<QHashDataFrames> m_writeBuffer;
     bool                  m_doubleBuffer;
     bool                  m_initialised;
+    int                   m_memoryOwner;
 
 public:
     FrameGenerator();
@@ -48,6 +50,11 @@ public:
 
     QElapsedTimer superTimer;
 
+    /**
+     * Category of the events recorded by the Tracer
+     */
+    virtual const char* generatorName() const {return "FrameGenerator";}
+
 protected:
     void restartStats();
     qint64 productsCount();
@@ -55,8 +62,13 @@ protected:
     virtual shared_ptr<QHashDataFrames> allocateMemory() = 0;
     virtual void produceFrames(QHashDataFrames& output) = 0;
 
+    /**
+     * Complete the description of the frame just produced before it is sent to the listeners
+     */
+    virtual void describeFrame(FrameInfo& info) {Q_UNUSED(info);}
+
 private:
-    inline void notifyListeners(const QHashDataFrames &dataFrames, qint64 frameId);
+    inline void notifyListeners(const QHashDataFrames &dataFrames, const FrameInfo& info);
     inline void swapBuffers();
 
     inline bool isValidFrame(qint64 frameIndex) {
@@ -5,7 +5,6 @@ namespace dai {
 
 FrameListener::FrameListener()
     : m_worker(nullptr)
-    , m_lastFrameId(0)
 {
 }
 
@@ -21,7 +20,7 @@ bool FrameListener::hasExpired()
     bool result = true;
 
     if (m_worker)
-        result = !m_worker->isValidFrame(m_lastFrameId);
+        result = !m_worker->isValidFrame(m_frameInfo.frameId);
 
     return result;
 }
@@ -15,12 +15,17 @@ class FrameListener
     friend class FrameNotifier;
 
     FrameGenerator* m_worker;  // PlaybackWorker::addListener sets this attribute
-    qint64 m_lastFrameId;
+    FrameInfo m_frameInfo;
 
 public:
     FrameListener();
     virtual ~FrameListener();
 
+    /**
+     * Category of the events recorded by the Tracer
+     */
+    virtual const char* listenerName() const {return "FrameListener";}
+
 protected:
     /**
      * This method is called from the ListenerNotifier thread assigned to each PlaybackListener
@@ -33,20 +38,32 @@ protected:
     virtual void newFrames(const QHashDataFrames dataFrames) = 0;
 
     bool hasExpired();
+
+    /**
+     * Description of the frames being processed (pacing policy, lateness, ...)
+     */
+    const FrameInfo& frameInfo() const {return m_frameInfo;}
+
     virtual void afterStop() {}
+
+    /**
+     * Called from the notifier thread when frames start being dropped because of a memory
+     * budget (see MemoryTracker). Listeners that keep frames (caches, queues) release them.
+     */
+    virtual void releaseMemory() {}
     FrameGenerator* producerHandler();
     void stopListener();
 
 private:
-    inline void newFrames(const QHashDataFrames dataFrames, const qint64 frameId) {
+    inline void newFrames(const QHashDataFrames dataFrames, const FrameInfo& info) {
         // Check the received frames are valid because we could have been called out of time
         // frameId is the frame counter of the frame generator.
-        if (!m_worker->isValidFrame(frameId)) {
-            qDebug() << "FrameListener - Frame" << frameId << "received but discarded";
+        if (!m_worker->isValidFrame(info.frameId)) {
+            qDebug() << "FrameListener - Frame" << info.frameId << "received but discarded";
             return;
         }
 
-        m_lastFrameId = frameId;
+        m_frameInfo = info;
         newFrames(dataFrames);
     }
 };
@@ -1,15 +1,26 @@
 #include "FrameNotifier.h"
 #include "FrameListener.h"
+#include "Tracer.h"
+#include "types/MemoryTracker.h"
 #include <QDebug>
 
 namespace dai {
 
+// Frames dropped in a row before concluding that dropping doesn't release the memory
+static const int MAX_MEMORY_DROPS = 50;
+
 FrameNotifier::FrameNotifier(FrameListener *listener)
     : m_listener(listener)
-    , m_frameId(0)
+    , m_notifyTime(0)
     , m_running(true)
     , m_workInProgress(false)
+    , m_memoryDropping(false)
+    , m_memoryDropsDisabled(false)
+    , m_memoryDrops(0)
+    , m_releaseRequested(false)
 {
+    setObjectName(QString("FrameNotifier (%1)").arg(listener->listenerName())); // Thread name in traces
+    m_memoryOwner = MemoryTracker::registerOwner(listener->listenerName(), MemoryTracker::OWNER_LISTENER);
 }
 
 // Al destruirme, espero a que el último trabajo finalice
@@ -36,10 +47,31 @@ void FrameNotifier::stop()
 
 void FrameNotifier::run()
 {
+    // Frames allocated by the listener are charged to it
+    MemoryScope memoryScope(m_memoryOwner);
+
     while (m_running)
     {
-        if (waitingForNewOrder()) {
-            m_listener->newFrames(m_data, m_frameId);
+        if (waitingForNewOrder())
+        {
+            if (takeReleaseRequest()) {
+                // The last frames received aren't kept either
+                TraceScope scope(m_listener->listenerName(), "releaseMemory");
+                m_data.clear();
+                m_listener->releaseMemory();
+                done();
+                continue;
+            }
+
+            if (Tracer::isEnabled()) {
+                // Time since the frame was notified until this thread woke up
+                if (m_notifyTime > 0)
+                    Tracer::complete(m_listener->listenerName(), "wakeUp", m_info.traceId, m_notifyTime, Tracer::now() - m_notifyTime);
+                Tracer::setCurrentFrame(m_info.traceId);
+            }
+
+            TraceScope scope(m_listener->listenerName(), "newFrames", m_info.traceId);
+            m_listener->newFrames(m_data, m_info);
         }
         done();
     }
@@ -48,18 +80,26 @@ void FrameNotifier::run()
     qDebug() << "FrameNotifier::run() is over";
 }
 
-// While the notifier is working, new notifications are ignored
-void FrameNotifier::notifyListener(const QHashDataFrames& data, const qint64 frameId)
+// While the notifier is working, or the listener is over its memory budget, new
+// notifications are ignored
+void FrameNotifier::notifyListener(const QHashDataFrames& data, const FrameInfo& info)
 {
+    if (dropForMemory()) {
+        Tracer::instant(m_listener->listenerName(), "droppedMemory", info.traceId);
+        return;
+    }
+
     m_syncLock.lock();
     if (!m_workInProgress) {
         m_data = data; // Implicit copy
-        m_frameId = frameId;
+        m_info = info;
+        m_notifyTime = Tracer::isEnabled() ? Tracer::now() : 0;
         m_workInProgress = true;
         m_sync.wakeOne();
-    }/* else {
-        qDebug() << "FrameNotifier::notifyListener() ignored (work in progress pending)";
-    }*/
+    } else {
+        Tracer::instant(m_listener->listenerName(), "dropped", info.traceId);
+        //qDebug() << "FrameNotifier::notifyListener() ignored (work in progress pending)";
+    }
     m_syncLock.unlock();
 }
 
@@ -79,8 +119,60 @@ bool FrameNotifier::waitingForNewOrder()
 void FrameNotifier::done()
 {
     m_syncLock.lock();
-    m_workInProgress = false;
+    m_workInProgress = m_releaseRequested; // A release requested meanwhile runs next
     m_syncLock.unlock();
 }
 
+/**
+ * Frames are dropped from the moment the listener, or the total, goes over a budget with
+ * BUDGET_DROP, and the listener is asked to release the memory it keeps. They are delivered
+ * again once usage is below the resume level. If usage doesn't go down after a while, the
+ * memory isn't released by dropping (i.e. buffers of the generators), so frames are
+ * delivered again and not dropped until usage goes below the resume level.
+ */
+bool FrameNotifier::dropForMemory()
+{
+    if (m_memoryDropping)
+    {
+        if (MemoryTracker::canResume(m_memoryOwner)) {
+            m_memoryDropping = false;
+        }
+        else if (++m_memoryDrops >= MAX_MEMORY_DROPS) {
+            qWarning() << "FrameNotifier:" << m_listener->listenerName() << "is still over the memory budget after"
+                       << m_memoryDrops << "dropped frames, they are delivered again";
+            m_memoryDropping = false;
+            m_memoryDropsDisabled = true;
+        }
+    }
+    else if (m_memoryDropsDisabled)
+    {
+        if (MemoryTracker::canResume(m_memoryOwner))
+            m_memoryDropsDisabled = false;
+    }
+    else if (MemoryTracker::shouldDrop(m_memoryOwner))
+    {
+        m_memoryDropping = true;
+        m_memoryDrops = 1;
+
+        m_syncLock.lock();
+        m_releaseRequested = true;
+        if (!m_workInProgress) {
+            m_notifyTime = 0;
+            m_workInProgress = true;
+            m_sync.wakeOne();
+        }
+        m_syncLock.unlock();
+    }
+
+    return m_memoryDropping;
+}
+
+bool FrameNotifier::takeReleaseRequest()
+{
+    QMutexLocker locker(&m_syncLock);
+    const bool result = m_releaseRequested;
+    m_releaseRequested = false;
+    return result;
+}
+
 } // End Namespace
@@ -5,6 +5,7 @@
 #include <QWaitCondition>
 #include <QMutex>
 #include "types/DataFrame.h"
+#include "playback/Pacing.h"
 
 namespace dai {
 
@@ -15,7 +16,7 @@ class FrameNotifier : public QThread
 public:
     FrameNotifier(FrameListener* listener);
     ~FrameNotifier();
-    void notifyListener(const QHashDataFrames &data, const qint64 frameId);
+    void notifyListener(const QHashDataFrames &data, const FrameInfo& info);
     void stop();
 
 protected:
@@ -24,14 +25,24 @@ protected:
 private:
     bool waitingForNewOrder();
     void done();
+    bool dropForMemory();
+    bool takeReleaseRequest();
 
     FrameListener* m_listener;
     QHashDataFrames m_data;
-    qint64 m_frameId;
+    FrameInfo m_info;
+    qint64 m_notifyTime;
     bool m_running;
     QWaitCondition m_sync;
     QMutex m_syncLock;
     bool m_workInProgress;
+    int m_memoryOwner;
+
+    // Drops because of the memory budget (only used from the generator thread)
+    bool m_memoryDropping;
+    bool m_memoryDropsDisabled;  // Dropping didn't release memory, until usage goes down
+    int m_memoryDrops;
+    bool m_releaseRequested;     // Guarded by m_syncLock
 
 };
 
@@ -0,0 +1,357 @@
+#include "InstanceSynchroniser.h"
+#include "Tracer.h"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDebug>
+#include <limits>
+#include <atomic>
+
+namespace dai {
+
+/**
+ * Frames read from an instance and their position in the stream
+ */
+struct SyncFrames
+{
+    QHashDataFrames frames;
+    qint64 time = 0;       // Microseconds since the first frame of the loop
+    qint64 timestamp = -1; // Source timestamp (-1 if none)
+    int loop = 0;
+};
+
+static inline bool isBefore(const SyncFrames& frames, const SyncFrames& reference)
+{
+    return frames.loop < reference.loop || (frames.loop == reference.loop && frames.time < reference.time);
+}
+
+static inline bool isAfter(const SyncFrames& frames, const SyncFrames& reference)
+{
+    return frames.loop > reference.loop || (frames.loop == reference.loop && frames.time > reference.time);
+}
+
+static inline qint64 distance(const SyncFrames& frames, const SyncFrames& reference)
+{
+    if (frames.loop != reference.loop)
+        return numeric_limits<qint64>::max();
+
+    return qAbs(frames.time - reference.time);
+}
+
+/**
+ * Reads an instance ahead of the playback and keeps the read frames in a bounded queue.
+ * The frame buffers are reused once nobody else holds them.
+ */
+class InstanceReader : public QThread
+{
+public:
+    InstanceReader(shared_ptr<StreamInstance> instance, bool playloop, qint64 interval)
+        : m_instance(instance)
+        , m_playloop(playloop)
+        , m_interval(interval)
+        , m_running(true)
+        , m_finished(false)
+        , m_discarded(0)
+    {
+    }
+
+    void stop()
+    {
+        m_lock.lock();
+        m_running = false;
+        m_produced.wakeAll();
+        m_consumed.wakeAll();
+        m_lock.unlock();
+        wait();
+    }
+
+    // Take the next frames (reference instance)
+    shared_ptr<SyncFrames> take()
+    {
+        QMutexLocker locker(&m_lock);
+
+        while (m_running && !m_finished && m_queue.isEmpty())
+            m_produced.wait(&m_lock);
+
+        if (m_queue.isEmpty())
+            return nullptr;
+
+        shared_ptr<SyncFrames> result = m_queue.takeFirst();
+        m_consumed.wakeAll();
+        return result;
+    }
+
+    // Frames nearest to the reference if they are within the tolerance
+    shared_ptr<SyncFrames> nearest(const SyncFrames& reference, qint64 tolerance)
+    {
+        QMutexLocker locker(&m_lock);
+
+        // Until a frame after the reference has been read, a nearer one could still come
+        while (m_running && !m_finished && m_queue.size() < QueueSize &&
+               (m_queue.isEmpty() || !isAfter(*m_queue.last(), reference))) {
+            m_produced.wait(&m_lock);
+        }
+
+        while (m_queue.size() > 1 && isBefore(*m_queue.first(), reference) &&
+               distance(*m_queue.at(1), reference) <= distance(*m_queue.first(), reference)) {
+            m_queue.removeFirst();
+            m_discarded++;
+        }
+
+        m_consumed.wakeAll();
+
+        // The matched frames are kept in the queue as they could match the next reference too
+        if (!m_queue.isEmpty() && distance(*m_queue.first(), reference) <= tolerance)
+            return m_queue.first();
+
+        return nullptr;
+    }
+
+    qint64 discarded() const {return m_discarded;}
+
+    // Last matched frames, used again when no frame is near enough
+    shared_ptr<SyncFrames> current;
+
+protected:
+    void run() override
+    {
+        int loop = 0;
+        qint64 index = 0;
+        qint64 origin = -1;
+
+        while (m_running)
+        {
+            m_lock.lock();
+            while (m_running && m_queue.size() >= QueueSize)
+                m_consumed.wait(&m_lock);
+            m_lock.unlock();
+
+            if (!m_running)
+                break;
+
+            if (!m_instance->hasNext() && m_playloop) {
+                m_instance->restart();
+                loop++;
+                index = 0;
+                origin = -1;
+            }
+
+            if (!m_instance->hasNext())
+                break;
+
+            shared_ptr<SyncFrames> buffer = acquireBuffer();
+
+            if (!buffer)
+                break;
+
+            {
+                TraceScope scope("InstanceReader", "readNextFrame", index);
+                m_instance->readNextFrame(buffer->frames);
+            }
+
+            buffer->timestamp = m_instance->getTimestamp();
+            buffer->loop = loop;
+
+            if (buffer->timestamp >= 0) {
+                if (origin < 0)
+                    origin = buffer->timestamp;
+                buffer->time = buffer->timestamp - origin;
+            }
+            else {
+                buffer->time = index * m_interval;
+            }
+
+            index++;
+
+            m_lock.lock();
+            m_queue << buffer;
+            m_produced.wakeAll();
+            m_lock.unlock();
+        }
+
+        m_lock.lock();
+        m_finished = true;
+        m_produced.wakeAll();
+        m_lock.unlock();
+    }
+
+private:
+    static const int QueueSize = 4;
+    static const int PoolSize = QueueSize + 6; // Queue, output buffers, held frames and listeners
+
+    shared_ptr<SyncFrames> acquireBuffer()
+    {
+        while (m_running)
+        {
+            for (const shared_ptr<SyncFrames>& buffer : m_pool) {
+                if (isFree(buffer))
+                    return buffer;
+            }
+
+            if (m_pool.size() < PoolSize) {
+                shared_ptr<SyncFrames> buffer = make_shared<SyncFrames>();
+                const StreamInfo& info = m_instance->getStreamInfo();
+
+                foreach (DataFrame::FrameType type, StreamInstance::getTypes(m_instance->getSupportedFrames())) {
+                    buffer->frames.insert(type, DataFrame::create(type, info.width, info.height));
+                }
+
+                m_pool << buffer;
+                return buffer;
+            }
+
+            QThread::msleep(1);
+        }
+
+        return nullptr;
+    }
+
+    static bool isFree(const shared_ptr<SyncFrames>& buffer)
+    {
+        if (buffer.use_count() > 1)
+            return false;
+
+        foreach (const shared_ptr<DataFrame>& frame, buffer->frames) {
+            if (frame.use_count() > 1)
+                return false;
+        }
+
+        return true;
+    }
+
+    shared_ptr<StreamInstance>    m_instance;
+    const bool                    m_playloop;
+    const qint64                  m_interval;
+    std::atomic<bool>             m_running; // Read without the lock by run()
+    bool                          m_finished;
+    qint64                        m_discarded;
+    QList<shared_ptr<SyncFrames>> m_queue;
+    QList<shared_ptr<SyncFrames>> m_pool;  // Only used by this thread
+    QMutex                        m_lock;
+    QWaitCondition                m_produced;
+    QWaitCondition                m_consumed;
+};
+
+InstanceSynchroniser::InstanceSynchroniser()
+    : m_tolerance(20000) // 20 ms, a bit more than half a frame at 30 fps
+    , m_interval(33333)
+    , m_timestamp(-1)
+    , m_matched(0)
+    , m_reused(0)
+{
+}
+
+InstanceSynchroniser::~InstanceSynchroniser()
+{
+    stop();
+}
+
+void InstanceSynchroniser::setTolerance(qint64 usecs)
+{
+    m_tolerance = usecs;
+}
+
+void InstanceSynchroniser::setNominalFrameRate(float fps)
+{
+    m_interval = 1000000 / fps;
+}
+
+void InstanceSynchroniser::start(const QList<shared_ptr<StreamInstance>>& instances, bool playloop)
+{
+    stop();
+
+    foreach (shared_ptr<StreamInstance> instance, instances) {
+        InstanceReader* reader = new InstanceReader(instance, playloop, m_interval);
+        reader->setObjectName(QString("InstanceReader %1").arg(m_readers.size())); // Thread name in traces
+        m_readers << reader;
+        reader->start();
+    }
+
+    m_timestamp = -1;
+    m_matched = 0;
+    m_reused = 0;
+}
+
+void InstanceSynchroniser::stop()
+{
+    if (m_readers.isEmpty())
+        return;
+
+    qint64 discarded = 0;
+
+    foreach (InstanceReader* reader, m_readers) {
+        reader->stop();
+        discarded += reader->discarded();
+        delete reader;
+    }
+
+    m_readers.clear();
+
+    qDebug() << "InstanceSynchroniser - Matched:" << m_matched << "Reused:" << m_reused
+             << "Discarded:" << discarded;
+}
+
+bool InstanceSynchroniser::isRunning() const
+{
+    return !m_readers.isEmpty();
+}
+
+bool InstanceSynchroniser::read(QHashDataFrames& output)
+{
+    if (m_readers.isEmpty())
+        return false;
+
+    shared_ptr<SyncFrames> reference = m_readers.first()->take();
+
+    if (!reference)
+        return false;
+
+    m_timestamp = reference->timestamp;
+
+    // Frames are not copied, the output holds the buffers of the readers
+    foreach (DataFrame::FrameType type, reference->frames.keys()) {
+        output.insert(type, reference->frames.value(type));
+    }
+
+    for (int i=1; i<m_readers.size(); ++i)
+    {
+        InstanceReader* reader = m_readers.at(i);
+        shared_ptr<SyncFrames> frames = reader->nearest(*reference, m_tolerance);
+
+        if (frames) {
+            reader->current = frames;
+            m_matched++;
+        }
+        else if (reader->current) {
+            m_reused++;
+        }
+
+        if (reader->current) {
+            foreach (DataFrame::FrameType type, reader->current->frames.keys()) {
+                output.insert(type, reader->current->frames.value(type));
+            }
+        }
+    }
+
+    return true;
+}
+
+unsigned int InstanceSynchroniser::skip(unsigned int count)
+{
+    unsigned int skipped = 0;
+
+    if (m_readers.isEmpty())
+        return skipped;
+
+    while (skipped < count && m_readers.first()->take())
+        skipped++;
+
+    return skipped;
+}
+
+qint64 InstanceSynchroniser::timestamp() const
+{
+    return m_timestamp;
+}
+
+} // End Namespace
@@ -0,0 +1,73 @@
+#ifndef INSTANCESYNCHRONISER_H
+#define INSTANCESYNCHRONISER_H
+
+#include "types/StreamInstance.h"
+#include <QList>
+#include <memory>
+
+using namespace std;
+
+namespace dai {
+
+class InstanceReader;
+
+/**
+ * Reads every instance in its own thread and assembles the output matching each frame of
+ * the first instance (the reference) with the nearest frame of the other instances.
+ *
+ * Frames are matched by their source timestamp, relative to the first frame of the
+ * instance, or by their index at the nominal frame rate if the instance has no timestamps.
+ * Frames of different play loops never match.
+ *
+ * @brief The InstanceSynchroniser class
+ */
+class InstanceSynchroniser
+{
+public:
+    InstanceSynchroniser();
+    ~InstanceSynchroniser();
+
+    /**
+     * Maximum distance between matched frames in microseconds. When the nearest frame of an
+     * instance is farther, its last matched frame is used again.
+     */
+    void setTolerance(qint64 usecs);
+
+    /**
+     * Frame rate of the instances without timestamps
+     */
+    void setNominalFrameRate(float fps);
+
+    void start(const QList<shared_ptr<StreamInstance>>& instances, bool playloop);
+    void stop();
+    bool isRunning() const;
+
+    /**
+     * Returns false once the reference instance has no more frames
+     */
+    bool read(QHashDataFrames& output);
+
+    /**
+     * Discard the next count frames of the reference instance. Returns the discarded frames.
+     */
+    unsigned int skip(unsigned int count);
+
+    /**
+     * Source timestamp of the last reference frame in microseconds (-1 if it has none)
+     */
+    qint64 timestamp() const;
+
+private:
+    QList<InstanceReader*> m_readers;
+    qint64                 m_tolerance;
+    qint64                 m_interval;
+    qint64                 m_timestamp;
+
+    // Stats
+    qint64                 m_matched;
+    qint64                 m_reused;
+};
+
+} // End Namespace
+
+#endif // INSTANCESYNCHRONISER_H
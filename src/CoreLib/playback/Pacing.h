@@ -0,0 +1,52 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <QtGlobal>
+
+namespace dai {
+
+/**
+ * What PlaybackWorker does when it cannot keep up with the frame rate
+ */
+enum PacingPolicy {
+    PACING_NONE,      // Frame not produced by a paced generator
+    PACING_DROP,      // Skip source frames to catch up with the deadlines
+    PACING_SLOWDOWN,  // Deliver every frame, later deadlines are delayed
+    PACING_REALTIME   // Deadlines follow the source timestamps (frame rate if there are none)
+};
+
+/**
+ * Description of a produced frame that travels with it to the listeners
+ */
+struct FrameInfo
+{
+    qint64 frameId = 0;         // Frame counter of the generator
+    qint64 traceId = 0;         // Frame id of the source (see Tracer)
+    PacingPolicy policy = PACING_NONE;
+    qint64 lateness = 0;        // Delivery time minus deadline (ns)
+    int skipped = 0;            // Source frames dropped just before this one
+    qint64 sourceTimestamp = -1; // Microseconds, -1 if the source has no timestamps
+
+    // Filters keep the pacing of the frame they received (ids are their own)
+    void copyPacing(const FrameInfo& received) {
+        policy = received.policy;
+        lateness = received.lateness;
+        skipped = received.skipped;
+        sourceTimestamp = received.sourceTimestamp;
+    }
+};
+
+struct PacingStats
+{
+    PacingPolicy policy = PACING_DROP;
+    qint64 framesProduced = 0;
+    qint64 framesDropped = 0;
+    double meanLatenessMs = 0;
+    double jitterMs = 0;         // Standard deviation of the lateness
+    double maxLatenessMs = 0;
+    double fps = 0;              // Delivered frames per second
+};
+
+} // End Namespace
+
+#endif // PACING_H
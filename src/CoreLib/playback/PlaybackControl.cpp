@@ -9,6 +9,7 @@ PlaybackControl::PlaybackControl()
 {
     m_worker = new PlaybackWorker;
     m_worker->moveToThread(&m_workerThread);
+    m_workerThread.setObjectName("PlaybackWorker");
     QObject::connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
     m_workerThread.start();
 }
@@ -47,6 +48,26 @@ void PlaybackControl::setFPS(float fps)
     m_worker->setFPS(fps);
 }
 
+void PlaybackControl::setPacingPolicy(PacingPolicy policy)
+{
+    m_worker->setPacingPolicy(policy);
+}
+
+PacingStats PlaybackControl::pacingStats() const
+{
+    return m_worker->stats();
+}
+
+void PlaybackControl::enableSynchronisation(bool value)
+{
+    m_worker->enableSynchronisation(value);
+}
+
+void PlaybackControl::setSyncTolerance(qint64 usecs)
+{
+    m_worker->setSyncTolerance(usecs);
+}
+
 void PlaybackControl::addListener(FrameListener *listener)
 {
     m_worker->addListener(listener);
@@ -3,6 +3,7 @@
 
 #include <QThread>
 #include "types/StreamInstance.h"
+#include "playback/Pacing.h"
 #include <memory>
 
 using namespace std;
@@ -23,7 +24,19 @@ public:
     void removeInstance(shared_ptr<StreamInstance> instance);
     void clearInstances();
     void enablePlayLoop(bool value);
+
+    /**
+     * Frames are produced as fast as they are read when fps is 0
+     */
     void setFPS(float fps);
+    void setPacingPolicy(PacingPolicy policy);
+    PacingStats pacingStats() const;
+
+    /**
+     * Read the instances in parallel and match their frames by timestamp (see InstanceSynchroniser)
+     */
+    void enableSynchronisation(bool value);
+    void setSyncTolerance(qint64 usecs);
 
 // These could be slots
     void play(bool restartAll = false);
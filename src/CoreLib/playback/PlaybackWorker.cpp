@@ -1,8 +1,10 @@
 #include "PlaybackWorker.h"
 #include "FrameListener.h"
+#include "Tracer.h"
 #include <QtConcurrent/QtConcurrent>
 #include "exceptions/CannotOpenInstanceException.h"
 #include <QDebug>
+#include <cmath>
 
 namespace dai {
 
@@ -12,8 +14,11 @@ PlaybackWorker::PlaybackWorker()
     , m_running(false)
     , m_paused(false)
     , m_supportedFrames(DataFrame::Unknown)
+    , m_policy(PACING_DROP)
+    , m_synchronised(false)
 {
     superTimer.start();
+    resetPacing();
 }
 
 PlaybackWorker::~PlaybackWorker()
@@ -71,75 +76,95 @@ void PlaybackWorker::enablePlayLoop(bool value)
 
 void PlaybackWorker::setFPS(float fps)
 {
-    m_slotTime = 1000000000 / fps;
+    m_slotTime = fps > 0 ? qint64(1000000000 / fps) : 0;
+}
+
+void PlaybackWorker::setPacingPolicy(PacingPolicy policy)
+{
+    m_policy = policy;
+}
+
+void PlaybackWorker::enableSynchronisation(bool value)
+{
+    m_synchronised = value;
+}
+
+void PlaybackWorker::setSyncTolerance(qint64 usecs)
+{
+    m_synchroniser.setTolerance(usecs);
+}
+
+PacingStats PlaybackWorker::stats()
+{
+    QMutexLocker locker(&m_statsLock);
+    PacingStats result = m_stats;
+    result.policy = m_policy;
+
+    if (result.framesProduced > 0) {
+        const double mean = m_latenessSum / result.framesProduced;
+        result.meanLatenessMs = mean / 1000000.0;
+        result.jitterMs = sqrt(qMax(0.0, m_latenessSqSum / result.framesProduced - mean * mean)) / 1000000.0;
+    }
+
+    if (result.framesProduced > 1 && m_lastDelivery > m_firstDelivery)
+        result.fps = (result.framesProduced - 1) * 1000000000.0 / (m_lastDelivery - m_firstDelivery);
+
+    return result;
 }
 
 /**
- * @brief PlaybackControl::run
+ * @brief PlaybackWorker::run
  *
- * We assume that the reading from instances takes less time that the slot time available.
- * If this assumption does not fulfil, time restrictions are not satisfied.
+ * Frames are read as soon as the previous one has been delivered and they are held until
+ * their deadline, so the time spent reading does not add jitter.
  */
 void PlaybackWorker::run()
 {
-    QElapsedTimer timer;
-    qint64 remainingTime = 0;
-    qint64 totalTime = 0;
-    qint64 global_deviation = 0;
-    qint64 skip_counter = 0;
-
     restartStats();
     FrameGenerator::begin(true);
     openAllInstances();
-    m_running = true;
 
-    timer.start();
+    if (m_synchronised)
+        m_synchroniser.start(m_instances, m_playloop_enabled);
+
+    resetPacing();
+    m_running = true;
 
     while (m_running)
     {
-        if (global_deviation >= -m_slotTime)
-        {
-            // Do something
-            if (!m_paused) {
-                bool hasProduced = generate();
-
-                if (!hasProduced || subscribersCount() == 0)
-                    m_running = false;
-
-                // Time management: Do I have free time?
-                remainingTime = m_slotTime - timer.nsecsElapsed();
-            }
-
-            if (remainingTime > 1500000) {
-                QThread::currentThread()->usleep((remainingTime - 1000000) / 1000); // FIX: usleep resolution is between 1 ms
-            }
-        }
-        else {
-            qDebug() << "PlaybackWorker - Skip Frame" << productsCount();
-            skip_counter++;
+        if (m_paused) {
+            // Deadlines are moved forward while paused
+            qint64 start = m_clock.nsecsElapsed();
+            QThread::currentThread()->msleep(qMax<qint64>(1, m_slotTime / 1000000));
+            qint64 pausedTime = m_clock.nsecsElapsed() - start;
+            m_origin += pausedTime;
+            if (m_nextDeadline >= 0)
+                m_nextDeadline += pausedTime;
+            continue;
         }
 
-        totalTime += timer.nsecsElapsed();
-        global_deviation += m_slotTime - timer.nsecsElapsed();
+        bool hasProduced = generate();
 
-        if ( (productsCount() + skip_counter) % 100 == 0) {
-            qDebug() << "PlaybackWorker is running" << productsCount() << "fps" << getFrameRate()
-                     << "capacity" << getGeneratorCapacity();
+        if (!hasProduced || subscribersCount() == 0)
+            m_running = false;
 
-            /*qDebug() << "Available Time (ms)" << m_slotTime / 1000000.0f
-                     << "Remaining (ms)" << remainingTime / 1000000.0f
-                     << "Deviation (ms)" << global_deviation / 1000000.0f;*/
+        if (productsCount() % 100 == 0) {
+            PacingStats stats = this->stats();
+            qDebug() << "PlaybackWorker is running" << productsCount() << "fps" << stats.fps
+                     << "capacity" << getGeneratorCapacity() << "dropped" << stats.framesDropped
+                     << "jitter (ms)" << stats.jitterMs;
         }
-
-        timer.start();
     }
 
+    m_synchroniser.stop();
     closeAllInstances();
 
-    qint64 pCounter = productsCount() + skip_counter;
+    PacingStats stats = this->stats();
 
-    if (pCounter > 0)
-        qDebug() << "Average Time:" << (totalTime / pCounter) / 1000 << "Frame Count:" << pCounter << "Skip" << skip_counter;
+    if (stats.framesProduced > 0)
+        qDebug() << "Frame Count:" << stats.framesProduced << "Dropped:" << stats.framesDropped
+                 << "Mean lateness (ms):" << stats.meanLatenessMs << "Jitter (ms):" << stats.jitterMs
+                 << "Max lateness (ms):" << stats.maxLatenessMs;
 }
 
 void PlaybackWorker::stop()
@@ -199,7 +224,81 @@ inline void PlaybackWorker::closeAllInstances()
 // Release: 10 ms
 void PlaybackWorker::produceFrames(QHashDataFrames& output)
 {
+    const qint64 slotTime = m_slotTime;
+    const PacingPolicy policy = m_policy;
+    const qint64 interval = policy == PACING_REALTIME && m_sourceInterval > 0 ? m_sourceInterval : slotTime;
+    int skipped = 0;
+
+    // Drop to catch up: skip the source frames whose deadline has already passed
+    if (policy != PACING_SLOWDOWN && m_nextDeadline >= 0 && interval > 0)
+    {
+        qint64 behind = m_clock.nsecsElapsed() - m_nextDeadline;
+
+        if (behind > interval) {
+            skipped = skipAllInstances(behind / interval, output);
+            m_nextDeadline += skipped * interval;
+        }
+    }
+
+    // Nothing is delivered at the end of the stream, so generate() fails and run() stops
+    if (!readAllInstances(output)) {
+        output.clear();
+        return;
+    }
+
+    // Deadline of this frame
+    qint64 deadline = m_nextDeadline >= 0 ? m_nextDeadline : m_clock.nsecsElapsed();
+    qint64 timestamp = sourceTimestamp();
+
+    if (policy == PACING_REALTIME && timestamp >= 0)
+    {
+        // First frame or the source has been restarted
+        if (m_sourceOrigin < 0 || timestamp < m_lastSourceTimestamp) {
+            m_sourceOrigin = timestamp;
+            m_origin = deadline;
+        }
+        else {
+            m_sourceInterval = (timestamp - m_lastSourceTimestamp) * 1000;
+        }
+
+        deadline = m_origin + (timestamp - m_sourceOrigin) * 1000;
+    }
+    else if (policy == PACING_SLOWDOWN) {
+        deadline = qMax(deadline, m_clock.nsecsElapsed());
+    }
+
+    m_lastSourceTimestamp = timestamp;
+
+    waitUntil(deadline);
+
+    qint64 lateness = m_clock.nsecsElapsed() - deadline;
+    m_nextDeadline = deadline + (policy == PACING_REALTIME && m_sourceInterval > 0 ? m_sourceInterval : slotTime);
+
+    m_frameInfo.policy = policy;
+    m_frameInfo.lateness = lateness;
+    m_frameInfo.skipped = skipped;
+    m_frameInfo.sourceTimestamp = timestamp;
+    updateStats(lateness, skipped);
+}
+
+void PlaybackWorker::describeFrame(FrameInfo& info)
+{
+    info.policy = m_frameInfo.policy;
+    info.lateness = m_frameInfo.lateness;
+    info.skipped = m_frameInfo.skipped;
+    info.sourceTimestamp = m_frameInfo.sourceTimestamp;
+}
+
+// Returns false when no instance has more frames
+bool PlaybackWorker::readAllInstances(QHashDataFrames& output)
+{
+    if (m_synchroniser.isRunning()) {
+        TraceScope scope(generatorName(), "readNextFrame");
+        return m_synchroniser.read(output);
+    }
+
     QList<shared_ptr<StreamInstance>> instances = m_instances; // implicit sharing
+    bool hasRead = false;
 
     foreach (shared_ptr<StreamInstance> instance, instances)
     {
@@ -211,13 +310,106 @@ void PlaybackWorker::produceFrames(QHashDataFrames& output)
         }
 
         if (hasNext) {
+            TraceScope scope(generatorName(), "readNextFrame");
             instance->readNextFrame(output);
+            hasRead = true;
         }
         else {
             instance->close();
             qDebug() << "Closed";
         }
     }
+
+    return hasRead;
+}
+
+// All the instances skip the same number of frames, the fewest that any of them can skip,
+// so they keep synchronised
+int PlaybackWorker::skipAllInstances(int count, QHashDataFrames& scratch)
+{
+    TraceScope scope(generatorName(), "skipFrames");
+    int skipped = count;
+
+    if (m_synchroniser.isRunning()) {
+        skipped = m_synchroniser.skip(count);
+    }
+    else {
+        foreach (shared_ptr<StreamInstance> instance, m_instances) {
+            if (instance->is_open())
+                skipped = qMin<int>(skipped, instance->skippableFrames(count));
+        }
+
+        foreach (shared_ptr<StreamInstance> instance, m_instances) {
+            if (instance->is_open() && int(instance->skipFrames(skipped, scratch)) != skipped)
+                qDebug() << "PlaybackWorker - An instance couldn't skip" << skipped << "frames";
+        }
+    }
+
+    if (skipped > 0)
+        Tracer::instant(generatorName(), "dropFrames", productsCount() + 1);
+
+    return skipped;
+}
+
+// Timestamp of the first instance that provides them
+qint64 PlaybackWorker::sourceTimestamp() const
+{
+    if (m_synchroniser.isRunning())
+        return m_synchroniser.timestamp();
+
+    foreach (shared_ptr<StreamInstance> instance, m_instances) {
+        if (instance->getTimestamp() >= 0)
+            return instance->getTimestamp();
+    }
+
+    return -1;
+}
+
+void PlaybackWorker::waitUntil(qint64 deadline)
+{
+    TraceScope scope(generatorName(), "wait");
+    qint64 remainingTime = deadline - m_clock.nsecsElapsed();
+
+    // usleep may oversleep about 1 ms, the end is waited yielding the CPU
+    if (remainingTime > 2000000)
+        QThread::currentThread()->usleep((remainingTime - 1500000) / 1000);
+
+    while (m_running && m_clock.nsecsElapsed() < deadline)
+        QThread::yieldCurrentThread();
+}
+
+void PlaybackWorker::resetPacing()
+{
+    m_clock.start();
+    m_nextDeadline = -1;
+    m_origin = 0;
+    m_sourceOrigin = -1;
+    m_lastSourceTimestamp = -1;
+    m_sourceInterval = 0;
+    m_frameInfo = FrameInfo();
+
+    QMutexLocker locker(&m_statsLock);
+    m_stats = PacingStats();
+    m_latenessSum = 0;
+    m_latenessSqSum = 0;
+    m_firstDelivery = -1;
+    m_lastDelivery = -1;
+}
+
+void PlaybackWorker::updateStats(qint64 lateness, int skipped)
+{
+    QMutexLocker locker(&m_statsLock);
+    qint64 now = m_clock.nsecsElapsed();
+
+    if (m_firstDelivery < 0)
+        m_firstDelivery = now;
+
+    m_lastDelivery = now;
+    m_stats.framesProduced++;
+    m_stats.framesDropped += skipped;
+    m_stats.maxLatenessMs = qMax(m_stats.maxLatenessMs, lateness / 1000000.0);
+    m_latenessSum += lateness;
+    m_latenessSqSum += double(lateness) * lateness;
 }
 
 } // End Namespace
@@ -3,7 +3,11 @@
 
 #include <QObject>
 #include "FrameGenerator.h"
+#include "Pacing.h"
+#include "InstanceSynchroniser.h"
 #include <QList>
+#include <QMutex>
+#include <QElapsedTimer>
 #include <memory>
 #include "types/StreamInstance.h"
 
@@ -13,6 +17,13 @@ namespace dai {
 
 class FrameListener;
 
+/**
+ * Reads the instances and delivers their frames at the configured frame rate. Every frame
+ * has an absolute deadline on a monotonic clock, what happens when a deadline is missed
+ * depends on the PacingPolicy.
+ *
+ * @brief The PlaybackWorker class
+ */
 class PlaybackWorker : public QObject, public FrameGenerator
 {
     Q_OBJECT
@@ -24,6 +35,7 @@ public:
     PlaybackWorker();
     ~PlaybackWorker();
     void pause();
+    const char* generatorName() const override {return "PlaybackWorker";}
 
 public slots:
     void run();
@@ -32,10 +44,15 @@ public slots:
 protected:
     void produceFrames(QHashDataFrames &output) override;
     shared_ptr<QHashDataFrames> allocateMemory() override;
+    void describeFrame(FrameInfo& info) override;
 
 private:
     void enablePlayLoop(bool value);
     void setFPS(float fps);
+    void setPacingPolicy(PacingPolicy policy);
+    void enableSynchronisation(bool value);
+    void setSyncTolerance(qint64 usecs);
+    PacingStats stats();
     bool addInstance(shared_ptr<StreamInstance> instance);
     void removeInstance(shared_ptr<StreamInstance> instance);
     void clearInstances();
@@ -43,12 +60,42 @@ private:
     void openAllInstances();
     void closeAllInstances();
 
+    // Pacing
+    void resetPacing();
+    bool readAllInstances(QHashDataFrames& output);
+    int skipAllInstances(int count, QHashDataFrames& scratch);
+    qint64 sourceTimestamp() const;
+    void waitUntil(qint64 deadline);
+    void updateStats(qint64 lateness, int skipped);
+
     QList<shared_ptr<StreamInstance>>  m_instances;
     bool                               m_playloop_enabled;
     qint64                             m_slotTime;
     bool                               m_running;
     bool                               m_paused;
     DataFrame::SupportedFrames         m_supportedFrames;
+
+    // Pacing (times in ns since m_clock started)
+    PacingPolicy                       m_policy;
+    QElapsedTimer                      m_clock;
+    qint64                             m_nextDeadline;   // -1 before the first frame
+    qint64                             m_origin;         // Deadline of the first source timestamp
+    qint64                             m_sourceOrigin;   // First source timestamp (us)
+    qint64                             m_lastSourceTimestamp;
+    qint64                             m_sourceInterval; // Time between the last two source frames
+    FrameInfo                          m_frameInfo;
+
+    // Instances read in parallel and matched by timestamp
+    bool                               m_synchronised;
+    InstanceSynchroniser               m_synchroniser;
+
+    // Stats
+    QMutex                             m_statsLock;
+    PacingStats                        m_stats;
+    double                             m_latenessSum;
+    double                             m_latenessSqSum;
+    qint64                             m_firstDelivery;
+    qint64                             m_lastDelivery;
 };
 
 } // End Namespace
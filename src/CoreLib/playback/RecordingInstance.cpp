@@ -0,0 +1,107 @@
+#include "RecordingInstance.h"
+#include <QDebug>
+
+namespace dai {
+
+// Frames and size of the stream are known before opening it
+static StreamRecording::Header recordingHeader(const QString& fileName)
+{
+    StreamRecording::Header header;
+
+    if (!StreamRecording::readHeader(fileName, &header))
+        qDebug() << "RecordingInstance - Invalid recording" << fileName;
+
+    return header;
+}
+
+RecordingInstance::RecordingInstance(const QString& fileName)
+    : RecordingInstance(fileName, recordingHeader(fileName))
+{
+}
+
+RecordingInstance::RecordingInstance(const QString& fileName, const StreamRecording::Header& header)
+    : StreamInstance(header.frames, header.width, header.height)
+    , m_fileName(fileName)
+    , m_nextFrame(0)
+{
+}
+
+RecordingInstance::~RecordingInstance()
+{
+    closeInstance();
+}
+
+bool RecordingInstance::is_open() const
+{
+    return m_recording.isOpen();
+}
+
+bool RecordingInstance::hasNext() const
+{
+    return is_open() && m_nextFrame < m_recording.framesCount();
+}
+
+int RecordingInstance::framesCount() const
+{
+    return m_recording.framesCount();
+}
+
+bool RecordingInstance::openInstance()
+{
+    m_nextFrame = 0;
+    return m_recording.open(m_fileName);
+}
+
+void RecordingInstance::closeInstance()
+{
+    m_recording.close();
+}
+
+void RecordingInstance::restartInstance()
+{
+    m_nextFrame = 0;
+}
+
+// Frames of the stream that aren't in the record are removed from output. Corrupt records
+// are skipped, output is only empty when no valid record is left
+void RecordingInstance::nextFrame(QHashDataFrames& output)
+{
+    QHashDataFrames frames;
+
+    for (DataFrame::FrameType type : getTypes(getSupportedFrames())) {
+        if (output.contains(type))
+            frames.insert(type, output.take(type));
+    }
+
+    qint64 timestamp = -1;
+    bool valid = false;
+
+    while (!valid && m_nextFrame < m_recording.framesCount())
+    {
+        const QByteArray record = m_recording.readRecord(m_nextFrame);
+        valid = StreamRecording::decodeFrames(record, frames, &timestamp);
+
+        if (!valid)
+            qDebug() << "RecordingInstance - Frame" << m_nextFrame << "of" << m_fileName << "is corrupt, skipped";
+
+        m_nextFrame++;
+    }
+
+    if (!valid) {
+        frames.clear();
+        timestamp = -1;
+    }
+
+    for (auto it = frames.constBegin(); it != frames.constEnd(); ++it)
+        output.insert(it.key(), it.value());
+
+    setTimestamp(timestamp);
+}
+
+bool RecordingInstance::seekInstance(unsigned int count)
+{
+    m_nextFrame = qMin<qint64>(qint64(m_nextFrame) + count, m_recording.framesCount());
+    return true;
+}
+
+} // End Namespace
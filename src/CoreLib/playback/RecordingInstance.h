@@ -0,0 +1,45 @@
+#ifndef RECORDINGINSTANCE_H
+#define RECORDINGINSTANCE_H
+
+#include "types/StreamInstance.h"
+#include "playback/StreamRecording.h"
+
+namespace dai {
+
+/**
+ * Replay of a file written by StreamRecorder. It produces the recorded frames with
+ * their capture timestamps, so PlaybackControl with PACING_REALTIME keeps the original
+ * timing, and with PACING_SLOWDOWN and setFPS(0) they are read as fast as possible.
+ *
+ * The index of the recording is used to skip frames without reading them.
+ *
+ * @brief The RecordingInstance class
+ */
+class RecordingInstance : public StreamInstance
+{
+public:
+    explicit RecordingInstance(const QString& fileName);
+    virtual ~RecordingInstance();
+    bool is_open() const override;
+    bool hasNext() const override;
+    int framesCount() const;
+    const QString& fileName() const {return m_fileName;}
+
+protected:
+    bool openInstance() override;
+    void closeInstance() override;
+    void restartInstance() override;
+    void nextFrame(QHashDataFrames& output) override;
+    bool seekInstance(unsigned int count) override;
+
+private:
+    RecordingInstance(const QString& fileName, const StreamRecording::Header& header);
+
+    QString m_fileName;
+    StreamRecording m_recording;
+    int m_nextFrame;
+};
+
+} // End Namespace
+
+#endif // RECORDINGINSTANCE_H
@@ -0,0 +1,352 @@
+#include "RingRecorder.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QDebug>
+#include <atomic>
+
+#ifdef Q_OS_UNIX
+    #include <signal.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+namespace dai {
+
+static const int MAX_QUEUE_SIZE = 2;
+static const int MAX_RECORDERS = 8;
+static const unsigned long FLUSH_POLL_MS = 250;
+
+// Recorders seen by the signal handlers
+static std::atomic<RingRecorder*> s_recorders[MAX_RECORDERS];
+static std::atomic<int> s_flushRequests(0);
+static std::atomic<bool> s_crashed(false);
+
+#ifdef Q_OS_UNIX
+// write() may write less than asked, or be interrupted
+static bool writeAll(int fd, const char* data, qint64 size)
+{
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+
+        if (written < 0 && errno == EINTR)
+            continue;
+        else if (written <= 0)
+            return false;
+
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+#endif
+
+RingRecorder::RingRecorder(const QString& name, const QString& directory, const Settings& settings)
+    : m_name(name)
+    , m_directory(directory)
+    , m_settings(settings)
+    , m_running(true)
+    , m_framesReceived(0)
+    , m_framesDropped(0)
+    , m_bytesKept(0)
+    , m_memory(MemoryTracker::registerOwner("RingRecorder " + name, MemoryTracker::OWNER_CACHE))
+    , m_flushRequests(s_flushRequests.load())
+{
+    m_settings.frameStep = qMax(1, m_settings.frameStep);
+
+    // The crash handler can't create it
+    QDir().mkpath(directory);
+    m_crashFile = QFile::encodeName(QString("%1/%2-crash-%3%4").arg(directory).arg(name)
+                                    .arg(QCoreApplication::applicationPid()).arg(StreamRecording::extension()));
+
+    bool registered = false;
+
+    for (int i=0; i<MAX_RECORDERS && !registered; ++i) {
+        RingRecorder* empty = nullptr;
+        registered = s_recorders[i].compare_exchange_strong(empty, this);
+    }
+
+    if (!registered)
+        qDebug() << "RingRecorder - Too many recorders," << name << "won't be written on a crash";
+
+    start(QThread::LowPriority);
+}
+
+RingRecorder::~RingRecorder()
+{
+    for (int i=0; i<MAX_RECORDERS; ++i) {
+        RingRecorder* self = this;
+        s_recorders[i].compare_exchange_strong(self, nullptr);
+    }
+
+    stopListener();
+    close();
+    qDebug() << "RingRecorder::~RingRecorder";
+}
+
+// This method is called from the FrameNotifier thread
+void RingRecorder::newFrames(const QHashDataFrames dataFrames)
+{
+    record(dataFrames, frameInfo().sourceTimestamp);
+}
+
+void RingRecorder::record(const QHashDataFrames& frames, qint64 timestamp)
+{
+    QMutexLocker locker(&m_lock);
+
+    if (!m_running)
+        return;
+
+    if (m_framesReceived++ % m_settings.frameStep != 0)
+        return;
+
+    if (m_queue.size() >= MAX_QUEUE_SIZE) {
+        m_framesDropped++;
+        return;
+    }
+
+    if (!m_clock.isValid())
+        m_clock.start();
+
+    Bundle bundle;
+    bundle.timestamp = timestamp >= 0 ? timestamp : m_clock.nsecsElapsed() / 1000;
+
+    // Producer reuses its buffers, so the frames must be copied
+    for (auto it = frames.constBegin(); it != frames.constEnd(); ++it)
+        bundle.frames.insert(it.key(), it.value()->clone());
+
+    m_queue.enqueue(bundle);
+    m_sync.wakeOne();
+}
+
+void RingRecorder::afterStop()
+{
+    close();
+}
+
+void RingRecorder::close()
+{
+    m_lock.lock();
+    m_running = false;
+    m_sync.wakeOne();
+    m_lock.unlock();
+
+    if (QThread::currentThread() != this)
+        this->wait();
+}
+
+// Encoder thread
+void RingRecorder::run()
+{
+    forever {
+        Bundle bundle;
+        bool received = false;
+
+        m_lock.lock();
+
+        // Wake up from time to time to check flush requests
+        if (m_running && m_queue.isEmpty())
+            m_sync.wait(&m_lock, FLUSH_POLL_MS);
+
+        if (!m_queue.isEmpty()) {
+            bundle = m_queue.dequeue();
+            received = true;
+        }
+        else if (!m_running) {
+            m_lock.unlock();
+            break;
+        }
+
+        m_lock.unlock();
+
+        if (received)
+            keep(bundle);
+
+        const int requests = s_flushRequests.load();
+
+        if (requests != m_flushRequests) {
+            m_flushRequests = requests;
+            flush();
+        }
+    }
+}
+
+void RingRecorder::keep(const Bundle& bundle)
+{
+    // Encoding is the expensive part, it's done out of the lock
+    Record record;
+    record.data = StreamRecording::encodeFrames(bundle.frames, bundle.timestamp, m_settings.compression);
+    record.timestamp = bundle.timestamp;
+
+    StreamRecording::Header header = StreamRecording::headerOf(bundle.frames);
+
+    QMutexLocker locker(&m_ringLock);
+
+    // Types of every kept bundle, size of the first one
+    header.frames |= m_header.frames;
+
+    if (m_header.width > 0) {
+        header.width = m_header.width;
+        header.height = m_header.height;
+    }
+
+    if (header.frames != m_header.frames || header.width != m_header.width || m_headerData.isEmpty()) {
+        m_header = header;
+        m_headerData = StreamRecording::headerData(header);
+    }
+
+    m_ring.enqueue(record);
+    m_bytesKept += record.data.size();
+
+    // Drop the oldest records
+    const qint64 maxBytes = qint64(m_settings.maxMegabytes) * 1024 * 1024;
+    const qint64 maxTime = qint64(m_settings.seconds) * 1000000;
+
+    while (m_ring.size() > 1 && (m_bytesKept > maxBytes || record.timestamp - m_ring.head().timestamp > maxTime))
+        m_bytesKept -= m_ring.dequeue().data.size();
+
+    m_memory.set(m_bytesKept);
+}
+
+// Over the memory budget the ring is emptied, it fills again once frames are delivered
+void RingRecorder::releaseMemory()
+{
+    m_lock.lock();
+    m_framesDropped += m_queue.size();
+    m_queue.clear();
+    m_lock.unlock();
+
+    QMutexLocker locker(&m_ringLock);
+    m_ring.clear();
+    m_bytesKept = 0;
+    m_memory.set(0);
+    qDebug() << "RingRecorder" << m_name << "- Ring emptied to release memory";
+}
+
+QString RingRecorder::flush()
+{
+    const QString fileName = QString("%1/%2-%3%4").arg(m_directory).arg(m_name)
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz")).arg(StreamRecording::extension());
+
+    return flush(fileName) ? fileName : QString();
+}
+
+bool RingRecorder::flush(const QString& fileName)
+{
+    // Records are shared, so the copy is cheap and the ring keeps running while writing
+    m_ringLock.lock();
+    const QQueue<Record> ring = m_ring;
+    const StreamRecording::Header header = m_header;
+    m_ringLock.unlock();
+
+    if (ring.isEmpty()) {
+        qDebug() << "RingRecorder - Nothing to write in" << fileName;
+        return false;
+    }
+
+    StreamRecording recording;
+
+    if (!recording.create(fileName, header))
+        return false;
+
+    for (const Record& record : ring) {
+        if (!recording.append(record.data, record.timestamp)) {
+            qDebug() << "RingRecorder - Error writing" << fileName;
+            return false;
+        }
+    }
+
+    qDebug() << "RingRecorder -" << ring.size() << "frames written to" << fileName;
+    return true;
+}
+
+/**
+ * Called from a signal handler: only system calls, no memory is allocated. The ring is
+ * skipped if it was being changed when the process crashed.
+ */
+void RingRecorder::writeCrashFile()
+{
+#ifdef Q_OS_UNIX
+    if (!m_ringLock.tryLock())
+        return;
+
+    const QQueue<Record>& ring = m_ring; // const, so it isn't detached
+    const int fd = ring.isEmpty() ? -1 : ::open(m_crashFile.constData(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd >= 0)
+    {
+        bool ok = writeAll(fd, m_headerData.constData(), m_headerData.size());
+
+        for (auto it = ring.constBegin(); ok && it != ring.constEnd(); ++it) {
+            char prefix[StreamRecording::RECORD_HEADER_SIZE];
+            StreamRecording::recordHeader(it->data.size(), prefix);
+            ok = writeAll(fd, prefix, sizeof(prefix)) && writeAll(fd, it->data.constData(), it->data.size());
+        }
+
+        ::close(fd);
+    }
+
+    m_ringLock.unlock();
+#endif
+}
+
+void RingRecorder::handleSignal(int signal)
+{
+#ifdef Q_OS_UNIX
+    if (signal == SIGUSR1) {
+        s_flushRequests++;
+        return;
+    }
+
+    if (!s_crashed.exchange(true)) {
+        for (int i=0; i<MAX_RECORDERS; ++i) {
+            RingRecorder* recorder = s_recorders[i].load();
+            if (recorder)
+                recorder->writeCrashFile();
+        }
+    }
+
+    // The handler has been reset, so the signal ends the process as usual
+    raise(signal);
+#else
+    Q_UNUSED(signal);
+#endif
+}
+
+void RingRecorder::installHandlers()
+{
+#ifdef Q_OS_UNIX
+    struct sigaction action = {};
+    sigemptyset(&action.sa_mask);
+    action.sa_handler = &RingRecorder::handleSignal;
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+
+    action.sa_flags = SA_RESETHAND;
+
+    for (int signal : {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT, SIGTERM})
+        sigaction(signal, &action, nullptr);
+#else
+    qDebug() << "RingRecorder - Signal handlers are only available on Unix";
+#endif
+}
+
+RingRecorder::Stats RingRecorder::stats() const
+{
+    Stats result;
+
+    m_lock.lock();
+    result.framesReceived = m_framesReceived;
+    result.framesDropped = m_framesDropped;
+    m_lock.unlock();
+
+    QMutexLocker locker(&m_ringLock);
+    result.framesKept = m_ring.size();
+    result.bytesKept = m_bytesKept;
+    result.secondsKept = m_ring.isEmpty() ? 0 : (m_ring.last().timestamp - m_ring.head().timestamp) / 1000000;
+    return result;
+}
+
+} // End Namespace
@@ -0,0 +1,123 @@
+#ifndef RINGRECORDER_H
+#define RINGRECORDER_H
+
+#include "playback/FrameListener.h"
+#include "playback/StreamRecording.h"
+#include "types/MemoryTracker.h"
+#include <QThread>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QQueue>
+#include <QElapsedTimer>
+
+namespace dai {
+
+/**
+ * Always-on listener that keeps the last seconds of received frames in memory, so they
+ * can be inspected when something goes wrong. Bundles are copied into a short queue and
+ * encoded as StreamRecording records by a low priority thread, which keeps them in a ring
+ * bounded by time and by size. When the encoder is behind, new bundles are dropped, so the
+ * producer is never slowed down.
+ *
+ * The ring is written as a recording (played with RecordingInstance) by flush(), by every
+ * recorder when the process receives SIGUSR1, and by a crash handler when the process is
+ * killed by a fatal signal. See installHandlers().
+ *
+ * @brief The RingRecorder class
+ */
+class RingRecorder : public QThread, public FrameListener
+{
+public:
+    struct Settings {
+        int seconds = 10;               // Time kept in the ring
+        int maxMegabytes = 128;         // Size of the ring (encoded)
+        int frameStep = 1;              // Only one of every frameStep bundles is kept
+        StreamRecording::Compression compression = StreamRecording::COMPRESSION_CODEC;
+    };
+
+    struct Stats {
+        qint64 framesReceived;
+        qint64 framesDropped;
+        int    framesKept;
+        qint64 bytesKept;
+        qint64 secondsKept;
+    };
+
+    /**
+     * Files are written in directory, with name as prefix
+     */
+    RingRecorder(const QString& name, const QString& directory, const Settings& settings = Settings());
+    virtual ~RingRecorder();
+
+    /**
+     * Keep frames that don't come from a FrameGenerator. timestamp is in microseconds, the
+     * time they are received is used when it's -1.
+     */
+    void record(const QHashDataFrames& frames, qint64 timestamp = -1);
+
+    /**
+     * Write the ring to a new file named after the current time. Returns its name, or an
+     * empty string on error.
+     */
+    QString flush();
+    bool flush(const QString& fileName);
+
+    Stats stats() const;
+    const char* listenerName() const override {return "RingRecorder";}
+
+    /**
+     * SIGUSR1 flushes every recorder (from its thread), and SIGSEGV, SIGBUS, SIGILL, SIGFPE,
+     * SIGABRT and SIGTERM write every ring to <name>-crash-<pid>.dair before the process
+     * ends. Only available on Unix.
+     */
+    static void installHandlers();
+
+protected:
+    void newFrames(const QHashDataFrames dataFrames) override;
+    void afterStop() override;
+    void releaseMemory() override;
+    void run() override;
+
+private:
+    struct Bundle {
+        QHashDataFrames frames;
+        qint64 timestamp;
+    };
+
+    struct Record {
+        QByteArray data;
+        qint64 timestamp;
+    };
+
+    static void handleSignal(int signal);
+    void keep(const Bundle& bundle);
+    void writeCrashFile();
+    void close();
+
+    QString m_name;
+    QString m_directory;
+    QByteArray m_crashFile;     // Encoded in advance, for the signal handler
+    Settings m_settings;
+    QElapsedTimer m_clock;
+
+    // Queue (shared with the encoder thread)
+    mutable QMutex m_lock;
+    QWaitCondition m_sync;
+    QQueue<Bundle> m_queue;
+    bool m_running;
+    qint64 m_framesReceived;
+    qint64 m_framesDropped;
+
+    // Ring (shared with flush)
+    mutable QMutex m_ringLock;
+    QQueue<Record> m_ring;
+    StreamRecording::Header m_header;
+    QByteArray m_headerData;
+    qint64 m_bytesKept;
+    MemoryCharge m_memory;      // The ring, charged as a cache
+    int m_flushRequests;        // Last SIGUSR1 count seen
+};
+
+} // End Namespace
+
+#endif // RINGRECORDER_H
@@ -0,0 +1,106 @@
+#include "SegmentationFilter.h"
+#include "types/DepthFrame.h"
+#include "types/MaskFrame.h"
+#include "types/MetadataFrame.h"
+#include "playback/Tracer.h"
+#include <QDebug>
+
+namespace dai {
+
+SegmentationFilter::SegmentationFilter()
+    : m_initialised(false)
+    , m_replaceMask(false)
+{
+}
+
+SegmentationFilter::~SegmentationFilter()
+{
+    stopListener();
+    qDebug() << "SegmentationFilter::~SegmentationFilter";
+}
+
+shared_ptr<QHashDataFrames> SegmentationFilter::allocateMemory()
+{
+    m_frames = make_shared<QHashDataFrames>();
+    return m_frames;
+}
+
+void SegmentationFilter::setSettings(const DepthSegmenter::Settings& settings)
+{
+    QMutexLocker locker(&m_lock);
+    m_segmenter.setSettings(settings);
+    m_segmenter.reset();
+}
+
+void SegmentationFilter::setReplaceMask(bool value)
+{
+    QMutexLocker locker(&m_lock);
+    m_replaceMask = value;
+}
+
+// This method is called from a thread
+void SegmentationFilter::newFrames(const QHashDataFrames dataFrames)
+{
+    if (!m_initialised) {
+        FrameGenerator::begin(false);
+        m_initialised = true;
+    }
+
+    // Copy frames
+    m_frames->clear();
+
+    foreach (DataFrame::FrameType key, dataFrames.keys()) {
+        shared_ptr<DataFrame> frame = dataFrames.value(key);
+        m_frames->insert(key, frame->clone());
+    }
+
+    if (!hasExpired()) {
+        if (subscribersCount() == 0 || !generate()) {
+            qDebug() << "SegmentationFilter: No listeners or Nothing produced";
+            stopListener();
+        }
+    }
+    else {
+        qDebug() << "SegmentationFilter - Frame copied out of time";
+        Tracer::instant(listenerName(), "expired", Tracer::currentFrame());
+    }
+}
+
+void SegmentationFilter::describeFrame(FrameInfo& info)
+{
+    info.copyPacing(frameInfo());
+}
+
+void SegmentationFilter::afterStop()
+{
+    QMutexLocker locker(&m_lock);
+    m_segmenter.reset();
+    m_initialised = false;
+}
+
+void SegmentationFilter::produceFrames(QHashDataFrames& output)
+{
+    if (!output.contains(DataFrame::Depth))
+        return;
+
+    QMutexLocker locker(&m_lock);
+
+    if (output.contains(DataFrame::Mask) && !m_replaceMask)
+        return;
+
+    TraceScope scope(generatorName(), "segment");
+    shared_ptr<DepthFrame> depthFrame = static_pointer_cast<DepthFrame>(output.value(DataFrame::Depth));
+    shared_ptr<MaskFrame> maskFrame = make_shared<MaskFrame>(depthFrame->width(), depthFrame->height());
+    shared_ptr<MetadataFrame> metadataFrame;
+
+    if (!output.contains(DataFrame::Metadata)) {
+        metadataFrame = make_shared<MetadataFrame>();
+        output.insert(DataFrame::Metadata, metadataFrame);
+    }
+
+    m_segmenter.segment(*depthFrame, *maskFrame, metadataFrame.get());
+    maskFrame->setIndex(depthFrame->getIndex());
+    output.insert(DataFrame::Mask, maskFrame);
+}
+
+} // End Namespace
@@ -0,0 +1,46 @@
+#ifndef SEGMENTATIONFILTER_H
+#define SEGMENTATIONFILTER_H
+
+#include "playback/FrameListener.h"
+#include "playback/FrameGenerator.h"
+#include "playback/DepthSegmenter.h"
+#include <QMutex>
+
+namespace dai {
+
+/**
+ * Stage that adds the user mask of the received depth frames (see DepthSegmenter), so
+ * the privacy filters work with depth sources that have no user tracker. When a mask is
+ * received it is kept, unless replaceMask is set. A metadata frame with the bounding
+ * boxes of the users is added along with the mask if there is none.
+ *
+ * @brief The SegmentationFilter class
+ */
+class SegmentationFilter : public FrameListener, public FrameGenerator
+{
+public:
+    SegmentationFilter();
+    ~SegmentationFilter();
+    void newFrames(const QHashDataFrames dataFrames) override;
+    void setSettings(const DepthSegmenter::Settings& settings);
+    void setReplaceMask(bool value);
+    const char* listenerName() const override {return "SegmentationFilter";}
+    const char* generatorName() const override {return "SegmentationFilter";}
+
+protected:
+    shared_ptr<QHashDataFrames> allocateMemory() override;
+    void afterStop() override;
+    void produceFrames(QHashDataFrames& output) override;
+    void describeFrame(FrameInfo& info) override;
+
+private:
+    shared_ptr<QHashDataFrames> m_frames;
+    DepthSegmenter m_segmenter;
+    QMutex m_lock;
+    bool m_initialised;
+    bool m_replaceMask;
+};
+
+} // End Namespace
+
+#endif // SEGMENTATIONFILTER_H
@@ -0,0 +1,682 @@
+#include "SharedFrameRing.h"
+#include "types/ColorFrame.h"
+#include "types/DepthFrame.h"
+#include "types/MaskFrame.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QDebug>
+#include <atomic>
+#include <limits>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+    #include <signal.h>
+    #include <cerrno>
+#endif
+
+namespace dai {
+
+static const quint32 MAGIC = 0x44414953;    // DAIS
+static const quint32 VERSION = 1;
+static const int ALIGNMENT = 64;            // Rows start at a cache line
+static const unsigned long POLL_US = 500;
+static const quint64 NOTHING_UNREAD = std::numeric_limits<quint64>::max();
+
+// The segment is shared by processes, so its atomics can't use locks
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "Atomics of the segment must be lock free");
+
+struct ReaderEntry {
+    std::atomic<qint64> pid;            // 0 if free, -1 while it's being reclaimed
+    std::atomic<quint64> pins;          // One bit per pinned slot
+    std::atomic<quint64> lastSequence;  // Last bundle read by a sequential reader
+};
+
+struct SharedFrameRing::SegmentHeader {
+    std::atomic<quint32> magic;         // Written last, once the header is valid
+    quint32 version;
+    qint32 slotCount;
+    qint32 slotBytes;                   // Including the SlotHeader
+    quint32 frames;
+    qint32 width;
+    qint32 height;
+    std::atomic<qint64> writerPid;      // 0 once the writer has closed
+    std::atomic<quint64> latest;        // Sequence of the last written bundle
+    ReaderEntry readers[MAX_READERS];
+};
+
+struct SharedFrameRing::SlotHeader {
+    std::atomic<qint32> readers;        // Pins, -1 while the writer is using the slot
+    std::atomic<quint64> sequence;      // 0 if empty
+    qint64 timestamp;
+    quint32 count;                      // Frames of the bundle
+};
+
+// Frames of a slot, after its SlotHeader
+struct FrameEntry {
+    quint32 type;           // Unknown for a StreamRecording record of the other frames
+    quint32 index;
+    qint32 width;
+    qint32 height;
+    qint32 offsetX;
+    qint32 offsetY;
+    quint32 units;
+    quint32 offset;         // From the start of the slot data
+    quint32 size;
+};
+
+static inline qint64 alignUp(qint64 size)
+{
+    return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+static const int HEADER_SIZE = int(alignUp(sizeof(SharedFrameRing::SegmentHeader)));
+static const int SLOT_HEADER_SIZE = int(alignUp(sizeof(SharedFrameRing::SlotHeader)));
+
+static qint64 currentPid()
+{
+    return QCoreApplication::applicationPid();
+}
+
+static bool isAlive(qint64 pid)
+{
+#ifdef Q_OS_UNIX
+    return ::kill(pid_t(pid), 0) == 0 || errno == EPERM;
+#else
+    Q_UNUSED(pid);
+    return true;
+#endif
+}
+
+template <class T, class Pixel>
+static FrameEntry describeImage(const DataFramePtr& dataFrame, qint64 offset)
+{
+    shared_ptr<T> frame = static_pointer_cast<T>(dataFrame);
+    FrameEntry entry;
+    entry.type = frame->getType();
+    entry.index = frame->getIndex();
+    entry.width = frame->width();
+    entry.height = frame->height();
+    entry.offsetX = frame->offset()[0];
+    entry.offsetY = frame->offset()[1];
+    entry.units = 0;
+    entry.offset = quint32(offset);
+    entry.size = quint32(qint64(frame->width()) * frame->height() * sizeof(Pixel));
+    return entry;
+}
+
+// Rows of views may have a stride, in the slot they are contiguous
+template <class T, class Pixel>
+static void copyImage(const DataFramePtr& dataFrame, uchar* destination)
+{
+    shared_ptr<T> frame = static_pointer_cast<T>(dataFrame);
+    const size_t rowSize = frame->width() * sizeof(Pixel);
+
+    for (int i=0; i<frame->height(); ++i)
+        memcpy(destination + i * rowSize, frame->getRowPtr(i), rowSize);
+}
+
+template <class T, class Pixel>
+static shared_ptr<T> readImage(const FrameEntry& entry, const uchar* data, DataFramePtr existing, shared_ptr<void> owner)
+{
+    const Pixel* pixels = (const Pixel*) (data + entry.offset);
+    shared_ptr<T> frame;
+
+    if (owner) {
+        frame = make_shared<T>();
+        frame->setDataPtr(entry.width, entry.height, pixels, entry.width * sizeof(Pixel), owner);
+    }
+    else {
+        frame = existing ? static_pointer_cast<T>(existing) : make_shared<T>();
+        frame->resize(entry.width, entry.height);
+
+        for (int i=0; i<entry.height; ++i)
+            memcpy(frame->getRowPtr(i), pixels + qint64(i) * entry.width, entry.width * sizeof(Pixel));
+    }
+
+    frame->setOffset(Point2i(entry.offsetX, entry.offsetY));
+    frame->setIndex(entry.index);
+    return frame;
+}
+
+/**
+ * Entries of the frames of a bundle. Colour, depth and masks are copied as they are, the
+ * other frames go in record. Returns the size of the slot data.
+ */
+static qint64 describeFrames(const QHashDataFrames& frames, qint64 timestamp, QVector<FrameEntry>* entries, QByteArray* record)
+{
+    QHashDataFrames others;
+    int count = 0;
+
+    for (auto it = frames.constBegin(); it != frames.constEnd(); ++it) {
+        if (it.key() == DataFrame::Color || it.key() == DataFrame::Depth || it.key() == DataFrame::Mask)
+            count++;
+        else
+            others.insert(it.key(), it.value());
+    }
+
+    count += !others.isEmpty();
+    qint64 offset = alignUp(count * sizeof(FrameEntry));
+    entries->clear();
+
+    if (frames.contains(DataFrame::Color)) {
+        *entries << describeImage<ColorFrame, RGBColor>(frames.value(DataFrame::Color), offset);
+        offset = alignUp(offset + entries->last().size);
+    }
+
+    if (frames.contains(DataFrame::Depth)) {
+        *entries << describeImage<DepthFrame, uint16_t>(frames.value(DataFrame::Depth), offset);
+        entries->last().units = static_pointer_cast<DepthFrame>(frames.value(DataFrame::Depth))->distanceUnits();
+        offset = alignUp(offset + entries->last().size);
+    }
+
+    if (frames.contains(DataFrame::Mask)) {
+        *entries << describeImage<MaskFrame, uint8_t>(frames.value(DataFrame::Mask), offset);
+        offset = alignUp(offset + entries->last().size);
+    }
+
+    record->clear();
+
+    if (!others.isEmpty())
+    {
+        *record = StreamRecording::encodeFrames(others, timestamp);
+        FrameEntry entry = {};
+        entry.type = DataFrame::Unknown;
+        entry.offset = quint32(offset);
+        entry.size = record->size();
+        *entries << entry;
+        offset = alignUp(offset + entry.size);
+    }
+
+    return offset;
+}
+
+SharedFrameRing::SharedFrameRing(const QString& name)
+    : m_name(name)
+    , m_writer(false)
+    , m_reader(-1)
+    , m_sequential(false)
+    , m_lastSequence(0)
+    , m_tooBigReported(false)
+{
+    m_memory.setKey("dai-frames-" + name);
+    m_stats.framesWritten = 0;
+    m_stats.framesDropped = 0;
+    m_stats.framesRead = 0;
+}
+
+SharedFrameRing::~SharedFrameRing()
+{
+    if (m_writer)
+        closeWriter();
+
+    // Every frame of this ring has been released, so its pins are gone
+    if (m_reader >= 0) {
+        ReaderEntry& entry = header()->readers[m_reader];
+        entry.lastSequence.store(NOTHING_UNREAD);
+        entry.pid.store(0);
+    }
+
+    m_memory.detach();
+}
+
+SharedFrameRing::SegmentHeader* SharedFrameRing::header() const
+{
+    return (SegmentHeader*) m_memory.constData();
+}
+
+SharedFrameRing::SlotHeader* SharedFrameRing::slot(int index) const
+{
+    return (SlotHeader*) ((const uchar*) m_memory.constData() + HEADER_SIZE + qint64(index) * header()->slotBytes);
+}
+
+uchar* SharedFrameRing::slotData(int index) const
+{
+    return (uchar*) slot(index) + SLOT_HEADER_SIZE;
+}
+
+int SharedFrameRing::slotBytesFor(const QHashDataFrames& frames)
+{
+    QVector<FrameEntry> entries;
+    QByteArray record;
+    return int(SLOT_HEADER_SIZE + describeFrames(frames, -1, &entries, &record));
+}
+
+bool SharedFrameRing::create(const StreamRecording::Header& streamHeader, int slots, int slotBytes)
+{
+    slots = qBound(1, slots, int(MAX_SLOTS));
+    slotBytes = int(alignUp(qMax(slotBytes, SLOT_HEADER_SIZE + ALIGNMENT)));
+    const qint64 segmentBytes = HEADER_SIZE + qint64(slots) * slotBytes;
+
+    const bool created = m_memory.create(segmentBytes);
+
+    if (!created && (m_memory.error() != QSharedMemory::AlreadyExists || !m_memory.attach())) {
+        qDebug() << "SharedFrameRing - Couldn't create" << m_name << m_memory.errorString();
+        return false;
+    }
+
+    m_memory.lock();
+    SegmentHeader* h = header();
+    const qint64 writerPid = h->writerPid.load();
+    const bool valid = !created && h->magic.load() == MAGIC && h->version == VERSION
+            && m_memory.size() >= HEADER_SIZE + qint64(h->slotCount) * h->slotBytes;
+
+    if (valid && writerPid != 0 && writerPid != currentPid() && isAlive(writerPid)) {
+        m_memory.unlock();
+        m_memory.detach();
+        qDebug() << "SharedFrameRing -" << m_name << "already has a writer";
+        return false;
+    }
+
+    if (valid)
+    {
+        // Segment of a previous writer, its readers stay attached. A slot it was writing
+        // when it died is emptied.
+        for (int i=0; i<h->slotCount; ++i) {
+            if (slot(i)->readers.load() < 0) {
+                slot(i)->sequence.store(0);
+                slot(i)->readers.store(0);
+            }
+        }
+
+        if (h->slotBytes < slotBytes)
+            qDebug() << "SharedFrameRing - Slots of" << m_name << "are smaller than requested";
+    }
+    else
+    {
+        if (m_memory.size() < segmentBytes) {
+            m_memory.unlock();
+            m_memory.detach();
+            qDebug() << "SharedFrameRing - Segment of" << m_name << "is too small";
+            return false;
+        }
+
+        memset(m_memory.data(), 0, m_memory.size());
+        h->version = VERSION;
+        h->slotCount = slots;
+        h->slotBytes = slotBytes;
+
+        for (int i=0; i<MAX_READERS; ++i)
+            h->readers[i].lastSequence.store(NOTHING_UNREAD);
+
+        h->magic.store(MAGIC);
+    }
+
+    h->frames = quint32(streamHeader.frames);
+    h->width = streamHeader.width;
+    h->height = streamHeader.height;
+    h->writerPid.store(currentPid());
+    m_memory.unlock();
+
+    m_writer = true;
+    return true;
+}
+
+void SharedFrameRing::closeWriter()
+{
+    if (m_writer && m_memory.isAttached())
+        header()->writerPid.store(0);
+
+    m_writer = false;
+}
+
+/**
+ * Oldest slot that isn't pinned and that every sequential reader has read. It's returned
+ * locked for the writer, -1 if there isn't any.
+ */
+int SharedFrameRing::findFreeSlot()
+{
+    SegmentHeader* h = header();
+    quint64 unread = NOTHING_UNREAD;
+
+    for (int i=0; i<MAX_READERS; ++i) {
+        if (h->readers[i].pid.load() != 0)
+            unread = qMin(unread, h->readers[i].lastSequence.load());
+    }
+
+    forever
+    {
+        int oldest = -1;
+        quint64 oldestSequence = NOTHING_UNREAD;
+
+        for (int i=0; i<h->slotCount; ++i) {
+            const quint64 sequence = slot(i)->sequence.load();
+            if (slot(i)->readers.load() == 0 && (sequence == 0 || sequence <= unread) && sequence < oldestSequence) {
+                oldest = i;
+                oldestSequence = sequence;
+            }
+        }
+
+        if (oldest < 0)
+            return -1;
+
+        // A reader may have pinned it in the meantime
+        qint32 free = 0;
+        if (slot(oldest)->readers.compare_exchange_strong(free, -1))
+            return oldest;
+    }
+}
+
+bool SharedFrameRing::write(const QHashDataFrames& frames, qint64 timestamp, Policy policy, int timeoutMs)
+{
+    if (!m_writer)
+        return false;
+
+    SegmentHeader* h = header();
+    QVector<FrameEntry> entries;
+    QByteArray record;
+    const qint64 dataSize = describeFrames(frames, timestamp, &entries, &record);
+
+    if (SLOT_HEADER_SIZE + dataSize > h->slotBytes) {
+        if (!m_tooBigReported)
+            qDebug() << "SharedFrameRing - Frames don't fit in the slots of" << m_name;
+        m_tooBigReported = true;
+        m_stats.framesDropped++;
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    bool reclaimed = false;
+    int index;
+
+    while ((index = findFreeSlot()) < 0)
+    {
+        // Slots may be pinned by a reader that has died
+        if (!reclaimed) {
+            reclaimDeadReaders();
+            reclaimed = true;
+            continue;
+        }
+
+        if (policy == POLICY_DROP || timer.elapsed() >= timeoutMs) {
+            m_stats.framesDropped++;
+            return false;
+        }
+
+        QThread::usleep(POLL_US);
+    }
+
+    SlotHeader* s = slot(index);
+    uchar* data = slotData(index);
+    s->sequence.store(0);
+    s->timestamp = timestamp;
+    s->count = entries.size();
+    memcpy(data, entries.constData(), entries.size() * sizeof(FrameEntry));
+
+    for (const FrameEntry& entry : entries)
+    {
+        uchar* destination = data + entry.offset;
+
+        if (entry.type == DataFrame::Color)
+            copyImage<ColorFrame, RGBColor>(frames.value(DataFrame::Color), destination);
+        else if (entry.type == DataFrame::Depth)
+            copyImage<DepthFrame, uint16_t>(frames.value(DataFrame::Depth), destination);
+        else if (entry.type == DataFrame::Mask)
+            copyImage<MaskFrame, uint8_t>(frames.value(DataFrame::Mask), destination);
+        else
+            memcpy(destination, record.constData(), record.size());
+    }
+
+    // Only this process writes latest
+    const quint64 sequence = h->latest.load() + 1;
+    s->sequence.store(sequence, std::memory_order_release);
+    s->readers.store(0, std::memory_order_release);
+    h->latest.store(sequence, std::memory_order_release);
+    m_stats.framesWritten++;
+    return true;
+}
+
+bool SharedFrameRing::attach(bool sequential)
+{
+    if (!m_memory.attach()) {
+        return false;
+    }
+
+    m_memory.lock();
+    SegmentHeader* h = header();
+
+    if (h->magic.load() != MAGIC || h->version != VERSION || m_memory.size() < HEADER_SIZE + qint64(h->slotCount) * h->slotBytes) {
+        m_memory.unlock();
+        m_memory.detach();
+        return false;
+    }
+
+    const qint64 pid = currentPid();
+
+    for (int attempt=0; attempt<2 && m_reader < 0; ++attempt)
+    {
+        for (int i=0; i<MAX_READERS && m_reader < 0; ++i) {
+            qint64 free = 0;
+            if (h->readers[i].pid.compare_exchange_strong(free, pid))
+                m_reader = i;
+        }
+
+        if (m_reader < 0)
+            reclaimDeadReaders();
+    }
+
+    if (m_reader < 0) {
+        m_memory.unlock();
+        m_memory.detach();
+        qDebug() << "SharedFrameRing - Too many readers of" << m_name;
+        return false;
+    }
+
+    // Start with the last written bundle
+    const quint64 latest = h->latest.load();
+    m_sequential = sequential;
+    m_lastSequence = latest > 0 ? latest - 1 : 0;
+
+    ReaderEntry& entry = h->readers[m_reader];
+    entry.pins.store(0);
+    entry.lastSequence.store(sequential ? m_lastSequence : NOTHING_UNREAD);
+    m_memory.unlock();
+    return true;
+}
+
+// Slot of the oldest (sequential) or newest bundle that hasn't been read yet
+int SharedFrameRing::findReadableSlot(quint64* sequence) const
+{
+    int result = -1;
+    *sequence = 0;
+
+    for (int i=0; i<header()->slotCount; ++i)
+    {
+        const quint64 current = slot(i)->sequence.load(std::memory_order_acquire);
+
+        if (current <= m_lastSequence)
+            continue;
+
+        if (result < 0 || (m_sequential ? current < *sequence : current > *sequence)) {
+            result = i;
+            *sequence = current;
+        }
+    }
+
+    return result;
+}
+
+// The pin is counted before it's recorded, so a reader that dies in between leaks a pin
+// instead of releasing one of other reader
+bool SharedFrameRing::pin(int index)
+{
+    std::atomic<qint32>& readers = slot(index)->readers;
+    qint32 count = readers.load();
+
+    do {
+        if (count < 0)
+            return false;
+    } while (!readers.compare_exchange_weak(count, count + 1));
+
+    header()->readers[m_reader].pins.fetch_or(quint64(1) << index);
+    return true;
+}
+
+void SharedFrameRing::unpin(int index)
+{
+    header()->readers[m_reader].pins.fetch_and(~(quint64(1) << index));
+    slot(index)->readers.fetch_sub(1);
+}
+
+void SharedFrameRing::reclaimDeadReaders()
+{
+    SegmentHeader* h = header();
+
+    for (int i=0; i<MAX_READERS; ++i)
+    {
+        ReaderEntry& entry = h->readers[i];
+        qint64 pid = entry.pid.load();
+
+        if (pid <= 0 || isAlive(pid) || !entry.pid.compare_exchange_strong(pid, -1))
+            continue;
+
+        const quint64 pins = entry.pins.exchange(0);
+
+        for (int j=0; j<h->slotCount; ++j) {
+            if (pins & (quint64(1) << j))
+                slot(j)->readers.fetch_sub(1);
+        }
+
+        qDebug() << "SharedFrameRing - Reader" << pid << "of" << m_name << "has died, its slots are released";
+        entry.lastSequence.store(NOTHING_UNREAD);
+        entry.pid.store(0);
+    }
+}
+
+bool SharedFrameRing::read(QHashDataFrames& output, qint64* timestamp, bool zeroCopy, int timeoutMs)
+{
+    if (m_reader < 0)
+        return false;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    forever
+    {
+        quint64 sequence;
+        const int index = findReadableSlot(&sequence);
+
+        // The slot may have been written again before it was pinned
+        if (index >= 0 && pin(index))
+        {
+            if (slot(index)->sequence.load(std::memory_order_acquire) == sequence)
+            {
+                if (timestamp)
+                    *timestamp = slot(index)->timestamp;
+
+                m_stats.framesDropped += m_lastSequence > 0 ? sequence - m_lastSequence - 1 : 0;
+                m_lastSequence = sequence;
+
+                if (m_sequential)
+                    header()->readers[m_reader].lastSequence.store(sequence);
+
+                if (readSlot(index, output, zeroCopy)) {
+                    m_stats.framesRead++;
+                    return true;
+                }
+
+                qDebug() << "SharedFrameRing - Bundle" << sequence << "of" << m_name << "is corrupt";
+                continue;
+            }
+
+            unpin(index);
+            continue;
+        }
+
+        if (timer.elapsed() >= timeoutMs || writerGone())
+            return false;
+
+        QThread::usleep(POLL_US);
+    }
+}
+
+// The pin of the slot is released by the last frame that uses it, or here if there isn't any
+bool SharedFrameRing::readSlot(int index, QHashDataFrames& output, bool zeroCopy)
+{
+    const SlotHeader* s = slot(index);
+    const uchar* data = slotData(index);
+    const qint64 dataSize = header()->slotBytes - SLOT_HEADER_SIZE;
+    const FrameEntry* entries = (const FrameEntry*) data;
+
+    shared_ptr<SharedFrameRing> self = shared_from_this();
+    shared_ptr<void> owner((void*) data, [self, index](void*) {self->unpin(index);});
+    QHashDataFrames frames;
+    bool ok = s->count <= 4 && qint64(s->count * sizeof(FrameEntry)) <= dataSize;
+
+    for (quint32 i=0; ok && i<s->count; ++i)
+    {
+        const FrameEntry& entry = entries[i];
+        const DataFrame::FrameType type = DataFrame::FrameType(entry.type);
+        qint64 pixelSize = type == DataFrame::Color ? sizeof(RGBColor) : type == DataFrame::Depth ? 2 : 1;
+
+        ok = qint64(entry.offset) + entry.size <= dataSize && entry.width >= 0 && entry.height >= 0
+                && (type == DataFrame::Unknown || qint64(entry.width) * entry.height * pixelSize == entry.size);
+
+        if (!ok)
+            break;
+
+        const shared_ptr<void> frameOwner = zeroCopy ? owner : nullptr;
+
+        if (type == DataFrame::Color) {
+            frames.insert(type, readImage<ColorFrame, RGBColor>(entry, data, output.value(type), frameOwner));
+        }
+        else if (type == DataFrame::Depth) {
+            shared_ptr<DepthFrame> depthFrame = readImage<DepthFrame, uint16_t>(entry, data, output.value(type), frameOwner);
+            depthFrame->setDistanceUnits(DistanceUnits(entry.units));
+            frames.insert(type, depthFrame);
+        }
+        else if (type == DataFrame::Mask) {
+            frames.insert(type, readImage<MaskFrame, uint8_t>(entry, data, output.value(type), frameOwner));
+        }
+        else {
+            QHashDataFrames others;
+            const QByteArray record = QByteArray::fromRawData((const char*) data + entry.offset, entry.size);
+
+            for (auto it = output.constBegin(); it != output.constEnd(); ++it) {
+                if (it.key() != DataFrame::Color && it.key() != DataFrame::Depth && it.key() != DataFrame::Mask)
+                    others.insert(it.key(), it.value());
+            }
+
+            ok = StreamRecording::decodeFrames(record, others);
+
+            for (auto it = others.constBegin(); it != others.constEnd(); ++it)
+                frames.insert(it.key(), it.value());
+        }
+    }
+
+    output = ok ? frames : QHashDataFrames();
+    return ok;
+}
+
+bool SharedFrameRing::hasEnded() const
+{
+    return m_reader >= 0 && writerGone() && header()->latest.load() <= m_lastSequence;
+}
+
+// Closed, or killed before it could close the ring
+bool SharedFrameRing::writerGone() const
+{
+    const qint64 pid = header()->writerPid.load();
+    return pid == 0 || (pid != currentPid() && !isAlive(pid));
+}
+
+StreamRecording::Header SharedFrameRing::streamHeader() const
+{
+    StreamRecording::Header result;
+
+    if (m_memory.isAttached()) {
+        result.frames = DataFrame::SupportedFrames(int(header()->frames));
+        result.width = header()->width;
+        result.height = header()->height;
+    }
+
+    return result;
+}
+
+SharedFrameRing::Stats SharedFrameRing::stats() const
+{
+    return m_stats;
+}
+
+} // End Namespace
@@ -0,0 +1,123 @@
+#ifndef SHAREDFRAMERING_H
+#define SHAREDFRAMERING_H
+
+#include "types/DataFrame.h"
+#include "playback/StreamRecording.h"
+#include <QSharedMemory>
+#include <memory>
+
+namespace dai {
+
+/**
+ * Ring of bundles of frames in shared memory, so frames can travel between processes of
+ * the same machine (i.e. capture, filters and viewers run as separate processes and a
+ * crash of one of them doesn't stop the others). One process writes (see
+ * SharedMemoryPublisher) and up to MAX_READERS read (see SharedMemoryInstance).
+ *
+ * The segment has a small header and a fixed number of slots. Colour, depth and masks are
+ * stored as raw rows, so readers can use them in place: the frames they get are views of
+ * the slot, which stays pinned (the writer can't reuse it) until the last of those frames
+ * is destroyed. Skeletons and metadata are small, they are stored as a StreamRecording
+ * record and copied.
+ *
+ * The writer uses the oldest free slot. When every slot is pinned, or still unread by a
+ * sequential reader, the bundle is dropped (POLICY_DROP, what FrameNotifier does with a
+ * busy listener) or the writer waits for a slot (POLICY_WAIT, back-pressure).
+ *
+ * Slots pinned by a reader that has died are released again, and a writer that restarts
+ * reuses the segment. Readers see the end of the stream when the writer closes or dies.
+ * The segment is kept while a frame of it is alive, so the ring is destroyed when the last
+ * one is released.
+ *
+ * @brief The SharedFrameRing class
+ */
+class SharedFrameRing : public std::enable_shared_from_this<SharedFrameRing>
+{
+public:
+    enum Policy {
+        POLICY_DROP,    // Drop the bundle if there isn't a free slot
+        POLICY_WAIT     // Wait for a free slot (up to a timeout)
+    };
+
+    struct Stats {
+        qint64 framesWritten;
+        qint64 framesDropped;   // Writer: no free slot or too big. Reader: overwritten before read
+        qint64 framesRead;
+    };
+
+    static const int MAX_SLOTS = 64;
+    static const int MAX_READERS = 16;
+
+    explicit SharedFrameRing(const QString& name);
+    ~SharedFrameRing();
+
+    const QString& name() const {return m_name;}
+
+    // Writer
+
+    /**
+     * Create the segment, or reuse the one of a previous writer with the same name.
+     * header describes the stream to the readers.
+     */
+    bool create(const StreamRecording::Header& header, int slots, int slotBytes);
+    bool write(const QHashDataFrames& frames, qint64 timestamp, Policy policy, int timeoutMs);
+
+    /**
+     * Readers see the end of the stream once they have read every bundle
+     */
+    void closeWriter();
+
+    /**
+     * Bytes needed by a slot to keep frames
+     */
+    static int slotBytesFor(const QHashDataFrames& frames);
+
+    // Reader
+
+    /**
+     * Sequential readers get every bundle (the writer doesn't reuse a slot they haven't
+     * read unless it drops frames), the others always get the latest one.
+     */
+    bool attach(bool sequential);
+
+    /**
+     * Wait up to timeoutMs for a bundle newer than the last read. output gets the frames of
+     * the bundle; with zeroCopy they are views of the slot, otherwise its frames of the same
+     * type are reused. Returns false on timeout, or at once if the writer is gone.
+     */
+    bool read(QHashDataFrames& output, qint64* timestamp, bool zeroCopy, int timeoutMs);
+    bool hasEnded() const;
+    StreamRecording::Header streamHeader() const;
+
+    bool isAttached() const {return m_memory.isAttached();}
+    Stats stats() const;
+
+    // Layout of the segment
+    struct SegmentHeader;
+    struct SlotHeader;
+
+private:
+    SegmentHeader* header() const;
+    SlotHeader* slot(int index) const;
+    uchar* slotData(int index) const;
+    int findFreeSlot();
+    int findReadableSlot(quint64* sequence) const;
+    bool writerGone() const;
+    bool pin(int index);
+    void unpin(int index);
+    void reclaimDeadReaders();
+    bool readSlot(int index, QHashDataFrames& output, bool zeroCopy);
+
+    QString m_name;
+    QSharedMemory m_memory;
+    bool m_writer;
+    int m_reader;           // Entry in the segment, -1 if not a reader
+    bool m_sequential;
+    quint64 m_lastSequence;
+    bool m_tooBigReported;
+    Stats m_stats;
+};
+
+} // End Namespace
+
+#endif // SHAREDFRAMERING_H
@@ -0,0 +1,100 @@
+#include "SharedMemoryInstance.h"
+#include <QElapsedTimer>
+#include <QThread>
+#include <QDebug>
+
+namespace dai {
+
+SharedMemoryInstance::SharedMemoryInstance(const QString& name, DataFrame::SupportedFrames frames, int width, int height,
+                                           const Settings& settings)
+    : StreamInstance(frames, width, height)
+    , m_name(name)
+    , m_settings(settings)
+{
+}
+
+SharedMemoryInstance::~SharedMemoryInstance()
+{
+    closeInstance();
+}
+
+bool SharedMemoryInstance::is_open() const
+{
+    return m_ring != nullptr;
+}
+
+bool SharedMemoryInstance::hasNext() const
+{
+    return is_open() && !m_ring->hasEnded();
+}
+
+SharedFrameRing::Stats SharedMemoryInstance::stats() const
+{
+    SharedFrameRing::Stats result = {0, 0, 0};
+    return m_ring ? m_ring->stats() : result;
+}
+
+// The publisher may start a bit later than the reader
+bool SharedMemoryInstance::openInstance()
+{
+    shared_ptr<SharedFrameRing> ring = make_shared<SharedFrameRing>(m_name);
+    QElapsedTimer timer;
+    timer.start();
+
+    while (!ring->attach(m_settings.sequential)) {
+        if (timer.elapsed() >= m_settings.timeoutMs) {
+            qDebug() << "SharedMemoryInstance - There is no publisher named" << m_name;
+            return false;
+        }
+        QThread::msleep(10);
+    }
+
+    m_ring = ring;
+    return true;
+}
+
+// Frames still in use keep the ring until they are released
+void SharedMemoryInstance::closeInstance()
+{
+    m_ring.reset();
+}
+
+void SharedMemoryInstance::restartInstance()
+{
+    // A live stream can't go back
+}
+
+// Frames of the stream that aren't in the bundle are removed from output. When there isn't a
+// new bundle (the publisher stalls or dies) the previous frames are kept, so listeners never
+// get a partial bundle; before the first bundle output gets no frames and isn't notified.
+void SharedMemoryInstance::nextFrame(QHashDataFrames& output)
+{
+    QHashDataFrames frames;
+
+    for (DataFrame::FrameType type : getTypes(getSupportedFrames())) {
+        if (output.contains(type))
+            frames.insert(type, output.take(type));
+    }
+
+    const QHashDataFrames previous = frames;
+    qint64 timestamp = -1;
+
+    if (m_ring->read(frames, &timestamp, m_settings.zeroCopy, m_settings.timeoutMs))
+        setTimestamp(timestamp);
+    else
+        frames = previous;
+
+    for (auto it = frames.constBegin(); it != frames.constEnd(); ++it) {
+        if (getSupportedFrames().testFlag(it.key()))
+            output.insert(it.key(), it.value());
+    }
+}
+
+// The next read gets the latest bundle anyway. Sequential readers can't skip.
+bool SharedMemoryInstance::seekInstance(unsigned int count)
+{
+    Q_UNUSED(count);
+    return !m_settings.sequential;
+}
+
+} // End Namespace
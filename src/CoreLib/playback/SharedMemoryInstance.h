@@ -0,0 +1,55 @@
+#ifndef SHAREDMEMORYINSTANCE_H
+#define SHAREDMEMORYINSTANCE_H
+
+#include "types/StreamInstance.h"
+#include "playback/SharedFrameRing.h"
+
+namespace dai {
+
+/**
+ * Frames published by SharedMemoryPublisher in another process. By default the frames are
+ * views of the shared memory (no copy) that keep their slot while they are alive, so a
+ * listener that changes them must clone() them first, as listeners already do with the
+ * buffers of a FrameGenerator.
+ *
+ * Reading waits for the next bundle (up to timeoutMs, then the previous frames are kept),
+ * so PlaybackControl with PACING_SLOWDOWN and setFPS(0) follows the rate of the publisher.
+ * The latest bundle is read unless sequential is set, which reads every bundle and makes
+ * the publisher wait or drop when this reader is behind. The stream ends when the
+ * publisher is closed or dies.
+ *
+ * @brief The SharedMemoryInstance class
+ */
+class SharedMemoryInstance : public StreamInstance
+{
+public:
+    struct Settings {
+        bool sequential = false;
+        bool zeroCopy = true;
+        int timeoutMs = 1000;
+    };
+
+    SharedMemoryInstance(const QString& name, DataFrame::SupportedFrames frames, int width = 640, int height = 480,
+                         const Settings& settings = Settings());
+    virtual ~SharedMemoryInstance();
+    bool is_open() const override;
+    bool hasNext() const override;
+    SharedFrameRing::Stats stats() const;
+    const QString& name() const {return m_name;}
+
+protected:
+    bool openInstance() override;
+    void closeInstance() override;
+    void restartInstance() override;
+    void nextFrame(QHashDataFrames& output) override;
+    bool seekInstance(unsigned int count) override;
+
+private:
+    QString m_name;
+    Settings m_settings;
+    shared_ptr<SharedFrameRing> m_ring;
+};
+
+} // End Namespace
+
+#endif // SHAREDMEMORYINSTANCE_H
@@ -0,0 +1,85 @@
+#include "SharedMemoryPublisher.h"
+#include <QDebug>
+
+namespace dai {
+
+// Skeletons and metadata change their size from one bundle to another
+static const int SLOT_MARGIN = 64 * 1024;
+
+SharedMemoryPublisher::SharedMemoryPublisher(const QString& name, const Settings& settings)
+    : m_name(name)
+    , m_settings(settings)
+    , m_running(true)
+    , m_failed(false)
+    , m_framesReceived(0)
+{
+}
+
+SharedMemoryPublisher::~SharedMemoryPublisher()
+{
+    stopListener();
+    close();
+    qDebug() << "SharedMemoryPublisher::~SharedMemoryPublisher";
+}
+
+// This method is called from the FrameNotifier thread
+void SharedMemoryPublisher::newFrames(const QHashDataFrames dataFrames)
+{
+    publish(dataFrames, frameInfo().sourceTimestamp);
+}
+
+bool SharedMemoryPublisher::publish(const QHashDataFrames& frames, qint64 timestamp)
+{
+    QMutexLocker locker(&m_lock);
+
+    if (!m_running || m_failed)
+        return false;
+
+    m_framesReceived++;
+
+    if (!m_clock.isValid())
+        m_clock.start();
+
+    if (timestamp < 0)
+        timestamp = m_clock.nsecsElapsed() / 1000;
+
+    if (!m_ring)
+    {
+        const int slotBytes = qMax(SharedFrameRing::slotBytesFor(frames) + SLOT_MARGIN, m_settings.slotKilobytes * 1024);
+        m_ring = make_shared<SharedFrameRing>(m_name);
+
+        if (!m_ring->create(StreamRecording::headerOf(frames), m_settings.slots, slotBytes)) {
+            m_ring.reset();
+            m_failed = true;
+            return false;
+        }
+    }
+
+    return m_ring->write(frames, timestamp, m_settings.policy, m_settings.timeoutMs);
+}
+
+void SharedMemoryPublisher::afterStop()
+{
+    close();
+}
+
+void SharedMemoryPublisher::close()
+{
+    QMutexLocker locker(&m_lock);
+    m_running = false;
+
+    if (m_ring)
+        m_ring->closeWriter();
+}
+
+SharedMemoryPublisher::Stats SharedMemoryPublisher::stats() const
+{
+    QMutexLocker locker(&m_lock);
+    Stats result;
+    result.framesReceived = m_framesReceived;
+    result.framesWritten = m_ring ? m_ring->stats().framesWritten : 0;
+    result.framesDropped = m_ring ? m_ring->stats().framesDropped : 0;
+    return result;
+}
+
+} // End Namespace
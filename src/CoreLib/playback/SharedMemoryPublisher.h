@@ -0,0 +1,73 @@
+#ifndef SHAREDMEMORYPUBLISHER_H
+#define SHAREDMEMORYPUBLISHER_H
+
+#include "playback/FrameListener.h"
+#include "playback/SharedFrameRing.h"
+#include <QMutex>
+#include <QElapsedTimer>
+
+namespace dai {
+
+/**
+ * Listener that writes every received bundle of frames to a SharedFrameRing, so other
+ * processes of the machine can read them with SharedMemoryInstance. The frames are copied
+ * once, into the ring, from the FrameNotifier thread.
+ *
+ * The ring is created with the first bundle, with slots big enough for it (or for
+ * slotKilobytes if that's bigger). Bundles keep the timestamp of their source, or the
+ * time at which they were received.
+ *
+ * @brief The SharedMemoryPublisher class
+ */
+class SharedMemoryPublisher : public FrameListener
+{
+public:
+    struct Settings {
+        int slots = 8;
+        int slotKilobytes = 0;      // 0 sizes the slots for the first bundle
+        SharedFrameRing::Policy policy = SharedFrameRing::POLICY_DROP;
+        int timeoutMs = 100;        // Longest wait for a free slot (POLICY_WAIT)
+    };
+
+    struct Stats {
+        qint64 framesReceived;
+        qint64 framesWritten;
+        qint64 framesDropped;
+    };
+
+    SharedMemoryPublisher(const QString& name, const Settings& settings = Settings());
+    virtual ~SharedMemoryPublisher();
+
+    /**
+     * Publish frames that don't come from a FrameGenerator. timestamp is in microseconds,
+     * the time they are received is used when it's -1.
+     */
+    bool publish(const QHashDataFrames& frames, qint64 timestamp = -1);
+
+    /**
+     * Readers see the end of the stream once they have read the last bundle
+     */
+    void close();
+    Stats stats() const;
+    const QString& name() const {return m_name;}
+    const char* listenerName() const override {return "SharedMemoryPublisher";}
+
+protected:
+    void newFrames(const QHashDataFrames dataFrames) override;
+    void afterStop() override;
+
+private:
+    QString m_name;
+    Settings m_settings;
+    QElapsedTimer m_clock;
+
+    mutable QMutex m_lock;
+    shared_ptr<SharedFrameRing> m_ring;
+    bool m_running;
+    bool m_failed;
+    qint64 m_framesReceived;
+};
+
+} // End Namespace
+
+#endif // SHAREDMEMORYPUBLISHER_H
@@ -0,0 +1,92 @@
+#include "SkeletonFilter.h"
+#include "playback/Tracer.h"
+#include <QDebug>
+
+namespace dai {
+
+SkeletonFilter::SkeletonFilter()
+    : m_initialised(false)
+    , m_enabled(true)
+{
+}
+
+SkeletonFilter::~SkeletonFilter()
+{
+    stopListener();
+    qDebug() << "SkeletonFilter::~SkeletonFilter";
+}
+
+shared_ptr<QHashDataFrames> SkeletonFilter::allocateMemory()
+{
+    m_frames = make_shared<QHashDataFrames>();
+    return m_frames;
+}
+
+void SkeletonFilter::setSettings(const SkeletonSmoother::Settings& settings)
+{
+    QMutexLocker locker(&m_lock);
+    m_smoother.setSettings(settings);
+}
+
+void SkeletonFilter::setEnabled(bool value)
+{
+    QMutexLocker locker(&m_lock);
+    m_enabled = value;
+    m_smoother.reset();
+}
+
+// This method is called from a thread
+void SkeletonFilter::newFrames(const QHashDataFrames dataFrames)
+{
+    if (!m_initialised) {
+        FrameGenerator::begin(false);
+        m_initialised = true;
+    }
+
+    // Only the skeletons are copied, the smoother replaces them and the ones received aren't
+    // modified. The other frames are passed through
+    *m_frames = dataFrames;
+
+    if (dataFrames.contains(DataFrame::Skeleton))
+        m_frames->insert(DataFrame::Skeleton, dataFrames.value(DataFrame::Skeleton)->clone());
+
+    if (!hasExpired()) {
+        if (subscribersCount() == 0 || !generate()) {
+            qDebug() << "SkeletonFilter: No listeners or Nothing produced";
+            stopListener();
+        }
+    }
+    else {
+        qDebug() << "SkeletonFilter - Frame copied out of time";
+        Tracer::instant(listenerName(), "expired", Tracer::currentFrame());
+    }
+}
+
+void SkeletonFilter::describeFrame(FrameInfo& info)
+{
+    info.copyPacing(frameInfo());
+}
+
+void SkeletonFilter::afterStop()
+{
+    QMutexLocker locker(&m_lock);
+    m_smoother.reset();
+    m_initialised = false;
+}
+
+void SkeletonFilter::produceFrames(QHashDataFrames& output)
+{
+    if (!output.contains(DataFrame::Skeleton))
+        return;
+
+    QMutexLocker locker(&m_lock);
+
+    if (!m_enabled)
+        return;
+
+    TraceScope scope(generatorName(), "smooth");
+    shared_ptr<SkeletonFrame> skeletonFrame = static_pointer_cast<SkeletonFrame>(output.value(DataFrame::Skeleton));
+    m_smoother.process(*skeletonFrame, frameInfo().sourceTimestamp);
+}
+
+} // End Namespace
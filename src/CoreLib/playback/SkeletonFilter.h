@@ -0,0 +1,45 @@
+#ifndef SKELETONFILTER_H
+#define SKELETONFILTER_H
+
+#include "playback/FrameListener.h"
+#include "playback/FrameGenerator.h"
+#include "playback/SkeletonSmoother.h"
+#include <QMutex>
+
+namespace dai {
+
+/**
+ * Stage that smooths the skeletons of the received frames (see SkeletonSmoother) and
+ * forwards every frame to its listeners. Frames without skeletons are forwarded as
+ * they are.
+ *
+ * @brief The SkeletonFilter class
+ */
+class SkeletonFilter : public FrameListener, public FrameGenerator
+{
+public:
+    SkeletonFilter();
+    ~SkeletonFilter();
+    void newFrames(const QHashDataFrames dataFrames) override;
+    void setSettings(const SkeletonSmoother::Settings& settings);
+    void setEnabled(bool value);
+    const char* listenerName() const override {return "SkeletonFilter";}
+    const char* generatorName() const override {return "SkeletonFilter";}
+
+protected:
+    shared_ptr<QHashDataFrames> allocateMemory() override;
+    void afterStop() override;
+    void produceFrames(QHashDataFrames& output) override;
+    void describeFrame(FrameInfo& info) override;
+
+private:
+    shared_ptr<QHashDataFrames> m_frames;
+    SkeletonSmoother m_smoother;
+    QMutex m_lock;
+    bool m_initialised;
+    bool m_enabled;
+};
+
+} // End Namespace
+
+#endif // SKELETONFILTER_H
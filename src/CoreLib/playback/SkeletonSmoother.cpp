@@ -0,0 +1,256 @@
+#include "SkeletonSmoother.h"
+#include <cmath>
+
+#ifndef M_PI
+    #define M_PI 3.14159265359
+#endif
+
+namespace dai {
+
+SkeletonSmoother::SkeletonSmoother()
+    : m_lastTimestamp(-1)
+{
+}
+
+void SkeletonSmoother::setSettings(const Settings& settings)
+{
+    m_settings = settings;
+}
+
+void SkeletonSmoother::reset()
+{
+    m_users.clear();
+    m_lastTimestamp = -1;
+}
+
+void SkeletonSmoother::process(SkeletonFrame& frame, qint64 timestamp)
+{
+    // Time between frames (seconds)
+    float dt = 1.0f / 30.0f;
+
+    if (timestamp >= 0 && m_lastTimestamp >= 0 && timestamp > m_lastTimestamp)
+        dt = qMin((timestamp - m_lastTimestamp) / 1000000.0f, 0.5f);
+
+    m_lastTimestamp = timestamp;
+
+    const QList<int> usersId = frame.getAllUsersId();
+
+    for (int userId : usersId)
+    {
+        SkeletonPtr input = frame.getSkeleton(userId);
+
+        if (!input)
+            continue;
+
+        auto it = m_users.find(userId);
+
+        if (it == m_users.end())
+            it = m_users.insert(userId, UserState());
+
+        frame.setSkeleton(userId, filterSkeleton(it.value(), *input, dt));
+    }
+
+    // Users lost in this frame are predicted for a while, then forgotten
+    auto it = m_users.begin();
+
+    while (it != m_users.end())
+    {
+        if (usersId.contains(it.key())) {
+            ++it;
+            continue;
+        }
+
+        UserState& state = it.value();
+
+        if (++state.missing > m_settings.maxGap) {
+            it = m_users.erase(it);
+            continue;
+        }
+
+        frame.setSkeleton(it.key(), predictSkeleton(state, dt));
+        ++it;
+    }
+}
+
+// Smoothing factor of an exponential filter with the given cutoff frequency
+float SkeletonSmoother::alpha(float dt, float cutoff)
+{
+    const float tau = 1.0f / (2.0f * float(M_PI) * cutoff);
+    return 1.0f / (1.0f + tau / dt);
+}
+
+Quaternion SkeletonSmoother::slerp(const Quaternion& q1, const Quaternion& q2, float t)
+{
+    double cosTheta = Quaternion::dotProduct(q1, q2);
+    double sign = 1.0;
+
+    // q and -q are the same rotation, take the shortest path
+    if (cosTheta < 0) {
+        cosTheta = -cosTheta;
+        sign = -1.0;
+    }
+
+    double w1 = 1.0 - t;
+    double w2 = t;
+
+    // Linear interpolation when they are almost the same
+    if (cosTheta < 0.9995) {
+        const double theta = std::acos(cosTheta);
+        const double sinTheta = std::sin(theta);
+        w1 = std::sin((1.0 - t) * theta) / sinTheta;
+        w2 = std::sin(t * theta) / sinTheta;
+    }
+
+    w2 *= sign;
+
+    Quaternion result(w1 * q1.w() + w2 * q2.w(),
+                      w1 * q1.x() + w2 * q2.x(),
+                      w1 * q1.y() + w2 * q2.y(),
+                      w1 * q1.z() + w2 * q2.z());
+    result.normalize();
+    return result;
+}
+
+/**
+ * One Euro filter of the position of joint, and slerp of its orientation
+ */
+void SkeletonSmoother::filterJoint(JointState& state, SkeletonJoint& joint, float dt, float unitScale) const
+{
+    const Point3f& raw = joint.getPosition();
+    const bool hasOrientation = joint.getOrientationConfidence() > 0;
+
+    state.missing = 0;
+
+    if (!state.valid)
+    {
+        for (int k=0; k<3; ++k) {
+            state.position[k] = raw.val(k);
+            state.velocity[k] = 0;
+        }
+
+        state.orientation = joint.getOrientation();
+        state.validOrientation = hasOrientation;
+        state.valid = true;
+        return;
+    }
+
+    // Speed, filtered with a fixed cutoff
+    const float derivativeAlpha = alpha(dt, m_settings.derivativeCutoff);
+    float speed = 0;
+
+    for (int k=0; k<3; ++k) {
+        const float velocity = (raw.val(k) - state.position[k]) / dt;
+        state.velocity[k] += derivativeAlpha * (velocity - state.velocity[k]);
+        speed += state.velocity[k] * state.velocity[k];
+    }
+
+    // The faster the joint moves, the less it is smoothed
+    speed = std::sqrt(speed) * unitScale;
+    const float positionAlpha = alpha(dt, m_settings.minCutoff + m_settings.beta * speed);
+
+    for (int k=0; k<3; ++k)
+        state.position[k] += positionAlpha * (raw.val(k) - state.position[k]);
+
+    joint.setPosition(Point3f(state.position[0], state.position[1], state.position[2]));
+
+    if (hasOrientation)
+    {
+        if (state.validOrientation)
+            state.orientation = slerp(state.orientation, joint.getOrientation(), alpha(dt, m_settings.orientationCutoff));
+        else
+            state.orientation = joint.getOrientation();
+
+        state.validOrientation = true;
+        joint.setOrientation(state.orientation);
+    }
+}
+
+/**
+ * Move a missing joint with its last speed. The speed is halved on each frame so the
+ * prediction settles. Predicted joints get minConfidence.
+ */
+bool SkeletonSmoother::predictJoint(JointState& state, SkeletonJoint& joint, float dt) const
+{
+    if (!state.valid || state.missing >= m_settings.maxGap) {
+        state.valid = false;
+        state.validOrientation = false;
+        return false;
+    }
+
+    state.missing++;
+
+    for (int k=0; k<3; ++k) {
+        state.position[k] += state.velocity[k] * dt;
+        state.velocity[k] *= 0.5f;
+    }
+
+    joint.setPosition(Point3f(state.position[0], state.position[1], state.position[2]));
+    joint.setPositionConfidence(m_settings.minConfidence);
+
+    if (state.validOrientation)
+        joint.setOrientation(state.orientation);
+
+    return true;
+}
+
+SkeletonPtr SkeletonSmoother::filterSkeleton(UserState& state, const Skeleton& input, float dt) const
+{
+    SkeletonPtr output = make_shared<Skeleton>(input);
+    const float unitScale = input.distanceUnits() == DISTANCE_MILIMETERS ? 0.001f : 1.0f;
+    state.missing = 0;
+
+    for (int i=0; i<MAX_JOINTS; ++i)
+    {
+        const SkeletonJoint::JointType type = SkeletonJoint::JointType(i);
+        JointState& jointState = state.joints[i];
+        const bool present = input.hasJoint(type);
+
+        if (!present && !jointState.valid)
+            continue;
+
+        SkeletonJoint joint = present ? input.getJoint(type) : state.last.getJoint(type);
+
+        if (present && joint.getPositionConfidence() >= m_settings.minConfidence) {
+            filterJoint(jointState, joint, dt, unitScale);
+            output->setJoint(type, joint);
+        }
+        else if (predictJoint(jointState, joint, dt)) {
+            output->setJoint(type, joint);
+        }
+    }
+
+    // Quaternions are computed from the filtered positions
+    if (input.hasQuaternions())
+        output->computeQuaternions();
+
+    state.last = *output;
+    return output;
+}
+
+SkeletonPtr SkeletonSmoother::predictSkeleton(UserState& state, float dt) const
+{
+    SkeletonPtr output = make_shared<Skeleton>(state.last);
+
+    for (int i=0; i<MAX_JOINTS; ++i)
+    {
+        const SkeletonJoint::JointType type = SkeletonJoint::JointType(i);
+
+        if (!state.last.hasJoint(type))
+            continue;
+
+        SkeletonJoint joint = state.last.getJoint(type);
+
+        if (predictJoint(state.joints[i], joint, dt))
+            output->setJoint(type, joint);
+        else
+            output->removeJoint(type);
+    }
+
+    if (state.last.hasQuaternions())
+        output->computeQuaternions();
+
+    state.last = *output;
+    return output;
+}
+
+} // End Namespace
@@ -0,0 +1,80 @@
+#ifndef SKELETONSMOOTHER_H
+#define SKELETONSMOOTHER_H
+
+#include "types/SkeletonFrame.h"
+#include <QHash>
+
+namespace dai {
+
+/**
+ * Temporal filter of the skeletons of a sequence. Joint positions are smoothed with a
+ * One Euro filter (low-pass filter whose cutoff grows with the speed, so slow motion is
+ * steady and fast motion doesn't lag) and joint orientations with slerp.
+ *
+ * Joints whose confidence drops, and users that are lost for a while, are predicted from
+ * their last position and speed during maxGap frames. The filter is causal, so it adds
+ * no latency, and it keeps a fixed state for each user id, which is forgotten once the
+ * user has been missing for longer than maxGap frames.
+ *
+ * Skeletons are replaced by filtered copies instead of being modified, as they may be
+ * shared with other frames.
+ *
+ * @brief The SkeletonSmoother class
+ */
+class SkeletonSmoother
+{
+public:
+    struct Settings {
+        float minCutoff = 1.0f;         // Hz, cutoff when joints don't move
+        float beta = 0.8f;              // Cutoff increase per m/s of speed
+        float derivativeCutoff = 1.0f;  // Hz, cutoff of the speed
+        float orientationCutoff = 3.0f; // Hz, cutoff of the orientations
+        float minConfidence = 0.5f;     // Joints below it are treated as missing
+        int maxGap = 6;                 // Frames a missing joint or user is predicted
+    };
+
+    SkeletonSmoother();
+    void setSettings(const Settings& settings);
+    const Settings& settings() const {return m_settings;}
+
+    /**
+     * Filter the skeletons of frame. timestamp is in microseconds, if it is -1 frames
+     * are assumed to be 1/30 s apart.
+     */
+    void process(SkeletonFrame& frame, qint64 timestamp = -1);
+    void reset();
+    int trackedUsers() const {return m_users.size();}
+
+private:
+    struct JointState {
+        JointState() : missing(0), valid(false), validOrientation(false) {}
+        float position[3];
+        float velocity[3];
+        Quaternion orientation;
+        int missing;
+        bool valid;
+        bool validOrientation;
+    };
+
+    struct UserState {
+        UserState() : missing(0) {}
+        JointState joints[MAX_JOINTS];
+        Skeleton last;      // Last output, used to predict lost users
+        int missing;
+    };
+
+    static float alpha(float dt, float cutoff);
+    static Quaternion slerp(const Quaternion& q1, const Quaternion& q2, float t);
+    void filterJoint(JointState& state, SkeletonJoint& joint, float dt, float unitScale) const;
+    bool predictJoint(JointState& state, SkeletonJoint& joint, float dt) const;
+    SkeletonPtr filterSkeleton(UserState& state, const Skeleton& input, float dt) const;
+    SkeletonPtr predictSkeleton(UserState& state, float dt) const;
+
+    Settings m_settings;
+    QHash<int, UserState> m_users;
+    qint64 m_lastTimestamp;
+};
+
+} // End Namespace
+
+#endif // SKELETONSMOOTHER_H
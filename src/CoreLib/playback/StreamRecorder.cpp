@@ -0,0 +1,151 @@
+#include "StreamRecorder.h"
+#include <QDebug>
+
+namespace dai {
+
+StreamRecorder::StreamRecorder(const QString& fileName, StreamRecording::Compression compression, int maxQueueSize)
+    : m_fileName(fileName)
+    , m_compression(compression)
+    , m_types(DataFrame::Color | DataFrame::Depth | DataFrame::Mask | DataFrame::Skeleton | DataFrame::Metadata)
+    , m_maxQueueSize(maxQueueSize > 0 ? maxQueueSize : 1)
+    , m_running(true)
+    , m_framesReceived(0)
+    , m_framesWritten(0)
+    , m_framesDropped(0)
+    , m_bytesWritten(0)
+{
+    start();
+}
+
+StreamRecorder::~StreamRecorder()
+{
+    stopListener();
+    close();
+    qDebug() << "StreamRecorder::~StreamRecorder";
+}
+
+void StreamRecorder::setFrameTypes(DataFrame::SupportedFrames types)
+{
+    QMutexLocker locker(&m_lock);
+    m_types = types;
+}
+
+// This method is called from the FrameNotifier thread
+void StreamRecorder::newFrames(const QHashDataFrames dataFrames)
+{
+    QMutexLocker locker(&m_lock);
+
+    if (!m_running)
+        return;
+
+    m_framesReceived++;
+
+    if (m_queue.size() >= m_maxQueueSize) {
+        m_framesDropped++;
+        return;
+    }
+
+    if (!m_clock.isValid())
+        m_clock.start();
+
+    Bundle bundle;
+    bundle.timestamp = frameInfo().sourceTimestamp >= 0 ? frameInfo().sourceTimestamp : m_clock.nsecsElapsed() / 1000;
+
+    // Producer reuses its buffers, so the frames must be copied
+    for (auto it = dataFrames.constBegin(); it != dataFrames.constEnd(); ++it) {
+        if (m_types.testFlag(it.key()))
+            bundle.frames.insert(it.key(), it.value()->clone());
+    }
+
+    m_queue.enqueue(bundle);
+    m_sync.wakeOne();
+}
+
+void StreamRecorder::afterStop()
+{
+    close();
+}
+
+void StreamRecorder::close()
+{
+    m_lock.lock();
+    m_running = false;
+    m_sync.wakeOne();
+    m_lock.unlock();
+
+    if (QThread::currentThread() != this)
+        this->wait();
+}
+
+// The header describes the frames of the first bundle
+bool StreamRecorder::openRecording(const QHashDataFrames& frames)
+{
+    return m_recording.create(m_fileName, StreamRecording::headerOf(frames));
+}
+
+// Writer thread
+void StreamRecorder::run()
+{
+    bool error = false;
+
+    forever {
+        Bundle bundle;
+
+        m_lock.lock();
+        while (m_running && m_queue.isEmpty()) {
+            m_sync.wait(&m_lock);
+        }
+
+        // Pending frames are written even after close()
+        if (m_queue.isEmpty()) {
+            m_lock.unlock();
+            break;
+        }
+
+        bundle = m_queue.dequeue();
+        m_lock.unlock();
+
+        if (error)
+            continue;
+
+        if (!m_recording.isOpen() && !openRecording(bundle.frames)) {
+            error = true;
+            continue;
+        }
+
+        const QByteArray record = StreamRecording::encodeFrames(bundle.frames, bundle.timestamp, m_compression);
+
+        if (!m_recording.append(record, bundle.timestamp)) {
+            qDebug() << "StreamRecorder - Error writing" << m_fileName;
+            error = true;
+            continue;
+        }
+
+        // Stats
+        m_lock.lock();
+        m_framesWritten++;
+        m_bytesWritten = m_recording.bytesWritten();
+        m_lock.unlock();
+    }
+
+    m_recording.close();
+
+    Stats result = stats();
+    qDebug() << "StreamRecorder -" << m_fileName << "Written" << result.framesWritten
+             << "Received" << result.framesReceived << "Dropped" << result.framesDropped;
+}
+
+StreamRecorder::Stats StreamRecorder::stats() const
+{
+    QMutexLocker locker(&m_lock);
+    Stats result;
+    result.framesReceived = m_framesReceived;
+    result.framesWritten = m_framesWritten;
+    result.framesDropped = m_framesDropped;
+    result.bytesWritten = m_bytesWritten;
+    result.queueSize = m_queue.size();
+    result.maxQueueSize = m_maxQueueSize;
+    return result;
+}
+
+} // End Namespace
@@ -0,0 +1,89 @@
+#ifndef STREAMRECORDER_H
+#define STREAMRECORDER_H
+
+#include "playback/FrameListener.h"
+#include "playback/StreamRecording.h"
+#include <QThread>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QQueue>
+#include <QElapsedTimer>
+
+namespace dai {
+
+/**
+ * Listener that writes every received bundle of frames to a StreamRecording, so it can
+ * be played again with RecordingInstance. Frames are copied into a bounded queue and
+ * written by its own thread, so the producer is never blocked by the disk. When the
+ * queue is full the new bundle is dropped.
+ *
+ * Bundles keep the timestamp of their source. When the source has no timestamps, the
+ * time at which they were received is used instead.
+ *
+ * @brief The StreamRecorder class
+ */
+class StreamRecorder : public QThread, public FrameListener
+{
+public:
+    struct Stats {
+        qint64 framesReceived;
+        qint64 framesWritten;
+        qint64 framesDropped;
+        qint64 bytesWritten;
+        int    queueSize;
+        int    maxQueueSize;
+    };
+
+    StreamRecorder(const QString& fileName, StreamRecording::Compression compression = StreamRecording::COMPRESSION_NONE,
+                   int maxQueueSize = 30);
+    virtual ~StreamRecorder();
+
+    /**
+     * Only the given frames are recorded (all of them by default)
+     */
+    void setFrameTypes(DataFrame::SupportedFrames types);
+
+    /**
+     * Stops accepting frames, waits until the queued frames are written and closes the file
+     */
+    void close();
+    Stats stats() const;
+    const QString& fileName() const {return m_fileName;}
+    const char* listenerName() const override {return "StreamRecorder";}
+
+protected:
+    void newFrames(const QHashDataFrames dataFrames) override;
+    void afterStop() override;
+    void run() override;
+
+private:
+    struct Bundle {
+        QHashDataFrames frames;
+        qint64 timestamp;
+    };
+
+    bool openRecording(const QHashDataFrames& frames);
+
+    QString m_fileName;
+    StreamRecording::Compression m_compression;
+    StreamRecording m_recording;
+    QElapsedTimer m_clock;
+
+    // Queue (shared with the writer thread)
+    mutable QMutex m_lock;
+    QWaitCondition m_sync;
+    QQueue<Bundle> m_queue;
+    DataFrame::SupportedFrames m_types;
+    int m_maxQueueSize;
+    bool m_running;
+
+    // Stats
+    qint64 m_framesReceived;
+    qint64 m_framesWritten;
+    qint64 m_framesDropped;
+    qint64 m_bytesWritten;
+};
+
+} // End Namespace
+
+#endif // STREAMRECORDER_H
@@ -0,0 +1,512 @@
+#include "StreamRecording.h"
+#include "types/ColorFrame.h"
+#include "types/DepthFrame.h"
+#include "types/MaskFrame.h"
+#include "types/SkeletonFrame.h"
+#include "types/MetadataFrame.h"
+#include "types/FrameCodec.h"
+#include <QDataStream>
+#include <QtEndian>
+#include <QDebug>
+
+namespace dai {
+
+static const quint32 DATA_MAGIC = 0x44414952;   // DAIR
+static const quint32 INDEX_MAGIC = 0x44414958;  // DAIX
+static const quint32 RECORD_MAGIC = 0x46524D45; // FRME
+static const quint32 VERSION = 1;
+static const int DATA_HEADER_SIZE = 20;
+static const int INDEX_HEADER_SIZE = 8;
+static const int INDEX_ENTRY_SIZE = 16;
+
+// Frames are written always in the same order
+static const DataFrame::FrameType recordedTypes[] = {
+    DataFrame::Color, DataFrame::Depth, DataFrame::Mask, DataFrame::Skeleton, DataFrame::Metadata
+};
+
+template <class T>
+static QByteArray encodeImage(const DataFramePtr& frame)
+{
+    return static_pointer_cast<T>(frame)->toBinary();
+}
+
+// Check the size before loading, as loadData trusts the buffer
+template <class T, class Pixel>
+static shared_ptr<T> decodeImage(const QByteArray& data, DataFramePtr existing)
+{
+    if (data.size() < 16)
+        return nullptr;
+
+    const int* pHeader = (const int*) data.constData();
+    const qint64 width = pHeader[0];
+    const qint64 height = pHeader[1];
+
+    if (width < 0 || height < 0 || data.size() != 16 + width * height * qint64(sizeof(Pixel)))
+        return nullptr;
+
+    shared_ptr<T> frame = existing ? static_pointer_cast<T>(existing) : make_shared<T>();
+    frame->loadData(data);
+    return frame;
+}
+
+// Recorders encode in their own thread, so the codec uses only one
+template <class T>
+static shared_ptr<T> decodeCodec(const QByteArray& data, DataFramePtr existing)
+{
+    shared_ptr<T> frame = existing ? static_pointer_cast<T>(existing) : make_shared<T>();
+    return FrameCodec::decode(data, *frame, 1) ? frame : nullptr;
+}
+
+static QByteArray encodeSkeletons(const SkeletonFrame& skeletonFrame)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    const QList<int> usersId = skeletonFrame.getAllUsersId();
+
+    stream << qint32(skeletonFrame.width()) << qint32(skeletonFrame.height()) << quint32(usersId.size());
+
+    for (int userId : usersId) {
+        SkeletonPtr skeleton = skeletonFrame.getSkeleton(userId);
+        stream << qint32(userId) << quint8(skeleton->getType()) << quint8(skeleton->hasQuaternions())
+               << skeleton->toBinary();
+    }
+
+    return data;
+}
+
+static SkeletonFramePtr decodeSkeletons(const QByteArray& data)
+{
+    QDataStream stream(data);
+    qint32 width, height;
+    quint32 count;
+    stream >> width >> height >> count;
+
+    SkeletonFramePtr skeletonFrame = make_shared<SkeletonFrame>(width, height);
+
+    for (quint32 i=0; i<count && stream.status() == QDataStream::Ok; ++i)
+    {
+        qint32 userId;
+        quint8 type, hasQuaternions;
+        QByteArray binary;
+        stream >> userId >> type >> hasQuaternions >> binary;
+
+        if (binary.size() < 2 || binary.size() < uchar(binary[0]) * 37 + 2)
+            return nullptr;
+
+        // Skeleton::fromBinary guesses the type from the number of joints
+        SkeletonPtr joints = Skeleton::fromBinary(binary);
+        SkeletonPtr skeleton = make_shared<Skeleton>(Skeleton::SkeletonType(type));
+        skeleton->setDistanceUnits(joints->distanceUnits());
+
+        for (const SkeletonJoint& joint : joints->joints())
+            skeleton->setJoint(joint.getType(), joint);
+
+        if (hasQuaternions)
+            skeleton->computeQuaternions();
+
+        skeletonFrame->setSkeleton(userId, skeleton);
+    }
+
+    return stream.status() == QDataStream::Ok ? skeletonFrame : nullptr;
+}
+
+static QByteArray encodeMetadata(MetadataFrame& metadataFrame)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    stream << quint32(metadataFrame.boundingBoxes().size());
+
+    for (const BoundingBox& box : metadataFrame.boundingBoxes()) {
+        for (int k=0; k<3; ++k)
+            stream << box.getMin()[k];
+        for (int k=0; k<3; ++k)
+            stream << box.getMax()[k];
+    }
+
+    return data;
+}
+
+static shared_ptr<MetadataFrame> decodeMetadata(const QByteArray& data)
+{
+    QDataStream stream(data);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    quint32 count;
+    stream >> count;
+
+    shared_ptr<MetadataFrame> metadataFrame = make_shared<MetadataFrame>();
+
+    for (quint32 i=0; i<count && stream.status() == QDataStream::Ok; ++i) {
+        float values[6];
+        for (int k=0; k<6; ++k)
+            stream >> values[k];
+        metadataFrame->addBoundingBox(BoundingBox(Point3f(values[0], values[1], values[2]),
+                                                  Point3f(values[3], values[4], values[5])));
+    }
+
+    return stream.status() == QDataStream::Ok ? metadataFrame : nullptr;
+}
+
+QByteArray StreamRecording::encodeFrames(const QHashDataFrames& frames, qint64 timestamp, Compression compression)
+{
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    quint8 count = 0;
+
+    for (DataFrame::FrameType type : recordedTypes)
+        count += frames.contains(type);
+
+    stream << timestamp << count;
+
+    for (DataFrame::FrameType type : recordedTypes)
+    {
+        if (!frames.contains(type))
+            continue;
+
+        DataFramePtr frame = frames.value(type);
+        const bool codec = compression == COMPRESSION_CODEC && (type == DataFrame::Depth || type == DataFrame::Mask);
+        QByteArray data;
+
+        if (type == DataFrame::Color) {
+            data = encodeImage<ColorFrame>(frame);
+        }
+        else if (type == DataFrame::Depth) {
+            shared_ptr<DepthFrame> depthFrame = static_pointer_cast<DepthFrame>(frame);
+            data.append(char(depthFrame->distanceUnits()));
+            data.append(codec ? FrameCodec::encode(*depthFrame, 1) : encodeImage<DepthFrame>(frame));
+        }
+        else if (type == DataFrame::Mask) {
+            data = codec ? FrameCodec::encode(*static_pointer_cast<MaskFrame>(frame), 1) : encodeImage<MaskFrame>(frame);
+        }
+        else if (type == DataFrame::Skeleton) {
+            data = encodeSkeletons(*static_pointer_cast<SkeletonFrame>(frame));
+        }
+        else if (type == DataFrame::Metadata) {
+            data = encodeMetadata(*static_pointer_cast<MetadataFrame>(frame));
+        }
+
+        Compression frameCompression = codec ? COMPRESSION_CODEC : COMPRESSION_NONE;
+
+        if (compression != COMPRESSION_NONE && !codec) {
+            data = qCompress(data, 1);
+            frameCompression = COMPRESSION_ZLIB;
+        }
+
+        stream << quint8(type) << quint8(frameCompression) << quint32(frame->getIndex()) << data;
+    }
+
+    return record;
+}
+
+bool StreamRecording::decodeFrames(const QByteArray& record, QHashDataFrames& output, qint64* timestamp)
+{
+    QDataStream stream(record);
+    qint64 recordTimestamp;
+    quint8 count;
+    stream >> recordTimestamp >> count;
+
+    QHashDataFrames result;
+
+    for (int i=0; i<count && stream.status() == QDataStream::Ok; ++i)
+    {
+        quint8 type, compression;
+        quint32 index;
+        QByteArray data;
+        stream >> type >> compression >> index >> data;
+
+        if (stream.status() != QDataStream::Ok)
+            break;
+
+        const DataFrame::FrameType frameType = DataFrame::FrameType(type);
+        const bool codec = compression == COMPRESSION_CODEC;
+
+        if (compression == COMPRESSION_ZLIB)
+            data = qUncompress(data);
+        else if (compression != COMPRESSION_NONE && !codec)
+            return false;
+
+        if (codec && frameType != DataFrame::Depth && frameType != DataFrame::Mask)
+            return false;
+
+        DataFramePtr existing = output.value(frameType);
+        DataFramePtr frame;
+
+        if (frameType == DataFrame::Color) {
+            frame = decodeImage<ColorFrame, RGBColor>(data, existing);
+        }
+        else if (frameType == DataFrame::Depth && !data.isEmpty()) {
+            shared_ptr<DepthFrame> depthFrame = codec ? decodeCodec<DepthFrame>(data.mid(1), existing)
+                                                      : decodeImage<DepthFrame, uint16_t>(data.mid(1), existing);
+            if (depthFrame)
+                depthFrame->setDistanceUnits(DistanceUnits(data[0]));
+            frame = depthFrame;
+        }
+        else if (frameType == DataFrame::Mask) {
+            frame = codec ? decodeCodec<MaskFrame>(data, existing) : decodeImage<MaskFrame, uint8_t>(data, existing);
+        }
+        else if (frameType == DataFrame::Skeleton) {
+            frame = decodeSkeletons(data);
+        }
+        else if (frameType == DataFrame::Metadata) {
+            frame = decodeMetadata(data);
+        }
+
+        if (!frame)
+            return false;
+
+        frame->setIndex(index);
+        result.insert(frameType, frame);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    output = result;
+
+    if (timestamp)
+        *timestamp = recordTimestamp;
+
+    return true;
+}
+
+StreamRecording::StreamRecording()
+{
+}
+
+StreamRecording::~StreamRecording()
+{
+    close();
+}
+
+bool StreamRecording::readHeader(const QString& fileName, Header* header)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    return readHeader(file, header);
+}
+
+bool StreamRecording::readHeader(QIODevice& device, Header* header)
+{
+    QDataStream stream(&device);
+    quint32 magic, version, frames;
+    qint32 width, height;
+    stream >> magic >> version >> frames >> width >> height;
+
+    if (stream.status() != QDataStream::Ok || magic != DATA_MAGIC || version != VERSION)
+        return false;
+
+    header->frames = DataFrame::SupportedFrames(int(frames));
+    header->width = width;
+    header->height = height;
+    return true;
+}
+
+StreamRecording::Header StreamRecording::headerOf(const QHashDataFrames& frames)
+{
+    Header header;
+
+    for (DataFrame::FrameType type : frames.keys())
+        header.frames |= type;
+
+    if (frames.contains(DataFrame::Color)) {
+        ColorFramePtr colorFrame = static_pointer_cast<ColorFrame>(frames.value(DataFrame::Color));
+        header.width = colorFrame->width();
+        header.height = colorFrame->height();
+    }
+    else if (frames.contains(DataFrame::Depth)) {
+        shared_ptr<DepthFrame> depthFrame = static_pointer_cast<DepthFrame>(frames.value(DataFrame::Depth));
+        header.width = depthFrame->width();
+        header.height = depthFrame->height();
+    }
+
+    return header;
+}
+
+QByteArray StreamRecording::headerData(const Header& header)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << DATA_MAGIC << VERSION << quint32(header.frames) << qint32(header.width) << qint32(header.height);
+    return data;
+}
+
+// Same layout QDataStream writes (big endian), without allocating memory
+void StreamRecording::recordHeader(quint32 size, char* buffer)
+{
+    qToBigEndian(RECORD_MAGIC, (uchar*) buffer);
+    qToBigEndian(size, (uchar*) buffer + 4);
+}
+
+bool StreamRecording::create(const QString& fileName, const Header& header)
+{
+    close();
+    m_data.setFileName(fileName);
+    m_index.setFileName(fileName + ".idx");
+
+    if (!m_data.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+            !m_index.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "StreamRecording - Error creating" << fileName;
+        close();
+        return false;
+    }
+
+    m_header = header;
+
+    m_data.write(headerData(header));
+
+    QDataStream indexStream(&m_index);
+    indexStream << INDEX_MAGIC << VERSION;
+
+    return m_data.flush() && m_index.flush();
+}
+
+bool StreamRecording::append(const QByteArray& record, qint64 timestamp)
+{
+    Q_ASSERT(m_index.isOpen());
+
+    Entry entry;
+    entry.offset = m_data.pos();
+    entry.timestamp = timestamp;
+
+    // The record must be complete before the index points to it
+    char prefix[RECORD_HEADER_SIZE];
+    recordHeader(record.size(), prefix);
+
+    if (m_data.write(prefix, RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE ||
+            m_data.write(record) != record.size() || !m_data.flush())
+        return false;
+
+    QDataStream indexStream(&m_index);
+    indexStream << entry.offset << entry.timestamp;
+
+    if (indexStream.status() != QDataStream::Ok || !m_index.flush())
+        return false;
+
+    m_entries << entry;
+    return true;
+}
+
+bool StreamRecording::open(const QString& fileName)
+{
+    close();
+    m_data.setFileName(fileName);
+
+    if (!m_data.open(QIODevice::ReadOnly) || !readHeader(m_data, &m_header)) {
+        qDebug() << "StreamRecording - Cannot open" << fileName;
+        close();
+        return false;
+    }
+
+    readIndex(fileName + ".idx");
+
+    // Records written after the last entry of the index (or without index)
+    scanRecords(m_entries.isEmpty() ? DATA_HEADER_SIZE : m_entries.last().offset);
+    return true;
+}
+
+/**
+ * Entries that point outside the data file, or to something that isn't a record, are
+ * dropped from the end of the index.
+ */
+void StreamRecording::readIndex(const QString& fileName)
+{
+    m_entries.clear();
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    quint32 magic, version;
+    stream >> magic >> version;
+
+    if (stream.status() != QDataStream::Ok || magic != INDEX_MAGIC || version != VERSION)
+        return;
+
+    const qint64 count = (file.size() - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE;
+    m_entries.reserve(count);
+
+    for (qint64 i=0; i<count; ++i)
+    {
+        Entry entry;
+        stream >> entry.offset >> entry.timestamp;
+
+        if (entry.offset < DATA_HEADER_SIZE || (!m_entries.isEmpty() && entry.offset <= m_entries.last().offset))
+            break;
+
+        m_entries << entry;
+    }
+
+    quint32 size;
+
+    while (!m_entries.isEmpty() && !readRecordSize(m_entries.last().offset, &size))
+        m_entries.removeLast();
+}
+
+// Add the records that start at offset, or after it if offset is already indexed
+void StreamRecording::scanRecords(qint64 offset)
+{
+    quint32 size;
+
+    if (!m_entries.isEmpty() && m_entries.last().offset == offset) {
+        readRecordSize(offset, &size);
+        offset += RECORD_HEADER_SIZE + size;
+    }
+
+    while (readRecordSize(offset, &size) && size >= sizeof(qint64))
+    {
+        Entry entry;
+        entry.offset = offset;
+
+        QDataStream stream(&m_data);
+        stream >> entry.timestamp;
+
+        m_entries << entry;
+        offset += RECORD_HEADER_SIZE + size;
+    }
+}
+
+// True if a complete record starts at offset
+bool StreamRecording::readRecordSize(qint64 offset, quint32* size)
+{
+    if (offset + RECORD_HEADER_SIZE > m_data.size() || !m_data.seek(offset))
+        return false;
+
+    QDataStream stream(&m_data);
+    quint32 magic;
+    stream >> magic >> *size;
+
+    return stream.status() == QDataStream::Ok && magic == RECORD_MAGIC
+            && offset + RECORD_HEADER_SIZE + *size <= m_data.size();
+}
+
+QByteArray StreamRecording::readRecord(int frame)
+{
+    quint32 size;
+
+    if (frame < 0 || frame >= m_entries.size() || !readRecordSize(m_entries[frame].offset, &size))
+        return QByteArray();
+
+    return m_data.read(size);
+}
+
+qint64 StreamRecording::bytesWritten() const
+{
+    return m_data.isOpen() ? m_data.size() + m_index.size() : 0;
+}
+
+void StreamRecording::close()
+{
+    if (m_data.isOpen())
+        m_data.close();
+
+    if (m_index.isOpen())
+        m_index.close();
+
+    m_entries.clear();
+}
+
+} // End Namespace
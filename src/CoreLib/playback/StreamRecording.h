@@ -0,0 +1,106 @@
+#ifndef STREAMRECORDING_H
+#define STREAMRECORDING_H
+
+#include "types/DataFrame.h"
+#include <QFile>
+#include <QVector>
+#include <QByteArray>
+
+namespace dai {
+
+/**
+ * File of recorded frames, written by StreamRecorder and read by RecordingInstance.
+ *
+ * The data file (extension .dair) has a header followed by one record per bundle of
+ * frames: colour, depth, mask, skeleton and metadata are stored losslessly with their
+ * capture time. An index file (same name plus .idx) keeps the offset and timestamp of
+ * each record, so frames can be read in any order.
+ *
+ * Records are written before their index entry, and both files are flushed after each
+ * record, so a recording survives a crash of the recorder. When the index is missing or
+ * shorter than the data, the records at the end are found again by scanning the file,
+ * and a partial record is ignored.
+ *
+ * @brief The StreamRecording class
+ */
+class StreamRecording
+{
+public:
+    enum Compression {
+        COMPRESSION_NONE,
+        COMPRESSION_ZLIB,
+        COMPRESSION_CODEC   // FrameCodec for depth and masks, zlib for the rest
+    };
+
+    struct Header {
+        DataFrame::SupportedFrames frames = DataFrame::Unknown;
+        int width = 0;
+        int height = 0;
+    };
+
+    static const char* extension() {return ".dair";}
+    static const int RECORD_HEADER_SIZE = 8;    // Magic and size before each record
+
+    /**
+     * Header describing a bundle: its frame types and the size of its colour or depth frame
+     */
+    static Header headerOf(const QHashDataFrames& frames);
+
+    /**
+     * Raw bytes of the file header and of the start of a record, for writers that don't go
+     * through create() and append(). A file written this way has no index, it is rebuilt
+     * by open().
+     */
+    static QByteArray headerData(const Header& header);
+    static void recordHeader(quint32 size, char* buffer);
+
+    /**
+     * Serialise a bundle of frames. timestamp is in microseconds (-1 if unknown).
+     */
+    static QByteArray encodeFrames(const QHashDataFrames& frames, qint64 timestamp, Compression compression = COMPRESSION_NONE);
+
+    /**
+     * Frames of output of the same type and size are reused. Returns false if the
+     * record is corrupt.
+     */
+    static bool decodeFrames(const QByteArray& record, QHashDataFrames& output, qint64* timestamp = nullptr);
+    static bool readHeader(const QString& fileName, Header* header);
+
+    StreamRecording();
+    ~StreamRecording();
+
+    // Writing
+    bool create(const QString& fileName, const Header& header);
+    bool append(const QByteArray& record, qint64 timestamp);
+
+    // Reading
+    bool open(const QString& fileName);
+    QByteArray readRecord(int frame);
+    qint64 timestamp(int frame) const {return m_entries[frame].timestamp;}
+
+    void close();
+    bool isOpen() const {return m_data.isOpen();}
+    const Header& header() const {return m_header;}
+    int framesCount() const {return m_entries.size();}
+    qint64 bytesWritten() const;
+
+private:
+    struct Entry {
+        qint64 offset;      // Position of the record in the data file
+        qint64 timestamp;
+    };
+
+    static bool readHeader(QIODevice& device, Header* header);
+    void readIndex(const QString& fileName);
+    void scanRecords(qint64 offset);
+    bool readRecordSize(qint64 offset, quint32* size);
+
+    QFile m_data;
+    QFile m_index;
+    Header m_header;
+    QVector<Entry> m_entries;
+};
+
+} // End Namespace
+
+#endif // STREAMRECORDING_H
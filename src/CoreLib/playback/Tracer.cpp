@@ -0,0 +1,309 @@
+#include "Tracer.h"
+#include <QThread>
+#include <QThreadStorage>
+#include <QMutex>
+#include <QList>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include <chrono>
+#include <memory>
+#include <limits>
+
+using namespace std;
+
+namespace dai {
+
+struct TraceEvent
+{
+    qint64 start;
+    qint64 duration;
+    qint64 frameId;
+    const char* category;
+    const char* name;
+    char phase; // 'X' complete, 'i' instant
+};
+
+/**
+ * Single producer ring. Only its thread writes on it, readers check the sequence
+ * number of each slot to discard the ones being overwritten while they are copied.
+ */
+class TraceRing
+{
+public:
+    explicit TraceRing(int capacity)
+        : m_slots(new Slot[capacity])
+        , m_capacity(capacity)
+        , m_head(0)
+        , m_exportFrom(0)
+        , m_currentFrame(-1)
+        , m_tid(0)
+        , m_finished(false)
+    {
+        for (int i=0; i<capacity; ++i)
+            m_slots[i].seq.store(0, memory_order_relaxed);
+    }
+
+    void push(const TraceEvent& event)
+    {
+        const quint64 head = m_head.load(memory_order_relaxed);
+        Slot& slot = m_slots[head % m_capacity];
+        slot.seq.store(2 * head + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot.event = event;
+        slot.seq.store(2 * head + 2, memory_order_release);
+        m_head.store(head + 1, memory_order_release);
+    }
+
+    QList<TraceEvent> snapshot() const
+    {
+        QList<TraceEvent> result;
+        const quint64 head = m_head.load(memory_order_acquire);
+        quint64 first = head > quint64(m_capacity) ? head - m_capacity : 0;
+        first = qMax(first, m_exportFrom);
+
+        for (quint64 i=first; i<head; ++i)
+        {
+            const Slot& slot = m_slots[i % m_capacity];
+            const quint64 seq1 = slot.seq.load(memory_order_acquire);
+            TraceEvent event = slot.event;
+            atomic_thread_fence(memory_order_acquire);
+            const quint64 seq2 = slot.seq.load(memory_order_relaxed);
+
+            if (seq1 == seq2 && seq1 == 2 * i + 2)
+                result << event;
+        }
+
+        return result;
+    }
+
+    void clear() {
+        m_exportFrom = m_head.load(memory_order_acquire);
+    }
+
+    qint64 currentFrame() const {return m_currentFrame;}
+    void setCurrentFrame(qint64 frameId) {m_currentFrame = frameId;}
+
+    int tid() const {return m_tid;}
+    void setTid(int tid) {m_tid = tid;}
+
+    // The thread has finished, so nothing else is written
+    bool isFinished() const {return m_finished.load(memory_order_acquire);}
+    void setFinished() {m_finished.store(true, memory_order_release);}
+
+    QString threadName() const {
+        QMutexLocker locker(&m_nameLock);
+        return m_threadName;
+    }
+
+    void setThreadName(const QString& name) {
+        QMutexLocker locker(&m_nameLock);
+        m_threadName = name;
+    }
+
+private:
+    struct Slot {
+        atomic<quint64> seq;
+        TraceEvent event;
+    };
+
+    unique_ptr<Slot[]> m_slots;
+    const int m_capacity;
+    atomic<quint64> m_head;
+    quint64 m_exportFrom;    // Guarded by the registry lock
+    qint64 m_currentFrame;   // Only used by the owner thread
+    int m_tid;
+    atomic<bool> m_finished;
+    QString m_threadName;
+    mutable QMutex m_nameLock;
+};
+
+// Rings are kept after their threads finish, so their events can still be exported. They
+// are dropped once exported or cleared
+struct ThreadTrace {
+    shared_ptr<TraceRing> ring;
+    ~ThreadTrace() {ring->setFinished();}
+};
+
+static QMutex g_registryLock;
+static QList<shared_ptr<TraceRing>> g_rings;
+static int g_nextTid = 1;       // Guarded by the registry lock
+static QThreadStorage<ThreadTrace*> g_threadTrace;
+static atomic<int> g_ringCapacity(16384);
+
+std::atomic<bool> Tracer::s_enabled(false);
+
+static TraceRing* localRing()
+{
+    if (!g_threadTrace.hasLocalData())
+    {
+        ThreadTrace* trace = new ThreadTrace;
+        trace->ring = make_shared<TraceRing>(g_ringCapacity.load());
+
+        QThread* thread = QThread::currentThread();
+        if (thread && !thread->objectName().isEmpty())
+            trace->ring->setThreadName(thread->objectName());
+
+        QMutexLocker locker(&g_registryLock);
+        g_rings << trace->ring;
+        trace->ring->setTid(g_nextTid++);
+
+        if (trace->ring->threadName().isEmpty())
+            trace->ring->setThreadName(QString("Thread %1").arg(trace->ring->tid()));
+
+        g_threadTrace.setLocalData(trace);
+    }
+
+    return g_threadTrace.localData()->ring.get();
+}
+
+void Tracer::setEnabled(bool value)
+{
+    s_enabled.store(value);
+    qDebug() << "Tracer" << (value ? "enabled" : "disabled");
+}
+
+void Tracer::setRingCapacity(int numEvents)
+{
+    g_ringCapacity.store(qMax(numEvents, 16));
+}
+
+qint64 Tracer::now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::complete(const char* category, const char* name, qint64 frameId, qint64 start, qint64 duration)
+{
+    if (!isEnabled())
+        return;
+
+    localRing()->push({start, duration, frameId, category, name, 'X'});
+}
+
+void Tracer::instant(const char* category, const char* name, qint64 frameId)
+{
+    if (!isEnabled())
+        return;
+
+    localRing()->push({now(), 0, frameId, category, name, 'i'});
+}
+
+void Tracer::setThreadName(const QString& name)
+{
+    localRing()->setThreadName(name);
+}
+
+qint64 Tracer::currentFrame()
+{
+    return g_threadTrace.hasLocalData() ? g_threadTrace.localData()->ring->currentFrame() : -1;
+}
+
+void Tracer::setCurrentFrame(qint64 frameId)
+{
+    localRing()->setCurrentFrame(frameId);
+}
+
+// Rings of the threads that had finished before their events were read. Called with the
+// registry lock held
+static QList<shared_ptr<TraceRing>> finishedRings()
+{
+    QList<shared_ptr<TraceRing>> result;
+
+    for (shared_ptr<TraceRing> ring : g_rings) {
+        if (ring->isFinished())
+            result << ring;
+    }
+
+    return result;
+}
+
+static void removeRings(const QList<shared_ptr<TraceRing>>& rings)
+{
+    for (shared_ptr<TraceRing> ring : rings)
+        g_rings.removeOne(ring);
+}
+
+void Tracer::clear()
+{
+    QMutexLocker locker(&g_registryLock);
+    const QList<shared_ptr<TraceRing>> finished = finishedRings();
+
+    for (shared_ptr<TraceRing> ring : g_rings)
+        ring->clear();
+
+    removeRings(finished);
+}
+
+static QString escapeJson(QString text)
+{
+    return text.replace("\\", "\\\\").replace("\"", "\\\"");
+}
+
+bool Tracer::exportChromeTrace(const QString& fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qDebug() << "Tracer - Couldn't open" << fileName;
+        return false;
+    }
+
+    QMutexLocker locker(&g_registryLock);
+    const QList<shared_ptr<TraceRing>> finished = finishedRings();
+    QList<QList<TraceEvent>> events;
+    qint64 origin = numeric_limits<qint64>::max();
+    int numEvents = 0;
+
+    for (shared_ptr<TraceRing> ring : g_rings) {
+        events << ring->snapshot();
+        numEvents += events.last().size();
+        for (const TraceEvent& event : events.last())
+            origin = qMin(origin, event.start);
+    }
+
+    QTextStream out(&file);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    bool first = true;
+
+    for (int i=0; i<g_rings.size(); ++i)
+    {
+        const shared_ptr<TraceRing>& ring = g_rings.at(i);
+
+        out << (first ? "" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid()
+            << ",\"args\":{\"name\":\"" << escapeJson(ring->threadName()) << "\"}}";
+        first = false;
+
+        // Timestamps in microseconds
+        for (const TraceEvent& event : events.at(i))
+        {
+            out << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+                << "\",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << ring->tid()
+                << ",\"ts\":" << (event.start - origin) / 1000.0;
+
+            if (event.phase == 'X')
+                out << ",\"dur\":" << event.duration / 1000.0;
+            else
+                out << ",\"s\":\"t\"";
+
+            out << ",\"args\":{\"frameId\":" << event.frameId << "}}";
+        }
+    }
+
+    out << "\n]}\n";
+    out.flush();
+    file.close();
+
+    // Their threads won't write anything else
+    removeRings(finished);
+
+    qDebug() << "Tracer -" << numEvents << "events written to" << fileName;
+    return true;
+}
+
+} // End Namespace
@@ -0,0 +1,101 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+namespace dai {
+
+/**
+ * Low overhead tracing of the stages a frame goes through (playback, notifiers, filters,
+ * viewers). Every thread writes its events in its own ring buffer without taking any lock,
+ * so old events are overwritten when the ring is full. Events are keyed by frameId and
+ * they can be exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+ *
+ * Tracing is disabled by default. When disabled, recording an event costs a relaxed load.
+ *
+ * @brief The Tracer class
+ */
+class Tracer
+{
+public:
+    static void setEnabled(bool value);
+    static inline bool isEnabled() {return s_enabled.load(std::memory_order_relaxed);}
+
+    /**
+     * Events kept per thread. Only applies to threads that have not traced yet.
+     */
+    static void setRingCapacity(int numEvents);
+
+    /**
+     * Monotonic time in nanoseconds
+     */
+    static qint64 now();
+
+    static void complete(const char* category, const char* name, qint64 frameId, qint64 start, qint64 duration);
+    static void instant(const char* category, const char* name, qint64 frameId);
+
+    /**
+     * Name shown for the calling thread in the exported trace
+     */
+    static void setThreadName(const QString& name);
+
+    /**
+     * Source frame being processed by the calling thread (-1 if none). FrameNotifier sets it
+     * before calling a listener, so the frames produced by a listener that is a generator too
+     * keep the id of the source frame.
+     */
+    static qint64 currentFrame();
+    static void setCurrentFrame(qint64 frameId);
+
+    /**
+     * Forget the recorded events
+     */
+    static void clear();
+
+    static bool exportChromeTrace(const QString& fileName);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * Records the time spent since its creation and until its destruction
+ *
+ * @brief The TraceScope class
+ */
+class TraceScope
+{
+public:
+    /**
+     * If frameId is -1, the current frame of the thread is used
+     */
+    TraceScope(const char* category, const char* name, qint64 frameId = -1)
+        : m_category(category)
+        , m_name(name)
+        , m_frameId(frameId)
+        , m_start(-1)
+    {
+        if (Tracer::isEnabled()) {
+            if (m_frameId < 0)
+                m_frameId = Tracer::currentFrame();
+            m_start = Tracer::now();
+        }
+    }
+
+    ~TraceScope() {
+        if (m_start >= 0)
+            Tracer::complete(m_category, m_name, m_frameId, m_start, Tracer::now() - m_start);
+    }
+
+private:
+    const char* m_category;
+    const char* m_name;
+    qint64 m_frameId;
+    qint64 m_start;
+};
+
+} // End Namespace
+
+#endif // TRACER_H
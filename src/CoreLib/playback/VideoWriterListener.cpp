@@ -0,0 +1,187 @@
+#include "VideoWriterListener.h"
+#include <QDebug>
+
+namespace dai {
+
+VideoWriterListener::VideoWriterListener(const QString& fileName, double fps, VideoCodec codec, int maxQueueSize)
+    : m_fileName(fileName)
+    , m_fps(fps)
+    , m_codec(codec)
+    , m_maxQueueSize(maxQueueSize > 0 ? maxQueueSize : 1)
+    , m_running(true)
+    , m_framesReceived(0)
+    , m_framesWritten(0)
+    , m_framesDropped(0)
+    , m_encodeFps(0.0f)
+{
+    start();
+}
+
+VideoWriterListener::~VideoWriterListener()
+{
+    stopListener();
+    close();
+    qDebug() << "VideoWriterListener::~VideoWriterListener";
+}
+
+int VideoWriterListener::fourcc(VideoCodec codec)
+{
+    int result;
+
+    switch (codec) {
+    case CODEC_FFV1:
+        result = CV_FOURCC('F', 'F', 'V', '1');
+        break;
+    case CODEC_XVID:
+        result = CV_FOURCC('X', 'V', 'I', 'D');
+        break;
+    default:
+        result = CV_FOURCC('M', 'J', 'P', 'G');
+    }
+
+    return result;
+}
+
+bool VideoWriterListener::openWriter(int width, int height)
+{
+    m_writer.open(m_fileName.toStdString(), fourcc(m_codec), m_fps, cv::Size(width, height), true);
+
+    if (!m_writer.isOpened()) {
+        qDebug() << "VideoWriterListener - Error opening file" << m_fileName;
+        return false;
+    }
+
+    return true;
+}
+
+// This method is called from the FrameNotifier thread
+void VideoWriterListener::newFrames(const QHashDataFrames dataFrames)
+{
+    if (!dataFrames.contains(DataFrame::Color))
+        return;
+
+    QMutexLocker locker(&m_lock);
+
+    if (!m_running)
+        return;
+
+    m_framesReceived++;
+
+    if (m_queue.size() >= m_maxQueueSize) {
+        m_framesDropped++;
+        return;
+    }
+
+    // Producer reuses its buffers, so the frame must be copied
+    ColorFramePtr colorFrame = static_pointer_cast<ColorFrame>(dataFrames.value(DataFrame::Color));
+    m_queue.enqueue( static_pointer_cast<ColorFrame>(colorFrame->clone()) );
+    m_sync.wakeOne();
+}
+
+void VideoWriterListener::afterStop()
+{
+    close();
+}
+
+void VideoWriterListener::close()
+{
+    m_lock.lock();
+    m_running = false;
+    m_sync.wakeOne();
+    m_lock.unlock();
+
+    if (QThread::currentThread() != this)
+        this->wait();
+}
+
+// Encoder thread
+void VideoWriterListener::run()
+{
+    cv::Mat bgr_mat;
+    cv::Size frameSize;
+    QElapsedTimer timer;
+    qint64 encodedSinceLastUpdate = 0;
+    bool error = false;
+
+    timer.start();
+
+    forever {
+        ColorFramePtr frame;
+
+        m_lock.lock();
+        while (m_running && m_queue.isEmpty()) {
+            m_sync.wait(&m_lock);
+        }
+
+        // Pending frames are written even after close()
+        if (m_queue.isEmpty()) {
+            m_lock.unlock();
+            break;
+        }
+
+        frame = m_queue.dequeue();
+        m_lock.unlock();
+
+        if (error)
+            continue;
+
+        if (!m_writer.isOpened())
+        {
+            if (!openWriter(frame->width(), frame->height())) {
+                error = true;
+                continue;
+            }
+
+            frameSize = cv::Size(frame->width(), frame->height());
+        }
+
+        // The video keeps the size of the first frame
+        if (frame->width() != frameSize.width || frame->height() != frameSize.height) {
+            qDebug() << "VideoWriterListener - Dropping a frame of" << frame->width() << "x" << frame->height()
+                     << "(video is" << frameSize.width << "x" << frameSize.height << ")";
+            m_lock.lock();
+            m_framesDropped++;
+            m_lock.unlock();
+            continue;
+        }
+
+        // Encode
+        cv::Mat rgb_mat(frame->height(), frame->width(), CV_8UC3,
+                        (void*) frame->getDataPtr(), frame->getStride());
+        cv::cvtColor(rgb_mat, bgr_mat, CV_RGB2BGR);
+        m_writer.write(bgr_mat);
+        encodedSinceLastUpdate++;
+
+        // Stats
+        m_lock.lock();
+        m_framesWritten++;
+
+        if (timer.elapsed() >= 1000) {
+            m_encodeFps = encodedSinceLastUpdate * 1000.0f / timer.elapsed();
+            encodedSinceLastUpdate = 0;
+            timer.restart();
+        }
+        m_lock.unlock();
+    }
+
+    m_writer.release();
+
+    Stats result = stats();
+    qDebug() << "VideoWriterListener -" << m_fileName << "Written" << result.framesWritten
+             << "Received" << result.framesReceived << "Dropped" << result.framesDropped;
+}
+
+VideoWriterListener::Stats VideoWriterListener::stats() const
+{
+    QMutexLocker locker(&m_lock);
+    Stats result;
+    result.framesReceived = m_framesReceived;
+    result.framesWritten = m_framesWritten;
+    result.framesDropped = m_framesDropped;
+    result.queueSize = m_queue.size();
+    result.maxQueueSize = m_maxQueueSize;
+    result.encodeFps = m_encodeFps;
+    return result;
+}
+
+} // End Namespace
@@ -0,0 +1,82 @@
+#ifndef VIDEOWRITERLISTENER_H
+#define VIDEOWRITERLISTENER_H
+
+#include "playback/FrameListener.h"
+#include "types/ColorFrame.h"
+#include <QThread>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QQueue>
+#include <QElapsedTimer>
+#include <opencv2/opencv.hpp>
+
+namespace dai {
+
+/**
+ * Listener that encodes the received ColorFrames into a video file. Frames are
+ * copied into a bounded queue and compressed by its own encoder thread, so the
+ * producer is never blocked by the encoder. When the queue is full the new frame
+ * is dropped, as are the frames whose size differs from the first one.
+ *
+ * @brief The VideoWriterListener class
+ */
+class VideoWriterListener : public QThread, public FrameListener
+{
+public:
+    enum VideoCodec {
+        CODEC_MJPG,
+        CODEC_FFV1, // Lossless
+        CODEC_XVID
+    };
+
+    struct Stats {
+        qint64 framesReceived;
+        qint64 framesWritten;
+        qint64 framesDropped;
+        int    queueSize;
+        int    maxQueueSize;
+        float  encodeFps;
+    };
+
+    VideoWriterListener(const QString& fileName, double fps = 25.0, VideoCodec codec = CODEC_MJPG, int maxQueueSize = 30);
+    virtual ~VideoWriterListener();
+
+    /**
+     * Stops accepting frames, waits until the queued frames are written and closes the file
+     */
+    void close();
+    Stats stats() const;
+    const QString& fileName() const {return m_fileName;}
+    const char* listenerName() const override {return "VideoWriterListener";}
+
+protected:
+    void newFrames(const QHashDataFrames dataFrames) override;
+    void afterStop() override;
+    void run() override;
+
+private:
+    static int fourcc(VideoCodec codec);
+    bool openWriter(int width, int height);
+
+    QString m_fileName;
+    double m_fps;
+    VideoCodec m_codec;
+    cv::VideoWriter m_writer;
+
+    // Queue (shared with the encoder thread)
+    mutable QMutex m_lock;
+    QWaitCondition m_sync;
+    QQueue<ColorFramePtr> m_queue;
+    int m_maxQueueSize;
+    bool m_running;
+
+    // Stats
+    qint64 m_framesReceived;
+    qint64 m_framesWritten;
+    qint64 m_framesDropped;
+    float m_encodeFps;
+};
+
+} // End Namespace
+
+#endif // VIDEOWRITERLISTENER_H
@@ -33,6 +33,16 @@ DepthFrame::DepthFrame(const DepthFrame& other)
     m_cy_d = other.m_cy_d;
 }
 
+DepthFrame::DepthFrame(DepthFrame&& other)
+    : GenericFrame<uint16_t,DataFrame::Depth>(std::move(other))
+{
+    m_units = other.m_units;
+    m_fx_d = other.m_fx_d;
+    m_fy_d = other.m_fy_d;
+    m_cx_d = other.m_cx_d;
+    m_cy_d = other.m_cy_d;
+}
+
 shared_ptr<DataFrame> DepthFrame::clone() const
 {
     return shared_ptr<DataFrame>(new DepthFrame(*this));
@@ -49,6 +59,17 @@ DepthFrame& DepthFrame::operator=(const DepthFrame& other)
     return *this;
 }
 
+DepthFrame& DepthFrame::operator=(DepthFrame&& other)
+{
+    GenericFrame<uint16_t,DataFrame::Depth>::operator=(std::move(other));
+    m_units = other.m_units;
+    m_fx_d = other.m_fx_d;
+    m_fy_d = other.m_fy_d;
+    m_cx_d = other.m_cx_d;
+    m_cy_d = other.m_cy_d;
+    return *this;
+}
+
 //
 // Static Class Methods
 //
@@ -137,4 +158,11 @@ void DepthFrame::convertCoordinatesToWorld(float x, float y, float z, float* pOu
     *pOutY = (y - m_cy_d) * z / m_fy_d;
 }
 
+// Inverse of convertCoordinatesToWorld
+void DepthFrame::convertWorldToCoordinates(float x, float y, float z, float* pOutX, float* pOutY) const
+{
+    *pOutX = x * m_fx_d / z + m_cx_d - offset()[0];
+    *pOutY = y * m_fy_d / z + m_cy_d - offset()[1];
+}
+
 } // End Namespace
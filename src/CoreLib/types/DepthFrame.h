@@ -27,6 +27,7 @@ public:
     DepthFrame(int width, int height);
     DepthFrame(int width, int height, uint16_t *pData, uint stride = 0);
     DepthFrame(const DepthFrame& other);
+    DepthFrame(DepthFrame&& other);
     shared_ptr<DataFrame> clone() const;
 
     // Member Methods
@@ -39,9 +40,11 @@ public:
 
     // Overriden operators
     DepthFrame& operator=(const DepthFrame& other);
+    DepthFrame& operator=(DepthFrame&& other);
 
     // Extra
     void convertCoordinatesToWorld(float x, float y, float z, float* pOutX, float* pOutY) const;
+    void convertWorldToCoordinates(float x, float y, float z, float* pOutX, float* pOutY) const;
     void setCameraIntrinsics(double fx_d, double cx_d, double fy_d, double cy_d);
 
 private:
@@ -0,0 +1,507 @@
+#include "FrameCodec.h"
+#include "Parallel.h"
+#include <QThread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
+
+namespace dai {
+
+static const quint32 CODEC_MAGIC = 0x43494144;  // DAIC
+static const quint8 CODEC_VERSION = 1;
+static const int BAND_ROWS = 32;
+static const unsigned RICE_LIMIT = 24;          // Longer unary codes are escaped
+static const qint64 MAX_PIXELS = 1 << 28;
+
+struct CodecHeader
+{
+    quint32 magic;
+    quint8  version;
+    quint8  sampleSize;
+    quint16 bandRows;
+    qint32  width;
+    qint32  height;
+    qint32  offsetX;
+    qint32  offsetY;
+    quint32 bandCount;      // Followed by the size of each band
+};
+
+static_assert(sizeof(CodecHeader) == 28, "CodecHeader must be packed");
+
+static inline int countLeadingZeros(quint64 value)
+{
+    if (value == 0)
+        return 64;
+#if defined(__GNUC__)
+    return __builtin_clzll(value);
+#else
+    int count = 0;
+    while (!(value & (quint64(1) << 63))) {
+        value <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Most significant bit first
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uchar>& output) : m_output(output), m_buffer(0), m_count(0) {}
+
+    // bits <= 32
+    void write(quint32 value, int bits) {
+        m_buffer = (m_buffer << bits) | value;
+        m_count += bits;
+
+        while (m_count >= 8) {
+            m_count -= 8;
+            m_output.push_back(uchar(m_buffer >> m_count));
+        }
+    }
+
+    void flush() {
+        if (m_count > 0)
+            m_output.push_back(uchar(m_buffer << (8 - m_count)));
+        m_count = 0;
+    }
+
+private:
+    std::vector<uchar>& m_output;
+    quint64 m_buffer;
+    int m_count;
+};
+
+// Bits past the end of the input are read as zeros, overrun() tells if any was used
+class BitReader
+{
+public:
+    BitReader(const uchar* data, qint64 size) : m_data(data), m_end(data + size), m_buffer(0), m_count(0), m_padding(0) {}
+
+    int leadingOnes() {
+        refill();
+        return countLeadingZeros(~m_buffer);
+    }
+
+    int leadingZeros() {
+        refill();
+        return countLeadingZeros(m_buffer);
+    }
+
+    void skip(int bits) {
+        m_buffer <<= bits;
+        m_count -= bits;
+    }
+
+    // bits <= 32
+    quint32 read(int bits) {
+        if (bits == 0)
+            return 0;
+        refill();
+        const quint32 value = quint32(m_buffer >> (64 - bits));
+        skip(bits);
+        return value;
+    }
+
+    bool overrun() const {return m_padding * 8 > m_count;}
+
+private:
+    void refill() {
+        while (m_count <= 56) {
+            quint64 byte = 0;
+            if (m_data < m_end)
+                byte = *m_data++;
+            else
+                m_padding++;
+            m_buffer |= byte << (56 - m_count);
+            m_count += 8;
+        }
+    }
+
+    const uchar* m_data;
+    const uchar* m_end;
+    quint64 m_buffer;
+    int m_count;
+    int m_padding;
+};
+
+// Rice parameter from the mean of the last residuals (LOCO-I)
+class RiceContext
+{
+public:
+    RiceContext() : m_sum(4), m_count(1) {}
+
+    int parameter() const {
+        int k = 0;
+        while ((m_count << k) < m_sum)
+            k++;
+        return k;
+    }
+
+    void update(quint32 value) {
+        m_sum += value;
+        if (++m_count == 64) {
+            m_sum >>= 1;
+            m_count >>= 1;
+        }
+    }
+
+private:
+    quint32 m_sum;
+    quint32 m_count;
+};
+
+static inline void writeRice(BitWriter& writer, quint32 value, int k, int bits)
+{
+    const quint32 quotient = value >> k;
+
+    if (quotient < RICE_LIMIT) {
+        writer.write(((1u << quotient) - 1) << 1, quotient + 1);
+        writer.write(value & ((1u << k) - 1), k);
+    }
+    else {
+        writer.write((1u << RICE_LIMIT) - 1, RICE_LIMIT);
+        writer.write(value, bits);
+    }
+}
+
+static inline quint32 readRice(BitReader& reader, int k, int bits)
+{
+    const unsigned quotient = std::min(unsigned(reader.leadingOnes()), RICE_LIMIT);
+
+    if (quotient < RICE_LIMIT) {
+        reader.skip(quotient + 1);
+        return (quotient << k) | reader.read(k);
+    }
+
+    reader.skip(RICE_LIMIT);
+    return reader.read(bits);
+}
+
+// Exp-Golomb, for the length of the runs
+static inline void writeRun(BitWriter& writer, quint32 run)
+{
+    const quint32 value = run + 1;
+    const int bits = 64 - countLeadingZeros(value);
+    writer.write(0, bits - 1);
+    writer.write(value, bits);
+}
+
+static inline bool readRun(BitReader& reader, quint32* run)
+{
+    const int zeros = reader.leadingZeros();
+
+    if (zeros > 31)
+        return false;
+
+    reader.skip(zeros);
+    *run = reader.read(zeros + 1) - 1;
+    return true;
+}
+
+// Median edge detector. The first row of a band is predicted from the left only
+template <class T>
+static inline int predict(const T* row, const T* up, int column)
+{
+    if (!up)
+        return column > 0 ? row[column-1] : 0;
+    else if (column == 0)
+        return up[0];
+
+    const int a = row[column-1];
+    const int b = up[column];
+    const int c = up[column-1];
+
+    if (c >= std::max(a, b))
+        return std::min(a, b);
+    else if (c <= std::min(a, b))
+        return std::max(a, b);
+
+    return a + b - c;
+}
+
+// Residual modulo the range of T, zigzagged so small values of both signs are small
+template <class T>
+static inline quint32 residual(int value, int prediction)
+{
+    typedef typename std::make_signed<T>::type Signed;
+    const qint32 difference = Signed(T(value - prediction));
+    return (quint32(difference) << 1 ^ quint32(difference >> 31)) & quint32(T(~T(0)));
+}
+
+template <class T>
+static inline T reconstruct(int prediction, quint32 residual)
+{
+    const qint32 difference = qint32(residual >> 1) ^ -qint32(residual & 1);
+    return T(prediction + difference);
+}
+
+template <class T>
+static void encodeBand(const uchar* data, size_t stride, int width, int height, std::vector<uchar>& output)
+{
+    const int bits = 8 * sizeof(T);
+    std::vector<T> residuals(size_t(width) * height);
+    size_t index = 0;
+
+    for (int i=0; i<height; ++i)
+    {
+        const T* row = (const T*) (data + i * stride);
+        const T* up = i > 0 ? (const T*) (data + (i - 1) * stride) : nullptr;
+
+        for (int j=0; j<width; ++j)
+            residuals[index++] = T(residual<T>(row[j], predict(row, up, j)));
+    }
+
+    output.clear();
+    output.reserve(residuals.size() * sizeof(T) / 2);
+    BitWriter writer(output);
+    RiceContext context;
+    const size_t count = residuals.size();
+
+    for (size_t n=0; n<count; ++n)
+    {
+        const quint32 value = residuals[n];
+        const int k = context.parameter();
+        writeRice(writer, value, k, bits);
+        context.update(value);
+
+        // Flat areas: a zero with k = 0 is followed by the number of zeros after it
+        if (k == 0 && value == 0) {
+            quint32 run = 0;
+            while (n + 1 + run < count && residuals[n + 1 + run] == 0)
+                run++;
+            writeRun(writer, run);
+            n += run;
+        }
+    }
+
+    writer.flush();
+}
+
+template <class T>
+static bool decodeBand(const uchar* input, qint64 size, uchar* data, size_t stride, int width, int height)
+{
+    const int bits = 8 * sizeof(T);
+    BitReader reader(input, size);
+    RiceContext context;
+    quint32 run = 0;
+    qint64 left = qint64(width) * height;
+
+    for (int i=0; i<height; ++i)
+    {
+        T* row = (T*) (data + i * stride);
+        const T* up = i > 0 ? (const T*) (data + (i - 1) * stride) : nullptr;
+
+        for (int j=0; j<width; ++j)
+        {
+            quint32 value = 0;
+            left--;
+
+            if (run > 0) {
+                run--;
+            }
+            else {
+                const int k = context.parameter();
+                value = readRice(reader, k, bits);
+                context.update(value);
+
+                if (k == 0 && value == 0 && (!readRun(reader, &run) || run > left))
+                    return false;
+            }
+
+            row[j] = reconstruct<T>(predict(row, up, j), value);
+        }
+    }
+
+    return !reader.overrun();
+}
+
+// Bands are taken by the threads one by one, which come from the shared pool
+template <class Function>
+static bool forEachBand(int count, int threads, Function function)
+{
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+
+    threads = std::max(1, std::min(threads, count));
+    std::atomic<int> nextBand(0);
+    std::atomic<bool> ok(true);
+
+    auto worker = [&]() {
+        int band;
+        while ((band = nextBand.fetch_add(1)) < count) {
+            if (!function(band))
+                ok = false;
+        }
+    };
+
+    runParallel(threads, worker);
+
+    return ok;
+}
+
+template <class T, DataFrame::FrameType frameType>
+static QByteArray encodeFrame(const GenericFrame<T, frameType>& frame, int threads)
+{
+    const int width = frame.width();
+    const int height = frame.height();
+    const int bands = (height + BAND_ROWS - 1) / BAND_ROWS;
+    std::vector<std::vector<uchar>> encoded(bands);
+
+    forEachBand(bands, threads, [&](int band) {
+        const int firstRow = band * BAND_ROWS;
+        encodeBand<T>((const uchar*) frame.getRowPtr(firstRow), frame.getStride(), width,
+                      std::min(BAND_ROWS, height - firstRow), encoded[band]);
+        return true;
+    });
+
+    CodecHeader header;
+    header.magic = CODEC_MAGIC;
+    header.version = CODEC_VERSION;
+    header.sampleSize = sizeof(T);
+    header.bandRows = BAND_ROWS;
+    header.width = width;
+    header.height = height;
+    header.offsetX = frame.offset()[0];
+    header.offsetY = frame.offset()[1];
+    header.bandCount = bands;
+
+    int size = sizeof(CodecHeader) + bands * sizeof(quint32);
+
+    for (const std::vector<uchar>& band : encoded)
+        size += int(band.size());
+
+    QByteArray result(size, Qt::Uninitialized);
+    char* pData = result.data();
+    memcpy(pData, &header, sizeof(header));
+    pData += sizeof(header);
+
+    for (const std::vector<uchar>& band : encoded) {
+        const quint32 bandSize = quint32(band.size());
+        memcpy(pData, &bandSize, sizeof(bandSize));
+        pData += sizeof(bandSize);
+    }
+
+    for (const std::vector<uchar>& band : encoded) {
+        if (!band.empty())
+            memcpy(pData, band.data(), band.size());
+        pData += band.size();
+    }
+
+    return result;
+}
+
+template <class T, DataFrame::FrameType frameType>
+static bool decodeFrame(const QByteArray& buffer, GenericFrame<T, frameType>& frame, int threads)
+{
+    CodecHeader header;
+
+    if (buffer.size() < int(sizeof(header)))
+        return false;
+
+    memcpy(&header, buffer.constData(), sizeof(header));
+
+    if (header.magic != CODEC_MAGIC || header.version != CODEC_VERSION || header.sampleSize != sizeof(T) ||
+            header.bandRows == 0 || header.width < 0 || header.height < 0 ||
+            qint64(header.width) * header.height > MAX_PIXELS)
+        return false;
+
+    const int bands = (header.height + header.bandRows - 1) / header.bandRows;
+
+    if (header.bandCount != quint32(bands) || qint64(sizeof(header)) + qint64(bands) * 4 > buffer.size())
+        return false;
+
+    // Start of each band in the buffer
+    const uchar* pSizes = (const uchar*) buffer.constData() + sizeof(header);
+    std::vector<qint64> offsets(bands + 1);
+    offsets[0] = sizeof(header) + bands * sizeof(quint32);
+
+    for (int i=0; i<bands; ++i) {
+        quint32 bandSize;
+        memcpy(&bandSize, pSizes + i * sizeof(quint32), sizeof(bandSize));
+        offsets[i+1] = offsets[i] + bandSize;
+    }
+
+    if (offsets[bands] != buffer.size())
+        return false;
+
+    frame.resize(header.width, header.height);
+    frame.setOffset(Point2i(header.offsetX, header.offsetY));
+
+    const uchar* pData = (const uchar*) buffer.constData();
+    const int bandRows = header.bandRows;
+
+    return forEachBand(bands, threads, [&](int band) {
+        const int firstRow = band * bandRows;
+        return decodeBand<T>(pData + offsets[band], offsets[band+1] - offsets[band],
+                             (uchar*) frame.getRowPtr(firstRow), frame.getStride(), header.width,
+                             std::min(bandRows, header.height - firstRow));
+    });
+}
+
+// Buffer of toBinary(): 16 bytes of header and the rows
+template <class T, DataFrame::FrameType frameType>
+static bool loadFrame(const QByteArray& buffer, GenericFrame<T, frameType>& frame, int threads)
+{
+    if (FrameCodec::isEncoded(buffer))
+        return decodeFrame(buffer, frame, threads);
+
+    if (buffer.size() < 16)
+        return false;
+
+    const qint32* pHeader = (const qint32*) buffer.constData();
+    const qint64 width = pHeader[0];
+    const qint64 height = pHeader[1];
+
+    if (width < 0 || height < 0 || buffer.size() != 16 + width * height * qint64(sizeof(T)))
+        return false;
+
+    frame.loadData(buffer);
+    return true;
+}
+
+QByteArray FrameCodec::encode(const DepthFrame& frame, int threads)
+{
+    return encodeFrame(frame, threads);
+}
+
+QByteArray FrameCodec::encode(const MaskFrame& frame, int threads)
+{
+    return encodeFrame(frame, threads);
+}
+
+bool FrameCodec::decode(const QByteArray& buffer, DepthFrame& frame, int threads)
+{
+    return decodeFrame(buffer, frame, threads);
+}
+
+bool FrameCodec::decode(const QByteArray& buffer, MaskFrame& frame, int threads)
+{
+    return decodeFrame(buffer, frame, threads);
+}
+
+bool FrameCodec::load(const QByteArray& buffer, DepthFrame& frame, int threads)
+{
+    return loadFrame(buffer, frame, threads);
+}
+
+bool FrameCodec::load(const QByteArray& buffer, MaskFrame& frame, int threads)
+{
+    return loadFrame(buffer, frame, threads);
+}
+
+bool FrameCodec::isEncoded(const QByteArray& buffer)
+{
+    quint32 magic;
+
+    if (buffer.size() < int(sizeof(CodecHeader)))
+        return false;
+
+    memcpy(&magic, buffer.constData(), sizeof(magic));
+    return magic == CODEC_MAGIC;
+}
+
+} // End Namespace
@@ -0,0 +1,47 @@
+#ifndef FRAMECODEC_H
+#define FRAMECODEC_H
+
+#include "types/DepthFrame.h"
+#include "types/MaskFrame.h"
+#include <QByteArray>
+
+namespace dai {
+
+/**
+ * Lossless codec of depth frames and masks, used instead of toBinary() to save disk and
+ * I/O. Every pixel is predicted from its left, upper and upper-left neighbours (median
+ * edge detector, as in LOCO-I) and the residuals are written with an adaptive Rice code.
+ * Runs of zero residuals (holes of the depth, background of the masks) take a few bits.
+ *
+ * Frames are split in bands of rows that are coded independently, so they are encoded and
+ * decoded in parallel and the result doesn't depend on the number of threads. threads is
+ * the number of threads used (0 uses every core); use 1 when frames are already processed
+ * in parallel. Encoded buffers keep the size and offset of the frame, like toBinary().
+ *
+ * @brief The FrameCodec class
+ */
+class FrameCodec
+{
+public:
+    static QByteArray encode(const DepthFrame& frame, int threads = 0);
+    static QByteArray encode(const MaskFrame& frame, int threads = 0);
+
+    /**
+     * Returns false if buffer isn't a valid encoded frame of the same type
+     */
+    static bool decode(const QByteArray& buffer, DepthFrame& frame, int threads = 0);
+    static bool decode(const QByteArray& buffer, MaskFrame& frame, int threads = 0);
+
+    /**
+     * Load a buffer written by encode() or by toBinary(), so dataset readers accept both.
+     * Readers already run in parallel, so one thread is used by default.
+     */
+    static bool load(const QByteArray& buffer, DepthFrame& frame, int threads = 1);
+    static bool load(const QByteArray& buffer, MaskFrame& frame, int threads = 1);
+
+    static bool isEncoded(const QByteArray& buffer);
+};
+
+} // End Namespace
+
+#endif // FRAMECODEC_H
@@ -4,8 +4,10 @@
 #include "DataFrame.h"
 #include "types/Point.h"
 #include "types/BoundingBox.h"
+#include "types/MemoryTracker.h"
 #include <QByteArray>
 #include <stdint.h>
+#include <utility>
 
 namespace dai {
 
@@ -18,6 +20,9 @@ class GenericFrame : public DataFrame
     int m_height;
     bool m_managedData;
     Point2i m_offset;
+    shared_ptr<void> m_owner; // Keeps external data alive (views)
+    int m_memoryOwner;        // Owner charged with m_data (see MemoryTracker)
+    qint64 m_memoryBytes;
 
 public:    
     // Constructor, Destructors and Copy Constructor
@@ -31,11 +36,21 @@ public:
     GenericFrame(int width, int height, T* pData, uint stride = 0);
     virtual ~GenericFrame();
     GenericFrame(const GenericFrame& other);
+    GenericFrame(GenericFrame&& other);
     GenericFrame& operator=(const GenericFrame& other);
+    GenericFrame& operator=(GenericFrame&& other);
     virtual shared_ptr<DataFrame> clone() const override;
 
     void setDataPtr(int width, int height, const T* pData, uint stride);
     void setDataPtr(int width, int height, const T* pData);
+
+    /**
+     * Use pData as a view of a buffer that belongs to owner (i.e. a frame of a driver).
+     * The frame, and every sub frame of it, keeps a reference to owner so the buffer
+     * stays valid while the frame is being processed. Assigning to the frame allocates
+     * its own memory instead of writing into the buffer.
+     */
+    void setDataPtr(int width, int height, const T* pData, uint stride, shared_ptr<void> owner);
     void setItem(int row, int column, T value);
     void setOffset(const Point2i& offset) {m_offset = offset;}
 
@@ -51,6 +66,12 @@ public:
     QByteArray toBinary() const;
     void loadData(const QByteArray& buffer);
 
+    /**
+     * Make room for a frame of the given size. Memory is reused when the size is the same,
+     * except for buffers of other owners, which are never written. Pixels aren't kept.
+     */
+    void resize(int width, int height);
+
     /**
      * Return the number of bytes that of each row line.
      */
@@ -59,14 +80,81 @@ public:
     T* getRowPtr(int row) const;
     const T* getDataPtr() const;
 
+    /**
+     * Unchecked access to a pixel (only asserted in debug builds). Use it in loops
+     * where the coordinates are already known to be valid instead of getItem/setItem.
+     */
+    T& at(int row, int column) const {
+        Q_ASSERT(row >= 0 && row < m_height && column >= 0 && column < m_width);
+        return getRowPtr(row)[column];
+    }
+
+    /**
+     * Pixels of a row, so they can be visited with a range-based for loop.
+     */
+    class Row
+    {
+    public:
+        Row(T* begin, int size) : m_begin(begin), m_end(begin + size) {}
+        T* begin() const {return m_begin;}
+        T* end() const {return m_end;}
+        int size() const {return int(m_end - m_begin);}
+        T& operator[](int column) const {return m_begin[column];}
+    private:
+        T* m_begin;
+        T* m_end;
+    };
+
+    /**
+     * Walks the rows of the frame taking the stride into account, i.e.
+     * for (auto row : frame.rows()) for (T& pixel : row) ...
+     */
+    class RowIterator
+    {
+    public:
+        RowIterator(uchar* ptr, uint stride, int width) : m_ptr(ptr), m_stride(stride), m_width(width) {}
+        Row operator*() const {return Row((T*) m_ptr, m_width);}
+        RowIterator& operator++() {m_ptr += m_stride; return *this;}
+        bool operator!=(const RowIterator& other) const {return m_ptr != other.m_ptr;}
+    private:
+        uchar* m_ptr;
+        uint m_stride;
+        int m_width;
+    };
+
+    class Rows
+    {
+    public:
+        Rows(RowIterator begin, RowIterator end) : m_begin(begin), m_end(end) {}
+        RowIterator begin() const {return m_begin;}
+        RowIterator end() const {return m_end;}
+    private:
+        RowIterator m_begin;
+        RowIterator m_end;
+    };
+
+    Row row(int row) const {return Row(getRowPtr(row), m_width);}
+
+    Rows rows() const {
+        return Rows(RowIterator((uchar*) m_data, m_stride, m_width),
+                    RowIterator((uchar*) getRowPtr(m_height), m_stride, m_width));
+    }
+
+    bool isContinuous() const {return m_stride == m_width * sizeof(T);}
+
 private:
     void setDataPtr(const T* pData);
+    void copyRows(const GenericFrame& other);
+    void allocate(int width, int height);
+    void release();
 };
 
 template <class T, DataFrame::FrameType frameType>
 GenericFrame<T, frameType>::GenericFrame()
     : DataFrame(frameType)
     , m_managedData(false)
+    , m_memoryOwner(0)
+    , m_memoryBytes(0)
 {
     this->m_data = nullptr;
     this->m_stride = 0;
@@ -78,13 +166,14 @@ template <class T, DataFrame::FrameType frameType>
 GenericFrame<T, frameType>::GenericFrame(int width, int height)
     : DataFrame(frameType)
     , m_managedData(true)
+    , m_memoryOwner(0)
+    , m_memoryBytes(0)
 {
     this->m_width = width;
     this->m_height = height;
 
     if (width > 0 && height > 0) {
-        this->m_data = new T[width * height];
-        this->m_stride = width * sizeof(T);
+        allocate(width, height);
         memset(this->m_data, 0, width*height*sizeof(T));
     } else {
         this->m_data = nullptr;
@@ -96,6 +185,8 @@ template <class T, DataFrame::FrameType frameType>
 GenericFrame<T, frameType>::GenericFrame(int width, int height, T* pData, uint stride)
     : DataFrame(frameType)
     , m_managedData(false)
+    , m_memoryOwner(0)
+    , m_memoryBytes(0)
 {
     this->m_width = width;
     this->m_height = height;
@@ -110,116 +201,186 @@ GenericFrame<T, frameType>::GenericFrame(int width, int height, T* pData, uint s
 template <class T, DataFrame::FrameType frameType>
 GenericFrame<T, frameType>::GenericFrame(const GenericFrame &other)
     : DataFrame(other)
+    , m_memoryOwner(0)
+    , m_memoryBytes(0)
 {
-    m_width = other.m_width;
-    m_height = other.m_height;
-    m_data = new T[m_width * m_height];
+    allocate(other.m_width, other.m_height);
+    this->m_offset = other.m_offset;
+    copyRows(other);
+}
 
-    // No padding
-    if (other.m_stride == other.m_width * sizeof(T)) {
-        m_stride = other.m_stride;
-        memcpy(m_data, other.m_data, m_stride * m_height);
-    }
-    // Padding, so I have to read each row
-    else {
-        m_stride = m_width * sizeof(T);
-        for (int i=0; i<other.height(); ++i) {
-            T* src = other.getRowPtr(i);
-            T* dst = this->getRowPtr(i);
+template <class T, DataFrame::FrameType frameType>
+GenericFrame<T, frameType>::GenericFrame(GenericFrame&& other)
+    : DataFrame(other)
+    , m_data(other.m_data)
+    , m_stride(other.m_stride)
+    , m_width(other.m_width)
+    , m_height(other.m_height)
+    , m_managedData(other.m_managedData)
+    , m_offset(other.m_offset)
+    , m_owner(std::move(other.m_owner))
+    , m_memoryOwner(other.m_memoryOwner)
+    , m_memoryBytes(other.m_memoryBytes)
+{
+    other.m_data = nullptr;
+    other.m_stride = 0;
+    other.m_width = 0;
+    other.m_height = 0;
+    other.m_managedData = false;
+    other.m_memoryBytes = 0;
+}
 
-            for (int j=0; j<other.width(); ++j)
-                dst[j] = src[j]; // Copy    // FIX: I could copy row by row
-        }
-    }
+template <class T, DataFrame::FrameType frameType>
+GenericFrame<T, frameType>& GenericFrame<T, frameType>::operator=(const GenericFrame<T,frameType>& other)
+{
+    if (this == &other)
+        return *this;
 
-    this->m_managedData = true;
+    DataFrame::operator=(other);
+    resize(other.m_width, other.m_height);
+
+    // The stride of reused memory is kept, it may be a view of a bigger buffer
+    copyRows(other);
     this->m_offset = other.m_offset;
+    return *this;
 }
 
 template <class T, DataFrame::FrameType frameType>
-GenericFrame<T, frameType>& GenericFrame<T, frameType>::operator=(const GenericFrame<T,frameType>& other)
+GenericFrame<T, frameType>& GenericFrame<T, frameType>::operator=(GenericFrame<T,frameType>&& other)
 {
+    if (this == &other)
+        return *this;
+
     DataFrame::operator=(other);
+    release();
 
-    // If want to reuse m_data memory. So, if size isn't correct to store new frame
-    // I need to create another one.
-    if (!this->m_data || this->m_width != other.m_width || this->m_height != other.m_height)
-    {
-        this->m_width = other.m_width;
-        this->m_height = other.m_height;
+    m_data = other.m_data;
+    m_stride = other.m_stride;
+    m_width = other.m_width;
+    m_height = other.m_height;
+    m_managedData = other.m_managedData;
+    m_offset = other.m_offset;
+    m_owner = std::move(other.m_owner);
+    m_memoryOwner = other.m_memoryOwner;
+    m_memoryBytes = other.m_memoryBytes;
+
+    other.m_data = nullptr;
+    other.m_stride = 0;
+    other.m_width = 0;
+    other.m_height = 0;
+    other.m_managedData = false;
+    other.m_memoryBytes = 0;
+    return *this;
+}
 
-        if (this->m_data) {
-            delete [] this->m_data;
-        }
+/**
+ * Copy the pixels of other (same size) into this frame. A single memcpy when neither
+ * frame has padding, one memcpy per row otherwise.
+ */
+template <class T, DataFrame::FrameType frameType>
+void GenericFrame<T, frameType>::copyRows(const GenericFrame& other)
+{
+    Q_ASSERT(m_width == other.m_width && m_height == other.m_height);
 
-        this->m_data = new T[this->m_width * this->m_height];
-        this->m_managedData = true;
-    }
+    if (m_data == nullptr || other.m_data == nullptr)
+        return;
 
-    // No padding
-    if (other.m_stride == other.m_width * sizeof(T)) {
-        m_stride = other.m_stride;
+    if (isContinuous() && other.isContinuous()) {
         memcpy(m_data, other.m_data, m_stride * m_height);
     }
-    // Padding, so I have to read each row
     else {
-        m_stride = m_width * sizeof(T);
-        for (int i=0; i<other.height(); ++i) {
-            T* src = other.getRowPtr(i);
-            T* dst = getRowPtr(i);
+        const size_t rowSize = m_width * sizeof(T);
 
-            for (int j=0; j<other.width(); ++j)
-                dst[j] = src[j]; // Copy    // FIX: I could copy row by row
+        for (int i=0; i<m_height; ++i) {
+            memcpy(getRowPtr(i), other.getRowPtr(i), rowSize);
         }
     }
+}
 
-    this->m_offset = other.m_offset;
-    return *this;
+template <class T, DataFrame::FrameType frameType>
+void GenericFrame<T, frameType>::resize(int width, int height)
+{
+    // If want to reuse m_data memory. So, if size isn't correct to store new frame
+    // I need to create another one. Buffers of other owners are never written.
+    if (!this->m_data || this->m_width != width || this->m_height != height || this->m_owner)
+    {
+        release();
+        allocate(width, height);
+    }
 }
 
+/**
+ * New memory for the pixels, charged to the current owner of the thread
+ */
 template <class T, DataFrame::FrameType frameType>
-shared_ptr<DataFrame> GenericFrame<T, frameType>::clone() const
+void GenericFrame<T, frameType>::allocate(int width, int height)
 {
-    return shared_ptr<GenericFrame<T, frameType>>(new GenericFrame<T, frameType>(*this));
+    this->m_width = width;
+    this->m_height = height;
+    this->m_stride = width * sizeof(T);
+    this->m_data = new T[width * height];
+    this->m_managedData = true;
+    this->m_memoryBytes = qint64(width) * height * sizeof(T);
+    this->m_memoryOwner = MemoryTracker::frameAllocated(frameType, m_memoryBytes);
 }
 
 template <class T, DataFrame::FrameType frameType>
-GenericFrame<T, frameType>::~GenericFrame()
+void GenericFrame<T, frameType>::release()
 {
     if (m_managedData && m_data != nullptr) {
         delete[] this->m_data;
-        this->m_data = nullptr;
+        MemoryTracker::frameReleased(m_memoryOwner, frameType, m_memoryBytes);
     }
+
+    this->m_memoryBytes = 0;
+
+    this->m_data = nullptr;
+    this->m_managedData = false;
+    this->m_owner.reset();
+}
+
+template <class T, DataFrame::FrameType frameType>
+shared_ptr<DataFrame> GenericFrame<T, frameType>::clone() const
+{
+    return shared_ptr<GenericFrame<T, frameType>>(new GenericFrame<T, frameType>(*this));
+}
+
+template <class T, DataFrame::FrameType frameType>
+GenericFrame<T, frameType>::~GenericFrame()
+{
+    release();
 }
 
 template <class T, DataFrame::FrameType frameType>
 void GenericFrame<T, frameType>::setDataPtr(int width, int height, const T *pData, uint stride)
 {
+    setDataPtr(pData);
     this->m_width = width;
     this->m_height = height;
     this->m_stride = stride;
-    setDataPtr(pData);
 }
 
 template <class T, DataFrame::FrameType frameType>
 void GenericFrame<T, frameType>::setDataPtr(int width, int height, const T *pData)
 {
+    setDataPtr(pData);
     this->m_width = width;
     this->m_height = height;
     this->m_stride = width*sizeof(T);
-    setDataPtr(pData);
 }
 
 template <class T, DataFrame::FrameType frameType>
-inline void GenericFrame<T, frameType>::setDataPtr(const T* pData)
+void GenericFrame<T, frameType>::setDataPtr(int width, int height, const T *pData, uint stride, shared_ptr<void> owner)
 {
-    if (m_managedData && m_data != nullptr) {
-        delete[] this->m_data;
-        this->m_data = nullptr;
-    }
+    setDataPtr(width, height, pData, stride);
+    this->m_owner = owner;
+}
 
+template <class T, DataFrame::FrameType frameType>
+inline void GenericFrame<T, frameType>::setDataPtr(const T* pData)
+{
+    release();
     this->m_data = const_cast<T*>(pData);
-    this->m_managedData = false;
 }
 
 template <class T, DataFrame::FrameType frameType>
@@ -236,6 +397,7 @@ shared_ptr<GenericFrame<T,frameType>> GenericFrame<T,frameType>::subFrame(int ro
     result->m_type = m_type;
     result->m_offset[0] = column;
     result->m_offset[1] = row;
+    result->m_owner = m_owner;
     return result;
 }
 
@@ -290,15 +452,15 @@ QByteArray GenericFrame<T, frameType>::toBinary() const
 
     // Body
     pData = (uchar*) pHeader;
-    T* output = (T*) pData;
+    const size_t rowSize = m_width * sizeof(T);
 
-    for (int i=0; i<m_height; ++i)
-    {
-        T* pixel = this->getRowPtr(i);
-
-        for (int j=0; j<m_width; ++j)
-        {
-            *output++ = pixel[j]; // copy
+    if (isContinuous()) {
+        memcpy(pData, m_data, rowSize * m_height);
+    }
+    else {
+        for (int i=0; i<m_height; ++i) {
+            memcpy(pData, getRowPtr(i), rowSize);
+            pData += rowSize;
         }
     }
 
@@ -320,23 +482,11 @@ void GenericFrame<T, frameType>::loadData(const QByteArray& buffer)
     // Body
     pData = (uchar*) pHeader;
 
-    // If want to reuse m_data memory. So, if size isn't correct to store new frame
-    // I need to create another one.
-    if (!this->m_data || this->m_width != width || this->m_height != height)
-    {
-        this->m_width = width;
-        this->m_height = height;
-
-        if (this->m_data) {
-            delete [] this->m_data;
-        }
-
-        this->m_data = new T[m_width * m_height];
-        this->m_managedData = true;
-    }
+    resize(width, height);
 
-    memcpy(this->m_data, pData, m_width * m_height * sizeof(T));
-    this->m_stride = m_width * sizeof(T);
+    // The stride of reused memory is kept
+    const GenericFrame input(width, height, (T*) pData);
+    copyRows(input);
 }
 
 } // End Namespace
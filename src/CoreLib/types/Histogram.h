@@ -404,6 +404,37 @@ public:
     }
 
 
+    /**
+     * Create a one channel histogram from dense bin counts (bin i counts the pixels with value i),
+     * as computed by the fused kernels of opencv_utils. Empty bins are not added.
+     */
+    const static std::shared_ptr<Histogram<T,N> > createFromBins(const int* counts, int numBins, std::vector<int> ranges)
+    {
+        Q_ASSERT(N == 1);
+
+        std::shared_ptr<Histogram<T,N>> result = std::make_shared<Histogram<T,N>>();
+
+        for (int i=0; i<numBins; ++i)
+        {
+            if (counts[i] == 0)
+                continue;
+
+            cv::Vec<T,N> point;
+            point[0] = T(i);
+            uint hash = hashItem<T,N>(point);
+            HistBin<T,N>& item = result->m_matrix[hash];
+            item.point[0] = T(i);
+            item.key = hash;
+            item.value = counts[i];
+            result->m_accumulated_freq += counts[i];
+        }
+
+        result->computeStats();
+        result->m_min_range = ranges[0];
+        result->m_max_range = ranges[1];
+        return result;
+    }
+
     /**
      * Compute the distance as the average distance element by element.
      */
@@ -0,0 +1,349 @@
+#include "MemoryTracker.h"
+#include <QThread>
+#include <QThreadStorage>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+#include <QDebug>
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+namespace dai {
+
+static const int TYPE_COUNT = 4;                // Colour, depth, mask and other
+static const qint64 WARNING_INTERVAL = 5000;    // ms between reports of the same budget
+static const int RESUME_PERCENT = 90;           // Of the budget, to deliver dropped frames again
+
+struct OwnerCounters {
+    atomic<qint64> bytes[TYPE_COUNT];
+    atomic<qint64> peak;
+    atomic<qint64> budget;
+    atomic<int> policy;
+    atomic<qint64> lastWarning;
+};
+
+// Static storage, so counters start at zero
+static OwnerCounters g_owners[MemoryTracker::MAX_OWNERS];
+static OwnerCounters g_total;
+
+static QMutex g_registryLock;
+static QString g_names[MemoryTracker::MAX_OWNERS] = {"Other"};
+static MemoryTracker::OwnerKind g_kinds[MemoryTracker::MAX_OWNERS];
+static atomic<int> g_ownerCount(1);
+
+static QThreadStorage<int> g_currentOwner;
+
+static inline int typeIndex(DataFrame::FrameType type)
+{
+    switch (type) {
+    case DataFrame::Color: return 0;
+    case DataFrame::Depth: return 1;
+    case DataFrame::Mask:  return 2;
+    default:               return 3;
+    }
+}
+
+static inline qint64 sumOf(const OwnerCounters& counters)
+{
+    qint64 result = 0;
+    for (int i=0; i<TYPE_COUNT; ++i)
+        result += counters.bytes[i].load(memory_order_relaxed);
+    return result;
+}
+
+static inline void updatePeak(atomic<qint64>& peak, qint64 value)
+{
+    qint64 current = peak.load(memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, memory_order_relaxed)) {}
+}
+
+static qint64 nowMs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static QString megabytes(qint64 bytes)
+{
+    return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+static QString ownerName(int owner)
+{
+    QMutexLocker locker(&g_registryLock);
+    return g_names[owner];
+}
+
+// owner is -1 for the total
+static void checkBudget(OwnerCounters& counters, qint64 used, int owner)
+{
+    const qint64 budget = counters.budget.load(memory_order_relaxed);
+
+    if (budget <= 0 || used <= budget)
+        return;
+
+    const qint64 now = nowMs();
+    qint64 last = counters.lastWarning.load(memory_order_relaxed);
+
+    if (now - last < WARNING_INTERVAL && last != 0)
+        return;
+
+    if (!counters.lastWarning.compare_exchange_strong(last, now, memory_order_relaxed))
+        return; // Other thread reports it
+
+    const QString name = owner >= 0 ? ownerName(owner) : QString("total");
+    qWarning() << "MemoryTracker:" << name << "uses" << megabytes(used)
+               << "of a budget of" << megabytes(budget)
+               << (counters.policy.load() == MemoryTracker::BUDGET_DROP ? "(dropping frames)" : "");
+}
+
+static void account(int owner, int index, qint64 bytes)
+{
+    if (owner < 0 || owner >= MemoryTracker::MAX_OWNERS)
+        owner = 0;
+
+    OwnerCounters& counters = g_owners[owner];
+    counters.bytes[index].fetch_add(bytes, memory_order_relaxed);
+    const qint64 used = sumOf(counters);
+
+    g_total.bytes[index].fetch_add(bytes, memory_order_relaxed);
+    const qint64 total = sumOf(g_total);
+
+    if (bytes > 0) {
+        updatePeak(counters.peak, used);
+        updatePeak(g_total.peak, total);
+        checkBudget(counters, used, owner);
+        checkBudget(g_total, total, -1);
+    }
+}
+
+int MemoryTracker::registerOwner(const QString& name, OwnerKind kind)
+{
+    QMutexLocker locker(&g_registryLock);
+    const int count = g_ownerCount.load();
+
+    for (int i=0; i<count; ++i) {
+        if (g_names[i] == name) {
+            if (g_kinds[i] == OWNER_OTHER)
+                g_kinds[i] = kind;
+            return i;
+        }
+    }
+
+    if (count == MAX_OWNERS) {
+        qDebug() << "MemoryTracker: too many owners," << name << "is charged to" << g_names[0];
+        return 0;
+    }
+
+    g_names[count] = name;
+    g_kinds[count] = kind;
+    g_ownerCount.store(count + 1);
+    return count;
+}
+
+int MemoryTracker::currentOwner()
+{
+    return g_currentOwner.hasLocalData() ? g_currentOwner.localData() : 0;
+}
+
+void MemoryTracker::setCurrentOwner(int owner)
+{
+    g_currentOwner.setLocalData(owner);
+}
+
+int MemoryTracker::frameAllocated(DataFrame::FrameType type, qint64 bytes)
+{
+    const int owner = currentOwner();
+    account(owner, typeIndex(type), bytes);
+    return owner;
+}
+
+void MemoryTracker::frameReleased(int owner, DataFrame::FrameType type, qint64 bytes)
+{
+    account(owner, typeIndex(type), -bytes);
+}
+
+void MemoryTracker::charge(int owner, qint64 bytes)
+{
+    account(owner, TYPE_COUNT - 1, bytes);
+}
+
+void MemoryTracker::setBudget(const QString& name, qint64 bytes, BudgetPolicy policy)
+{
+    OwnerCounters& counters = name.isEmpty() ? g_total : g_owners[registerOwner(name, OWNER_OTHER)];
+    counters.policy.store(policy);
+    counters.budget.store(qMax<qint64>(bytes, 0));
+    counters.lastWarning.store(0);
+}
+
+bool MemoryTracker::shouldDrop(int owner)
+{
+    if (owner < 0 || owner >= MAX_OWNERS)
+        owner = 0;
+
+    for (const OwnerCounters* counters : {&g_owners[owner], &g_total})
+    {
+        const qint64 budget = counters->budget.load(memory_order_relaxed);
+
+        if (budget > 0 && counters->policy.load(memory_order_relaxed) == BUDGET_DROP &&
+                sumOf(*counters) > budget)
+            return true;
+    }
+
+    return false;
+}
+
+bool MemoryTracker::canResume(int owner)
+{
+    if (owner < 0 || owner >= MAX_OWNERS)
+        owner = 0;
+
+    for (const OwnerCounters* counters : {&g_owners[owner], &g_total})
+    {
+        const qint64 budget = counters->budget.load(memory_order_relaxed);
+
+        if (budget > 0 && counters->policy.load(memory_order_relaxed) == BUDGET_DROP &&
+                sumOf(*counters) > budget * RESUME_PERCENT / 100)
+            return false;
+    }
+
+    return true;
+}
+
+qint64 MemoryTracker::bytes()
+{
+    return sumOf(g_total);
+}
+
+qint64 MemoryTracker::bytes(DataFrame::FrameType type)
+{
+    return g_total.bytes[typeIndex(type)].load(memory_order_relaxed);
+}
+
+qint64 MemoryTracker::peakBytes()
+{
+    return g_total.peak.load(memory_order_relaxed);
+}
+
+QList<MemoryTracker::OwnerUsage> MemoryTracker::owners()
+{
+    QMutexLocker locker(&g_registryLock);
+    QList<OwnerUsage> result;
+    const int count = g_ownerCount.load();
+
+    for (int i=0; i<count; ++i) {
+        const OwnerCounters& counters = g_owners[i];
+        OwnerUsage usage;
+        usage.name = g_names[i];
+        usage.kind = g_kinds[i];
+        usage.color = counters.bytes[0].load(memory_order_relaxed);
+        usage.depth = counters.bytes[1].load(memory_order_relaxed);
+        usage.mask = counters.bytes[2].load(memory_order_relaxed);
+        usage.other = counters.bytes[3].load(memory_order_relaxed);
+        usage.peak = counters.peak.load(memory_order_relaxed);
+        usage.budget = counters.budget.load(memory_order_relaxed);
+        result << usage;
+    }
+
+    return result;
+}
+
+QString MemoryTracker::report()
+{
+    static const char* kindNames[] = {"other", "generator", "listener", "cache", "features"};
+
+    QStringList lines;
+    lines << QString("Memory: %1 (peak %2) colour %3, depth %4, mask %5")
+             .arg(megabytes(bytes()), megabytes(peakBytes()),
+                  megabytes(bytes(DataFrame::Color)), megabytes(bytes(DataFrame::Depth)),
+                  megabytes(bytes(DataFrame::Mask)));
+
+    const qint64 totalBudget = g_total.budget.load(memory_order_relaxed);
+
+    if (totalBudget > 0)
+        lines.last() += QString(", budget %1").arg(megabytes(totalBudget));
+
+    for (const OwnerUsage& usage : owners())
+    {
+        if (usage.total() == 0 && usage.peak == 0)
+            continue;
+
+        QString line = QString("  %1 (%2): %3 (peak %4)")
+                .arg(usage.name, QString(kindNames[usage.kind]), megabytes(usage.total()), megabytes(usage.peak));
+
+        if (usage.budget > 0)
+            line += QString(", budget %1").arg(megabytes(usage.budget));
+
+        lines << line;
+    }
+
+    return lines.join('\n');
+}
+
+/**
+ * Writes the report to the log periodically
+ */
+class MemoryReporter : public QThread
+{
+public:
+    explicit MemoryReporter(int seconds)
+        : m_seconds(seconds)
+        , m_running(true)
+    {
+        setObjectName("MemoryReporter");
+    }
+
+    void stop() {
+        m_lock.lock();
+        m_running = false;
+        m_sync.wakeOne();
+        m_lock.unlock();
+        wait();
+    }
+
+protected:
+    void run() override {
+        QMutexLocker locker(&m_lock);
+        while (m_running) {
+            m_sync.wait(&m_lock, m_seconds * 1000);
+            if (m_running)
+                qDebug().noquote() << MemoryTracker::report();
+        }
+    }
+
+private:
+    const int m_seconds;
+    bool m_running;
+    QMutex m_lock;
+    QWaitCondition m_sync;
+};
+
+static QMutex g_reporterLock;
+static MemoryReporter* g_reporter = nullptr;
+
+void MemoryTracker::startReports(int seconds)
+{
+    stopReports();
+
+    if (seconds <= 0)
+        return;
+
+    QMutexLocker locker(&g_reporterLock);
+    g_reporter = new MemoryReporter(seconds);
+    g_reporter->start(QThread::LowPriority);
+}
+
+void MemoryTracker::stopReports()
+{
+    QMutexLocker locker(&g_reporterLock);
+
+    if (g_reporter) {
+        g_reporter->stop();
+        delete g_reporter;
+        g_reporter = nullptr;
+    }
+}
+
+} // End Namespace
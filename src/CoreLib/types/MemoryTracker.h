@@ -0,0 +1,180 @@
+#ifndef MEMORYTRACKER_H
+#define MEMORYTRACKER_H
+
+#include "types/DataFrame.h"
+#include <QString>
+#include <QList>
+#include <QtGlobal>
+
+namespace dai {
+
+/**
+ * Accounting of the memory held by frames and by other big structures (caches, features).
+ * Memory is charged to an owner: frames are charged to the owner of the thread that
+ * allocates their pixels, which FrameGenerator and FrameNotifier set to the generator or
+ * listener being run (see MemoryScope); other memory is charged explicitly (see
+ * MemoryCharge). Owners are registered by name, so every instance of a component adds to
+ * the same owner. Owner 0 ("Other") gets everything else.
+ *
+ * Owners, and the total, may have a budget. An exceeded budget is reported (at most once
+ * every few seconds) and, with BUDGET_DROP, FrameNotifier drops the notifications of the
+ * listeners over budget, like it does with a busy listener, and asks them to release the
+ * memory they keep (FrameListener::releaseMemory). Frames are delivered again when usage
+ * goes down, or when dropping doesn't release anything.
+ *
+ * Counters are atomic, so accounting doesn't take any lock.
+ *
+ * @brief The MemoryTracker class
+ */
+class MemoryTracker
+{
+public:
+    enum OwnerKind {
+        OWNER_OTHER,
+        OWNER_GENERATOR,
+        OWNER_LISTENER,
+        OWNER_CACHE,
+        OWNER_FEATURES
+    };
+
+    enum BudgetPolicy {
+        BUDGET_WARN,    // Only report it
+        BUDGET_DROP     // Drop frames for the listeners over budget
+    };
+
+    struct OwnerUsage {
+        QString name;
+        OwnerKind kind;
+        qint64 color;   // Bytes of colour frames
+        qint64 depth;
+        qint64 mask;
+        qint64 other;   // Other frames and explicit charges
+        qint64 peak;
+        qint64 budget;  // 0 if none
+        qint64 total() const {return color + depth + mask + other;}
+    };
+
+    static const int MAX_OWNERS = 64;
+
+    /**
+     * Returns the id of the owner with the given name, registering it the first time.
+     * Returns 0 (Other) when there isn't room for more owners.
+     */
+    static int registerOwner(const QString& name, OwnerKind kind);
+
+    /**
+     * Owner charged with the frames allocated by the calling thread (0 by default)
+     */
+    static int currentOwner();
+    static void setCurrentOwner(int owner);
+
+    /**
+     * Called by GenericFrame. frameAllocated returns the owner charged.
+     */
+    static int frameAllocated(DataFrame::FrameType type, qint64 bytes);
+    static void frameReleased(int owner, DataFrame::FrameType type, qint64 bytes);
+
+    /**
+     * Memory that isn't a frame (bytes may be negative to release it)
+     */
+    static void charge(int owner, qint64 bytes);
+
+    /**
+     * Budget of the owner with the given name, or of the total if name is empty.
+     * bytes = 0 removes it.
+     */
+    static void setBudget(const QString& name, qint64 bytes, BudgetPolicy policy = BUDGET_WARN);
+
+    /**
+     * True if owner, or the total, is over a budget with BUDGET_DROP
+     */
+    static bool shouldDrop(int owner);
+
+    /**
+     * True if owner, and the total, are under the resume level (90%) of their budgets with
+     * BUDGET_DROP, so frames dropped by shouldDrop can be delivered again
+     */
+    static bool canResume(int owner);
+
+    static qint64 bytes();
+    static qint64 bytes(DataFrame::FrameType type);
+    static qint64 peakBytes();
+    static QList<OwnerUsage> owners();
+
+    /**
+     * Summary of the memory in use, one line per owner with memory
+     */
+    static QString report();
+
+    /**
+     * Write report() to the log every given seconds (from a thread of its own).
+     * stopReports() must be called before the application ends.
+     */
+    static void startReports(int seconds);
+    static void stopReports();
+};
+
+/**
+ * Charges the frames allocated by the calling thread to owner while it exists
+ *
+ * @brief The MemoryScope class
+ */
+class MemoryScope
+{
+public:
+    explicit MemoryScope(int owner)
+        : m_previous(MemoryTracker::currentOwner())
+    {
+        MemoryTracker::setCurrentOwner(owner);
+    }
+
+    ~MemoryScope() {
+        MemoryTracker::setCurrentOwner(m_previous);
+    }
+
+private:
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+    int m_previous;
+};
+
+/**
+ * Memory of an object charged to an owner, released when the object is destroyed. Copies
+ * are charged the same memory, so it can be a member of a copyable class.
+ *
+ * @brief The MemoryCharge class
+ */
+class MemoryCharge
+{
+public:
+    explicit MemoryCharge(int owner = 0) : m_owner(owner), m_bytes(0) {}
+    MemoryCharge(const MemoryCharge& other) : m_owner(other.m_owner), m_bytes(0) {set(other.m_bytes);}
+    ~MemoryCharge() {set(0);}
+
+    MemoryCharge& operator=(const MemoryCharge& other) {
+        if (this != &other) {
+            set(0);
+            m_owner = other.m_owner;
+            set(other.m_bytes);
+        }
+        return *this;
+    }
+
+    void set(qint64 bytes) {
+        if (bytes != m_bytes) {
+            MemoryTracker::charge(m_owner, bytes - m_bytes);
+            m_bytes = bytes;
+        }
+    }
+
+    void add(qint64 bytes) {set(m_bytes + bytes);}
+    qint64 bytes() const {return m_bytes;}
+
+private:
+    int m_owner;
+    qint64 m_bytes;
+};
+
+} // End Namespace
+
+#endif // MEMORYTRACKER_H
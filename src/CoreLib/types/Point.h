@@ -128,16 +128,8 @@ public:
         memcpy(m_data, data, N * sizeof(T));
     }
 
-    Point(const Point& other)
-    {
-        memcpy(m_data, other.m_data, N * sizeof(T));
-    }
-
-    Point& operator=(const Point& other)
-    {
-        memcpy(m_data, other.m_data, N * sizeof(T));
-        return *this;
-    }
+    Point(const Point& other) = default;
+    Point& operator=(const Point& other) = default;
 
     const T* dataPtr() const
     {
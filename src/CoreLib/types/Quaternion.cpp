@@ -88,19 +88,6 @@ Quaternion::Quaternion(float w, float i, float j, float k)
     m_vector = Vector3f(i, j, k);
 }
 
-Quaternion::Quaternion(const Quaternion& other)
-{
-    m_w = other.m_w;
-    m_vector = other.m_vector;
-}
-
-Quaternion& Quaternion::operator=(const Quaternion& other)
-{
-    m_w = other.m_w;
-    m_vector = other.m_vector;
-    return *this;
-}
-
 void Quaternion::setScalar(float value)
 {
     m_w = value;
@@ -82,8 +82,8 @@ public:
 
     Quaternion();
     Quaternion(float w, float i, float j, float k);
-    Quaternion(const Quaternion& other);
-    Quaternion& operator=(const Quaternion& other);
+    Quaternion(const Quaternion& other) = default;
+    Quaternion& operator=(const Quaternion& other) = default;
     void setScalar(float value);
     void setVector(Vector3f vector);
     void setVector(float i, float j, float k);
@@ -1,6 +1,8 @@
 #include "Skeleton.h"
 #include <cmath>
 #include <QVector>
+#include <QtAlgorithms>
+#include <cstring>
 #include <QDebug>
 
 namespace dai {
@@ -84,6 +86,9 @@ Skeleton::Skeleton(SkeletonType type)
 {
     m_type = type;
     m_units = dai::DISTANCE_MILIMETERS;
+    m_jointsMask = 0;
+    m_hasQuaternions = false;
+    memset(&m_positions, 0, sizeof(JointPositions));
 
     if (type == SKELETON_OPENNI) {
         memcpy(m_limbs, staticOpenNILimbsMap, 16 * sizeof(SkeletonLimb));
@@ -94,54 +99,53 @@ Skeleton::Skeleton(SkeletonType type)
     }
 }
 
-Skeleton::Skeleton(const Skeleton& other)
+const SkeletonJoint& Skeleton::getJoint(SkeletonJoint::JointType type) const
 {
-    m_type = other.m_type;
-    m_limbsSize = other.m_limbsSize;
-    m_joints = other.m_joints;  // implicit sharing
-    m_quaternions = other.m_quaternions; // implicit sharing
-    m_units = other.m_units;
-    m_units = other.m_units;
-    m_fx_rgb = other.m_fx_rgb;
-    m_fy_rgb = other.m_fy_rgb;
-    m_cx_rgb = other.m_cx_rgb;
-    m_cy_rgb = other.m_cy_rgb;
-    memcpy(m_limbs, other.m_limbs, other.m_limbsSize * sizeof(SkeletonLimb));
-}
+    static const SkeletonJoint emptyJoint;
 
-Skeleton& Skeleton::operator=(const Skeleton& other)
-{
-    m_type = other.m_type;
-    m_limbsSize = other.m_limbsSize;
-    m_joints = other.m_joints;
-    m_quaternions = other.m_quaternions;
-    m_units = other.m_units;
-    m_fx_rgb = other.m_fx_rgb;
-    m_fy_rgb = other.m_fy_rgb;
-    m_cx_rgb = other.m_cx_rgb;
-    m_cy_rgb = other.m_cy_rgb;
-    memcpy(m_limbs, other.m_limbs, other.m_limbsSize * sizeof(SkeletonLimb));
-    return *this;
+    if (type < 0 || type >= MAX_JOINTS)
+        return emptyJoint;
+
+    return m_joints[type];
 }
 
-const SkeletonJoint Skeleton::getJoint(SkeletonJoint::JointType type) const
+QList<SkeletonJoint> Skeleton::joints() const
 {
-    return m_joints.value(type);
+    QList<SkeletonJoint> result;
+
+    for (int type=0; type<MAX_JOINTS; ++type) {
+        if (m_jointsMask & (Q_UINT64_C(1) << type))
+            result << m_joints[type];
+    }
+
+    return result;
 }
 
-QList<SkeletonJoint> Skeleton::joints() const
+bool Skeleton::hasJoint(SkeletonJoint::JointType type) const
 {
-    return m_joints.values();
+    return type >= 0 && type < MAX_JOINTS && (m_jointsMask & (Q_UINT64_C(1) << type));
 }
 
-const Quaternion Skeleton::getQuaternion(Quaternion::QuaternionType type) const
+const Quaternion& Skeleton::getQuaternion(Quaternion::QuaternionType type) const
 {
-    return m_quaternions.value(type);
+    static const Quaternion identity;
+
+    if (!m_hasQuaternions || type < 0 || type >= MAX_QUATERNIONS)
+        return identity;
+
+    return m_quaternions[type];
 }
 
 QList<Quaternion> Skeleton::quaternions() const
 {
-    return m_quaternions.values();
+    QList<Quaternion> result;
+
+    if (m_hasQuaternions) {
+        for (int i=0; i<MAX_QUATERNIONS; ++i)
+            result << m_quaternions[i];
+    }
+
+    return result;
 }
 
 const Skeleton::SkeletonLimb* Skeleton::getLimbsMap() const
@@ -151,7 +155,7 @@ const Skeleton::SkeletonLimb* Skeleton::getLimbsMap() const
 
 short Skeleton::getJointsCount() const
 {
-    return m_joints.size();
+    return qPopulationCount(m_jointsMask);
 }
 
 short Skeleton::getLimbsCount() const
@@ -171,12 +175,28 @@ DistanceUnits Skeleton::distanceUnits() const
 
 void Skeleton::setJoint(SkeletonJoint::JointType type, const SkeletonJoint& joint)
 {
-    m_joints.insert(type, joint); // copy
+    Q_ASSERT(type >= 0 && type < MAX_JOINTS);
+
+    if (type < 0 || type >= MAX_JOINTS)
+        return;
+
+    m_joints[type] = joint; // copy
+    m_positions.x[type] = joint.getPosition().val(0);
+    m_positions.y[type] = joint.getPosition().val(1);
+    m_positions.z[type] = joint.getPosition().val(2);
+    m_jointsMask |= Q_UINT64_C(1) << type;
 }
 
 void Skeleton::removeJoint(SkeletonJoint::JointType joint_type)
 {
-    m_joints.remove(joint_type);
+    if (joint_type < 0 || joint_type >= MAX_JOINTS)
+        return;
+
+    m_joints[joint_type] = SkeletonJoint();
+    m_positions.x[joint_type] = 0;
+    m_positions.y[joint_type] = 0;
+    m_positions.z[joint_type] = 0;
+    m_jointsMask &= ~(Q_UINT64_C(1) << joint_type);
 }
 
 void Skeleton::setDistanceUnits(DistanceUnits units)
@@ -184,17 +204,54 @@ void Skeleton::setDistanceUnits(DistanceUnits units)
     m_units = units;
 }
 
+// Same as Quaternion::getRotationBetween(p1, p2, vertex) for the 22 joint triplets, but
+// the vectors are gathered in arrays first so each step is a plain loop
 void Skeleton::computeQuaternions()
 {
-    // Quaternions
-    for (int i=0; i<22; ++i) {
-        SkeletonJoint::JointType joint1 = staticQuaternionsMap[i][0];
-        SkeletonJoint::JointType joint2 = staticQuaternionsMap[i][1]; // vertex
-        SkeletonJoint::JointType joint3 = staticQuaternionsMap[i][2];
-        m_quaternions[i] = Quaternion::getRotationBetween(m_joints[joint1].getPosition(),
-                                                          m_joints[joint3].getPosition(),
-                                                          m_joints[joint2].getPosition());
+    double v1x[MAX_QUATERNIONS], v1y[MAX_QUATERNIONS], v1z[MAX_QUATERNIONS];
+    double v2x[MAX_QUATERNIONS], v2y[MAX_QUATERNIONS], v2z[MAX_QUATERNIONS];
+
+    for (int i=0; i<MAX_QUATERNIONS; ++i) {
+        const int joint1 = staticQuaternionsMap[i][0];
+        const int joint2 = staticQuaternionsMap[i][1]; // vertex
+        const int joint3 = staticQuaternionsMap[i][2];
+        v1x[i] = float(m_positions.x[joint1] - m_positions.x[joint2]);
+        v1y[i] = float(m_positions.y[joint1] - m_positions.y[joint2]);
+        v1z[i] = float(m_positions.z[joint1] - m_positions.z[joint2]);
+        v2x[i] = float(m_positions.x[joint3] - m_positions.x[joint2]);
+        v2y[i] = float(m_positions.y[joint3] - m_positions.y[joint2]);
+        v2z[i] = float(m_positions.z[joint3] - m_positions.z[joint2]);
+    }
+
+    double w[MAX_QUATERNIONS], qx[MAX_QUATERNIONS], qy[MAX_QUATERNIONS], qz[MAX_QUATERNIONS];
+    double cosTheta[MAX_QUATERNIONS], k[MAX_QUATERNIONS];
+
+    for (int i=0; i<MAX_QUATERNIONS; ++i) {
+        cosTheta[i] = v1x[i]*v2x[i] + v1y[i]*v2y[i] + v1z[i]*v2z[i];
+        k[i] = sqrt((v1x[i]*v1x[i] + v1y[i]*v1y[i] + v1z[i]*v1z[i]) *
+                    (v2x[i]*v2x[i] + v2y[i]*v2y[i] + v2z[i]*v2z[i]));
+        w[i] = k[i] + cosTheta[i];
+        qx[i] = v1y[i]*v2z[i] - v1z[i]*v2y[i];
+        qy[i] = v1z[i]*v2x[i] - v1x[i]*v2z[i];
+        qz[i] = v1x[i]*v2y[i] - v1y[i]*v2x[i];
     }
+
+    for (int i=0; i<MAX_QUATERNIONS; ++i)
+    {
+        if (cosTheta[i] / k[i] != -1) {
+            // Normalize as Quaternion::normalize() does (vector part stored as float first)
+            const float fx = qx[i], fy = qy[i], fz = qz[i];
+            const float fw = w[i];
+            const double norm = sqrt(double(fw)*fw + double(fx)*fx + double(fy)*fy + double(fz)*fz);
+            m_quaternions[i] = Quaternion(fw / norm, fx / norm, fy / norm, fz / norm);
+        }
+        else {
+            // 180 degree rotation around any axis (y-axis used here)
+            m_quaternions[i] = Quaternion(0, 0, 1, 0);
+        }
+    }
+
+    m_hasQuaternions = true;
 }
 
 void Skeleton::setCameraIntrinsics(double fx, double cx, double fy, double cy) {
@@ -213,14 +270,19 @@ void Skeleton::convertCoordinatesToDepth(float x, float y, float z, float* pOutX
 
 QByteArray Skeleton::toBinary() const
 {
-    QByteArray data_mem(m_joints.size() * 37 + 2, 0);
+    const int numJoints = getJointsCount();
+    QByteArray data_mem(numJoints * 37 + 2, 0);
     uchar* pData = (uchar*) data_mem.data();
 
-    *pData++ = m_joints.size(); // Number of joints (1 byte)
+    *pData++ = numJoints; // Number of joints (1 byte)
     *pData++ = m_units; // Units (1 byte)
 
-    for (SkeletonJoint joint : m_joints)
+    for (int type=0; type<MAX_JOINTS; ++type)
     {
+        if (!(m_jointsMask & (Q_UINT64_C(1) << type)))
+            continue;
+
+        const SkeletonJoint& joint = m_joints[type];
         *pData = joint.getType(); // Joint type (1 byte)
         pData++;
 
@@ -267,7 +329,7 @@ SkeletonPtr Skeleton::fromBinary(const QByteArray& buffer, int* read_bytes)
     uchar number_joints = *binData++;
     DistanceUnits units = (DistanceUnits) *binData++;
 
-    SkeletonType skelType;
+    SkeletonType skelType = SKELETON_OPENNI;
 
     if (number_joints == 15)
         skelType = SKELETON_OPENNI;
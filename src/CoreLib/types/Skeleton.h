@@ -4,11 +4,15 @@
 #include "SkeletonJoint.h"
 #include "Quaternion.h"
 #include "types/Enums.h"
+#include <QList>
 #include <QHash>
 #include <QMap>
 #include <memory>
+#include <type_traits>
 
 #define MAX_LIMBS 19
+#define MAX_JOINTS 64       // Tracker joints plus the ones made up (see PersonReid::makeUpJoints)
+#define MAX_QUATERNIONS 22
 
 namespace dai {
 
@@ -18,6 +22,10 @@ typedef std::shared_ptr<Skeleton> SkeletonPtr;
 /**
  * Skeleton depth distances are in meter in real world coordinates.
  *
+ * Joints are kept in a fixed array indexed by JointType with a bitmask of the present ones,
+ * so a Skeleton is trivially copyable and reading it never allocates. Joint positions are
+ * also kept as separate x, y, z arrays for the per-pixel and per-joint loops.
+ *
  * @brief The Skeleton class
  */
 class Skeleton
@@ -38,16 +46,25 @@ public:
         SkeletonJoint::JointType joint2;
     };
 
+    struct JointPositions {
+        float x[MAX_JOINTS];
+        float y[MAX_JOINTS];
+        float z[MAX_JOINTS];
+    };
+
     static SkeletonPtr fromBinary(const QByteArray &binData, int* read_bytes = nullptr);
 
     // Constructors
     Skeleton(SkeletonType type = SKELETON_OPENNI);
-    Skeleton(const Skeleton& other);
 
     // Methods
-    const SkeletonJoint getJoint(SkeletonJoint::JointType type) const;
+    const SkeletonJoint& getJoint(SkeletonJoint::JointType type) const;
     QList<SkeletonJoint> joints() const;
-    const Quaternion getQuaternion(Quaternion::QuaternionType type) const;
+    bool hasJoint(SkeletonJoint::JointType type) const;
+    quint64 jointsMask() const {return m_jointsMask;}
+    const JointPositions& positions() const {return m_positions;}
+    const Quaternion& getQuaternion(Quaternion::QuaternionType type) const;
+    bool hasQuaternions() const {return m_hasQuaternions;}
     QList<Quaternion> quaternions() const;
     const SkeletonLimb* getLimbsMap() const;
     short getJointsCount() const;
@@ -56,13 +73,14 @@ public:
     DistanceUnits distanceUnits() const;
     void setJoint(SkeletonJoint::JointType type, const SkeletonJoint& joint);
     void removeJoint(SkeletonJoint::JointType joint_type);
+
+    /**
+     * Compute the 22 quaternions at once from the joint positions
+     */
     void computeQuaternions();
     void setDistanceUnits(DistanceUnits units);
     QByteArray toBinary() const;
 
-    // Operators Overload
-    Skeleton& operator=(const Skeleton& other);
-
     // Extra
     void convertCoordinatesToDepth(float x, float y, float z, float* pOutX, float* pOutY) const;
     void setCameraIntrinsics(double fx, double cx, double fy, double cy);
@@ -72,8 +90,11 @@ private:
     static SkeletonLimb staticKinectLimbsMap[MAX_LIMBS];
     static SkeletonLimb staticOpenNILimbsMap[16];
 
-    QMap<int, SkeletonJoint> m_joints;
-    QMap<int, Quaternion> m_quaternions;
+    SkeletonJoint m_joints[MAX_JOINTS];
+    JointPositions m_positions;
+    quint64 m_jointsMask;
+    Quaternion m_quaternions[MAX_QUATERNIONS];
+    bool m_hasQuaternions;
     SkeletonLimb m_limbs[MAX_LIMBS];
     short m_limbsSize;
     SkeletonType m_type;
@@ -87,6 +108,8 @@ private:
     double m_cy_rgb = 240.0;
 };
 
+static_assert(std::is_trivially_copyable<Skeleton>::value, "Skeleton must be trivially copyable");
+
 } // End Namespace
 
 #endif // SKELETON_H
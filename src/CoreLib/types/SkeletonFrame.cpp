@@ -53,13 +53,53 @@ void SkeletonFrame::setSkeleton(int userId, shared_ptr<dai::Skeleton> skeleton)
     m_hashSkeletons.insert(userId, skeleton);
 }
 
+SkeletonPtr SkeletonFrame::reuseSkeleton(int userId, Skeleton::SkeletonType type)
+{
+    SkeletonPtr skeleton = m_hashSkeletons.value(userId);
+
+    if (!skeleton)
+    {
+        if (!m_spares.isEmpty()) {
+            skeleton = m_spares.takeLast();
+            *skeleton = Skeleton(type);
+        } else {
+            skeleton = make_shared<Skeleton>(type);
+        }
+
+        m_hashSkeletons.insert(userId, skeleton);
+    }
+
+    return skeleton;
+}
+
 QList<int> SkeletonFrame::getAllUsersId() const
 {
     return m_hashSkeletons.keys();
 }
 
+int SkeletonFrame::usersCount() const
+{
+    return m_hashSkeletons.size();
+}
+
+int SkeletonFrame::firstUserId() const
+{
+    return m_hashSkeletons.isEmpty() ? 0 : m_hashSkeletons.firstKey();
+}
+
 void SkeletonFrame::clear()
 {
+    // Skeletons shared with a copy of this frame are still in use
+    if (m_hashSkeletons.isDetached())
+    {
+        const QMap<int, SkeletonPtr>& skeletons = m_hashSkeletons;
+
+        for (const SkeletonPtr& skeleton : skeletons) {
+            if (skeleton.use_count() == 1 && m_spares.size() < MAX_SPARES)
+                m_spares << skeleton;
+        }
+    }
+
     m_hashSkeletons.clear();
 }
 
@@ -17,6 +17,8 @@ typedef shared_ptr<SkeletonFrame> SkeletonFramePtr;
 class SkeletonFrame : public DataFrame
 {
     QMap<int, SkeletonPtr> m_hashSkeletons;
+    static const int MAX_SPARES = 15; // Users tracked at most by NiTE
+    QList<SkeletonPtr> m_spares; // Skeletons released by clear() that nobody else holds
     int m_width;
     int m_height;
 
@@ -33,7 +35,15 @@ public:
     SkeletonPtr getSkeleton(int userId) const;
     QList<SkeletonPtr> skeletons() const;
     void setSkeleton(int userId, const dai::SkeletonPtr skeleton);
+
+    /**
+     * Skeleton of userId. If there is none, an empty one is added, reusing the memory of
+     * the skeletons released by clear() when possible.
+     */
+    SkeletonPtr reuseSkeleton(int userId, Skeleton::SkeletonType type);
     QList<int> getAllUsersId() const;
+    int usersCount() const;
+    int firstUserId() const; // 0 if there are no users
     void clear();
     QByteArray toBinary() const;
 
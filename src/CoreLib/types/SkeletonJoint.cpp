@@ -17,25 +17,6 @@ SkeletonJoint::SkeletonJoint(const Point3f& point, JointType type)
     m_orientation_confidence = 0.0f;
 }
 
-SkeletonJoint::SkeletonJoint(const SkeletonJoint& other)
-{
-    m_realworld_point = other.m_realworld_point;
-    m_orientation = other.m_orientation;
-    m_type = other.m_type;
-    m_position_confidence = other.m_position_confidence;
-    m_orientation_confidence = other.m_orientation_confidence;
-}
-
-SkeletonJoint& SkeletonJoint::operator=(const SkeletonJoint& other)
-{
-    m_realworld_point = other.m_realworld_point;
-    m_orientation = other.m_orientation;
-    m_type = other.m_type;
-    m_position_confidence = other.m_position_confidence;
-    m_orientation_confidence = other.m_orientation_confidence;
-    return *this;
-}
-
 void SkeletonJoint::setType(JointType type)
 {
     m_type = type;
@@ -45,8 +45,8 @@ public:
 
     SkeletonJoint();
     explicit SkeletonJoint(const Point3f& point, JointType type);
-    SkeletonJoint(const SkeletonJoint& other);
-    SkeletonJoint& operator=(const SkeletonJoint& other);
+    SkeletonJoint(const SkeletonJoint& other) = default; // Trivially copyable (see Skeleton)
+    SkeletonJoint& operator=(const SkeletonJoint& other) = default;
     void setType(JointType type);
     void setPosition(const Point3f &point);
     void setPositionConfidence(float value);
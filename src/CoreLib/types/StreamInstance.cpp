@@ -8,6 +8,7 @@ StreamInstance::StreamInstance(DataFrame::SupportedFrames supportedFrames)
     m_frame_counter = 0;
     m_info.width = 0;
     m_info.width = 0;
+    m_timestamp = -1;
 }
 
 StreamInstance::StreamInstance(DataFrame::SupportedFrames supportedFrames, int width, int height)
@@ -16,6 +17,7 @@ StreamInstance::StreamInstance(DataFrame::SupportedFrames supportedFrames, int w
     m_frame_counter = 0;
     m_info.width = width;
     m_info.height = height;
+    m_timestamp = -1;
 }
 
 unsigned int StreamInstance::getFrameCounter() const
@@ -28,6 +30,16 @@ DataFrame::SupportedFrames StreamInstance::getSupportedFrames() const
     return m_supportedFrames;
 }
 
+qint64 StreamInstance::getTimestamp() const
+{
+    return m_timestamp;
+}
+
+void StreamInstance::setTimestamp(qint64 timestamp)
+{
+    m_timestamp = timestamp;
+}
+
 const StreamInfo& StreamInstance::getStreamInfo() const
 {
     return m_info;
@@ -63,6 +75,37 @@ bool StreamInstance::hasNext() const
     return is_open();
 }
 
+unsigned int StreamInstance::skipFrames(unsigned int count, QHashDataFrames& scratch)
+{
+    if (count == 0 || !is_open())
+        return 0;
+
+    if (seekInstance(count)) {
+        m_frame_counter += count;
+        return count;
+    }
+
+    unsigned int skipped = 0;
+
+    while (skipped < count && hasNext()) {
+        readNextFrame(scratch);
+        skipped++;
+    }
+
+    return skipped;
+}
+
+unsigned int StreamInstance::skippableFrames(unsigned int count) const
+{
+    return is_open() ? count : 0;
+}
+
+bool StreamInstance::seekInstance(unsigned int count)
+{
+    Q_UNUSED(count);
+    return false;
+}
+
 QList<DataFrame::FrameType> StreamInstance::getTypes(DataFrame::SupportedFrames type)
 {
     DataFrame::FrameType all_types[] = {
@@ -20,6 +20,7 @@ class StreamInstance
     unsigned int                m_frame_counter;
     DataFrame::SupportedFrames  m_supportedFrames;
     StreamInfo                  m_info;
+    qint64                      m_timestamp;
 
 public:
 
@@ -40,15 +41,37 @@ public:
         m_frame_counter++;
     }
 
+    /**
+     * Skip the next count frames. Sources that cannot seek read the frames into scratch
+     * and discard them. Returns the number of skipped frames.
+     */
+    virtual unsigned int skipFrames(unsigned int count, QHashDataFrames& scratch);
+
+    /**
+     * Frames, up to count, that skipFrames() can skip now
+     */
+    virtual unsigned int skippableFrames(unsigned int count) const;
+
     const StreamInfo& getStreamInfo() const;
     unsigned int getFrameCounter() const;
     DataFrame::SupportedFrames getSupportedFrames() const;
 
+    /**
+     * Capture time of the last read frame in microseconds (-1 if the source has no timestamps)
+     */
+    qint64 getTimestamp() const;
+
 protected:
     virtual bool openInstance() = 0;
     virtual void closeInstance() = 0;
     virtual void restartInstance() = 0;
     virtual void nextFrame(QHashDataFrames& output) = 0;
+
+    /**
+     * Move count frames forward without reading them. Returns false if not supported.
+     */
+    virtual bool seekInstance(unsigned int count);
+    void setTimestamp(qint64 timestamp);
 };
 
 } // End namespace
@@ -142,6 +142,11 @@ void DepthFilter::newFrames(const QHashDataFrames dataFrames)
     }
 }
 
+void DepthFilter::describeFrame(FrameInfo& info)
+{
+    info.copyPacing(frameInfo());
+}
+
 void DepthFilter::afterStop()
 {
     freeResources();
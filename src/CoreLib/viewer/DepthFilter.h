@@ -22,11 +22,14 @@ public:
     ~DepthFilter();
     void initialise();
     void newFrames(const QHashDataFrames dataFrames) override;
+    const char* listenerName() const override {return "DepthFilter";}
+    const char* generatorName() const override {return "DepthFilter";}
 
 protected:
     shared_ptr<QHashDataFrames> allocateMemory() override;
     void afterStop() override;
     void produceFrames(QHashDataFrames& output) override;
+    void describeFrame(FrameInfo& info) override;
     void freeResources();
 
 private:
@@ -1,5 +1,6 @@
 #include "InstanceViewerWindow.h"
 #include "playback/PlaybackControl.h"
+#include "playback/Tracer.h"
 #include "InstanceWidgetItem.h"
 #include "dataset/Dataset.h"
 #include "dataset/InstanceInfo.h"
@@ -136,16 +137,23 @@ void InstanceViewerWindow::newFrames(const QHashDataFrames dataFrames)
     // Copy frames (1 ms)
     QHashDataFrames copyFrames;
 
-    foreach (DataFrame::FrameType key, dataFrames.keys()) {
-        shared_ptr<DataFrame> frame = dataFrames.value(key);
-        copyFrames.insert(key, frame->clone());
+    {
+        TraceScope scope(listenerName(), "copyFrames");
+
+        foreach (DataFrame::FrameType key, dataFrames.keys()) {
+            shared_ptr<DataFrame> frame = dataFrames.value(key);
+            copyFrames.insert(key, frame->clone());
+        }
     }
 
     // Check if the frames has been copied correctly
     if (!hasExpired())
     {
         // Do task
-        m_viewerEngine->prepareScene(copyFrames);
+        {
+            TraceScope scope(listenerName(), "prepareScene");
+            m_viewerEngine->prepareScene(copyFrames);
+        }
 
         // Feed skeleton data models
         if (copyFrames.contains(DataFrame::Skeleton)) {
@@ -158,6 +166,7 @@ void InstanceViewerWindow::newFrames(const QHashDataFrames dataFrames)
     }
     else {
         qDebug() << "InstanceViewerWindow - Frame copied out of time";
+        Tracer::instant(listenerName(), "expired", Tracer::currentFrame());
     }
 
     m_fps = producerHandler()->getFrameRate();
@@ -331,11 +340,9 @@ void InstanceViewerWindow::feedDataModels(shared_ptr<SkeletonFrame> skeletonFram
     if (!skeletonFrame)
         return;
 
-    QList<int> allUsers = skeletonFrame->getAllUsersId();
-
-    if (!allUsers.isEmpty()) {
+    if (skeletonFrame->usersCount() > 0) {
 
-        int userId = allUsers.first();
+        int userId = skeletonFrame->firstUserId();
         const auto& skeleton = *(skeletonFrame->getSkeleton(userId));
 
         if (m_joints_table_view.isVisible())
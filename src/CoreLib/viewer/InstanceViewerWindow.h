@@ -54,6 +54,7 @@ public:
     void setDelay(qint64 milliseconds);
     void setDrawMode(ViewerEngine::DrawMode mode);
     void showFrame(shared_ptr<ColorFrame> frame);
+    const char* listenerName() const override {return "InstanceViewerWindow";}
 
 protected:
     void newFrames(const QHashDataFrames dataFrames) override;
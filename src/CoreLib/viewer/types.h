@@ -12,7 +12,8 @@ enum ColorFilter {
     FILTER_EMBOSS,
     FILTER_SILHOUETTE,
     FILTER_SKELETON,
-    FILTER_3DMODEL
+    FILTER_3DMODEL,
+    FILTER_POINTCLOUD
 };
 
 } // End Namespace
@@ -0,0 +1,230 @@
+#include "ConversionPipeline.h"
+#include "types/FrameCodec.h"
+#include <QImage>
+#include <QBuffer>
+#include <QSaveFile>
+#include <QDir>
+#include <QDebug>
+
+namespace dai {
+
+class StageTask : public QRunnable
+{
+public:
+    explicit StageTask(std::function<void ()> task)
+        : m_task(task) {}
+
+    void run() override {
+        m_task();
+    }
+
+private:
+    std::function<void ()> m_task;
+};
+
+ConversionPipeline::ConversionPipeline(const QString& outputPath, int decoders, int workers, int writers, int maxFramesInFlight)
+    : m_outputPath(outputPath)
+    , m_framesInFlight(maxFramesInFlight)
+    , m_maxFramesInFlight(maxFramesInFlight)
+    , m_frameCodec(false)
+    , m_checkpoint(outputPath + "/progress.ini", QSettings::IniFormat)
+{
+    QDir().mkpath(outputPath);
+
+    m_decodePool.setMaxThreadCount(qMax(1, decoders));
+    m_cropPool.setMaxThreadCount(qMax(1, workers / 2));
+    m_encodePool.setMaxThreadCount(qMax(1, workers));
+    m_writePool.setMaxThreadCount(qMax(1, writers));
+
+    m_lastSave.start();
+    m_timer.start();
+}
+
+ConversionPipeline::~ConversionPipeline()
+{
+    waitForDone();
+}
+
+void ConversionPipeline::runDecoder(std::function<void ()> decoder)
+{
+    start(m_decodePool, decoder);
+}
+
+void ConversionPipeline::push(shared_ptr<ConversionJob> job)
+{
+    // Blocks the decoder while the other stages are busy
+    m_framesInFlight.acquire();
+
+    m_lock.lock();
+    Progress& progress = m_progress[job->instance];
+    progress.inFlight.insert(job->frameIndex);
+    progress.lastPushed = job->frameIndex;
+    m_lock.unlock();
+
+    start(m_cropPool, [this, job]() {crop(job);});
+}
+
+bool ConversionPipeline::isInstanceDone(const QString& instance) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_checkpoint.value(instance + "/done", false).toBool();
+}
+
+unsigned int ConversionPipeline::resumeFrame(const QString& instance) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_checkpoint.value(instance + "/frame", 0).toUInt();
+}
+
+void ConversionPipeline::beginInstance(const QString& instance)
+{
+    QMutexLocker locker(&m_lock);
+    m_progress.insert(instance, Progress());
+}
+
+void ConversionPipeline::endInstance(const QString& instance)
+{
+    QMutexLocker locker(&m_lock);
+    Progress& progress = m_progress[instance];
+    progress.decoded = true;
+    saveCheckpoint(instance, progress, true);
+}
+
+void ConversionPipeline::waitForDone()
+{
+    // Decoders first, as they feed the next stages
+    m_decodePool.waitForDone();
+
+    // Every job releases its slot once written
+    m_framesInFlight.acquire(m_maxFramesInFlight);
+    m_framesInFlight.release(m_maxFramesInFlight);
+
+    m_cropPool.waitForDone();
+    m_encodePool.waitForDone();
+    m_writePool.waitForDone();
+
+    QMutexLocker locker(&m_lock);
+    m_checkpoint.sync();
+}
+
+ConversionPipeline::Stats ConversionPipeline::stats() const
+{
+    QMutexLocker locker(&m_lock);
+    Stats result = m_stats;
+    result.elapsedMs = m_timer.elapsed();
+    return result;
+}
+
+void ConversionPipeline::start(QThreadPool& pool, std::function<void ()> task)
+{
+    StageTask* runnable = new StageTask(task);
+    runnable->setAutoDelete(true);
+    pool.start(runnable);
+}
+
+void ConversionPipeline::crop(shared_ptr<ConversionJob> job)
+{
+    if (!job->roi.isEmpty()) {
+        const BoundingBox& bb = job->roi.first();
+        job->color = job->color->subFrame(bb);
+        job->depth = job->depth->subFrame(bb);
+        job->mask = job->mask->subFrame(bb);
+    }
+
+    start(m_encodePool, [this, job]() {encode(job);});
+}
+
+void ConversionPipeline::encode(shared_ptr<ConversionJob> job)
+{
+    // Color as JPEG
+    QImage image( (uchar*) job->color->getDataPtr(), job->color->width(), job->color->height(),
+                  job->color->getStride(), QImage::Format_RGB888);
+    QBuffer buffer(&job->colorData);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPG");
+
+    // Frames are already encoded in parallel, so the codec uses one thread
+    job->depthData = m_frameCodec ? FrameCodec::encode(*job->depth, 1) : job->depth->toBinary();
+    job->maskData = m_frameCodec ? FrameCodec::encode(*job->mask, 1) : job->mask->toBinary();
+    job->skeletonData = job->skeleton->toBinary();
+
+    // Frames are not needed anymore
+    job->color.reset();
+    job->depth.reset();
+    job->mask.reset();
+    job->skeleton.reset();
+
+    start(m_writePool, [this, job]() {write(job);});
+}
+
+void ConversionPipeline::write(shared_ptr<ConversionJob> job)
+{
+    const QString prefix = m_outputPath + "/" + job->name;
+
+    // The skeleton is written last, so if it exists the frame is complete
+    bool ok = writeFile(prefix + "_color.jpg", job->colorData) &&
+              writeFile(prefix + "_depth.bin", job->depthData) &&
+              writeFile(prefix + "_mask.bin", job->maskData) &&
+              writeFile(prefix + "_skel.bin", job->skeletonData);
+
+    const qint64 bytes = job->colorData.size() + job->depthData.size() +
+                         job->maskData.size() + job->skeletonData.size();
+
+    m_lock.lock();
+
+    if (ok) {
+        m_stats.framesWritten++;
+        m_stats.bytesWritten += bytes;
+    }
+    else {
+        qDebug() << "Couldn't write frame" << job->name;
+    }
+
+    Progress& progress = m_progress[job->instance];
+    progress.inFlight.erase(job->frameIndex);
+
+    if (!ok)
+        progress.failed.insert(job->frameIndex);
+
+    saveCheckpoint(job->instance, progress, false);
+    m_lock.unlock();
+
+    m_framesInFlight.release();
+}
+
+bool ConversionPipeline::writeFile(const QString& fileName, const QByteArray& data)
+{
+    // Written to a temporary file that is renamed once complete
+    QSaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(data);
+    return file.commit();
+}
+
+// Called with m_lock held
+void ConversionPipeline::saveCheckpoint(const QString& instance, const Progress& progress, bool force)
+{
+    // First frame that has not been completely written, failed frames are converted again
+    // when resuming
+    unsigned int frame = progress.inFlight.empty() ? progress.lastPushed + 1 : *progress.inFlight.begin();
+
+    if (!progress.failed.empty())
+        frame = qMin(frame, *progress.failed.begin());
+
+    if (frame > m_checkpoint.value(instance + "/frame", 0).toUInt())
+        m_checkpoint.setValue(instance + "/frame", frame);
+
+    if (progress.decoded && progress.inFlight.empty() && progress.failed.empty())
+        m_checkpoint.setValue(instance + "/done", true);
+
+    // Sync every few seconds, frames written since then are written again after a crash
+    if (force || m_lastSave.elapsed() > 2000) {
+        m_checkpoint.sync();
+        m_lastSave.restart();
+    }
+}
+
+} // End Namespace
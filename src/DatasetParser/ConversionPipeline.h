@@ -0,0 +1,117 @@
+#ifndef CONVERSIONPIPELINE_H
+#define CONVERSIONPIPELINE_H
+
+#include "types/ColorFrame.h"
+#include "types/DepthFrame.h"
+#include "types/MaskFrame.h"
+#include "types/Skeleton.h"
+#include "types/BoundingBox.h"
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QSettings>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMap>
+#include <functional>
+#include <set>
+
+namespace dai {
+
+/**
+ * A frame that travels through the pipeline. The decoder fills the full frames, the crop
+ * stage replaces them by the region of interest and the encode stage serialises them.
+ */
+struct ConversionJob
+{
+    QString instance;            // Checkpoint key of the source instance
+    QString name;                // Prefix of the output files
+    unsigned int frameIndex = 0;
+    shared_ptr<ColorFrame> color;
+    shared_ptr<DepthFrame> depth;
+    shared_ptr<MaskFrame> mask;
+    shared_ptr<Skeleton> skeleton;
+    QList<BoundingBox> roi;      // Empty to keep the whole frame
+    QByteArray colorData;
+    QByteArray depthData;
+    QByteArray maskData;
+    QByteArray skeletonData;
+};
+
+/**
+ * Converts dataset frames into files as a pipeline: decode -> crop ROI -> encode -> write.
+ * Every stage has its own worker pool and the number of frames in flight is bounded, so
+ * the decoders block when the disk cannot keep up.
+ *
+ * Files are written atomically and the skeleton is written last, and the progress of every
+ * instance is saved in a checkpoint file of the output folder. A crashed run resumes from
+ * the first frame that was not completely written.
+ *
+ * @brief The ConversionPipeline class
+ */
+class ConversionPipeline
+{
+public:
+    struct Stats {
+        qint64 framesWritten = 0;
+        qint64 bytesWritten = 0;
+        qint64 elapsedMs = 0;
+    };
+
+    ConversionPipeline(const QString& outputPath, int decoders, int workers, int writers, int maxFramesInFlight);
+    ~ConversionPipeline();
+
+    /**
+     * Depth and masks are written with FrameCodec instead of toBinary()
+     */
+    void setFrameCodec(bool enabled) {m_frameCodec = enabled;}
+
+    // Decode stage: decoders run in the decode pool and push the frames they read
+    void runDecoder(std::function<void ()> decoder);
+    void push(shared_ptr<ConversionJob> job);
+
+    // Checkpoints
+    bool isInstanceDone(const QString& instance) const;
+    unsigned int resumeFrame(const QString& instance) const;
+    void beginInstance(const QString& instance);
+    void endInstance(const QString& instance);
+
+    void waitForDone();
+    Stats stats() const;
+    const QString& outputPath() const {return m_outputPath;}
+
+private:
+    struct Progress {
+        std::set<unsigned int> inFlight;
+        std::set<unsigned int> failed;  // Frames that couldn't be written
+        unsigned int lastPushed = 0;
+        bool decoded = false;
+    };
+
+    void start(QThreadPool& pool, std::function<void ()> task);
+    void crop(shared_ptr<ConversionJob> job);
+    void encode(shared_ptr<ConversionJob> job);
+    void write(shared_ptr<ConversionJob> job);
+    bool writeFile(const QString& fileName, const QByteArray& data);
+    void saveCheckpoint(const QString& instance, const Progress& progress, bool force);
+
+    const QString          m_outputPath;
+    QThreadPool            m_decodePool;
+    QThreadPool            m_cropPool;
+    QThreadPool            m_encodePool;
+    QThreadPool            m_writePool;
+    QSemaphore             m_framesInFlight;
+    const int              m_maxFramesInFlight;
+    bool                   m_frameCodec;
+
+    // Checkpoints and stats
+    mutable QMutex         m_lock;
+    QSettings              m_checkpoint;
+    QMap<QString, Progress> m_progress;
+    QElapsedTimer          m_lastSave;
+    QElapsedTimer          m_timer;
+    Stats                  m_stats;
+};
+
+} // End Namespace
+
+#endif // CONVERSIONPIPELINE_H
@@ -2,7 +2,7 @@
     error("Couldn't find the common.pri file!")
 }
 
-QT       += core
+QT       += core concurrent
 #QT       -= gui
 
 TARGET = DatasetParser
@@ -10,7 +10,11 @@ TEMPLATE  = app
 CONFIG   += console link_prl
 CONFIG   -= app_bundle
 
-SOURCES += main.cpp
+HEADERS += \
+    ConversionPipeline.h
+
+SOURCES += main.cpp \
+    ConversionPipeline.cpp
 
 unix {
     # CoreLib
@@ -12,9 +12,16 @@
 #include "types/MaskFrame.h"
 #include "types/DepthFrame.h"
 #include "types/MetadataFrame.h"
+#include "types/FrameCodec.h"
 #include "openni/OpenNIColorInstance.h"
 #include "opencv_utils.h"
-#include <QImage>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QtConcurrent>
+#include <QDirIterator>
+#include <QSaveFile>
+#include "exceptions/CannotOpenInstanceException.h"
+#include "ConversionPipeline.h"
 #include "Config.h"
 
 using namespace std;
@@ -64,6 +71,22 @@ void writeXML(QMap<int, QMap<int, QMap<int, DatasetSample> > > samples)
     cout << "\t" << "</instances>" << endl;
 }
 
+static bool isMissing(const QString& fileName)
+{
+    return !QFile::exists(fileName);
+}
+
+// Files are checked in parallel, one by one is slow on network drives
+void checkMissingFiles(const QStringList& fileNames)
+{
+    QStringList missing = QtConcurrent::blockingFiltered(fileNames, isMissing);
+
+    if (!missing.isEmpty()) {
+        qDebug() << "Some missing files" << missing.first();
+        throw 1;
+    }
+}
+
 void parseIAS_LAB_RGBD_ID(const QString datasetPath)
 {
     QList<QString> actor_folders = {"000", "001", "002", "003", "004", "005", "006", "007", "008", "009", "010"};
@@ -71,7 +94,9 @@ void parseIAS_LAB_RGBD_ID(const QString datasetPath)
     int num_samples = 0;
 
     // Lambda function -> Parse Dataset
-    auto parseDataset = [datasetPath, actor_folders, &samples, &num_samples](QString subfolder, int camera)
+    QStringList files;
+
+    auto parseDataset = [datasetPath, actor_folders, &samples, &num_samples, &files](QString subfolder, int camera)
     {
         for (QString actor_folder : actor_folders)
         {
@@ -94,12 +119,9 @@ void parseIAS_LAB_RGBD_ID(const QString datasetPath)
                 sample.file_mask  = subfolder + "/" + actor_folder + "/" + QString(fileName).replace("_rgb.jpg", "_userMap.pgm");
                 sample.file_skel  = subfolder + "/" + actor_folder + "/" + QString(fileName).replace("_rgb.jpg", "_skel.txt");
 
-                if (!QFile::exists(datasetPath + "/" + sample.file_depth) ||
-                        !QFile::exists(datasetPath + "/" + sample.file_mask) ||
-                        !QFile::exists(datasetPath + "/" + sample.file_skel)) {
-                    qDebug() << "Some missing files";
-                    throw 1;
-                }
+                files << datasetPath + "/" + sample.file_depth
+                      << datasetPath + "/" + sample.file_mask
+                      << datasetPath + "/" + sample.file_skel;
 
                 samples[sample.actorId][sample.cameraId][sample.sampleId] = sample;
             }
@@ -108,6 +130,7 @@ void parseIAS_LAB_RGBD_ID(const QString datasetPath)
 
     parseDataset("Training", 1);
     parseDataset("TestingB", 2);
+    checkMissingFiles(files);
 
     cout << "<dataset name=\"IAS-LAB-RGBD-ID\">" << endl << endl;
 
@@ -161,6 +184,7 @@ void parseDAI4REID(const QString datasetPath)
     int num_samples = 0;
 
     QStringList sampleEntries = datasetDir.entryList();
+    QStringList files;
 
     for (auto it = sampleEntries.constBegin(); it != sampleEntries.constEnd(); ++it)
     {
@@ -187,18 +211,17 @@ void parseDAI4REID(const QString datasetPath)
         sample.file_mask = QString(fileName).replace("_color.jpg", "_mask.bin");
         sample.file_skel = QString(fileName).replace("_color.jpg", "_skel.bin");
 
-        if (!QFile::exists(datasetPath + "/" + sample.file_depth) ||
-                !QFile::exists(datasetPath + "/" + sample.file_mask) ||
-                !QFile::exists(datasetPath + "/" + sample.file_skel)) {
-            qDebug() << "Some missing files";
-            throw 1;
-        }
+        files << datasetPath + "/" + sample.file_depth
+              << datasetPath + "/" + sample.file_mask
+              << datasetPath + "/" + sample.file_skel;
 
         samples[sample.actorId][sample.cameraId][sample.sampleId] = sample;
         actors.insert(sample.actorId, "Actor " + QString::number(sample.actorId) );
         num_samples++;
     }
 
+    checkMissingFiles(files);
+
     // Cameras
     cout << "\t" << "<cameras size=\"2\">" << endl;
     cout << "\t\t" << "<camera key=\"1\">Camera 1</camera>" << endl;
@@ -786,153 +809,304 @@ dai::InstanceInfo* findInstance(QString activity, int actor, int sample, QMap<in
     return result;
 }
 
-void convertDAI4REIDOniToFiles()
+/**
+ * Decode stage of the DAI4REID conversion: reads an ONI file and pushes the frames with a
+ * user inside of a bounding box into the pipeline
+ */
+void decodeDAI4REIDInstance(shared_ptr<dai::Dataset> dataset, shared_ptr<dai::InstanceInfo> instance_info,
+                            dai::ConversionPipeline& pipeline, float speed)
 {
     using namespace dai;
-    using namespace cv;
 
-    Dataset* dataset = new DAI4REID;
-    dataset->setPath("/files/DAI4REID");
-    const DatasetMetadata& metadata = dataset->getMetadata();
+    const QString key = "U" + QString::number(instance_info->getActor()) +
+                        "_C" + QString::number(instance_info->getCamera()) +
+                        "_S" + QString::number(instance_info->getSample());
 
-    // Create memory for all kind of frames
-    QHashDataFrames readFrames;
-    readFrames.insert(DataFrame::Color, make_shared<ColorFrame>(640, 480));
-    readFrames.insert(DataFrame::Depth, make_shared<DepthFrame>(640, 480));
-    readFrames.insert(DataFrame::Mask, make_shared<MaskFrame>(640, 480));
-    readFrames.insert(DataFrame::Skeleton, make_shared<SkeletonFrame>());
-    readFrames.insert(DataFrame::Metadata, make_shared<MetadataFrame>());
+    if (pipeline.isInstanceDone(key)) {
+        qDebug() << key << "already converted";
+        return;
+    }
 
-    // For each actor, parse his/her samples
-    QList<int> actors = {1,2,3,4,5};
+    // Frames before this one were written by a previous run
+    const unsigned int resumeFrame = pipeline.resumeFrame(key);
+    pipeline.beginInstance(key);
 
-    for (int actor : actors)
-    {
-        QList<shared_ptr<InstanceInfo>> instances_md = metadata.instances({actor},
-                                                                       {2},
-                                                                       DatasetMetadata::ANY_LABEL);
-        shared_ptr<InstanceInfo> instance_info = instances_md.at(0);
-        std::string fileName = instance_info->getFileName(DataFrame::Color).toStdString();
+    // Get instances
+    QList<shared_ptr<StreamInstance>> instances;
+    instances << dataset->getInstance(*instance_info, DataFrame::Color);
+    instances << dataset->getInstance(*instance_info, DataFrame::Metadata);
 
-        printf("actor %i sample %i file %s\n", instance_info->getActor(),
-               instance_info->getSample(),
-               fileName.c_str());
+    // Open Instances
+    try {
+        for (shared_ptr<StreamInstance> instance : instances) {
+            instance->open();
+        }
+    }
+    catch (CannotOpenInstanceException ex) {
+        qDebug() << "Couldn't open" << instance_info->getFileName(DataFrame::Color);
+        return;
+    }
+
+    // With a non positive speed frames are read as fast as the decoder asks for them
+    shared_ptr<OpenNIColorInstance> colorInstance = static_pointer_cast<OpenNIColorInstance>(instances.at(0));
+    colorInstance->device().playbackControl()->setSpeed(speed > 0 ? speed : -1.0f);
 
-        std::fflush(stdout);
+    qDebug() << "Converting" << key << "from frame" << resumeFrame;
 
-        // Get instances
-        QList<shared_ptr<StreamInstance>> instances;
-        instances << dataset->getInstance(*instance_info, DataFrame::Color);
-        instances << dataset->getInstance(*instance_info, DataFrame::Metadata);
+    // Read frames
+    uint previousFrame = 0;
 
-        // Open Instances
+    while (colorInstance->hasNext())
+    {
+        // Every frame has its own memory as it is processed by the next stages meanwhile
+        QHashDataFrames readFrames;
+        readFrames.insert(DataFrame::Color, make_shared<ColorFrame>(640, 480));
+        readFrames.insert(DataFrame::Depth, make_shared<DepthFrame>(640, 480));
+        readFrames.insert(DataFrame::Mask, make_shared<MaskFrame>(640, 480));
+        readFrames.insert(DataFrame::Skeleton, make_shared<SkeletonFrame>());
+        readFrames.insert(DataFrame::Metadata, make_shared<MetadataFrame>());
+
+        // The user tracker needs every frame, so frames are read even when resuming
         for (shared_ptr<StreamInstance> instance : instances) {
-            instance->open();
+            instance->readNextFrame(readFrames);
         }
 
-        shared_ptr<OpenNIColorInstance> colorInstance = static_pointer_cast<OpenNIColorInstance>(instances.at(0));
-        colorInstance->device().playbackControl()->setSpeed(0.15f);
+        // Get Frames
+        auto colorFrame = static_pointer_cast<ColorFrame>(readFrames.value(DataFrame::Color));
+        auto skeletonFrame = static_pointer_cast<SkeletonFrame>(readFrames.value(DataFrame::Skeleton));
+        auto metadataFrame = static_pointer_cast<MetadataFrame>(readFrames.value(DataFrame::Metadata));
 
-        // Read frames
-        uint previousFrame = 0;
+        if (previousFrame + 1 != colorFrame->getIndex())
+            qDebug() << key << "Frame Skip" << colorFrame->getIndex();
 
-        while (colorInstance->hasNext())
-        {
-            for (shared_ptr<StreamInstance> instance : instances) {
-                instance->readNextFrame(readFrames);
-            }
+        previousFrame = colorFrame->getIndex();
 
-            // Get Frames
-            auto colorFrame = static_pointer_cast<ColorFrame>(readFrames.value(DataFrame::Color));
-            auto depthFrame = static_pointer_cast<DepthFrame>(readFrames.value(DataFrame::Depth));
-            auto maskFrame = static_pointer_cast<MaskFrame>(readFrames.value(DataFrame::Mask));
-            auto skeletonFrame = static_pointer_cast<SkeletonFrame>(readFrames.value(DataFrame::Skeleton));
-            auto metadataFrame = static_pointer_cast<MetadataFrame>(readFrames.value(DataFrame::Metadata));
+        // Work with the user inside of the Bounding Box
+        QList<int> users = skeletonFrame->getAllUsersId();
 
-            if (previousFrame + 1 != colorFrame->getIndex())
-                qDebug() << "Frame Skip" << colorFrame->getIndex();
+        if (colorFrame->getIndex() < resumeFrame || users.isEmpty() || metadataFrame->boundingBoxes().isEmpty())
+            continue;
 
-            qDebug() << "Processing frame" << colorFrame->getIndex();
+        shared_ptr<ConversionJob> job = make_shared<ConversionJob>();
+        job->instance = key;
+        job->frameIndex = colorFrame->getIndex();
+        job->name = key + "_F" + QString::number(colorFrame->getIndex());
+        job->color = colorFrame;
+        job->depth = static_pointer_cast<DepthFrame>(readFrames.value(DataFrame::Depth));
+        job->mask = static_pointer_cast<MaskFrame>(readFrames.value(DataFrame::Mask));
+        job->skeleton = skeletonFrame->getSkeleton(users.at(0));
+        job->roi << metadataFrame->boundingBoxes().first();
+        pipeline.push(job);
+    }
 
-            // Process
-            QList<int> users = skeletonFrame->getAllUsersId();
+    // Close Instances
+    for (shared_ptr<StreamInstance> instance : instances) {
+        instance->close();
+    }
 
-            // Work with the user inside of the Bounding Box
-            if (!users.isEmpty() && !metadataFrame->boundingBoxes().isEmpty() /*&& colorFrame->getIndex() > 140*/)
-            {
-                int firstUser = users.at(0);
-                shared_ptr<Skeleton> skeleton = skeletonFrame->getSkeleton(firstUser);
-
-                // Get ROIs
-                BoundingBox bb = metadataFrame->boundingBoxes().first();
-                shared_ptr<ColorFrame> roiColor = colorFrame->subFrame(bb);
-                shared_ptr<DepthFrame> roiDepth = depthFrame->subFrame(bb);
-                shared_ptr<MaskFrame> roiMask = maskFrame->subFrame(bb);
-
-                QString fileName = "U" + QString::number(instance_info->getActor()) +
-                                  "_C" + QString::number(instance_info->getCamera()) +
-                                  "_F" + QString::number(roiColor->getIndex());
-
-                // Show
-                cv::Mat color_mat(roiColor->height(), roiColor->width(), CV_8UC3,
-                                  (void*) roiColor->getDataPtr(), roiColor->getStride());
-
-                cv::imshow("img1", color_mat);
-                cv::waitKey(1);
-                QCoreApplication::processEvents();
-
-                // Save color as JPEG
-                QImage image( (uchar*) roiColor->getDataPtr(), roiColor->width(), roiColor->height(),
-                             roiColor->getStride(), QImage::Format_RGB888);
-                image.save("data/" + fileName + "_color.jpg");
-
-                // Save depth
-                /*cv::Mat depth_mat(roiDepth->height(), roiDepth->width(), CV_16UC1,
-                                  (uchar*) roiDepth->getDataPtr(), roiDepth->getStride());
-                cv::imwrite(QString("data/" + fileName + "_depth.png").toStdString(), depth_mat);*/
-                QFile depthFile("data/" + fileName + "_depth.bin");
-                QByteArray depth_data = roiDepth->toBinary();
-                depthFile.open(QIODevice::WriteOnly);
-                depthFile.write(depth_data);
-                depthFile.close();
-
-                // Save mask
-                QFile maskFile("data/" + fileName + "_mask.bin");
-                QByteArray mask_data = roiMask->toBinary();
-                maskFile.open(QIODevice::WriteOnly);
-                maskFile.write(mask_data);
-                maskFile.close();
-
-                // Save Skeleton
-                QFile file("data/" + fileName + "_skel.bin");
-                QByteArray skel_data = skeleton->toBinary();
-                file.open(QIODevice::WriteOnly);
-                file.write(skel_data);
-                file.close();
-            }
+    pipeline.endInstance(key);
+}
 
-            previousFrame = colorFrame->getIndex();
-        }
+void convertDAI4REIDOniToFiles(const QString& datasetPath, const QList<int>& actors, const QList<int>& cameras,
+                               const QString& outputPath, int decoders, int workers, float speed, bool codec)
+{
+    using namespace dai;
 
-        // Close Instances
-        for (shared_ptr<StreamInstance> instance : instances) {
-            instance->close();
-        }
+    shared_ptr<Dataset> dataset = make_shared<DAI4REID>();
+    dataset->setPath(datasetPath);
+    const DatasetMetadata& metadata = dataset->getMetadata();
+
+    ConversionPipeline pipeline(outputPath, decoders, workers, 2, 64);
+    pipeline.setFrameCodec(codec);
+
+    // Instances are decoded in parallel, each one in its own decoder
+    for (shared_ptr<InstanceInfo> instance_info : metadata.instances(actors, cameras, DatasetMetadata::ANY_LABEL))
+    {
+        pipeline.runDecoder([dataset, instance_info, &pipeline, speed]() {
+            decodeDAI4REIDInstance(dataset, instance_info, pipeline, speed);
+        });
     }
 
-    qDebug() << "Parse Finished!";
+    pipeline.waitForDone();
+
+    ConversionPipeline::Stats stats = pipeline.stats();
+    qDebug() << "Parse Finished!" << stats.framesWritten << "frames"
+             << stats.bytesWritten / (1024 * 1024) << "MB in" << stats.elapsedMs / 1000.0 << "s";
 }
 
+struct CompressResult {
+    qint64 bytesBefore = 0;
+    qint64 bytesAfter = 0;
+    bool failed = false;
+};
 
+/**
+ * Encode a depth or mask file with FrameCodec. IASLAB-RGBD-ID files (pgmHeader > 0) are
+ * read as IASLAB_RGBD_ID_Instance does. The result is decoded and compared with the frame.
+ */
+template <class Frame, class Pixel>
+static bool encodeFrameFile(const QByteArray& buffer, int pgmHeader, QByteArray* encoded)
+{
+    Frame frame, decoded;
+
+    if (pgmHeader > 0) {
+        if (buffer.size() < pgmHeader + 640 * 480 * int(sizeof(Pixel)))
+            return false;
+        Frame view(640, 480, (Pixel*) (buffer.constData() + pgmHeader));
+        frame = view;
+    }
+    else if (!dai::FrameCodec::load(buffer, frame)) {
+        return false;
+    }
+
+    *encoded = dai::FrameCodec::encode(frame, 1);
+    return dai::FrameCodec::decode(*encoded, decoded, 1) && decoded.toBinary() == frame.toBinary();
+}
+
+static CompressResult compressFrameFile(const QString& fileName)
+{
+    CompressResult result;
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.failed = true;
+        return result;
+    }
+
+    const QByteArray buffer = file.readAll();
+    file.close();
+    result.bytesBefore = result.bytesAfter = buffer.size();
+
+    if (dai::FrameCodec::isEncoded(buffer))
+        return result;
+
+    const bool pgm = fileName.endsWith(".pgm");
+    QByteArray encoded;
+    bool ok;
+
+    if (fileName.endsWith("_depth.bin") || fileName.endsWith("_depth.pgm"))
+        ok = encodeFrameFile<dai::DepthFrame, uint16_t>(buffer, pgm ? 16 : 0, &encoded);
+    else
+        ok = encodeFrameFile<dai::MaskFrame, uint8_t>(buffer, pgm ? 14 : 0, &encoded);
+
+    if (!ok) {
+        qDebug() << "Couldn't compress" << fileName;
+        result.failed = true;
+        return result;
+    }
+
+    // Files that don't get smaller are kept as they are
+    if (encoded.size() >= buffer.size())
+        return result;
+
+    QSaveFile output(fileName);
+
+    if (!output.open(QIODevice::WriteOnly) || output.write(encoded) != encoded.size() || !output.commit()) {
+        qDebug() << "Couldn't write" << fileName;
+        result.failed = true;
+        return result;
+    }
+
+    result.bytesAfter = encoded.size();
+    return result;
+}
+
+/**
+ * Rewrite in place the depth and mask files of a DAI4REID_Parsed or IASLAB-RGBD-ID folder
+ * with FrameCodec. The dataset readers accept both formats, so the XML descriptions are
+ * still valid.
+ */
+void compressDatasetFiles(const QString& datasetPath)
+{
+    QStringList fileNames;
+    QDirIterator it(datasetPath, {"*_depth.bin", "*_mask.bin", "*_depth.pgm", "*_userMap.pgm"},
+                    QDir::Files, QDirIterator::Subdirectories);
+
+    while (it.hasNext())
+        fileNames << it.next();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QList<CompressResult> results = QtConcurrent::blockingMapped<QList<CompressResult>>(fileNames, compressFrameFile);
+    qint64 before = 0, after = 0;
+    int failed = 0;
+
+    for (const CompressResult& result : results) {
+        before += result.bytesBefore;
+        after += result.bytesAfter;
+        failed += result.failed;
+    }
+
+    qDebug() << "Compress Finished!" << fileNames.size() << "files (" << failed << "failed )"
+             << before / (1024 * 1024) << "MB ->" << after / (1024 * 1024) << "MB in" << timer.elapsed() / 1000.0 << "s";
+}
+
+QList<int> parseIntList(const QString& value)
+{
+    QList<int> result;
+
+    for (const QString& item : value.split(",", QString::SkipEmptyParts)) {
+        result << item.trimmed().toInt();
+    }
+
+    return result;
+}
 
 int main(int argc, char *argv[])
 {
-    Q_UNUSED(argc);
     CoreLib_InitResources();
-    //parseMSRAction3D(argv[1]);
-    //parseCAVIAR4REID(argv[1]);
-    //parseDAI4REID(argv[1]);
-    //parseMSRAction3D_Quaternions(argv[1]);
-    parseIAS_LAB_RGBD_ID((argv[1]));
-}
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("DatasetParser");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Writes the XML description of a dataset to stdout or converts "
+                                     "DAI4REID captures into files");
+    parser.addHelpOption();
+    parser.addPositionalArgument("dataset", "ias-lab, dai4reid, caviar4reid, msraction3d, "
+                                            "msraction3d-quaternions, convert-dai4reid or compress");
+    parser.addPositionalArgument("path", "Dataset folder");
+    parser.addOptions({
+        {"actors", "Comma separated actors to convert (all by default)", "list"},
+        {"cameras", "Comma separated cameras to convert (all by default)", "list"},
+        {"output", "Output folder of the conversion", "folder", "data"},
+        {"decoders", "Instances decoded at the same time", "n", "2"},
+        {"workers", "Crop and encode threads", "n", QString::number(QThread::idealThreadCount())},
+        {"speed", "Playback speed of the ONI files, 0 reads them as fast as possible", "speed", "0"},
+        {"codec", "Write depth and masks with the lossless FrameCodec (convert-dai4reid)"}
+    });
+    parser.process(a);
+
+    const QStringList args = parser.positionalArguments();
+
+    if (args.size() != 2) {
+        parser.showHelp(1);
+    }
 
+    const QString dataset = args.at(0);
+    const QString path = args.at(1);
+
+    if (dataset == "ias-lab")
+        parseIAS_LAB_RGBD_ID(path);
+    else if (dataset == "dai4reid")
+        parseDAI4REID(path);
+    else if (dataset == "caviar4reid")
+        parseCAVIAR4REID(path);
+    else if (dataset == "msraction3d")
+        parseMSRAction3D(path);
+    else if (dataset == "msraction3d-quaternions")
+        parseMSRAction3D_Quaternions(path);
+    else if (dataset == "convert-dai4reid")
+        convertDAI4REIDOniToFiles(path, parseIntList(parser.value("actors")), parseIntList(parser.value("cameras")),
+                                  parser.value("output"), parser.value("decoders").toInt(),
+                                  parser.value("workers").toInt(), parser.value("speed").toFloat(),
+                                  parser.isSet("codec"));
+    else if (dataset == "compress")
+        compressDatasetFiles(path);
+    else {
+        qCritical() << "Unknown dataset" << dataset;
+        return 1;
+    }
+
+    return 0;
+}
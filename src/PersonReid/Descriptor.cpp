@@ -9,15 +9,23 @@ namespace dai {
 {
 }*/
 
+static int descriptorsOwner()
+{
+    static const int owner = MemoryTracker::registerOwner("PersonReid descriptors", MemoryTracker::OWNER_FEATURES);
+    return owner;
+}
+
 Descriptor::Descriptor(const InstanceInfo& label, int frameId)
+    : m_memory(descriptorsOwner())
 {
     m_label = label;
     m_frameId = frameId;
+    m_userId = 0;
 }
 
 bool Descriptor::operator==(const Descriptor& other) const
 {
-    return m_label == other.m_label && m_frameId == other.m_frameId;
+    return m_label == other.m_label && m_frameId == other.m_frameId && m_userId == other.m_userId;
 }
 
 float Descriptor::minDistanceParallel(const DescriptorPtr feature, const QList<DescriptorPtr>& samples)
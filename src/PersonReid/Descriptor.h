@@ -2,6 +2,7 @@
 #define DESCRIPTOR_H
 
 #include "dataset/InstanceInfo.h"
+#include "types/MemoryTracker.h"
 #include <memory>
 #include <QList>
 
@@ -15,6 +16,8 @@ class Descriptor
 protected:
     InstanceInfo m_label;
     int m_frameId;
+    int m_userId; // User of the frame the descriptor belongs to (0 = unknown)
+    MemoryCharge m_memory; // Data of the descriptor, charged to "PersonReid descriptors"
 
 public:
     static float minDistanceParallel(const DescriptorPtr feature, const QList<DescriptorPtr>& samples);
@@ -27,6 +30,8 @@ public:
     virtual bool operator==(const Descriptor& other) const;
     const InstanceInfo& label() const {return m_label;}
     int frameId() const {return m_frameId;}
+    int userId() const {return m_userId;}
+    void setUserId(int userId) {m_userId = userId;}
 };
 
 } // End Namespace
@@ -53,6 +53,7 @@ bool DistancesFeature::operator==(const Descriptor& other_desc) const
 void DistancesFeature::addDistance(float value)
 {
     m_distances << value;
+    m_memory.add(sizeof(float));
 }
 
 } // End Namespace
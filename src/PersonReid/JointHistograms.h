@@ -25,6 +25,7 @@ public:
     void addHistogram(const Histogram<T, N> &hist)
     {
          m_histograms.append(hist); // copy
+         m_memory.add(hist.sizeInBytes());
     }
 
     float distance(const Descriptor& other_desc) const override
@@ -20,7 +20,9 @@
 #include "DistancesFeature.h"
 #include "RegionDescriptor.h"
 #include "DescriptorSet.h"
+#include "SkeletonFeatures.h"
 #include <QtConcurrent>
+#include <algorithm>
 #include <cstdlib>
 
 namespace dai {
@@ -78,6 +80,12 @@ void PersonReid::execute()
     // Train cam1, Test cam2 and viceversa
     for (int i=0; i<2; ++i)
     {
+        // Skeleton-only version: only reads the skeletons (anthropometric distances)
+        if (m_skeletonDistances) {
+            validate_skeleton_distances(dataset, actors, i==0 ? 1 : 2, i==0 ? 2 : 1, results, &num_tests);
+            continue;
+        }
+
         // Training (camera 1)
         QMultiMap<int, DescriptorPtr> gallery = train(dataset, actors, i==0 ? 1 : 2);
 
@@ -97,7 +105,12 @@ void PersonReid::execute()
     QCoreApplication::instance()->quit();
 }
 
-DescriptorPtr PersonReid::computeFeature(Dataset* dataset, shared_ptr<InstanceInfo> instance_info)
+/**
+ * Features of every person of the sample. The first person is processed in this thread
+ * and the rest in parallel. Descriptors are tagged with the user id, so people of the
+ * same frame can be told apart.
+ */
+QList<DescriptorPtr> PersonReid::computeFeatures(Dataset* dataset, shared_ptr<InstanceInfo> instance_info)
 {
     // Get Sample
     shared_ptr<StreamInstance> instance = dataset->getInstance(*instance_info, DataFrame::Color);
@@ -114,21 +127,47 @@ DescriptorPtr PersonReid::computeFeature(Dataset* dataset, shared_ptr<InstanceIn
     auto depthFrame = static_pointer_cast<DepthFrame>(readFrames.value(DataFrame::Depth));
     auto maskFrame = static_pointer_cast<MaskFrame>(readFrames.value(DataFrame::Mask));
     auto skeletonFrame = static_pointer_cast<SkeletonFrame>(readFrames.value(DataFrame::Skeleton));
-    shared_ptr<Skeleton> skeleton = skeletonFrame->getSkeleton(skeletonFrame->getAllUsersId().at(0));
+    auto metadataFrame = static_pointer_cast<MetadataFrame>(readFrames.value(DataFrame::Metadata));
+
+    // Process (color and depth are only read, so they are shared by all of the users)
+    auto compute = [&](const UserSample& user) -> DescriptorPtr
+    {
+        if (!user.skeleton)
+            return nullptr;
+
+        //DescriptorPtr feature = feature_global_hist(*colorFrame, *user.mask, *instance_info);
+        DescriptorPtr feature = feature_joints_hist(*colorFrame, *depthFrame, *user.mask, *user.skeleton, *instance_info);
+        //DescriptorPtr feature = feature_region_descriptor(*colorFrame, *depthFrame, *user.mask, *user.skeleton, *instance_info);
+        //DescriptorPtr feature = feature_pointinterest_descriptor(*colorFrame, *user.mask, *instance_info);
+        //DescriptorPtr feature = feature_skeleton_distances(*colorFrame, *user.skeleton, *instance_info);
+        //DescriptorPtr feature = feature_joint_descriptor(*colorFrame, *depthFrame, *user.mask, *user.skeleton, *instance_info);
+        //DescriptorPtr feature = feature_fusion(*colorFrame, *depthFrame, *user.mask, *user.skeleton, *instance_info);
+
+        if (feature)
+            feature->setUserId(user.userId);
+
+        return feature;
+    };
+
+    QList<UserSample> users = splitUsers(*maskFrame, skeletonFrame.get(), metadataFrame.get());
+    QList<DescriptorPtr> features;
+    std::vector<QFuture<DescriptorPtr>> workers;
+
+    for (int i=1; i<users.size(); ++i)
+        workers.push_back( QtConcurrent::run(compute, users.at(i)) );
 
-    // Process
-    //DescriptorPtr feature = feature_global_hist(*colorFrame, *maskFrame, *instance_info);
-    DescriptorPtr feature = feature_joints_hist(*colorFrame, *depthFrame, *maskFrame, *skeleton, *instance_info);
-    //DescriptorPtr feature = feature_region_descriptor(*colorFrame, *depthFrame, *maskFrame, *skeleton, *instance_info);
-    //DescriptorPtr feature = feature_pointinterest_descriptor(*colorFrame, *maskFrame, *instance_info);
-    //DescriptorPtr feature = feature_skeleton_distances(*colorFrame, *skeleton, *instance_info);
-    //DescriptorPtr feature = feature_joint_descriptor(*colorFrame, *depthFrame, *maskFrame, *skeleton, *instance_info);
-    //DescriptorPtr feature = feature_fusion(*colorFrame, *depthFrame, *maskFrame, *skeleton, *instance_info);
+    if (!users.isEmpty())
+        features << compute(users.first());
+
+    for (QFuture<DescriptorPtr>& f : workers)
+        features << f.result();
+
+    features.removeAll(nullptr);
 
     // Close Instances
     instance->close();
 
-    return feature;
+    return features;
 }
 
 /**
@@ -174,27 +213,27 @@ QMultiMap<int, DescriptorPtr> PersonReid::train(Dataset* dataset, QList<int> act
         }*/
 
         // Parallel version
-        std::vector<QFuture<DescriptorPtr>> workers;
+        std::vector<QFuture<QList<DescriptorPtr>>> workers;
 
         //int i = 0;
         for (shared_ptr<InstanceInfo> instance_info : instances) {
             //if (i % 2 == 0)
-                workers.push_back( QtConcurrent::run(this, &PersonReid::computeFeature, dataset, instance_info) );
+                workers.push_back( QtConcurrent::run(this, &PersonReid::computeFeatures, dataset, instance_info) );
             //i++;
         }
 
-        for (QFuture<DescriptorPtr>& f : workers) {
-
-            DescriptorPtr feature = f.result();
+        for (QFuture<QList<DescriptorPtr>>& f : workers) {
 
-            if (feature) {
+            // Every person of the sample is added to the gallery
+            for (DescriptorPtr feature : f.result()) {
                 gallery.insert(feature->label().getActor(), feature);
                 samples_processed++;
-            }
 
-            // Show
-            //show_images(colorFrame, maskFrame, depthFrame, skeleton);
-            qDebug("actor %i sample %i fps %f", feature->label().getActor(), feature->label().getSample(), float(samples_processed )/ timer.elapsed() * 1000.0f);
+                // Show
+                //show_images(colorFrame, maskFrame, depthFrame, skeleton);
+                qDebug("actor %i sample %i user %i fps %f", feature->label().getActor(), feature->label().getSample(),
+                       feature->userId(), float(samples_processed )/ timer.elapsed() * 1000.0f);
+            }
         }
 
         qDebug() << "Gallery size" << gallery.size();
@@ -207,19 +246,18 @@ void PersonReid::validate(Dataset* dataset, const QList<int> &actors, int camera
 {
     const DatasetMetadata& metadata = dataset->getMetadata();
     QList<shared_ptr<InstanceInfo>> instances = metadata.instances(actors, {camera}, DatasetMetadata::ANY_LABEL);
-    std::vector<QFuture<DescriptorPtr>> workers;
+    std::vector<QFuture<QList<DescriptorPtr>>> workers;
     int total_tests = 0;
 
     // Start validation
     for (shared_ptr<InstanceInfo> instance_info : instances) {
-        workers.push_back( QtConcurrent::run(this, &PersonReid::computeFeature, dataset, instance_info) );
+        workers.push_back( QtConcurrent::run(this, &PersonReid::computeFeatures, dataset, instance_info) );
     }
 
-    for (QFuture<DescriptorPtr>& f : workers) {
+    for (QFuture<QList<DescriptorPtr>>& f : workers) {
 
-        DescriptorPtr query = f.result();
-
-        if (query) {
+        // Every person of the sample is a query
+        for (DescriptorPtr query : f.result()) {
             // CMC: Build ranking
             QMap<float, int> query_results; // distance, actor
 
@@ -232,7 +270,8 @@ void PersonReid::validate(Dataset* dataset, const QList<int> &actors, int camera
 
             int pos = cummulative_match_curve(query_results, results, query->label().getActor());
             std::string fileName = query->label().getFileName(DataFrame::Color).toStdString();
-            qDebug("Results for actor %i sample %i file %s (pos=%i)", query->label().getActor(), query->label().getSample(), fileName.c_str(), pos+1);
+            qDebug("Results for actor %i sample %i user %i file %s (pos=%i)", query->label().getActor(), query->label().getSample(),
+                   query->userId(), fileName.c_str(), pos+1);
             print_query_results(query_results, pos);
             qDebug() << "--------------------------";
             total_tests++;
@@ -244,6 +283,62 @@ void PersonReid::validate(Dataset* dataset, const QList<int> &actors, int camera
     }
 }
 
+/**
+ * Re-identification using only the anthropometric distances of the skeletons. The skeletons
+ * of both cameras are read in parallel and matched at once, so it takes a few seconds for
+ * the whole dataset.
+ *
+ * @brief PersonReid::validate_skeleton_distances
+ */
+void PersonReid::validate_skeleton_distances(Dataset* dataset, const QList<int> &actors, int gallery_camera, int query_camera, QVector<float>& results, int *num_tests)
+{
+    const DatasetMetadata& metadata = dataset->getMetadata();
+    QElapsedTimer timer;
+    timer.start();
+
+    SkeletonFeatures gallery = SkeletonFeatures::compute(dataset, metadata.instances(actors, {gallery_camera}, DatasetMetadata::ANY_LABEL));
+    SkeletonFeatures queries = SkeletonFeatures::compute(dataset, metadata.instances(actors, {query_camera}, DatasetMetadata::ANY_LABEL));
+    cv::Mat distances = SkeletonFeatures::distances(queries.matrix(), gallery.matrix());
+
+    qDebug() << "Skeletons" << gallery.size() << "(gallery)" << queries.size() << "(queries)"
+             << "computed and matched in" << timer.elapsed() << "ms";
+
+    int total_tests = 0;
+
+    for (int i=0; i<distances.rows; ++i)
+    {
+        // Distance to the nearest sample of every actor
+        const float* row = distances.ptr<float>(i);
+        QMap<int, float> actor_distances;
+
+        for (int j=0; j<distances.cols; ++j) {
+            const int actor = gallery.actors().at(j);
+            auto it = actor_distances.find(actor);
+            if (it == actor_distances.end() || row[j] < it.value())
+                actor_distances.insert(actor, row[j]);
+        }
+
+        const int label = queries.actors().at(i);
+
+        if (!actor_distances.contains(label))
+            continue;
+
+        // CMC: Build ranking
+        QMap<float, int> query_results; // distance, actor
+
+        for (auto it = actor_distances.constBegin(); it != actor_distances.constEnd(); ++it) {
+            query_results.insertMulti(it.value(), it.key());
+        }
+
+        cummulative_match_curve(query_results, results, label);
+        total_tests++;
+    }
+
+    if (num_tests) {
+        *num_tests += total_tests;
+    }
+}
+
 void PersonReid::show_images(shared_ptr<ColorFrame> colorFrame, shared_ptr<MaskFrame> maskFrame, shared_ptr<DepthFrame> depthFrame, shared_ptr<Skeleton> skeleton)
 {
     Q_UNUSED(depthFrame);
@@ -727,18 +822,14 @@ DescriptorPtr PersonReid::feature_2parts_hist(shared_ptr<ColorFrame> colorFrame,
     cv::Mat inputImg(colorFrame->height(), colorFrame->width(),
                  CV_8UC3, (void*)colorFrame->getDataPtr(), colorFrame->getStride());
 
+    // Masks and histograms of the upper (torso) and lower (leggs) parts with a Color Palette
+    // of 8-8-4 levels, computed in one pass
     cv::Mat upper_mask, lower_mask;
-    dai::computeUpperAndLowerMasks(inputImg, upper_mask, lower_mask);
-
-    // Color Palette with 16-16-16 levels
-    //cv::Mat indexedImg = dai::convertRGB2Indexed161616(inputImg);
-
-    // Color Palette with 8-8-4 levels
-    cv::Mat indexedImg = dai::convertRGB2Indexed884(inputImg);
+    int upper_bins[256], lower_bins[256];
+    dai::computeUpperAndLowerHist884(inputImg, upper_mask, lower_mask, upper_bins, lower_bins);
 
-    // Compute the histogram for the upper (torso) and lower (leggs) parts of each frame in the buffer
-    auto u_hist = Histogram1c::create(indexedImg, {0, 255}, upper_mask);
-    auto l_hist = Histogram1c::create(indexedImg, {0, 255}, lower_mask);
+    auto u_hist = Histogram1c::createFromBins(upper_bins, 256, {0, 255});
+    auto l_hist = Histogram1c::createFromBins(lower_bins, 256, {0, 255});
 
     dai::colorImageWithMask(inputImg, inputImg, upper_mask, lower_mask);
 
@@ -762,21 +853,21 @@ DescriptorPtr PersonReid::feature_skeleton_distances(ColorFrame &colorFrame, Ske
 {
     shared_ptr<DistancesFeature> feature = make_shared<DistancesFeature>(instance_info, colorFrame.getIndex());
 
-    SkeletonJoint spine = skeleton.getJoint(SkeletonJoint::JOINT_SPINE);
-    SkeletonJoint knee_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_KNEE);
-    SkeletonJoint foot_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_FOOT);
-    SkeletonJoint foot_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_FOOT);
-    SkeletonJoint knee_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_KNEE);
-    SkeletonJoint hip_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_HIP);
-    SkeletonJoint hip_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_HIP);
-    SkeletonJoint neck = skeleton.getJoint(SkeletonJoint::JOINT_CENTER_SHOULDER);
-    SkeletonJoint head =  skeleton.getJoint(SkeletonJoint::JOINT_HEAD);
-    SkeletonJoint shoulder_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_SHOULDER);
-    SkeletonJoint shoulder_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_SHOULDER);
-    SkeletonJoint elbow_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_ELBOW);
-    SkeletonJoint elbow_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_ELBOW);
-    SkeletonJoint hand_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_HAND);
-    SkeletonJoint hand_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_HAND);
+    const SkeletonJoint& spine = skeleton.getJoint(SkeletonJoint::JOINT_SPINE);
+    const SkeletonJoint& knee_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_KNEE);
+    const SkeletonJoint& foot_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_FOOT);
+    const SkeletonJoint& foot_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_FOOT);
+    const SkeletonJoint& knee_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_KNEE);
+    const SkeletonJoint& hip_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_HIP);
+    const SkeletonJoint& hip_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_HIP);
+    const SkeletonJoint& neck = skeleton.getJoint(SkeletonJoint::JOINT_CENTER_SHOULDER);
+    const SkeletonJoint& head = skeleton.getJoint(SkeletonJoint::JOINT_HEAD);
+    const SkeletonJoint& shoulder_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_SHOULDER);
+    const SkeletonJoint& shoulder_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_SHOULDER);
+    const SkeletonJoint& elbow_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_ELBOW);
+    const SkeletonJoint& elbow_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_ELBOW);
+    const SkeletonJoint& hand_left = skeleton.getJoint(SkeletonJoint::JOINT_LEFT_HAND);
+    const SkeletonJoint& hand_right = skeleton.getJoint(SkeletonJoint::JOINT_RIGHT_HAND);
 
     // Hip center
     Point3f base_line = Point3f::vector(hip_left.getPosition(), hip_right.getPosition());
@@ -794,7 +885,7 @@ DescriptorPtr PersonReid::feature_skeleton_distances(ColorFrame &colorFrame, Ske
         }
     }*/
 
-    // Padilla
+    // Padilla (SkeletonFeatures::computeBatch computes the same distances for many skeletons)
     // hip-head
     feature->addDistance(Point3f::euclideanDistance(hip_center, head.getPosition()));
 
@@ -881,6 +972,117 @@ DescriptorPtr PersonReid::feature_skeleton_distances(ColorFrame &colorFrame, Ske
     return feature;
 }
 
+/**
+ * Split a frame in its users. Each bounding box of the metadata frame is paired with the
+ * mask label that covers most of it. Without metadata, every label of the mask is a user.
+ * The mask of each user only keeps its own pixels, so features don't mix people.
+ *
+ * When there is only one user and one skeleton they are paired even if the mask label
+ * and the skeleton id don't match (datasets with binary masks).
+ */
+QList<UserSample> PersonReid::splitUsers(const MaskFrame& maskFrame, const SkeletonFrame* skeletonFrame,
+                                         MetadataFrame* metadataFrame)
+{
+    const int width = maskFrame.width();
+    const int height = maskFrame.height();
+    const QList<int> skeletonUsers = skeletonFrame ? skeletonFrame->getAllUsersId() : QList<int>();
+
+    // Bounds of each label (255 is the border added by the privacy filters, not a user)
+    int count[256] = {0};
+    int minX[256], minY[256], maxX[256], maxY[256];
+
+    for (int i=0; i<height; ++i)
+    {
+        const uint8_t* mask = maskFrame.getRowPtr(i);
+
+        for (int j=0; j<width; ++j)
+        {
+            const uint8_t label = mask[j];
+
+            if (count[label]++ == 0) {
+                minX[label] = maxX[label] = j;
+                minY[label] = maxY[label] = i;
+            } else {
+                minX[label] = qMin(minX[label], j);
+                maxX[label] = qMax(maxX[label], j);
+                maxY[label] = i;
+            }
+        }
+    }
+
+    count[0] = count[255] = 0;
+
+    // Pair users and boxes
+    QList<QPair<int, BoundingBox>> users;
+
+    if (metadataFrame && !metadataFrame->boundingBoxes().isEmpty())
+    {
+        for (const BoundingBox& box : metadataFrame->boundingBoxes())
+        {
+            const int x1 = qMax(0, int(box.getMin().val(0)));
+            const int y1 = qMax(0, int(box.getMin().val(1)));
+            const int x2 = qMin(width, int(box.getMax().val(0)));
+            const int y2 = qMin(height, int(box.getMax().val(1)));
+            int boxCount[256] = {0};
+
+            for (int i=y1; i<y2; ++i) {
+                const uint8_t* mask = maskFrame.getRowPtr(i);
+                for (int j=x1; j<x2; ++j)
+                    boxCount[mask[j]]++;
+            }
+
+            boxCount[0] = boxCount[255] = 0;
+            const int label = int(std::max_element(boxCount, boxCount + 256) - boxCount);
+            bool used = false;
+
+            for (const auto& user : users)
+                used |= user.first == label;
+
+            if (boxCount[label] > 0 && !used)
+                users << qMakePair(label, box);
+        }
+    }
+    else
+    {
+        for (int label=1; label<255; ++label) {
+            if (count[label] > 0) {
+                users << qMakePair(label, BoundingBox(Point3f(minX[label], minY[label], 0),
+                                                      Point3f(maxX[label] + 1, maxY[label] + 1, 0)));
+            }
+        }
+    }
+
+    // Mask and skeleton of each user
+    QList<UserSample> result;
+
+    for (const auto& user : users)
+    {
+        const int label = user.first;
+        int userId = label;
+        shared_ptr<MaskFrame> mask = make_shared<MaskFrame>(width, height);
+        mask->setIndex(maskFrame.getIndex());
+        mask->setOffset(maskFrame.offset());
+
+        for (int i=minY[label]; i<=maxY[label]; ++i) {
+            const uint8_t* src = maskFrame.getRowPtr(i);
+            uint8_t* dst = mask->getRowPtr(i);
+            for (int j=minX[label]; j<=maxX[label]; ++j)
+                dst[j] = src[j] == label ? label : 0;
+        }
+
+        shared_ptr<Skeleton> skeleton = skeletonFrame ? skeletonFrame->getSkeleton(label) : nullptr;
+
+        if (!skeleton && skeletonUsers.size() == 1 && users.size() == 1) {
+            userId = skeletonUsers.first();
+            skeleton = skeletonFrame->getSkeleton(userId);
+        }
+
+        result << UserSample{userId, user.second, mask, skeleton};
+    }
+
+    return result;
+}
+
 QHashDataFrames PersonReid::allocateMemory() const
 {
     QHashDataFrames container;
@@ -893,11 +1095,61 @@ QHashDataFrames PersonReid::allocateMemory() const
 }
 
 // Extract Voronoi cells as a mask
+/**
+ * Joints of a skeleton packed in arrays, so the closest joint of every pixel is found
+ * without copying joints or allocating.
+ */
+struct PackedJoints
+{
+    float x[MAX_JOINTS];
+    float y[MAX_JOINTS];
+    float z[MAX_JOINTS];
+    uint8_t label[MAX_JOINTS];
+    int count;
+
+    explicit PackedJoints(const Skeleton& skeleton)
+        : count(0)
+    {
+        const Skeleton::JointPositions& positions = skeleton.positions();
+
+        for (int i=0; i<MAX_JOINTS; ++i) {
+            if (skeleton.jointsMask() & (Q_UINT64_C(1) << i)) {
+                x[count] = positions.x[i];
+                y[count] = positions.y[i];
+                z[count] = positions.z[i];
+                // 0 means no user, and joint type starts at 0, so I increase it by one
+                label[count] = skeleton.getJoint((SkeletonJoint::JointType) i).getType() + 1;
+                count++;
+            }
+        }
+    }
+
+    uint8_t closerLabel(float px, float py, float pz) const
+    {
+        uint8_t result = SkeletonJoint::JOINT_HEAD + 1;
+        float minDistance = numeric_limits<float>::max();
+
+        for (int i=0; i<count; ++i) {
+            const float dx = x[i] - px;
+            const float dy = y[i] - py;
+            const float dz = z[i] - pz;
+            const float distance = dx*dx + dy*dy + dz*dz;
+
+            if (distance < minDistance) {
+                minDistance = distance;
+                result = label[i];
+            }
+        }
+
+        return result;
+    }
+};
+
 shared_ptr<MaskFrame> PersonReid::getVoronoiCells(const DepthFrame& depthFrame, const MaskFrame& maskFrame, const Skeleton& skeleton)
 {
     Q_ASSERT(depthFrame.width() == maskFrame.width() && depthFrame.height() == maskFrame.height());
     shared_ptr<MaskFrame> result = static_pointer_cast<MaskFrame>(maskFrame.clone());   
-    QList<SkeletonJoint> joints = skeleton.joints();
+    const PackedJoints joints(skeleton);
 
     for (int i=0; i<depthFrame.height(); ++i)
     {
@@ -910,8 +1162,7 @@ shared_ptr<MaskFrame> PersonReid::getVoronoiCells(const DepthFrame& depthFrame,
             {
                 Point3f point(0.0f, 0.0f, float(depth[j]));
                 depthFrame.convertCoordinatesToWorld(j, i, depth[j], &point[0], &point[1]);
-                SkeletonJoint closerJoint = getCloserJoint(point, joints);
-                mask[j] = closerJoint.getType()+1; // 0 means no user, and joint type starts at 0, so I increase it by one
+                mask[j] = joints.closerLabel(point[0], point[1], point[2]);
             }
         }
     }
@@ -927,9 +1178,9 @@ shared_ptr<MaskFrame> PersonReid::getVoronoiCellsParallel(const DepthFrame& dept
     //timer.start();
 
     shared_ptr<MaskFrame> output_mask = static_pointer_cast<MaskFrame>(maskFrame.clone());
-    QList<SkeletonJoint> joints = skeleton.joints();
+    const PackedJoints joints(skeleton);
 
-    auto code = [depthFrame, joints, &output_mask](int row) -> void
+    auto code = [&depthFrame, &joints, &output_mask](int row) -> void
     {
         uint16_t* depth = depthFrame.getRowPtr(row);
         uint8_t* mask = output_mask->getRowPtr(row);
@@ -940,8 +1191,7 @@ shared_ptr<MaskFrame> PersonReid::getVoronoiCellsParallel(const DepthFrame& dept
             {
                 Point3f point(0.0f, 0.0f, float(depth[j]));
                 depthFrame.convertCoordinatesToWorld(j, row, depth[j], &point[0], &point[1]);
-                SkeletonJoint closerJoint = PersonReid::getCloserJoint(point, joints);
-                mask[j] = closerJoint.getType()+1;
+                mask[j] = joints.closerLabel(point[0], point[1], point[2]);
             }
         }
     };
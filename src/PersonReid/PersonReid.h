@@ -7,22 +7,39 @@
 #include "types/ColorFrame.h"
 #include "types/MaskFrame.h"
 #include "types/SkeletonFrame.h"
+#include "types/MetadataFrame.h"
 #include "openni/OpenNIDevice.h"
 #include "opencv2/features2d/features2d.hpp"
 
 namespace dai {
 
+/**
+ * One person of a frame. Frames may show several people, each of them is an independent
+ * sample for the features.
+ */
+struct UserSample
+{
+    int userId;
+    BoundingBox box;                // Region of the user in the frame
+    shared_ptr<MaskFrame> mask;     // Only the pixels of this user
+    shared_ptr<Skeleton> skeleton;  // nullptr if the user has no skeleton
+};
+
 class PersonReid : public QObject
 {
     Q_OBJECT
 
 public:
+    // Validate with the anthropometric distances of the skeletons instead of the gallery features
+    void setSkeletonDistances(bool enabled) {m_skeletonDistances = enabled;}
+
     // Training and Testing
     QMultiMap<int, DescriptorPtr> train(Dataset *dataset, QList<int> actors, int camera);
     void validate(Dataset* dataset, const QList<int> &actors, int camera, const QMultiMap<int, DescriptorPtr>& gallery, QVector<float>& results, int *num_tests);
+    void validate_skeleton_distances(Dataset* dataset, const QList<int> &actors, int gallery_camera, int query_camera, QVector<float>& results, int *num_tests);
 
     // Features
-    DescriptorPtr computeFeature(Dataset *dataset, shared_ptr<InstanceInfo> instance_info);
+    QList<DescriptorPtr> computeFeatures(Dataset *dataset, shared_ptr<InstanceInfo> instance_info);
 
     DescriptorPtr feature_2parts_hist(shared_ptr<ColorFrame> colorFrame, const InstanceInfo& instance_info) const;
 
@@ -45,6 +62,8 @@ public:
     DescriptorPtr feature_skeleton_distances(ColorFrame &colorFrame, Skeleton &skeleton, const InstanceInfo& instance_info) const;
 
     // Utils
+    static QList<UserSample> splitUsers(const MaskFrame& maskFrame, const SkeletonFrame* skeletonFrame,
+                                        MetadataFrame* metadataFrame);
     static void makeUpJoints(Skeleton& skeleton, bool only_middle_points = false);
     static void makeUpOnlySomeJoints(Skeleton& skeleton);
     cv::KeyPoint createKeyPoint(const SkeletonJoint& joint, const Skeleton &skeleton, shared_ptr<MaskFrame> voronoi) const;
@@ -73,6 +92,7 @@ private:
     void drawPoint(ColorFrame &colorFrame, int x, int y, RGBColor color = {255, 0, 0}) const;
 
     OpenNIDevice* m_device;
+    bool m_skeletonDistances = false;
 };
 
 } // End Namespace
@@ -21,6 +21,7 @@ HEADERS += \
     DistancesFeature.h \
     RegionDescriptor.h \
     DescriptorSet.h \
+    SkeletonFeatures.h \
     tests.h
 
 SOURCES += main.cpp \
@@ -29,6 +30,7 @@ SOURCES += main.cpp \
     DistancesFeature.cpp \
     RegionDescriptor.cpp \
     DescriptorSet.cpp \
+    SkeletonFeatures.cpp \
     tests.cpp
 
 
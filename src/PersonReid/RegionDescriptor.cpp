@@ -81,6 +81,7 @@ bool RegionDescriptor::operator==(const Descriptor& other) const
 void RegionDescriptor::addDescriptor(const cv::Mat& descriptor)
 {
     m_descriptors << descriptor;
+    m_memory.add(descriptor.total() * descriptor.elemSize());
 }
 
 } // End Namespace
@@ -0,0 +1,265 @@
+#include "SkeletonFeatures.h"
+#include "types/SkeletonFrame.h"
+#include "exceptions/CannotOpenInstanceException.h"
+#include <QtConcurrent>
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+
+namespace dai {
+
+const SkeletonJoint::JointType SkeletonBatch::_joints[JOINTS_COUNT] = {
+    SkeletonJoint::JOINT_HEAD,
+    SkeletonJoint::JOINT_CENTER_SHOULDER,
+    SkeletonJoint::JOINT_LEFT_SHOULDER,
+    SkeletonJoint::JOINT_RIGHT_SHOULDER,
+    SkeletonJoint::JOINT_LEFT_ELBOW,
+    SkeletonJoint::JOINT_RIGHT_ELBOW,
+    SkeletonJoint::JOINT_LEFT_HAND,
+    SkeletonJoint::JOINT_RIGHT_HAND,
+    SkeletonJoint::JOINT_LEFT_HIP,
+    SkeletonJoint::JOINT_RIGHT_HIP,
+    SkeletonJoint::JOINT_LEFT_KNEE,
+    SkeletonJoint::JOINT_RIGHT_KNEE,
+    SkeletonJoint::JOINT_LEFT_FOOT,
+    SkeletonJoint::JOINT_RIGHT_FOOT
+};
+
+void SkeletonBatch::append(const Skeleton& skeleton, int actor)
+{
+    const Skeleton::JointPositions& positions = skeleton.positions();
+
+    for (int i=0; i<JOINTS_COUNT; ++i) {
+        const int joint = _joints[i];
+        m_x[i] << positions.x[joint];
+        m_y[i] << positions.y[joint];
+        m_z[i] << positions.z[joint];
+    }
+
+    m_actors << actor;
+}
+
+void SkeletonBatch::append(const SkeletonBatch& other)
+{
+    for (int i=0; i<JOINTS_COUNT; ++i) {
+        m_x[i] << other.m_x[i];
+        m_y[i] << other.m_y[i];
+        m_z[i] << other.m_z[i];
+    }
+
+    m_actors << other.m_actors;
+}
+
+void SkeletonBatch::reserve(int size)
+{
+    for (int i=0; i<JOINTS_COUNT; ++i) {
+        m_x[i].reserve(size);
+        m_y[i].reserve(size);
+        m_z[i].reserve(size);
+    }
+
+    m_actors.reserve(size);
+}
+
+// Kernels over the whole batch. They only touch contiguous arrays so the compiler can
+// vectorise them.
+static void jointDistances(const SkeletonBatch& batch, SkeletonBatch::BatchJoint joint1, SkeletonBatch::BatchJoint joint2, float* output)
+{
+    const float* x1 = batch.x(joint1);
+    const float* y1 = batch.y(joint1);
+    const float* z1 = batch.z(joint1);
+    const float* x2 = batch.x(joint2);
+    const float* y2 = batch.y(joint2);
+    const float* z2 = batch.z(joint2);
+    const int n = batch.size();
+
+    for (int i=0; i<n; ++i) {
+        const float dx = x2[i] - x1[i];
+        const float dy = y2[i] - y1[i];
+        const float dz = z2[i] - z1[i];
+        output[i] = std::sqrt(dx*dx + dy*dy + dz*dz);
+    }
+}
+
+static void ratios(const float* numerator, const float* denominator, int n, float* output)
+{
+    for (int i=0; i<n; ++i)
+        output[i] = numerator[i] / denominator[i];
+}
+
+SkeletonFeatures SkeletonFeatures::compute(Dataset* dataset, const QList<shared_ptr<InstanceInfo>>& instances)
+{
+    // Read the skeletons of every instance in the global thread pool
+    std::vector<QFuture<SkeletonBatch>> workers;
+    workers.reserve(instances.size());
+
+    for (shared_ptr<InstanceInfo> instance_info : instances) {
+        workers.push_back( QtConcurrent::run(&SkeletonFeatures::readSkeletons, dataset, instance_info) );
+    }
+
+    SkeletonBatch batch;
+
+    for (QFuture<SkeletonBatch>& f : workers) {
+        batch.append(f.result());
+    }
+
+    // Compute the features of all of them at once
+    SkeletonFeatures result;
+    cv::Mat features;
+    computeBatch(batch, features);
+    cv::transpose(features, result.m_matrix);
+    result.m_actors = batch.actors();
+
+    static const int owner = MemoryTracker::registerOwner("PersonReid features", MemoryTracker::OWNER_FEATURES);
+    result.m_memory = MemoryCharge(owner);
+    result.m_memory.set(result.m_matrix.total() * result.m_matrix.elemSize() + result.m_actors.size() * sizeof(int));
+
+    return result;
+}
+
+/**
+ * Same distances and order than PersonReid::feature_skeleton_distances (Padilla).
+ *
+ * @brief SkeletonFeatures::computeBatch
+ * @param batch
+ * @param output
+ */
+void SkeletonFeatures::computeBatch(const SkeletonBatch& batch, cv::Mat& output)
+{
+    const int n = batch.size();
+    output.create(DIMENSIONS, n, CV_32F);
+
+    if (n == 0)
+        return;
+
+    // Scratch rows: hip center (x, y, z) and the limbs used in the ratios
+    cv::Mat scratch(8, n, CV_32F);
+    float* hip_center_x = scratch.ptr<float>(0);
+    float* hip_center_y = scratch.ptr<float>(1);
+    float* hip_center_z = scratch.ptr<float>(2);
+    float* upper_leg = scratch.ptr<float>(3);
+    float* lower_leg = scratch.ptr<float>(4);
+    float* upper_arm = scratch.ptr<float>(5);
+    float* lower_arm = scratch.ptr<float>(6);
+    float* shoulders = scratch.ptr<float>(7);
+
+    // Hip center
+    const float* hip_left_x = batch.x(SkeletonBatch::LEFT_HIP);
+    const float* hip_left_y = batch.y(SkeletonBatch::LEFT_HIP);
+    const float* hip_left_z = batch.z(SkeletonBatch::LEFT_HIP);
+    const float* hip_right_x = batch.x(SkeletonBatch::RIGHT_HIP);
+    const float* hip_right_y = batch.y(SkeletonBatch::RIGHT_HIP);
+    const float* hip_right_z = batch.z(SkeletonBatch::RIGHT_HIP);
+
+    for (int i=0; i<n; ++i) {
+        hip_center_x[i] = hip_left_x[i] + (hip_right_x[i] - hip_left_x[i]) / 2;
+        hip_center_y[i] = hip_left_y[i] + (hip_right_y[i] - hip_left_y[i]) / 2;
+        hip_center_z[i] = hip_left_z[i] + (hip_right_z[i] - hip_left_z[i]) / 2;
+    }
+
+    // hip-head
+    const float* head_x = batch.x(SkeletonBatch::HEAD);
+    const float* head_y = batch.y(SkeletonBatch::HEAD);
+    const float* head_z = batch.z(SkeletonBatch::HEAD);
+    float* out = output.ptr<float>(0);
+
+    for (int i=0; i<n; ++i) {
+        const float dx = head_x[i] - hip_center_x[i];
+        const float dy = head_y[i] - hip_center_y[i];
+        const float dz = head_z[i] - hip_center_z[i];
+        out[i] = std::sqrt(dx*dx + dy*dy + dz*dz);
+    }
+
+    // neck-head
+    jointDistances(batch, SkeletonBatch::NECK, SkeletonBatch::HEAD, output.ptr<float>(1));
+
+    // Hips
+    float* hips = output.ptr<float>(2);
+    jointDistances(batch, SkeletonBatch::LEFT_HIP, SkeletonBatch::RIGHT_HIP, hips);
+
+    // l.hip-r.shoulder, r.hip-l.shoulder
+    jointDistances(batch, SkeletonBatch::LEFT_HIP, SkeletonBatch::RIGHT_SHOULDER, output.ptr<float>(3));
+    jointDistances(batch, SkeletonBatch::RIGHT_HIP, SkeletonBatch::LEFT_SHOULDER, output.ptr<float>(4));
+
+    // Head
+    memcpy(output.ptr<float>(5), head_y, n * sizeof(float));
+
+    // neck-l.shoulder, neck-r.shoulder
+    jointDistances(batch, SkeletonBatch::NECK, SkeletonBatch::LEFT_SHOULDER, output.ptr<float>(6));
+    jointDistances(batch, SkeletonBatch::NECK, SkeletonBatch::RIGHT_SHOULDER, output.ptr<float>(7));
+
+    // l.shoulder-l.hip, r.shoulder-r.hip
+    jointDistances(batch, SkeletonBatch::LEFT_SHOULDER, SkeletonBatch::LEFT_HIP, output.ptr<float>(8));
+    jointDistances(batch, SkeletonBatch::RIGHT_SHOULDER, SkeletonBatch::RIGHT_HIP, output.ptr<float>(9));
+
+    // legs
+    jointDistances(batch, SkeletonBatch::RIGHT_KNEE, SkeletonBatch::RIGHT_HIP, upper_leg);
+    jointDistances(batch, SkeletonBatch::RIGHT_FOOT, SkeletonBatch::RIGHT_KNEE, lower_leg);
+    ratios(upper_leg, lower_leg, n, output.ptr<float>(10));
+    jointDistances(batch, SkeletonBatch::LEFT_KNEE, SkeletonBatch::LEFT_HIP, upper_leg);
+    jointDistances(batch, SkeletonBatch::LEFT_FOOT, SkeletonBatch::LEFT_KNEE, lower_leg);
+    ratios(upper_leg, lower_leg, n, output.ptr<float>(11));
+
+    // arms
+    jointDistances(batch, SkeletonBatch::RIGHT_ELBOW, SkeletonBatch::RIGHT_SHOULDER, upper_arm);
+    jointDistances(batch, SkeletonBatch::RIGHT_HAND, SkeletonBatch::RIGHT_ELBOW, lower_arm);
+    ratios(upper_arm, lower_arm, n, output.ptr<float>(12));
+    jointDistances(batch, SkeletonBatch::LEFT_ELBOW, SkeletonBatch::LEFT_SHOULDER, upper_arm);
+    jointDistances(batch, SkeletonBatch::LEFT_HAND, SkeletonBatch::LEFT_ELBOW, lower_arm);
+    ratios(upper_arm, lower_arm, n, output.ptr<float>(13));
+
+    // corpulencia
+    jointDistances(batch, SkeletonBatch::LEFT_SHOULDER, SkeletonBatch::RIGHT_SHOULDER, shoulders);
+    ratios(shoulders, hips, n, output.ptr<float>(14));
+}
+
+cv::Mat SkeletonFeatures::distances(const cv::Mat& queries, const cv::Mat& gallery)
+{
+    cv::Mat result;
+
+    if (queries.empty() || gallery.empty())
+        return result;
+
+    cv::batchDistance(queries, gallery, result, CV_32F, cv::noArray(), cv::NORM_L1);
+    result /= queries.cols;
+
+    return result;
+}
+
+SkeletonBatch SkeletonFeatures::readSkeletons(Dataset* dataset, shared_ptr<InstanceInfo> instance_info)
+{
+    SkeletonBatch batch;
+    shared_ptr<StreamInstance> instance = dataset->getInstance(*instance_info, DataFrame::Skeleton);
+
+    if (!instance) {
+        qDebug() << "The dataset has no skeletons for" << instance_info->getFileName(DataFrame::Skeleton);
+        return batch;
+    }
+
+    try {
+        instance->open();
+    }
+    catch (CannotOpenInstanceException ex) {
+        qDebug() << "Cannot open" << instance_info->getFileName(DataFrame::Skeleton);
+        return batch;
+    }
+
+    QHashDataFrames readFrames;
+    readFrames.insert(DataFrame::Skeleton, make_shared<SkeletonFrame>());
+
+    while (instance->hasNext())
+    {
+        instance->readNextFrame(readFrames);
+        auto skeletonFrame = static_pointer_cast<SkeletonFrame>(readFrames.value(DataFrame::Skeleton));
+        int userId = skeletonFrame->firstUserId();
+
+        if (userId > 0)
+            batch.append(*skeletonFrame->getSkeleton(userId), instance_info->getActor());
+    }
+
+    instance->close();
+
+    return batch;
+}
+
+} // End Namespace
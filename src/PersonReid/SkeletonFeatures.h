@@ -0,0 +1,100 @@
+#ifndef SKELETON_FEATURES_H
+#define SKELETON_FEATURES_H
+
+#include "dataset/Dataset.h"
+#include "types/Skeleton.h"
+#include "types/MemoryTracker.h"
+#include "opencv2/core/core.hpp"
+#include <QVector>
+
+namespace dai {
+
+/**
+ * Joint positions of several skeletons stored as one array per joint and coordinate, so the
+ * features of all of them are computed with loops over contiguous memory.
+ *
+ * @brief The SkeletonBatch class
+ */
+class SkeletonBatch
+{
+public:
+    // Joints used by the anthropometric features
+    enum BatchJoint {
+        HEAD = 0,
+        NECK,
+        LEFT_SHOULDER,
+        RIGHT_SHOULDER,
+        LEFT_ELBOW,
+        RIGHT_ELBOW,
+        LEFT_HAND,
+        RIGHT_HAND,
+        LEFT_HIP,
+        RIGHT_HIP,
+        LEFT_KNEE,
+        RIGHT_KNEE,
+        LEFT_FOOT,
+        RIGHT_FOOT,
+        JOINTS_COUNT
+    };
+
+    void append(const Skeleton& skeleton, int actor);
+    void append(const SkeletonBatch& other);
+    void reserve(int size);
+    int size() const {return m_actors.size();}
+    const float* x(BatchJoint joint) const {return m_x[joint].constData();}
+    const float* y(BatchJoint joint) const {return m_y[joint].constData();}
+    const float* z(BatchJoint joint) const {return m_z[joint].constData();}
+    const QVector<int>& actors() const {return m_actors;}
+
+private:
+    static const SkeletonJoint::JointType _joints[JOINTS_COUNT];
+
+    QVector<float> m_x[JOINTS_COUNT];
+    QVector<float> m_y[JOINTS_COUNT];
+    QVector<float> m_z[JOINTS_COUNT];
+    QVector<int>   m_actors;
+};
+
+/**
+ * Anthropometric features of PersonReid::feature_skeleton_distances for the skeletons of
+ * whole datasets. Only the skeleton files are read, the instances are read in parallel and
+ * the result is a dense matrix with one row per skeleton.
+ *
+ * @brief The SkeletonFeatures class
+ */
+class SkeletonFeatures
+{
+public:
+    static const int DIMENSIONS = 15;
+
+    /**
+     * Every frame of the given instances with a user becomes a row of the matrix
+     */
+    static SkeletonFeatures compute(Dataset* dataset, const QList<shared_ptr<InstanceInfo>>& instances);
+
+    /**
+     * Features of the batch (a DIMENSIONS x size matrix, one column per skeleton)
+     */
+    static void computeBatch(const SkeletonBatch& batch, cv::Mat& output);
+
+    /**
+     * Mean absolute difference between every query and every sample of the gallery, as in
+     * DistancesFeature::distance (queries.rows x gallery.rows matrix)
+     */
+    static cv::Mat distances(const cv::Mat& queries, const cv::Mat& gallery);
+
+    const cv::Mat& matrix() const {return m_matrix;}   // One row per skeleton, CV_32F
+    const QVector<int>& actors() const {return m_actors;} // Actor of each row
+    int size() const {return m_matrix.rows;}
+
+private:
+    static SkeletonBatch readSkeletons(Dataset* dataset, shared_ptr<InstanceInfo> instance_info);
+
+    cv::Mat      m_matrix;
+    QVector<int> m_actors;
+    MemoryCharge m_memory;
+};
+
+} // End Namespace
+
+#endif // SKELETON_FEATURES_H
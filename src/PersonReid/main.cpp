@@ -1,4 +1,5 @@
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QTimer>
 #include "Config.h"
 #include "PersonReid.h"
@@ -7,7 +8,17 @@ int main(int argc, char *argv[])
 {
     CoreLib_InitResources();
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Person Re-identification");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"skeleton-distances", "Match people only by the anthropometric distances of their skeletons."}
+    });
+    parser.process(a);
+
     dai::PersonReid personReidApp;
+    personReidApp.setSkeletonDistances(parser.isSet("skeleton-distances"));
     QTimer::singleShot(0, &personReidApp, SLOT(execute()));
     return a.exec();
 }
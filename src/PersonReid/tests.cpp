@@ -4,6 +4,7 @@
 #include "types/DepthFrame.h"
 #include <QFile>
 #include <QCryptographicHash>
+#include <QHash>
 #include "viewer/InstanceViewerWindow.h"
 #include "dataset/DAI4REID_Parsed/DAI4REID_Parsed.h"
 #include "PersonReid.h"
@@ -98,14 +99,13 @@ void Tests::test3()
         auto skeletonFrame = static_pointer_cast<SkeletonFrame>(readFrames.value(DataFrame::Skeleton));
         colorFrame->setOffset(depthFrame->offset());
 
-        // Process
-        QList<int> users = skeletonFrame->getAllUsersId();
-        shared_ptr<Skeleton> skeleton = skeletonFrame->getSkeleton(users.at(0));
-
+        // Process (skeletons of every user)
         sha1_hash.addData(colorFrame->toBinary());
         sha1_hash.addData(depthFrame->toBinary());
         sha1_hash.addData(maskFrame->toBinary());
-        sha1_hash.addData(skeleton->toBinary());
+
+        for (int userId : skeletonFrame->getAllUsersId())
+            sha1_hash.addData(skeletonFrame->getSkeleton(userId)->toBinary());
 
         // Close Instances
         instance->close();
@@ -175,25 +175,42 @@ void Tests::show_different_skel_resolutions()
     instance->close();
 }
 
-// Approach 1: log color space (2 channels) without Histogram!!
-// Paper: Color Invariants for Person Reidentification
-void Tests::approach1(QHashDataFrames &frames)
+// Users of the frames, each of them is processed as an independent sample
+static QList<UserSample> frameUsers(const QHashDataFrames& frames)
 {
     Q_ASSERT(frames.contains(DataFrame::Color) && frames.contains(DataFrame::Mask) &&
              frames.contains(DataFrame::Skeleton) && frames.contains(DataFrame::Metadata));
 
-    shared_ptr<ColorFrame> colorFrame = static_pointer_cast<ColorFrame>(frames.value(DataFrame::Color));
     shared_ptr<MaskFrame> maskFrame = static_pointer_cast<MaskFrame>(frames.value(DataFrame::Mask));
+    shared_ptr<SkeletonFrame> skeletonFrame = static_pointer_cast<SkeletonFrame>(frames.value(DataFrame::Skeleton));
     shared_ptr<MetadataFrame> metadataFrame = static_pointer_cast<MetadataFrame>(frames.value(DataFrame::Metadata));
 
-    // Work in the Bounding Box
-    if (metadataFrame->boundingBoxes().isEmpty())
-        return;
+    return PersonReid::splitUsers(*maskFrame, skeletonFrame.get(), metadataFrame.get());
+}
+
+// Each user is shown in its own windows
+static std::string windowName(const char* name, const UserSample& user)
+{
+    return std::string(name) + " (user " + QString::number(user.userId).toStdString() + ")";
+}
+
+// Approach 1: log color space (2 channels) without Histogram!!
+// Paper: Color Invariants for Person Reidentification
+void Tests::approach1(QHashDataFrames& frames)
+{
+    shared_ptr<ColorFrame> colorFrame = static_pointer_cast<ColorFrame>(frames.value(DataFrame::Color));
+
+    // Work in the Bounding Box of every user
+    for (const UserSample& user : frameUsers(frames))
+        approach1(*colorFrame, user);
+}
 
-    BoundingBox bb = metadataFrame->boundingBoxes().first();
-    shared_ptr<ColorFrame> subColorFrame = colorFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
-                                                                bb.size().width(), bb.size().height());
-    shared_ptr<MaskFrame> subMaskFrame = maskFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
+void Tests::approach1(ColorFrame& colorFrame, const UserSample& user)
+{
+    const BoundingBox& bb = user.box;
+    shared_ptr<ColorFrame> subColorFrame = colorFrame.subFrame(bb.getMin().val(1),bb.getMin().val(0),
+                                                               bb.size().width(), bb.size().height());
+    shared_ptr<MaskFrame> subMaskFrame = user.mask->subFrame(bb.getMin().val(1),bb.getMin().val(0),
                                                              bb.size().width(), bb.size().height());
 
     // Use cv::Mat for my color frame and mask frame
@@ -225,29 +242,27 @@ void Tests::approach1(QHashDataFrames &frames)
                        log_range);
 
     // Show
-    cv::imshow("Log.Img", logCoordImg);
+    cv::imshow(windowName("Log.Img", user), logCoordImg);
     cv::waitKey(1);
 }
 
 // Approach 2: CIElab (2 channels)
 // Paper: Color Invariants for Person Reidentification
-void Tests::approach2(QHashDataFrames &frames)
+void Tests::approach2(QHashDataFrames& frames)
 {
-    Q_ASSERT(frames.contains(DataFrame::Color) && frames.contains(DataFrame::Mask) &&
-             frames.contains(DataFrame::Skeleton) && frames.contains(DataFrame::Metadata));
-
     shared_ptr<ColorFrame> colorFrame = static_pointer_cast<ColorFrame>(frames.value(DataFrame::Color));
-    shared_ptr<MaskFrame> maskFrame = static_pointer_cast<MaskFrame>(frames.value(DataFrame::Mask));
-    shared_ptr<MetadataFrame> metadataFrame = static_pointer_cast<MetadataFrame>(frames.value(DataFrame::Metadata));
 
-    // Work in the Bounding Box
-    if (metadataFrame->boundingBoxes().isEmpty())
-        return;
+    // Work in the Bounding Box of every user
+    for (const UserSample& user : frameUsers(frames))
+        approach2(*colorFrame, user);
+}
 
-    BoundingBox bb = metadataFrame->boundingBoxes().first();
-    shared_ptr<ColorFrame> subColorFrame = colorFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
-                                                                bb.size().width(), bb.size().height());
-    shared_ptr<MaskFrame> subMaskFrame = maskFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
+void Tests::approach2(ColorFrame& colorFrame, const UserSample& user)
+{
+    const BoundingBox& bb = user.box;
+    shared_ptr<ColorFrame> subColorFrame = colorFrame.subFrame(bb.getMin().val(1),bb.getMin().val(0),
+                                                               bb.size().width(), bb.size().height());
+    shared_ptr<MaskFrame> subMaskFrame = user.mask->subFrame(bb.getMin().val(1),bb.getMin().val(0),
                                                              bb.size().width(), bb.size().height());
 
     // Start OpenCV code
@@ -310,8 +325,8 @@ void Tests::approach2(QHashDataFrames &frames)
         colorImageWithMask(inputImg, inputImg, upper_mask, lower_mask);
 
         // Show
-        imshow("Hist.Dist", histDist);
-        imshow("Hist.Img", histImg);
+        imshow(windowName("Hist.Dist", user), histDist);
+        imshow(windowName("Hist.Img", user), histImg);
         waitKey(1);
 
     } // End OpenCV code
@@ -323,21 +338,19 @@ void Tests::approach2(QHashDataFrames &frames)
 // Paper: Color Invariants for Person Reidentification
 void Tests::approach3(QHashDataFrames& frames)
 {
-    Q_ASSERT(frames.contains(DataFrame::Color) && frames.contains(DataFrame::Mask) &&
-             frames.contains(DataFrame::Skeleton) && frames.contains(DataFrame::Metadata));
-
     shared_ptr<ColorFrame> colorFrame = static_pointer_cast<ColorFrame>(frames.value(DataFrame::Color));
-    shared_ptr<MaskFrame> maskFrame = static_pointer_cast<MaskFrame>(frames.value(DataFrame::Mask));
-    shared_ptr<MetadataFrame> metadataFrame = static_pointer_cast<MetadataFrame>(frames.value(DataFrame::Metadata));
 
-    // Work in the Bounding Box
-    if (metadataFrame->boundingBoxes().isEmpty())
-        return;
+    // Work in the Bounding Box of every user
+    for (const UserSample& user : frameUsers(frames))
+        approach3(*colorFrame, user);
+}
 
-    BoundingBox bb = metadataFrame->boundingBoxes().first();
-    shared_ptr<ColorFrame> subColorFrame = colorFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
-                                                                bb.size().width(), bb.size().height());
-    shared_ptr<MaskFrame> subMaskFrame = maskFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
+void Tests::approach3(ColorFrame& colorFrame, const UserSample& user)
+{
+    const BoundingBox& bb = user.box;
+    shared_ptr<ColorFrame> subColorFrame = colorFrame.subFrame(bb.getMin().val(1),bb.getMin().val(0),
+                                                               bb.size().width(), bb.size().height());
+    shared_ptr<MaskFrame> subMaskFrame = user.mask->subFrame(bb.getMin().val(1),bb.getMin().val(0),
                                                              bb.size().width(), bb.size().height());
 
     // Start OpenCV code
@@ -403,8 +416,8 @@ void Tests::approach3(QHashDataFrames& frames)
         colorImageWithMask(inputImg, inputImg, upper_mask, lower_mask);
 
         // Show
-        imshow("Hist.Dist", histDist);
-        imshow("Hist.Img", histImg);
+        imshow(windowName("Hist.Dist", user), histDist);
+        imshow(windowName("Hist.Img", user), histImg);
         waitKey(1);
 
     } // End OpenCV code
@@ -414,23 +427,21 @@ void Tests::approach3(QHashDataFrames& frames)
 
 // Approach 4: RGB
 // Paper: Color Invariants for Person Reidentification
-void Tests::approach4(QHashDataFrames &frames)
+void Tests::approach4(QHashDataFrames& frames)
 {
-    Q_ASSERT(frames.contains(DataFrame::Color) && frames.contains(DataFrame::Mask) &&
-             frames.contains(DataFrame::Skeleton) && frames.contains(DataFrame::Metadata));
-
     shared_ptr<ColorFrame> colorFrame = static_pointer_cast<ColorFrame>(frames.value(DataFrame::Color));
-    shared_ptr<MaskFrame> maskFrame = static_pointer_cast<MaskFrame>(frames.value(DataFrame::Mask));
-    shared_ptr<MetadataFrame> metadataFrame = static_pointer_cast<MetadataFrame>(frames.value(DataFrame::Metadata));
 
-    // Work in the Bounding Box
-    if (metadataFrame->boundingBoxes().isEmpty())
-        return;
+    // Work in the Bounding Box of every user
+    for (const UserSample& user : frameUsers(frames))
+        approach4(*colorFrame, user);
+}
 
-    BoundingBox bb = metadataFrame->boundingBoxes().first();
-    shared_ptr<ColorFrame> roiColorFrame = colorFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
-                                                                bb.size().width(), bb.size().height());
-    shared_ptr<MaskFrame> roiMaskFrame = maskFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
+void Tests::approach4(ColorFrame& colorFrame, const UserSample& user)
+{
+    const BoundingBox& bb = user.box;
+    shared_ptr<ColorFrame> roiColorFrame = colorFrame.subFrame(bb.getMin().val(1),bb.getMin().val(0),
+                                                               bb.size().width(), bb.size().height());
+    shared_ptr<MaskFrame> roiMaskFrame = user.mask->subFrame(bb.getMin().val(1),bb.getMin().val(0),
                                                              bb.size().width(), bb.size().height());
 
     // Start OpenCV code
@@ -479,8 +490,8 @@ void Tests::approach4(QHashDataFrames &frames)
         cv::cvtColor(colorPalette, colorPalette, cv::COLOR_YCrCb2BGR); // YUV to BGR
 
         // Show
-        imshow("Dist.Hist", distImg);
-        imshow("Palette", colorPalette);
+        imshow(windowName("Dist.Hist", user), distImg);
+        imshow(windowName("Palette", user), colorPalette);
         waitKey(1);
 
     } // End OpenCV code
@@ -490,30 +501,38 @@ void Tests::approach4(QHashDataFrames &frames)
 // Paper: Color Invariants for Person Reidentification
 void Tests::approach5(QHashDataFrames& frames)
 {
-    Q_ASSERT(frames.contains(DataFrame::Color) && frames.contains(DataFrame::Mask) &&
-             frames.contains(DataFrame::Skeleton) && frames.contains(DataFrame::Metadata));
-
     shared_ptr<ColorFrame> colorFrame = static_pointer_cast<ColorFrame>(frames.value(DataFrame::Color));
-    shared_ptr<MaskFrame> maskFrame = static_pointer_cast<MaskFrame>(frames.value(DataFrame::Mask));
-    shared_ptr<MetadataFrame> metadataFrame = static_pointer_cast<MetadataFrame>(frames.value(DataFrame::Metadata));
 
-    // Work in the Bounding Box
-    if (metadataFrame->boundingBoxes().isEmpty())
-        return;
+    // Work in the Bounding Box of every user
+    for (const UserSample& user : frameUsers(frames))
+        approach5(*colorFrame, user);
+}
 
-    BoundingBox bb = metadataFrame->boundingBoxes().first();
-    shared_ptr<ColorFrame> roiColorFrame = colorFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
-                                                                bb.size().width(), bb.size().height());
-    shared_ptr<MaskFrame> roiMaskFrame = maskFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
+void Tests::approach5(ColorFrame& colorFrame, const UserSample& user)
+{
+    const BoundingBox& bb = user.box;
+    shared_ptr<ColorFrame> roiColorFrame = colorFrame.subFrame(bb.getMin().val(1),bb.getMin().val(0),
+                                                               bb.size().width(), bb.size().height());
+    shared_ptr<MaskFrame> roiMaskFrame = user.mask->subFrame(bb.getMin().val(1),bb.getMin().val(0),
                                                              bb.size().width(), bb.size().height());
 
-    static int frame_counter = 0;
     static const int buffer_size = 5;
     const int n_often_items = 72;
-    static cv::Mat color_frame_vector[buffer_size];
-    static cv::Mat mask_frame_vector[buffer_size];
     static bool finished = false;
 
+    // Frames are buffered per user
+    struct UserBuffer {
+        int frame_counter = 0;
+        cv::Mat color_frame_vector[buffer_size];
+        cv::Mat mask_frame_vector[buffer_size];
+    };
+
+    static QHash<int, UserBuffer> buffers;
+    UserBuffer& buffer = buffers[user.userId];
+    int& frame_counter = buffer.frame_counter;
+    cv::Mat* color_frame_vector = buffer.color_frame_vector;
+    cv::Mat* mask_frame_vector = buffer.mask_frame_vector;
+
     // Start OpenCV code
     {using namespace cv;
 
@@ -583,8 +602,8 @@ void Tests::approach5(QHashDataFrames& frames)
                                          distImg);
 
             // Show
-            imshow("Palette AC", colorPalette_acc);
-            imshow("Hist.dist", distImg);
+            imshow(windowName("Palette AC", user), colorPalette_acc);
+            imshow(windowName("Hist.dist", user), distImg);
             waitKey(1);
         }
         else {
@@ -597,29 +616,37 @@ void Tests::approach5(QHashDataFrames& frames)
 }
 
 // Approach 6: Indexed colors
-void Tests::approach6(QHashDataFrames &frames)
+void Tests::approach6(QHashDataFrames& frames)
 {
-    Q_ASSERT(frames.contains(DataFrame::Color) && frames.contains(DataFrame::Mask) &&
-             frames.contains(DataFrame::Skeleton) && frames.contains(DataFrame::Metadata));
-
     shared_ptr<ColorFrame> colorFrame = static_pointer_cast<ColorFrame>(frames.value(DataFrame::Color));
-    shared_ptr<MaskFrame> maskFrame = static_pointer_cast<MaskFrame>(frames.value(DataFrame::Mask));
-    shared_ptr<MetadataFrame> metadataFrame = static_pointer_cast<MetadataFrame>(frames.value(DataFrame::Metadata));
 
-    // Work in the Bounding Box
-    if (metadataFrame->boundingBoxes().isEmpty())
-        return;
+    // Work in the Bounding Box of every user
+    for (const UserSample& user : frameUsers(frames))
+        approach6(*colorFrame, user);
+}
 
-    BoundingBox bb = metadataFrame->boundingBoxes().first();
-    shared_ptr<ColorFrame> roiColorFrame = colorFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
-                                                                bb.size().width(), bb.size().height());
-    shared_ptr<MaskFrame> roiMaskFrame = maskFrame->subFrame(bb.getMin().val(1),bb.getMin().val(0),
+void Tests::approach6(ColorFrame& colorFrame, const UserSample& user)
+{
+    const BoundingBox& bb = user.box;
+    shared_ptr<ColorFrame> roiColorFrame = colorFrame.subFrame(bb.getMin().val(1),bb.getMin().val(0),
+                                                               bb.size().width(), bb.size().height());
+    shared_ptr<MaskFrame> roiMaskFrame = user.mask->subFrame(bb.getMin().val(1),bb.getMin().val(0),
                                                              bb.size().width(), bb.size().height());
 
-    static int frame_counter = 0;
     static const int buffer_size = 5; // 190
-    static cv::Mat color_frame_vector[buffer_size];
-    static cv::Mat mask_frame_vector[buffer_size];
+
+    // Frames are buffered per user
+    struct UserBuffer {
+        int frame_counter = 0;
+        cv::Mat color_frame_vector[buffer_size];
+        cv::Mat mask_frame_vector[buffer_size];
+    };
+
+    static QHash<int, UserBuffer> buffers;
+    UserBuffer& buffer = buffers[user.userId];
+    int& frame_counter = buffer.frame_counter;
+    cv::Mat* color_frame_vector = buffer.color_frame_vector;
+    cv::Mat* mask_frame_vector = buffer.mask_frame_vector;
 
     // Start OpenCV code
     {using namespace cv;
@@ -704,10 +731,10 @@ void Tests::approach6(QHashDataFrames &frames)
                 img_idx++;
             }
 
-            imshow("centroid1", hist_img[0]);
-            imshow("centroid2", hist_img[1]);
-            imshow("centroid3", hist_img[2]);
-            imshow("centroid4", hist_img[3]);*/
+            imshow(windowName("centroid1", user), hist_img[0]);
+            imshow(windowName("centroid2", user), hist_img[1]);
+            imshow(windowName("centroid3", user), hist_img[2]);
+            imshow(windowName("centroid4", user), hist_img[3]);*/
 
             // Show it on an image
             /*Mat colorPalette_acc;
@@ -721,11 +748,11 @@ void Tests::approach6(QHashDataFrames &frames)
                                        {Scalar(0, 255, 255), Scalar(0, 0, 255)}, // Blue (upper hist), Red (lower hist)
                                        distImg);*/
             // Show
-            //imshow("Palette AC", colorPalette_acc);
+            //imshow(windowName("Palette AC", user), colorPalette_acc);
 
-            //imshow("Hist.dist", distImg);
-            imshow("hist1", hist_img[0]);
-            imshow("hist2", hist_img[1]);
+            //imshow(windowName("Hist.dist", user), distImg);
+            imshow(windowName("hist1", user), hist_img[0]);
+            imshow(windowName("hist2", user), hist_img[1]);
             waitKey(1);
         }
         else {
@@ -2,9 +2,12 @@
 #define TESTS_H
 
 #include "types/DataFrame.h"
+#include "types/ColorFrame.h"
 
 namespace dai {
 
+struct UserSample;
+
 class Tests
 {
 public:
@@ -18,6 +21,15 @@ public:
     void approach4(QHashDataFrames& frames);
     void approach5(QHashDataFrames& frames);
     void approach6(QHashDataFrames& frames);
+
+private:
+    // Every approach is applied to each user of the frames
+    void approach1(ColorFrame& colorFrame, const UserSample& user);
+    void approach2(ColorFrame& colorFrame, const UserSample& user);
+    void approach3(ColorFrame& colorFrame, const UserSample& user);
+    void approach4(ColorFrame& colorFrame, const UserSample& user);
+    void approach5(ColorFrame& colorFrame, const UserSample& user);
+    void approach6(ColorFrame& colorFrame, const UserSample& user);
 };
 
 } // End Namespace
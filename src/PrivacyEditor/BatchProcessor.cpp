@@ -0,0 +1,265 @@
+#include "BatchProcessor.h"
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QImageReader>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QMap>
+#include <QPair>
+#include <QDebug>
+#include <QtConcurrent>
+#include <vector>
+
+BatchProcessor::BatchProcessor(const QString& inputPath, const QString& outputPath)
+    : m_inputPath(inputPath)
+    , m_outputPath(outputPath)
+    , m_workers(QThread::idealThreadCount())
+    , m_softwareRendering(true)
+{
+}
+
+void BatchProcessor::setWorkers(int workers)
+{
+    m_workers = qMax(1, workers);
+}
+
+void BatchProcessor::setSoftwareRendering(bool value)
+{
+    m_softwareRendering = value;
+}
+
+void BatchProcessor::setPolicy(dai::PrivacyPolicyPtr policy)
+{
+    m_policy = policy;
+}
+
+BatchProcessor::Stats BatchProcessor::run()
+{
+    Stats stats;
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!QDir().mkpath(m_outputPath)) {
+        qDebug() << "Cannot create the output folder" << m_outputPath;
+        return stats;
+    }
+
+    QList<QList<BatchItem>> chunks = scan(&stats.groups);
+    QAtomicInt nextChunk(0);
+    QAtomicInt failed(0);
+
+    // GL contexts and Ogre can't be shared between threads
+    if (!m_softwareRendering) {
+        stats.images = processChunks(chunks, &nextChunk, &failed);
+    }
+    else {
+        std::vector<QFuture<int>> workers;
+        const int numWorkers = qMin(m_workers, chunks.size());
+
+        // Own pool, so the global one keeps its size for QtConcurrent and runParallel
+        QThreadPool pool;
+        pool.setMaxThreadCount(qMax(numWorkers, 1));
+
+        for (int i=0; i<numWorkers; ++i) {
+            workers.push_back( QtConcurrent::run(&pool, this, &BatchProcessor::processChunks, chunks, &nextChunk, &failed) );
+        }
+
+        for (QFuture<int>& f : workers) {
+            stats.images += f.result();
+        }
+    }
+
+    stats.failed = failed.load();
+    stats.elapsedMs = timer.elapsed();
+    return stats;
+}
+
+/**
+ * Look for the images and split them in chunks of images of the same resolution.
+ *
+ * @brief BatchProcessor::scan
+ * @param groups Number of different resolutions
+ * @return
+ */
+QList<QList<BatchProcessor::BatchItem>> BatchProcessor::scan(int* groups) const
+{
+    QDir dir(m_inputPath);
+    QStringList filters = {"*_real.jpg", "*_real.jpeg", "*_real.bmp", "*_real.png"};
+    QMap<QPair<int,int>, QList<BatchItem>> bySize;
+
+    for (const QFileInfo& file : dir.entryInfoList(filters, QDir::Files, QDir::Name))
+    {
+        const QString fileName = file.fileName();
+
+        BatchItem item;
+        item.name = fileName.left(fileName.lastIndexOf("_real."));
+        item.colorFile = file.absoluteFilePath();
+        item.maskFile = dir.absoluteFilePath(item.name + "_mask.png");
+        item.bgFile = dir.absoluteFilePath(item.name + "_bg.png");
+        item.skeletonFile = dir.absoluteFilePath(item.name + ".bin");
+
+        if (!QFile::exists(item.maskFile) || !QFile::exists(item.bgFile)) {
+            qDebug() << "Skipping" << fileName << "(mask or background not found)";
+            continue;
+        }
+
+        // Only the header is read
+        QSize size = QImageReader(item.colorFile).size();
+        bySize[qMakePair(size.width(), size.height())] << item;
+    }
+
+    QList<QList<BatchItem>> chunks;
+
+    for (const QList<BatchItem>& group : bySize) {
+        for (int i=0; i<group.size(); i += CHUNK_SIZE) {
+            chunks << group.mid(i, CHUNK_SIZE);
+        }
+    }
+
+    *groups = bySize.size();
+    return chunks;
+}
+
+int BatchProcessor::processChunks(const QList<QList<BatchItem>>& chunks, QAtomicInt* nextChunk, QAtomicInt* failed) const
+{
+    dai::PrivacyFilter filter(m_softwareRendering);
+    int count = 0;
+
+    // The workers already use every core
+    if (m_softwareRendering)
+        filter.setRenderingThreads(1);
+
+    // Policies are immutable, so every worker can use the same one
+    filter.setPolicy(m_policy);
+
+    int chunk;
+
+    while ((chunk = nextChunk->fetchAndAddOrdered(1)) < chunks.size())
+    {
+        for (const BatchItem& item : chunks.at(chunk)) {
+            if (processImage(filter, item))
+                count++;
+            else
+                failed->fetchAndAddOrdered(1);
+        }
+    }
+
+    return count;
+}
+
+bool BatchProcessor::processImage(dai::PrivacyFilter& filter, const BatchItem& item) const
+{
+    QImage image(item.colorFile);
+    QImage mask(item.maskFile);
+    QImage bg(item.bgFile);
+
+    if (image.isNull() || mask.isNull() || bg.isNull() || image.size() != mask.size() || image.size() != bg.size()) {
+        qDebug() << "Cannot load" << item.name;
+        return false;
+    }
+
+    // convertQImage2ColorFrame and createMask expect 32 bits per pixel
+    image = image.convertToFormat(QImage::Format_RGB32);
+    mask = mask.convertToFormat(QImage::Format_RGB32);
+    bg = bg.convertToFormat(QImage::Format_RGB32);
+
+    const int width = image.width();
+    const int height = image.height();
+
+    dai::ColorFramePtr color = make_shared<dai::ColorFrame>(width, height);
+    dai::ColorFramePtr background = make_shared<dai::ColorFrame>(width, height);
+    dai::MaskFramePtr userMask = createMask(mask);
+    dai::SkeletonFramePtr skeleton = loadSkeleton(item.skeletonFile);
+    dai::PrivacyFilter::convertQImage2ColorFrame(image, color);
+    dai::PrivacyFilter::convertQImage2ColorFrame(bg, background);
+
+    // Learn the background first (BG frame with no mask)
+    dai::QHashDataFrames frames;
+    frames.insert(dai::DataFrame::Color, background);
+    frames.insert(dai::DataFrame::Mask, make_shared<dai::MaskFrame>(width, height));
+    filter.enableFilter(dai::FILTER_DISABLED);
+    filter.filterFrames(frames, width, height);
+
+    const QString baseName = m_outputPath + "/" + item.name + "_";
+
+    // The policy chooses the filters itself, so a single image is rendered
+    if (m_policy)
+        return renderImage(filter, dai::FILTER_DISABLED, color, userMask, skeleton, baseName + "policy.png");
+
+    for (int i=dai::FILTER_DISABLED; i<=dai::FILTER_3DMODEL; ++i)
+    {
+        dai::ColorFilter filterType = dai::ColorFilter(i);
+        QString fileName = baseName + dai::PrivacyPolicy::filterName(filterType) + ".png";
+
+        if (!renderImage(filter, filterType, color, userMask, skeleton, fileName))
+            return false;
+    }
+
+    return true;
+}
+
+// Every filter works on its own copy of the FG frames
+bool BatchProcessor::renderImage(dai::PrivacyFilter& filter, dai::ColorFilter filterType, dai::ColorFramePtr color,
+                                 dai::MaskFramePtr userMask, dai::SkeletonFramePtr skeleton, const QString& fileName) const
+{
+    const int width = color->width();
+    const int height = color->height();
+    dai::ColorFramePtr output = static_pointer_cast<dai::ColorFrame>(color->clone());
+
+    dai::QHashDataFrames frames;
+    frames.insert(dai::DataFrame::Color, output);
+    frames.insert(dai::DataFrame::Mask, userMask->clone());
+
+    if (skeleton)
+        frames.insert(dai::DataFrame::Skeleton, skeleton->clone());
+
+    filter.enableFilter(filterType);
+    filter.filterFrames(frames, width, height);
+
+    QImage output_image((uchar*) output->getDataPtr(), output->width(), output->height(),
+                        output->getStride(), QImage::Format_RGB888);
+
+    if (!output_image.save(fileName)) {
+        qDebug() << "Cannot write" << fileName;
+        return false;
+    }
+
+    return true;
+}
+
+// Same as MainWindow::create_mask
+dai::MaskFramePtr BatchProcessor::createMask(const QImage& image)
+{
+    dai::MaskFramePtr mask = make_shared<dai::MaskFrame>(image.width(), image.height());
+
+    for (int i=0; i<image.height(); ++i)
+    {
+        const QRgb* in_pixel = reinterpret_cast<const QRgb*>(image.constScanLine(i));
+        uint8_t* out_pixel = mask->getRowPtr(i);
+
+        for (int j=0; j<image.width(); ++j)
+        {
+            if (qRed(in_pixel[j]) > 0)
+                out_pixel[j] = 1;
+        }
+    }
+
+    return mask;
+}
+
+dai::SkeletonFramePtr BatchProcessor::loadSkeleton(const QString& fileName)
+{
+    QFile skeletonFile(fileName);
+
+    if (!skeletonFile.open(QIODevice::ReadOnly))
+        return nullptr;
+
+    QByteArray data = skeletonFile.readAll();
+    skeletonFile.close();
+
+    if (data.isEmpty())
+        return nullptr;
+
+    return dai::SkeletonFrame::fromBinary(data);
+}
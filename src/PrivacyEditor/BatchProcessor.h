@@ -0,0 +1,69 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QAtomicInt>
+#include "types/MaskFrame.h"
+#include "types/ColorFrame.h"
+#include "types/SkeletonFrame.h"
+#include "filters/PrivacyFilter.h"
+
+/**
+ * Applies every privacy filter to the images of a folder without GUI. It reads the same
+ * files that the editor loads (<name>_real.png, <name>_mask.png, <name>_bg.png and the
+ * optional <name>.bin skeleton) and writes <name>_<filter>.png into the output folder.
+ *
+ * With a policy, users are filtered following its rules and <name>_policy.png is
+ * written instead.
+ *
+ * Images are grouped by resolution and processed in chunks of the same size, so the
+ * filters are not resized between images. Each worker owns its PrivacyFilter. With GL
+ * rendering everything runs in the calling thread (it must be the GUI thread).
+ *
+ * @brief The BatchProcessor class
+ */
+class BatchProcessor
+{
+public:
+    struct Stats {
+        int images = 0;
+        int failed = 0;
+        int groups = 0;
+        qint64 elapsedMs = 0;
+    };
+
+    BatchProcessor(const QString& inputPath, const QString& outputPath);
+    void setWorkers(int workers);
+    void setSoftwareRendering(bool value);
+    void setPolicy(dai::PrivacyPolicyPtr policy);
+    Stats run();
+
+private:
+    struct BatchItem {
+        QString name;
+        QString colorFile;
+        QString maskFile;
+        QString bgFile;
+        QString skeletonFile;
+    };
+
+    QList<QList<BatchItem>> scan(int* groups) const;
+    int processChunks(const QList<QList<BatchItem>>& chunks, QAtomicInt* nextChunk, QAtomicInt* failed) const;
+    bool processImage(dai::PrivacyFilter& filter, const BatchItem& item) const;
+    bool renderImage(dai::PrivacyFilter& filter, dai::ColorFilter filterType, dai::ColorFramePtr color,
+                     dai::MaskFramePtr userMask, dai::SkeletonFramePtr skeleton, const QString& fileName) const;
+    static dai::MaskFramePtr createMask(const QImage& image);
+    static dai::SkeletonFramePtr loadSkeleton(const QString& fileName);
+
+    static const int CHUNK_SIZE = 16;
+
+    const QString m_inputPath;
+    const QString m_outputPath;
+    int m_workers;
+    bool m_softwareRendering;
+    dai::PrivacyPolicyPtr m_policy;
+};
+
+#endif // BATCHPROCESSOR_H
@@ -1,5 +1,6 @@
 #include "MainWindow.h"
 #include "ui_MainWindow.h"
+#include <QApplication>
 #include <QFileDialog>
 #include <QTimer>
 #include <QMessageBox>
@@ -55,6 +56,8 @@ const QGraphicsPixmapItem* Display::background() const
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_ui(new Ui::MainWindow)
+    , m_inputRing("input", QApplication::applicationDirPath() + "/ring")
+    , m_outputRing("output", QApplication::applicationDirPath() + "/ring")
     , m_skeleton_root(nullptr)
 {
     m_ui->setupUi(this);
@@ -65,6 +68,7 @@ MainWindow::MainWindow(QWidget *parent)
     m_input.scene()->installEventFilter(this);
     m_ui->graphicsView->setScene(m_input.scene());
     m_privacy.addListener(this);
+    m_privacy.addListener(&m_outputRing);
     m_selected_joint = nullptr;
 
     // Action: Open Folder (setup model)
@@ -185,11 +189,13 @@ MainWindow::MainWindow(QWidget *parent)
         dai::QHashDataFrames frames;
         frames.insert(dai::DataFrame::Color, bg);
         frames.insert(dai::DataFrame::Mask, empty_mask);
+        m_inputRing.record(frames);
         m_privacy.singleFrame(frames, color->width(), color->height()); // Send BG frame with no mask
 
         frames.insert(dai::DataFrame::Color, color);
         frames.insert(dai::DataFrame::Mask, mask);
         frames.insert(dai::DataFrame::Skeleton, skeleton);
+        m_inputRing.record(frames);
         m_privacy.singleFrame(frames, color->width(), color->height()); // Send FG frame with mask
     });
 
@@ -216,6 +222,7 @@ MainWindow::MainWindow(QWidget *parent)
         frames.insert(dai::DataFrame::Skeleton, skeleton);
 
         m_privacy.enableFilter(dai::ColorFilter(m_ui->comboFilter->currentIndex()));
+        m_inputRing.record(frames);
         m_privacy.singleFrame(frames, color->width(), color->height());
     });
 
@@ -13,6 +13,7 @@
 #include "types/ColorFrame.h"
 #include "types/SkeletonFrame.h"
 #include "filters/PrivacyFilter.h"
+#include "playback/RingRecorder.h"
 
 namespace Ui {
 class MainWindow;
@@ -58,6 +59,8 @@ class MainWindow : public QMainWindow, dai::FrameListener
     QPen m_pen;
     QString m_current_image_path;
     dai::PrivacyFilter m_privacy;
+    dai::RingRecorder m_inputRing;     // Frames sent to m_privacy
+    dai::RingRecorder m_outputRing;    // Filtered frames
     QGraphicsRectItem* m_selected_joint;
     bool m_drawing = false;
     QGraphicsItem* m_skeleton_root;
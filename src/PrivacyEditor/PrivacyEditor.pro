@@ -2,16 +2,18 @@
     error("Couldn't find the common.pri file!")
 }
 
-QT += core gui quick
+QT += core gui quick concurrent
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET = PrivacyEditor
 TEMPLATE = app
 
 SOURCES += main.cpp\
-        MainWindow.cpp
+        MainWindow.cpp \
+    BatchProcessor.cpp
 
-HEADERS  += MainWindow.h
+HEADERS  += MainWindow.h \
+    BatchProcessor.h
 
 FORMS    += MainWindow.ui
 
@@ -1,13 +1,74 @@
 #include "MainWindow.h"
+#include "BatchProcessor.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QDebug>
 #include "Config.h"
 #include "filters/PrivacyFilter.h"
+#include "playback/RingRecorder.h"
+
+int runBatch(const QCommandLineParser& parser)
+{
+    BatchProcessor processor(parser.value("batch"), parser.value("output"));
+    processor.setWorkers(parser.value("workers").toInt());
+    processor.setSoftwareRendering(!parser.isSet("gl"));
+
+    if (parser.isSet("policy")) {
+        dai::PrivacyPolicyPtr policy = dai::PrivacyPolicy::load(parser.value("policy"));
+
+        if (!policy)
+            return 1;
+
+        processor.setPolicy(policy);
+    }
+
+    BatchProcessor::Stats stats = processor.run();
+    const double seconds = stats.elapsedMs / 1000.0;
+
+    qDebug() << "Batch Finished!" << stats.images << "images" << "(" << stats.failed << "failed,"
+             << stats.groups << "resolutions ) in" << seconds << "s"
+             << (seconds > 0 ? stats.images / seconds : 0.0) << "images/s";
+
+    return stats.failed > 0 ? 1 : 0;
+}
 
 int main(int argc, char *argv[])
 {
     CoreLib_InitResources();
     PrivacyLib_InitResources();
+
+    // Headless batch mode doesn't need a display unless GL rendering is requested
+    bool batch = false, gl = false;
+
+    for (int i=1; i<argc; ++i) {
+        batch |= QString(argv[i]).startsWith("--batch");
+        gl |= QString(argv[i]) == "--gl";
+    }
+
+    if (batch && !gl && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Privacy Editor");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"batch", "Apply every filter to the images of <folder> without GUI.", "folder"},
+        {"output", "Output folder of the batch mode.", "folder", "output"},
+        {"workers", "Number of images filtered in parallel.", "count", QString::number(QThread::idealThreadCount())},
+        {"gl", "Render with OpenGL instead of the software renderer (single-threaded)."},
+        {"policy", "Filter each user following the rules of the policy <file> (batch mode).", "file"}
+    });
+    parser.process(a);
+
+    if (parser.isSet("batch"))
+        return runBatch(parser);
+
+    // Last input and filtered frames are written on SIGUSR1 or on a crash
+    dai::RingRecorder::installHandlers();
+
     MainWindow w;
     w.show();
     return a.exec();
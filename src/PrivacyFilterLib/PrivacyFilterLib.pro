@@ -15,6 +15,11 @@ CONFIG += staticlib create_prl thread
 
 SOURCES += \
     filters/PrivacyFilter.cpp \
+    filters/SoftwareRenderer.cpp \
+    filters/PointCloudRenderer.cpp \
+    filters/CaptureWriter.cpp \
+    filters/FaceTracker.cpp \
+    filters/PrivacyPolicy.cpp \
     ogre/OgrePointCloud.cpp \
     ogre/OgreScene.cpp \
     ogre/OgreWrapper.cpp \
@@ -22,6 +27,11 @@ SOURCES += \
 
 HEADERS += \
     filters/PrivacyFilter.h \
+    filters/SoftwareRenderer.h \
+    filters/PointCloudRenderer.h \
+    filters/CaptureWriter.h \
+    filters/FaceTracker.h \
+    filters/PrivacyPolicy.h \
     ogre/OgrePointCloud.h \
     ogre/OgreScene.h \
     ogre/OgreWrapper.h \
@@ -0,0 +1,202 @@
+#include "CaptureWriter.h"
+#include <QImage>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+
+namespace dai {
+
+CaptureWriter::CaptureWriter(int poolSize)
+    : m_running(true)
+    , m_pendingCaptures(0)
+    , m_nextCaptureId(1)
+    , m_batchSize(4)
+    , m_written(0)
+    , m_dropped(0)
+    , m_directory("data")
+    , m_prefix("capture")
+    , m_format(FORMAT_PNG)
+    , m_quality(-1)
+{
+    for (int i=0; i<poolSize; ++i) {
+        CapturePtr capture = make_shared<Capture>();
+        capture->color = make_shared<ColorFrame>();
+        capture->mask = make_shared<MaskFrame>();
+        capture->hasMask = false;
+        capture->captureId = 0;
+        m_pool << capture;
+    }
+
+    start();
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    stop();
+}
+
+void CaptureWriter::setOutput(const QString& directory, const QString& prefix)
+{
+    QMutexLocker locker(&m_lock);
+    m_directory = directory;
+    m_prefix = prefix;
+}
+
+void CaptureWriter::setFormat(ImageFormat format, int quality)
+{
+    QMutexLocker locker(&m_lock);
+    m_format = format;
+    m_quality = quality;
+}
+
+void CaptureWriter::setBatchSize(int size)
+{
+    QMutexLocker locker(&m_lock);
+    m_batchSize = size > 0 ? size : 1;
+}
+
+void CaptureWriter::requestCapture(int numFrames)
+{
+    QMutexLocker locker(&m_lock);
+    m_pendingCaptures += numFrames;
+}
+
+bool CaptureWriter::isCapturePending() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_pendingCaptures > 0;
+}
+
+CaptureWriter::CapturePtr CaptureWriter::acquire()
+{
+    QMutexLocker locker(&m_lock);
+
+    if (m_pendingCaptures == 0 || !m_running)
+        return nullptr;
+
+    m_pendingCaptures--;
+
+    if (m_pool.isEmpty()) {
+        m_dropped++;
+        qDebug() << "CaptureWriter - No free buffers, capture dropped";
+        return nullptr;
+    }
+
+    CapturePtr capture = m_pool.takeLast();
+    capture->hasMask = false;
+    capture->skeleton.clear();
+    capture->captureId = m_nextCaptureId++;
+    return capture;
+}
+
+void CaptureWriter::commit(CapturePtr capture)
+{
+    QMutexLocker locker(&m_lock);
+    m_queue.enqueue(capture);
+    m_sync.wakeOne();
+}
+
+void CaptureWriter::stop()
+{
+    m_lock.lock();
+    m_running = false;
+    m_pendingCaptures = 0;
+    m_sync.wakeOne();
+    m_lock.unlock();
+
+    if (QThread::currentThread() != this)
+        this->wait();
+}
+
+qint64 CaptureWriter::capturesWritten() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_written;
+}
+
+qint64 CaptureWriter::capturesDropped() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_dropped;
+}
+
+void CaptureWriter::run()
+{
+    QList<CapturePtr> batch;
+
+    forever {
+        m_lock.lock();
+        while (m_running && m_queue.isEmpty()) {
+            m_sync.wait(&m_lock);
+        }
+
+        // Committed captures are written even after stop()
+        if (m_queue.isEmpty()) {
+            m_lock.unlock();
+            break;
+        }
+
+        while (!m_queue.isEmpty() && batch.size() < m_batchSize) {
+            batch << m_queue.dequeue();
+        }
+        m_lock.unlock();
+
+        for (CapturePtr capture : batch) {
+            write(*capture);
+        }
+
+        // Give buffers back to the pool
+        m_lock.lock();
+        m_written += batch.size();
+        m_pool << batch;
+        m_lock.unlock();
+
+        batch.clear();
+    }
+}
+
+void CaptureWriter::write(const Capture& capture)
+{
+    m_lock.lock();
+    QString directory = m_directory;
+    QString prefix = m_prefix;
+    ImageFormat format = m_format;
+    int quality = m_quality;
+    m_lock.unlock();
+
+    QDir().mkpath(directory);
+    QString fileName = directory + "/" + prefix + "_" + QString::number(capture.captureId);
+
+    // Color
+    const ColorFrame& color = *capture.color;
+    QImage image( (uchar*) color.getDataPtr(), color.width(), color.height(),
+                  color.getStride(), QImage::Format_RGB888);
+
+    if (format == FORMAT_JPEG)
+        image.save(fileName + "_color.jpg", "JPG", quality);
+    else
+        image.save(fileName + "_color.png", "PNG", quality);
+
+    // Mask
+    if (capture.hasMask) {
+        const MaskFrame& mask = *capture.mask;
+        QImage mask_image( (uchar*) mask.getDataPtr(), mask.width(), mask.height(),
+                           mask.getStride(), QImage::Format_Indexed8);
+        QVector<QRgb> colorTable;
+        for (int i=0; i<256; ++i)
+            colorTable << qRgb(i, i, i);
+        mask_image.setColorTable(colorTable);
+        mask_image.save(fileName + "_mask.png", "PNG");
+    }
+
+    // Skeleton
+    if (!capture.skeleton.isEmpty()) {
+        QFile file(fileName + "_skel.bin");
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(capture.skeleton);
+            file.close();
+        }
+    }
+}
+
+} // End Namespace
@@ -0,0 +1,96 @@
+#ifndef CAPTUREWRITER_H
+#define CAPTUREWRITER_H
+
+#include "types/ColorFrame.h"
+#include "types/MaskFrame.h"
+#include <QByteArray>
+#include <QThread>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QQueue>
+#include <QList>
+#include <QString>
+
+namespace dai {
+
+/**
+ * Saves captured frames to disk from a background thread. The caller acquires a
+ * pooled capture buffer, copies the frames into it and commits it. Committed
+ * captures are encoded and written in batches, so the render thread is never blocked
+ * by the encoder. It also supports bursts (capture of the next N frames).
+ *
+ * Files written for each capture: <prefix>_<N>_color.(png|jpg), <prefix>_<N>_mask.png
+ * and <prefix>_<N>_skel.bin
+ *
+ * @brief The CaptureWriter class
+ */
+class CaptureWriter : public QThread
+{
+public:
+    enum ImageFormat {
+        FORMAT_PNG,
+        FORMAT_JPEG
+    };
+
+    struct Capture {
+        ColorFramePtr color;
+        MaskFramePtr mask;
+        QByteArray skeleton; // Serialised on capture time, skeletons are shared with the producer
+        bool hasMask;
+        int captureId;
+    };
+
+    typedef shared_ptr<Capture> CapturePtr;
+
+    CaptureWriter(int poolSize = 8);
+    virtual ~CaptureWriter();
+
+    void setOutput(const QString& directory, const QString& prefix = "capture");
+    void setFormat(ImageFormat format, int quality = -1);
+    void setBatchSize(int size);
+
+    /**
+     * Request the capture of the next numFrames frames
+     */
+    void requestCapture(int numFrames = 1);
+    bool isCapturePending() const;
+
+    /**
+     * Return a buffer from the pool or nullptr if there isn't any capture pending. If the
+     * pool is exhausted the capture is dropped and nullptr is returned too. This method
+     * never blocks.
+     */
+    CapturePtr acquire();
+    void commit(CapturePtr capture);
+    void stop();
+
+    qint64 capturesWritten() const;
+    qint64 capturesDropped() const;
+
+protected:
+    void run() override;
+
+private:
+    void write(const Capture& capture);
+
+    mutable QMutex m_lock;
+    QWaitCondition m_sync;
+    QList<CapturePtr> m_pool;
+    QQueue<CapturePtr> m_queue;
+    bool m_running;
+    int m_pendingCaptures;
+    int m_nextCaptureId;
+    int m_batchSize;
+    qint64 m_written;
+    qint64 m_dropped;
+
+    // Output settings
+    QString m_directory;
+    QString m_prefix;
+    ImageFormat m_format;
+    int m_quality;
+};
+
+} // End Namespace
+
+#endif // CAPTUREWRITER_H
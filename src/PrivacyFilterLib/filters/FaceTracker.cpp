@@ -0,0 +1,252 @@
+#include "FaceTracker.h"
+#include <QDebug>
+#include <QSet>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace dai {
+
+static const float FACE_WIDTH = 160.0f;        // Milimeters
+static const float TRACK_MIN_SCORE = 0.6f;
+
+FaceTracker::FaceTracker(const QString& cascadeFile)
+    : m_redetectInterval(10)
+    , m_workInProgress(false)
+    , m_running(true)
+{
+    m_cascadeLoaded = m_cascade.load(cascadeFile.toStdString());
+
+    if (!m_cascadeLoaded)
+        qDebug() << "FaceTracker - Error loading cascade" << cascadeFile;
+
+    start();
+}
+
+FaceTracker::~FaceTracker()
+{
+    stop();
+}
+
+void FaceTracker::setRedetectInterval(int frames)
+{
+    QMutexLocker locker(&m_lock);
+    m_redetectInterval = frames > 0 ? frames : 1;
+}
+
+void FaceTracker::stop()
+{
+    m_lock.lock();
+    m_running = false;
+    m_workInProgress = true;
+    m_sync.wakeOne();
+    m_lock.unlock();
+
+    if (QThread::currentThread() != this)
+        this->wait();
+}
+
+QMap<int, cv::Rect> FaceTracker::faces() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_faces;
+}
+
+bool FaceTracker::computeHeadRegion(const Skeleton& skeleton, const ColorFrame& colorFrame, HeadRegion& region)
+{
+    const Point3f& head = skeleton.getJoint(SkeletonJoint::JOINT_HEAD).getPosition();
+
+    if (head[2] <= 0.0f)
+        return false;
+
+    // Milimeters are assumed for the face size
+    const float faceWidth = skeleton.distanceUnits() == DISTANCE_METERS ? FACE_WIDTH / 1000.0f : FACE_WIDTH;
+    float x, y, x2, y2;
+
+    skeleton.convertCoordinatesToDepth(head[0], head[1], head[2], &x, &y);
+    skeleton.convertCoordinatesToDepth(head[0] + faceWidth, head[1], head[2], &x2, &y2);
+    x -= colorFrame.offset()[0];
+    y -= colorFrame.offset()[1];
+
+    const int facePixels = std::max(8, int(std::abs(x2 - x)));
+    const int side = 3 * facePixels;
+    cv::Rect frameRect(0, 0, colorFrame.width(), colorFrame.height());
+    region.roi = cv::Rect(int(x) - side/2, int(y) - side/2, side, side) & frameRect;
+
+    if (region.roi.width < facePixels / 2 || region.roi.height < facePixels / 2)
+        return false;
+
+    region.minFace = cv::Size(facePixels / 2, facePixels / 2);
+    region.maxFace = cv::Size(facePixels * 2, facePixels * 2);
+
+    // Grey copy of the region (the colour frame is reused by the producer)
+    cv::Mat color_mat(colorFrame.height(), colorFrame.width(), CV_8UC3,
+                      (void*) colorFrame.getDataPtr(), colorFrame.getStride());
+    cv::cvtColor(color_mat(region.roi), region.gray, CV_RGB2GRAY);
+    return true;
+}
+
+bool FaceTracker::submit(const ColorFrame& colorFrame, const SkeletonFrame& skeletonFrame)
+{
+    m_lock.lock();
+    bool busy = m_workInProgress;
+    m_lock.unlock();
+
+    if (busy)
+        return false;
+
+    QList<HeadRegion> regions;
+
+    for (int userId : skeletonFrame.getAllUsersId())
+    {
+        HeadRegion region;
+        region.userId = userId;
+
+        if (computeHeadRegion(*skeletonFrame.getSkeleton(userId), colorFrame, region))
+            regions << region;
+    }
+
+    m_lock.lock();
+    m_regions = regions;
+    m_workInProgress = true;
+    m_sync.wakeOne();
+    m_lock.unlock();
+    return true;
+}
+
+void FaceTracker::run()
+{
+    forever {
+        m_lock.lock();
+        while (m_running && !m_workInProgress) {
+            m_sync.wait(&m_lock);
+        }
+
+        if (!m_running) {
+            m_lock.unlock();
+            break;
+        }
+
+        QList<HeadRegion> regions = m_regions;
+        m_regions.clear();
+        m_lock.unlock();
+
+        // Forget users that are not present anymore
+        QSet<int> users;
+
+        for (HeadRegion& region : regions) {
+            processRegion(region);
+            users << region.userId;
+        }
+
+        for (int userId : m_tracks.keys()) {
+            if (!users.contains(userId))
+                m_tracks.remove(userId);
+        }
+
+        // Publish results
+        QMap<int, cv::Rect> faces;
+
+        for (auto it = m_tracks.constBegin(); it != m_tracks.constEnd(); ++it)
+            faces.insert(it.key(), it.value().rect);
+
+        m_lock.lock();
+        m_faces = faces;
+        m_workInProgress = false;
+        m_lock.unlock();
+    }
+}
+
+void FaceTracker::processRegion(HeadRegion& region)
+{
+    m_lock.lock();
+    const int redetectInterval = m_redetectInterval;
+    m_lock.unlock();
+
+    bool found = false;
+    bool redetect = false;
+
+    if (m_tracks.contains(region.userId))
+    {
+        FaceTrack& faceTrack = m_tracks[region.userId];
+
+        if (faceTrack.framesSinceDetection >= redetectInterval) {
+            redetect = true;
+        }
+        else if (trackFace(region, faceTrack)) {
+            faceTrack.framesSinceDetection++;
+            found = true;
+        }
+    }
+
+    // Track lost or redetection time
+    if (!found) {
+        FaceTrack faceTrack;
+
+        if (detectFace(region, faceTrack)) {
+            m_tracks.insert(region.userId, faceTrack);
+        }
+        // A missed redetection keeps the face blurred while it can still be tracked,
+        // detection is tried again on the next frame
+        else if (redetect && trackFace(region, m_tracks[region.userId])) {
+            m_tracks[region.userId].framesSinceDetection++;
+        }
+        else {
+            m_tracks.remove(region.userId);
+        }
+    }
+}
+
+bool FaceTracker::detectFace(HeadRegion& region, FaceTrack& track)
+{
+    if (!m_cascadeLoaded)
+        return false;
+
+    cv::Mat equalised;
+    std::vector<cv::Rect> faces;
+    cv::equalizeHist(region.gray, equalised);
+    m_cascade.detectMultiScale(equalised, faces, 1.1, 2, 0 | CV_HAAR_SCALE_IMAGE, region.minFace, region.maxFace);
+
+    if (faces.empty())
+        return false;
+
+    // Keep the face closest to the projected head (center of the region)
+    cv::Point center(region.roi.width / 2, region.roi.height / 2);
+    size_t best = 0;
+    int bestDistance = INT_MAX;
+
+    for (size_t i=0; i<faces.size(); ++i) {
+        cv::Point diff = (faces[i].tl() + faces[i].br()) * 0.5 - center;
+        int distance = diff.x * diff.x + diff.y * diff.y;
+
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = i;
+        }
+    }
+
+    track.rect = faces[best] + region.roi.tl();
+    track.templ = region.gray(faces[best]).clone();
+    track.framesSinceDetection = 0;
+    return true;
+}
+
+bool FaceTracker::trackFace(const HeadRegion& region, FaceTrack& track) const
+{
+    if (track.templ.cols > region.gray.cols || track.templ.rows > region.gray.rows)
+        return false;
+
+    cv::Mat scores;
+    double maxScore;
+    cv::Point maxLoc;
+    cv::matchTemplate(region.gray, track.templ, scores, CV_TM_CCOEFF_NORMED);
+    cv::minMaxLoc(scores, nullptr, &maxScore, nullptr, &maxLoc);
+
+    if (maxScore < TRACK_MIN_SCORE)
+        return false;
+
+    track.rect = cv::Rect(maxLoc + region.roi.tl(), track.templ.size());
+    return true;
+}
+
+} // End Namespace
@@ -0,0 +1,84 @@
+#ifndef FACETRACKER_H
+#define FACETRACKER_H
+
+#include "types/ColorFrame.h"
+#include "types/SkeletonFrame.h"
+#include <QThread>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QMap>
+#include <opencv2/opencv.hpp>
+#include <opencv2/objdetect/objdetect.hpp>
+
+namespace dai {
+
+/**
+ * Finds the faces of the tracked users. Instead of running the cascade over the whole
+ * frame, it only searches inside a region around the projected JOINT_HEAD of each
+ * skeleton. Once a face is found it is tracked by template matching and the cascade is
+ * only run again every K frames or when the track is lost.
+ *
+ * Work is done in its own thread. While it is busy new frames are ignored, so
+ * submit() never blocks the caller. Results are read with faces().
+ *
+ * @brief The FaceTracker class
+ */
+class FaceTracker : public QThread
+{
+public:
+    explicit FaceTracker(const QString& cascadeFile = "haarcascade_frontalface_alt.xml");
+    virtual ~FaceTracker();
+
+    /**
+     * Prepare the head regions of the given frame and hand them to the worker. Returns
+     * false if the worker was busy and the frame has been ignored.
+     */
+    bool submit(const ColorFrame& colorFrame, const SkeletonFrame& skeletonFrame);
+
+    /**
+     * Last known face of each user in frame coordinates
+     */
+    QMap<int, cv::Rect> faces() const;
+    void setRedetectInterval(int frames);
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    struct HeadRegion {
+        int userId;
+        cv::Rect roi;       // Search region in frame coordinates
+        cv::Mat gray;       // Grey copy of roi
+        cv::Size minFace;
+        cv::Size maxFace;
+    };
+
+    struct FaceTrack {
+        cv::Rect rect;      // Frame coordinates
+        cv::Mat templ;
+        int framesSinceDetection;
+    };
+
+    static bool computeHeadRegion(const Skeleton& skeleton, const ColorFrame& colorFrame, HeadRegion& region);
+    void processRegion(HeadRegion& region);
+    bool detectFace(HeadRegion& region, FaceTrack& track);
+    bool trackFace(const HeadRegion& region, FaceTrack& track) const;
+
+    cv::CascadeClassifier m_cascade;
+    bool m_cascadeLoaded;
+    int m_redetectInterval;
+    QMap<int, FaceTrack> m_tracks; // Only used from the worker thread
+
+    // Shared with callers
+    mutable QMutex m_lock;
+    QWaitCondition m_sync;
+    QList<HeadRegion> m_regions;
+    QMap<int, cv::Rect> m_faces;
+    bool m_workInProgress;
+    bool m_running;
+};
+
+} // End Namespace
+
+#endif // FACETRACKER_H
@@ -0,0 +1,240 @@
+#include "PointCloudRenderer.h"
+#include "Parallel.h"
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef M_PI
+    #define M_PI 3.14159265359
+#endif
+
+namespace dai {
+
+static const RGBColor userColors[] = {
+    {90, 140, 200},
+    {200, 120, 80},
+    {110, 180, 110},
+    {190, 170, 70},
+    {160, 100, 180},
+    {80, 170, 170}
+};
+
+static const quint64 EMPTY_PIXEL = ~quint64(0);
+static const float NEAR_PLANE = 100.0f;    // mm
+static const float MAX_SPLAT = 16.0f;      // pixels
+static const int ROWS_PER_TASK = 16;
+
+// Depth (positive floats sort as integers) and colour in a single word
+inline static quint64 packPoint(float z, RGBColor color)
+{
+    quint32 bits;
+    memcpy(&bits, &z, sizeof(bits));
+    return (quint64(bits) << 32) | (quint32(color.red) << 16) | (quint32(color.green) << 8) | color.blue;
+}
+
+inline static RGBColor shadeColor(RGBColor color, float shade)
+{
+    return {uint8_t(color.red * shade), uint8_t(color.green * shade), uint8_t(color.blue * shade)};
+}
+
+PointCloudRenderer::PointCloudRenderer()
+    : m_threads(QThread::idealThreadCount())
+    , m_scaleX(1.0f)
+    , m_scaleY(1.0f)
+    , m_bufferSize(0)
+{
+    if (m_threads < 1)
+        m_threads = 1;
+}
+
+void PointCloudRenderer::setSettings(const Settings& settings)
+{
+    m_settings = settings;
+    m_settings.step = std::max(1, m_settings.step);
+}
+
+void PointCloudRenderer::setThreadsCount(int count)
+{
+    m_threads = std::max(1, count);
+}
+
+void PointCloudRenderer::render(const DepthFrame& depth, const MaskFrame& mask, ColorFrame& target, const ColorFrame* colour)
+{
+    Q_ASSERT(mask.width() == depth.width() && mask.height() == depth.height());
+
+    prepare(depth, target);
+
+    const int targetWidth = target.width();
+    const int targetHeight = target.height();
+    const int numTasks = (depth.height() + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    std::atomic<int> nextTask(0);
+
+    auto worker = [&]() {
+        int task;
+        while ((task = nextTask.fetch_add(1)) < numTasks) {
+            const int firstRow = task * ROWS_PER_TASK;
+            renderRows(depth, mask, colour, targetWidth, targetHeight, firstRow,
+                       std::min(firstRow + ROWS_PER_TASK, depth.height()));
+        }
+    };
+
+    runParallel(std::min(m_threads, numTasks), worker);
+
+    resolve(target);
+}
+
+void PointCloudRenderer::prepare(const DepthFrame& depth, const ColorFrame& target)
+{
+    const int width = depth.width();
+    const int height = depth.height();
+
+    // Rays of the pixels of the depth frame (real world coordinates at z = 1)
+    m_rayX.resize(width);
+    m_rayY.resize(height);
+
+    for (int j=0; j<width; ++j) {
+        float y;
+        depth.convertCoordinatesToWorld(j, 0, 1.0f, &m_rayX[j], &y);
+    }
+
+    for (int i=0; i<height; ++i) {
+        float x;
+        depth.convertCoordinatesToWorld(0, i, 1.0f, &x, &m_rayY[i]);
+    }
+
+    // Camera rotation: yaw around Y, then pitch around X
+    const float yaw = m_settings.yaw * float(M_PI) / 180.0f;
+    const float pitch = m_settings.pitch * float(M_PI) / 180.0f;
+    const float cy = std::cos(yaw), sy = std::sin(yaw);
+    const float cp = std::cos(pitch), sp = std::sin(pitch);
+    const float rotation[9] = {
+        cy,       0.0f, sy,
+        sp * sy,  cp,   -sp * cy,
+        -cp * sy, sp,   cp * cy
+    };
+    memcpy(m_rotation, rotation, sizeof(m_rotation));
+
+    m_scaleX = float(target.width()) / width;
+    m_scaleY = float(target.height()) / height;
+
+    // Depth buffer
+    const int size = target.width() * target.height();
+
+    if (size != m_bufferSize) {
+        m_buffer.reset(new std::atomic<quint64>[size]);
+        m_bufferSize = size;
+    }
+
+    for (int i=0; i<size; ++i)
+        m_buffer[i].store(EMPTY_PIXEL, std::memory_order_relaxed);
+}
+
+void PointCloudRenderer::renderRows(const DepthFrame& depth, const MaskFrame& mask, const ColorFrame* colour,
+                                    int targetWidth, int targetHeight, int firstRow, int lastRow)
+{
+    const int width = depth.width();
+    const int height = depth.height();
+    const int step = m_settings.step;
+    const float pivot = m_settings.pivotDepth;
+    const float* r = m_rotation;
+    const float zoom = m_settings.zoom;
+    const float splat = m_settings.splatSize * step * zoom * std::max(m_scaleX, m_scaleY);
+    const bool background = m_settings.drawBackground;
+    const bool useColour = background && m_settings.colourBackground && colour != nullptr;
+
+    // Rows aligned to step, so the points drawn don't depend on the tasks
+    firstRow = (firstRow + step - 1) / step * step;
+
+    for (int i=firstRow; i<lastRow; i+=step)
+    {
+        const uint16_t* pDepth = depth.getRowPtr(i);
+        const uint8_t* pMask = mask.getRowPtr(i);
+        const RGBColor* pColour = useColour ? colour->getRowPtr(i * colour->height() / height) : nullptr;
+        const float rayY = m_rayY[i];
+
+        for (int j=0; j<width; j+=step)
+        {
+            const uint16_t z = pDepth[j];
+            const uint8_t label = pMask[j];
+
+            if (z == 0 || label == 255 || (label == 0 && !background))
+                continue;
+
+            // Move the point to the virtual camera
+            const float x = m_rayX[j] * z;
+            const float y = rayY * z;
+            const float dz = z - pivot;
+            const float vx = r[0] * x + r[1] * y + r[2] * dz;
+            const float vy = r[3] * x + r[4] * y + r[5] * dz;
+            const float vz = r[6] * x + r[7] * y + r[8] * dz + pivot + m_settings.distance;
+
+            if (vz < NEAR_PLANE)
+                continue;
+
+            float u, v;
+            depth.convertWorldToCoordinates(vx, vy, vz, &u, &v);
+            u = ((u - width * 0.5f) * zoom + width * 0.5f) * m_scaleX;
+            v = ((v - height * 0.5f) * zoom + height * 0.5f) * m_scaleY;
+
+            // Splat covering the footprint of the pixel
+            const float size = std::min(std::max(splat * z / vz, 1.0f), MAX_SPLAT);
+            const int x0 = std::max(int(std::floor(u - size * 0.5f + 0.5f)), 0);
+            const int y0 = std::max(int(std::floor(v - size * 0.5f + 0.5f)), 0);
+            const int x1 = std::min(int(std::floor(u + size * 0.5f + 0.5f)), targetWidth);
+            const int y1 = std::min(int(std::floor(v + size * 0.5f + 0.5f)), targetHeight);
+
+            if (x0 >= x1 || y0 >= y1)
+                continue;
+
+            // Nearer points are brighter
+            const float shade = std::min(std::max(1.2f - vz / 6000.0f, 0.35f), 1.0f);
+            RGBColor color;
+
+            if (label > 0)
+                color = shadeColor(userColors[label % (sizeof(userColors) / sizeof(RGBColor))], shade);
+            else if (pColour)
+                color = pColour[j * colour->width() / width];
+            else
+                color = shadeColor({180, 180, 180}, shade);
+
+            const quint64 point = packPoint(vz, color);
+
+            for (int ty=y0; ty<y1; ++ty)
+            {
+                std::atomic<quint64>* pBuffer = &m_buffer[ty * targetWidth];
+
+                for (int tx=x0; tx<x1; ++tx)
+                {
+                    quint64 current = pBuffer[tx].load(std::memory_order_relaxed);
+
+                    while (point < current && !pBuffer[tx].compare_exchange_weak(current, point, std::memory_order_relaxed))
+                        ;
+                }
+            }
+        }
+    }
+}
+
+void PointCloudRenderer::resolve(ColorFrame& target) const
+{
+    const bool background = m_settings.drawBackground;
+
+    for (int i=0; i<target.height(); ++i)
+    {
+        const std::atomic<quint64>* pBuffer = &m_buffer[i * target.width()];
+        RGBColor* pTarget = target.getRowPtr(i);
+
+        for (int j=0; j<target.width(); ++j)
+        {
+            const quint64 point = pBuffer[j].load(std::memory_order_relaxed);
+
+            if (point != EMPTY_PIXEL)
+                pTarget[j] = {uint8_t(point >> 16), uint8_t(point >> 8), uint8_t(point)};
+            else if (background)
+                pTarget[j] = {0, 0, 0};
+        }
+    }
+}
+
+} // End Namespace
@@ -0,0 +1,76 @@
+#ifndef POINTCLOUDRENDERER_H
+#define POINTCLOUDRENDERER_H
+
+#include "types/ColorFrame.h"
+#include "types/DepthFrame.h"
+#include "types/MaskFrame.h"
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+namespace dai {
+
+/**
+ * CPU renderer of the point cloud of a DepthFrame seen from a virtual camera
+ * (FILTER_POINTCLOUD). It replaces Scene3DPainter and OgrePointCloud when there is no
+ * GL context, so it can be used on servers.
+ *
+ * Each pixel of the depth frame is taken to real world coordinates with the intrinsics
+ * of the frame, moved around a pivot in front of the sensor and projected back with the
+ * same intrinsics. Points are drawn as square splats whose size follows their distance to
+ * the virtual camera, so surfaces stay closed when the camera moves, and the nearest
+ * point wins on each pixel. Users are painted with a flat colour per label (1..254) and
+ * the border of the mask (255) is not drawn, so nothing of the user's appearance is kept.
+ *
+ * Source rows are processed in parallel. Depth and colour of each splat are packed in a
+ * single 64-bit word, so the depth test is an atomic minimum and the result doesn't
+ * depend on the order of the threads.
+ *
+ * @brief The PointCloudRenderer class
+ */
+class PointCloudRenderer
+{
+public:
+    struct Settings {
+        float yaw = 0.0f;               // Degrees the camera turns around the vertical axis of the pivot
+        float pitch = 0.0f;             // Degrees the camera turns around the horizontal axis of the pivot
+        float pivotDepth = 2500.0f;     // mm in front of the sensor the camera turns around
+        float distance = 0.0f;          // mm the camera moves back
+        float zoom = 1.0f;
+        float splatSize = 1.5f;         // Side of a splat, in pixels of the depth frame
+        int step = 1;                   // Only one of every step rows and columns is drawn
+        bool drawBackground = true;     // If false, only users are drawn over the target
+        bool colourBackground = true;   // Background points take the colour of their pixel
+    };
+
+    PointCloudRenderer();
+    void setSettings(const Settings& settings);
+    const Settings& settings() const {return m_settings;}
+    void setThreadsCount(int count);
+
+    /**
+     * Draw the points of depth into target. mask must be the size of depth. target may
+     * have another size, and colour (used for the background points) too. When the
+     * background is drawn, pixels that no point reaches are black.
+     */
+    void render(const DepthFrame& depth, const MaskFrame& mask, ColorFrame& target, const ColorFrame* colour = nullptr);
+
+private:
+    void prepare(const DepthFrame& depth, const ColorFrame& target);
+    void renderRows(const DepthFrame& depth, const MaskFrame& mask, const ColorFrame* colour,
+                    int targetWidth, int targetHeight, int firstRow, int lastRow);
+    void resolve(ColorFrame& target) const;
+
+    Settings m_settings;
+    int m_threads;
+    QVector<float> m_rayX;              // Real world x/z of each column
+    QVector<float> m_rayY;              // Real world y/z of each row
+    float m_rotation[9];                // Row-major, pitch after yaw
+    float m_scaleX, m_scaleY;           // Depth pixels to target pixels
+    std::unique_ptr<std::atomic<quint64>[]> m_buffer; // Depth (high bits) and colour of each target pixel
+    int m_bufferSize;
+};
+
+} // End Namespace
+
+#endif // POINTCLOUDRENDERER_H
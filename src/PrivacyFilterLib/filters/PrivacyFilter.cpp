@@ -20,7 +20,10 @@
 #include "ml/KMeans.h"
 #include <cmath>
 #include "opencv_utils.h"
+#include "opencv_utils_simd.h"
+#include "playback/Tracer.h"
 #include <QLabel>
+#include <QFileInfo>
 
 void PrivacyLib_InitResources()
 {
@@ -29,16 +32,22 @@ void PrivacyLib_InitResources()
 
 namespace dai {
 
-PrivacyFilter::PrivacyFilter()
+PrivacyFilter::PrivacyFilter(bool softwareRendering)
     : m_glContext(nullptr)
     , m_gles(nullptr)
     , m_initialised(false)
+    , m_scene(nullptr)
+    , m_ogreScene(nullptr)
     , m_fboDisplay(nullptr)
     , m_filter(FILTER_DISABLED)
     , m_file("data.csv")
     , m_out(&m_file)
-    , m_make_capture(false)
+    , m_softwareRendering(softwareRendering)
 {
+    // Headless mode doesn't need any surface
+    if (m_softwareRendering)
+        return;
+
     QSurfaceFormat format;
     format.setMajorVersion(2);
     format.setMinorVersion(0);
@@ -56,17 +65,13 @@ PrivacyFilter::PrivacyFilter()
 
     m_scene = new Scene2DPainter;
     m_ogreScene = new OgreScene;
-
-    // haarcascade_frontalface_default
-    // haarcascade_frontalface_alt.xml
-    if (!m_face_cascade.load("haarcascade_frontalface_alt.xml"))
-        qDebug() << "Error loading cascades";
 }
 
 PrivacyFilter::~PrivacyFilter()
 {
    stopListener();
    freeResources();
+   enableFaceBlurring(false);
    if (m_file.isOpen())
        m_file.close();
    qDebug() << "PrivacyFilter::~PrivacyFilter";
@@ -76,6 +81,13 @@ void PrivacyFilter::initialise(int width, int height)
 {
     m_width = width;
     m_height = height;
+
+    if (m_softwareRendering) {
+        m_softwareRenderer.resetBackground();
+        m_initialised = true;
+        return;
+    }
+
     m_glContext = new QOpenGLContext;
     m_glContext->setFormat(m_surface.format());
 
@@ -146,6 +158,9 @@ void PrivacyFilter::resize(int width, int height)
     m_width = width;
     m_height = height;
 
+    if (m_softwareRendering)
+        return;
+
     m_scene->setAvatarTexture(m_ogreScene->texture());
 
     m_glContext->makeCurrent(&m_surface);
@@ -206,6 +221,7 @@ void PrivacyFilter::newFrames(const QHashDataFrames dataFrames)
     }
     else {
         qDebug() << "PrivacyFilter - Frame copied out of time";
+        Tracer::instant(listenerName(), "expired", Tracer::currentFrame());
     }
 }
 
@@ -237,6 +253,28 @@ void PrivacyFilter::singleFrame(const QHashDataFrames dataFrames, int width, int
     }
 }
 
+void PrivacyFilter::filterFrames(QHashDataFrames& frames, int width, int height)
+{
+    if (!m_initialised) {
+        initialise(width, height);
+    } else {
+        resize(width, height);
+    }
+
+    produceFrames(frames);
+}
+
+void PrivacyFilter::setRenderingThreads(int count)
+{
+    m_softwareRenderer.setThreadsCount(count);
+    m_pointCloudRenderer.setThreadsCount(count);
+}
+
+void PrivacyFilter::describeFrame(FrameInfo& info)
+{
+    info.copyPacing(frameInfo());
+}
+
 void PrivacyFilter::produceFrames(QHashDataFrames &output)
 {
     Q_ASSERT(output.contains(DataFrame::Color) && output.contains(DataFrame::Mask));
@@ -244,23 +282,161 @@ void PrivacyFilter::produceFrames(QHashDataFrames &output)
     ColorFramePtr colorFrame = static_pointer_cast<ColorFrame>(output.value(DataFrame::Color));
     MaskFramePtr maskFrame = static_pointer_cast<MaskFrame>(output.value(DataFrame::Mask));
 
-    // Dilate mask to create a wide border (value = 255)
-    shared_ptr<MaskFrame> outputMask = static_pointer_cast<MaskFrame>(maskFrame->clone());
-    dilateUserMask(const_cast<uint8_t*>(outputMask->getDataPtr()));
+    // Snapshot input mask and skeletons before they are modified (only when capturing)
+    CaptureWriter::CapturePtr capture = m_capture.acquire();
+
+    if (capture) {
+        *capture->mask = *maskFrame;
+        capture->hasMask = true;
+
+        if (output.contains(DataFrame::Skeleton))
+            capture->skeleton = static_pointer_cast<SkeletonFrame>(output.value(DataFrame::Skeleton))->toBinary();
+    }
+
+    // Users are split by filter before the border is added
+    reloadPolicy();
+    PrivacyPolicyPtr currentPolicy = policy();
+    QList<PrivacyPolicy::Assignment> assignments;
+
+    if (currentPolicy) {
+        MetadataFrame* metadataFrame = output.contains(DataFrame::Metadata)
+                ? static_pointer_cast<MetadataFrame>(output.value(DataFrame::Metadata)).get() : nullptr;
+        assignments = currentPolicy->apply(*maskFrame, metadataFrame);
+    }
+
+    addMaskBorder(*maskFrame);
+
+    // Kept alive while this frame is filtered, even if face blurring is disabled meanwhile
+    m_policyLock.lock();
+    shared_ptr<FaceTracker> faceTracker = m_faceTracker;
+    m_policyLock.unlock();
+
+    // Look for faces around the heads (asynchronous, results are used on next frames)
+    if (faceTracker && output.contains(DataFrame::Skeleton)) {
+        faceTracker->submit(*colorFrame, *static_pointer_cast<SkeletonFrame>(output.value(DataFrame::Skeleton)));
+    }
 
-    for (int i=0; i<maskFrame->height(); ++i)
+    // Render the filter (policy, point cloud, software or OpenGL scene)
     {
-        for (int j=0; j<maskFrame->width(); ++j)
-        {
-            uint8_t inputValue = maskFrame->getItem(i,j);
-            uint8_t outputValue = outputMask->getItem(i,j);
+        TraceScope scope(generatorName(), "render");
+        ColorFilter filter = m_filter;
+
+        // Users can't be drawn as points without depth
+        if (filter == FILTER_POINTCLOUD && !output.contains(DataFrame::Depth))
+            filter = FILTER_INVISIBILITY;
+
+        if (currentPolicy) {
+            renderPolicy(assignments, output, colorFrame, maskFrame);
+        }
+        else if (filter == FILTER_POINTCLOUD) {
+            if (m_softwareRendering)
+                m_softwareRenderer.updateBackground(*colorFrame, *maskFrame);
+
+            renderPointCloud(output, *colorFrame, *maskFrame, true);
+        }
+        else if (m_softwareRendering) {
+            SkeletonFramePtr skeletonFrame = output.contains(DataFrame::Skeleton)
+                    ? static_pointer_cast<SkeletonFrame>(output.value(DataFrame::Skeleton)) : nullptr;
+            m_softwareRenderer.render(filter, colorFrame, maskFrame, skeletonFrame);
+        }
+        else {
+            renderScene(output, colorFrame, maskFrame, filter);
+        }
+    }
+
+    if (faceTracker)
+        pixelateFaces(colorFrame, faceTracker->faces());
+
+    // Hand the output to the capture writer (encoded in background)
+    if (capture) {
+        *capture->color = *colorFrame;
+        m_capture.commit(capture);
+    }
+}
+
+/**
+ * Render each group of users with its own filter. Every filter is applied over the
+ * output of the previous one, and only touches the pixels of its users. Users with
+ * FILTER_POINTCLOUD are removed and their points drawn over the frame, without moving
+ * the rest of the scene.
+ */
+void PrivacyFilter::renderPolicy(const QList<PrivacyPolicy::Assignment>& assignments, QHashDataFrames& output,
+                                 ColorFramePtr colorFrame, MaskFramePtr maskFrame)
+{
+    SkeletonFramePtr skeletonFrame = output.contains(DataFrame::Skeleton)
+            ? static_pointer_cast<SkeletonFrame>(output.value(DataFrame::Skeleton)) : nullptr;
+
+    // The background is learned once with the mask of every user
+    if (m_softwareRendering)
+        m_softwareRenderer.updateBackground(*colorFrame, *maskFrame);
+
+    for (const PrivacyPolicy::Assignment& assignment : assignments)
+    {
+        if (assignment.filter == FILTER_DISABLED)
+            continue;
 
-            if (inputValue == 0 && outputValue > 0) {
-                maskFrame->setItem(i, j, uint8_t(255));
+        const bool pointCloud = assignment.filter == FILTER_POINTCLOUD && output.contains(DataFrame::Depth);
+        const ColorFilter filter = assignment.filter == FILTER_POINTCLOUD ? FILTER_INVISIBILITY : assignment.filter;
+
+        addMaskBorder(*assignment.mask, maskFrame.get());
+
+        // Only the skeletons of the users of this filter are drawn
+        SkeletonFramePtr userSkeletons;
+
+        if (skeletonFrame) {
+            userSkeletons = make_shared<SkeletonFrame>(skeletonFrame->width(), skeletonFrame->height());
+
+            for (int userId : assignment.users) {
+                SkeletonPtr skeleton = skeletonFrame->getSkeleton(userId);
+                if (skeleton)
+                    userSkeletons->setSkeleton(userId, skeleton);
             }
         }
+
+        if (m_softwareRendering) {
+            m_softwareRenderer.renderFilter(filter, *colorFrame, *assignment.mask, userSkeletons);
+        }
+        else {
+            QHashDataFrames frames = output;
+            frames.insert(DataFrame::Mask, assignment.mask);
+
+            if (userSkeletons)
+                frames.insert(DataFrame::Skeleton, userSkeletons);
+
+            renderScene(frames, colorFrame, assignment.mask, filter);
+        }
+
+        if (pointCloud)
+            renderPointCloud(output, *colorFrame, *assignment.mask, false);
+    }
+}
+
+/**
+ * Render the point cloud of the depth frame into colorFrame. If background is false only
+ * the users of maskFrame are drawn, over the current content of colorFrame.
+ */
+void PrivacyFilter::renderPointCloud(QHashDataFrames& output, ColorFrame& colorFrame, const MaskFrame& maskFrame, bool background)
+{
+    shared_ptr<DepthFrame> depthFrame = static_pointer_cast<DepthFrame>(output.value(DataFrame::Depth));
+
+    m_policyLock.lock();
+    PointCloudRenderer::Settings settings = m_pointCloudSettings;
+    m_policyLock.unlock();
+
+    settings.drawBackground = background;
+    m_pointCloudRenderer.setSettings(settings);
+
+    // Background points take their colour from the frame before it is replaced
+    if (background && settings.colourBackground) {
+        ColorFrame source = colorFrame;
+        m_pointCloudRenderer.render(*depthFrame, maskFrame, colorFrame, &source);
+    } else {
+        m_pointCloudRenderer.render(*depthFrame, maskFrame, colorFrame);
     }
+}
 
+void PrivacyFilter::renderScene(QHashDataFrames& output, ColorFramePtr colorFrame, MaskFramePtr maskFrame, ColorFilter filter)
+{
     //
     // Prepare Scene
     //
@@ -302,9 +478,9 @@ void PrivacyFilter::produceFrames(QHashDataFrames &output)
     }
 
     // Enable Filter
-    m_scene->enableFilter(m_filter);
+    m_scene->enableFilter(filter);
 
-    if (m_filter == FILTER_3DMODEL && output.contains(DataFrame::Skeleton))
+    if (filter == FILTER_3DMODEL && output.contains(DataFrame::Skeleton))
         m_ogreScene->enableFilter(true);
     else
         m_ogreScene->enableFilter(false);
@@ -333,26 +509,6 @@ void PrivacyFilter::produceFrames(QHashDataFrames &output)
     convertQImage2ColorFrame(m_fboDisplay->toImage().mirrored(), colorFrame);
 
 
-    // Face detection
-    /*std::vector<cv::Rect> faces = faceDetection(colorFrame);
-
-    cv::Mat color_mat(colorFrame->height(), colorFrame->width(), CV_8UC3,
-                      (void*) colorFrame->getDataPtr(), colorFrame->getStride());
-
-    for (size_t i = 0; i < faces.size(); i++) {
-        cv::rectangle(color_mat, faces[i], cv::Scalar(255, 255, 0));
-    }*/
-
-    // Save color as JPEG
-    if (m_make_capture) {
-        static int capture_id = 1;
-        QImage image( (uchar*) colorFrame->getDataPtr(), colorFrame->width(), colorFrame->height(),
-                      colorFrame->getStride(), QImage::Format_RGB888);
-        image.save("data/capture_" + QString::number(capture_id) + ".png");
-        capture_id++;
-        m_make_capture = false;
-    }
-
     m_fboDisplay->release();
     m_glContext->doneCurrent();
 }
@@ -365,7 +521,17 @@ void PrivacyFilter::afterStop()
 
 void PrivacyFilter::captureImage()
 {
-    m_make_capture = true;
+    m_capture.requestCapture(1);
+}
+
+void PrivacyFilter::captureBurst(int numFrames)
+{
+    m_capture.requestCapture(numFrames);
+}
+
+void PrivacyFilter::setCaptureFormat(CaptureWriter::ImageFormat format, int quality)
+{
+    m_capture.setFormat(format, quality);
 }
 
 void PrivacyFilter::enableFilter(ColorFilter filterType)
@@ -373,6 +539,103 @@ void PrivacyFilter::enableFilter(ColorFilter filterType)
     m_filter = filterType;
 }
 
+void PrivacyFilter::setPolicy(PrivacyPolicyPtr policy)
+{
+    QMutexLocker locker(&m_policyLock);
+    m_policy = policy;
+    m_policyFile.clear();
+}
+
+PrivacyPolicyPtr PrivacyFilter::policy() const
+{
+    QMutexLocker locker(&m_policyLock);
+    return m_policy;
+}
+
+bool PrivacyFilter::loadPolicy(const QString& fileName)
+{
+    PrivacyPolicyPtr policy = PrivacyPolicy::load(fileName);
+
+    if (!policy)
+        return false;
+
+    QMutexLocker locker(&m_policyLock);
+    m_policy = policy;
+    m_policyFile = fileName;
+    m_policyModified = QFileInfo(fileName).lastModified();
+    m_policyCheck.start();
+    return true;
+}
+
+void PrivacyFilter::setPointCloudSettings(const PointCloudRenderer::Settings& settings)
+{
+    QMutexLocker locker(&m_policyLock);
+    m_pointCloudSettings = settings;
+}
+
+// Called from the filter thread, the file is loaded without holding the lock
+void PrivacyFilter::reloadPolicy()
+{
+    m_policyLock.lock();
+    const QString fileName = m_policyFile;
+    bool check = !fileName.isEmpty() && m_policyCheck.elapsed() >= 1000;
+
+    if (check)
+        m_policyCheck.restart();
+
+    const QDateTime previousModified = m_policyModified;
+    m_policyLock.unlock();
+
+    if (!check)
+        return;
+
+    const QDateTime modified = QFileInfo(fileName).lastModified();
+
+    if (modified == previousModified)
+        return;
+
+    PrivacyPolicyPtr policy = PrivacyPolicy::load(fileName);
+
+    QMutexLocker locker(&m_policyLock);
+
+    // Another policy may have been set meanwhile
+    if (m_policyFile != fileName)
+        return;
+
+    m_policyModified = modified;
+
+    if (policy) {
+        m_policy = policy;
+        qDebug() << "PrivacyFilter: Policy reloaded" << fileName;
+    } else {
+        qDebug() << "PrivacyFilter: Policy not reloaded, the previous one is kept";
+    }
+}
+
+/**
+ * Dilate mask to create a wide border (value = 255). If otherUsers is given, the border
+ * doesn't cover the users of that mask.
+ */
+void PrivacyFilter::addMaskBorder(MaskFrame& maskFrame, const MaskFrame* otherUsers)
+{
+    shared_ptr<MaskFrame> outputMask = static_pointer_cast<MaskFrame>(maskFrame.clone());
+    dilateUserMask(const_cast<uint8_t*>(outputMask->getDataPtr()));
+
+    for (int i=0; i<maskFrame.height(); ++i)
+    {
+        uint8_t* inputRow = maskFrame.getRowPtr(i);
+        const uint8_t* outputRow = outputMask->getRowPtr(i);
+        const uint8_t* usersRow = otherUsers ? otherUsers->getRowPtr(i) : nullptr;
+
+        for (int j=0; j<maskFrame.width(); ++j)
+        {
+            if (inputRow[j] == 0 && outputRow[j] > 0 && (!usersRow || usersRow[j] == 0 || usersRow[j] == 255)) {
+                inputRow[j] = 255;
+            }
+        }
+    }
+}
+
 void PrivacyFilter::dilateUserMask(uint8_t *labels)
 {
     int dilationSize = 22;
@@ -383,52 +646,59 @@ void PrivacyFilter::dilateUserMask(uint8_t *labels)
     cv::dilate(newImag, newImag, kernel);
 }
 
-std::vector<cv::Rect> PrivacyFilter::faceDetection(shared_ptr<ColorFrame> frame)
+void PrivacyFilter::enableFaceBlurring(bool value)
 {
-    Q_ASSERT(frame != nullptr);
+    shared_ptr<FaceTracker> previous;
 
-    using namespace cv;
+    QMutexLocker locker(&m_policyLock);
 
-    Mat color_mat(frame->height(), frame->width(), CV_8UC3,
-                      (void*) frame->getDataPtr(), frame->getStride());
+    if (value && !m_faceTracker) {
+        m_faceTracker = make_shared<FaceTracker>();
+    }
+    else if (!value && m_faceTracker) {
+        previous = m_faceTracker; // Stopped out of the lock, or by the filter thread if it's using it
+        m_faceTracker.reset();
+    }
 
-    Mat gray_mat;
-    cvtColor(color_mat, gray_mat, CV_RGB2GRAY);
-    equalizeHist(gray_mat, gray_mat);
-    return faceDetection(gray_mat, true);
+    locker.unlock();
 }
 
-std::vector<cv::Rect> PrivacyFilter::faceDetection(cv::Mat frameGray, bool equalised)
+bool PrivacyFilter::isFaceBlurringEnabled() const
 {
-    using namespace cv;
-    std::vector<cv::Rect> faces;
+    QMutexLocker locker(&m_policyLock);
+    return m_faceTracker != nullptr;
+}
 
-    if (!equalised) {
-        equalizeHist( frameGray, frameGray );
-    }
+void PrivacyFilter::pixelateFaces(ColorFramePtr colorFrame, const QMap<int, cv::Rect>& faces)
+{
+    const int blockSize = 12;
+    cv::Mat color_mat(colorFrame->height(), colorFrame->width(), CV_8UC3,
+                      (void*) colorFrame->getDataPtr(), colorFrame->getStride());
+    cv::Rect frameRect(0, 0, colorFrame->width(), colorFrame->height());
+
+    for (cv::Rect face : faces) {
+        face &= frameRect;
 
-    // Detect faces
-    m_face_cascade.detectMultiScale( frameGray, faces, 1.1, 2, 0 | CV_HAAR_SCALE_IMAGE, cv::Size(30, 30));
+        if (face.width < 2 || face.height < 2)
+            continue;
 
-    return faces;
+        cv::Mat face_mat = color_mat(face);
+        cv::Mat small_mat;
+        cv::resize(face_mat, small_mat, cv::Size(std::max(1, face.width / blockSize), std::max(1, face.height / blockSize)),
+                   0, 0, cv::INTER_AREA);
+        cv::resize(small_mat, face_mat, face.size(), 0, 0, cv::INTER_NEAREST);
+    }
 }
 
 void PrivacyFilter::convertQImage2ColorFrame(const QImage& input_img, ColorFramePtr output_img)
 {
     Q_ASSERT(input_img.width() == output_img->width() && input_img.height() == output_img->height());
-    cv::Mat res(input_img.height(), input_img.width(), CV_8UC4, (uchar*) input_img.constBits(), input_img.bytesPerLine());
+    Q_ASSERT(input_img.depth() == 32);
 
-    for (int i=0; i<res.rows; ++i)
+    // 32 bits QImages are BGRA in memory
+    for (int i=0; i<input_img.height(); ++i)
     {
-        cv::Vec4b* in_pixel = res.ptr<cv::Vec4b>(i);
-        RGBColor* out_pixel = output_img->getRowPtr(i);
-
-        for (int j=0; j<res.cols; ++j)
-        {
-            out_pixel[j].red = in_pixel[j][2];
-            out_pixel[j].green = in_pixel[j][1];
-            out_pixel[j].blue = in_pixel[j][0];
-        }
+        simd::bgra2RgbRow(input_img.constScanLine(i), (uint8_t*) output_img->getRowPtr(i), input_img.width());
     }
 
     /*QLabel* label = new QLabel;
@@ -5,11 +5,18 @@
 #include "playback/FrameGenerator.h"
 #include <QOffscreenSurface>
 #include <opencv2/opencv.hpp>
-#include <opencv2/objdetect/objdetect.hpp>
 #include <QImage>
 #include <QFile>
+#include <QMutex>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include "types/ColorFrame.h"
 #include "viewer/types.h"
+#include "filters/SoftwareRenderer.h"
+#include "filters/PointCloudRenderer.h"
+#include "filters/CaptureWriter.h"
+#include "filters/FaceTracker.h"
+#include "filters/PrivacyPolicy.h"
 
 extern void PrivacyLib_InitResources();
 
@@ -36,35 +43,93 @@ class PrivacyFilter : public FrameListener, public FrameGenerator
     ColorFilter m_filter;
     QFile m_file;
     QTextStream m_out;
-    bool m_make_capture;
-    cv::CascadeClassifier m_face_cascade;
+    CaptureWriter m_capture;
     int m_width = 640;
     int m_height = 480;
     bool m_paused = false;
+    bool m_softwareRendering;
+    SoftwareRenderer m_softwareRenderer;
+    PointCloudRenderer m_pointCloudRenderer;
+    PointCloudRenderer::Settings m_pointCloudSettings;
+    shared_ptr<FaceTracker> m_faceTracker; // Guarded by m_policyLock
+    PrivacyPolicyPtr m_policy;
+    QString m_policyFile;
+    QDateTime m_policyModified;
+    QElapsedTimer m_policyCheck;
+    mutable QMutex m_policyLock;
 
 public:
     static void convertQImage2ColorFrame(const QImage &input_img, ColorFramePtr output_img);
 
-    PrivacyFilter();
+    /**
+     * When softwareRendering is true no GL context is created and the filters are
+     * rendered on the CPU by SoftwareRenderer (headless mode).
+     */
+    explicit PrivacyFilter(bool softwareRendering = false);
     ~PrivacyFilter();
     void newFrames(const QHashDataFrames dataFrames) override;
     void singleFrame(const QHashDataFrames dataFrames, int width, int height);
+
+    /**
+     * Filter the given frames in the calling thread. Unlike singleFrame, frames are
+     * modified in place and listeners are not notified, so no frame can be dropped.
+     */
+    void filterFrames(QHashDataFrames& frames, int width, int height);
     void enableFilter(ColorFilter filterType);
     void captureImage();
+    void captureBurst(int numFrames);
+    void setCaptureFormat(CaptureWriter::ImageFormat format, int quality = -1);
     void resize(int width, int height);
+    void setRenderingThreads(int count);
     void pause();
+    const char* listenerName() const override {return "PrivacyFilter";}
+    const char* generatorName() const override {return "PrivacyFilter";}
+
+    /**
+     * Pixelate the faces of the tracked users. Faces are searched around the head joint
+     * by a FaceTracker running in its own thread. It can be changed while frames are
+     * being filtered.
+     */
+    void enableFaceBlurring(bool value);
+    bool isFaceBlurringEnabled() const;
+
+    /**
+     * Choose the filter of each user with policy instead of the filter given by
+     * enableFilter. It can be replaced while frames are being filtered, and nullptr
+     * goes back to a single filter.
+     */
+    void setPolicy(PrivacyPolicyPtr policy);
+    PrivacyPolicyPtr policy() const;
+
+    /**
+     * Load the policy from fileName. While filtering, the file is checked every second
+     * and loaded again when it changes. If it is wrong the current policy is kept.
+     */
+    bool loadPolicy(const QString& fileName);
+
+    /**
+     * Virtual camera of FILTER_POINTCLOUD. The point cloud is always rendered on the CPU,
+     * and frames without depth get FILTER_INVISIBILITY instead.
+     */
+    void setPointCloudSettings(const PointCloudRenderer::Settings& settings);
 
 protected:
     void initialise(int width = 640, int height = 480);
     void afterStop() override;
     shared_ptr<QHashDataFrames> allocateMemory() override;
     void produceFrames(QHashDataFrames& output) override;
+    void describeFrame(FrameInfo& info) override;
     void freeResources();
 
 private:
+    void renderScene(QHashDataFrames& output, ColorFramePtr colorFrame, MaskFramePtr maskFrame, ColorFilter filter);
+    void renderPolicy(const QList<PrivacyPolicy::Assignment>& assignments, QHashDataFrames& output,
+                      ColorFramePtr colorFrame, MaskFramePtr maskFrame);
+    void renderPointCloud(QHashDataFrames& output, ColorFrame& colorFrame, const MaskFrame& maskFrame, bool background);
+    void reloadPolicy();
+    void addMaskBorder(MaskFrame& maskFrame, const MaskFrame* otherUsers = nullptr);
     void dilateUserMask(uint8_t *labels);
-    std::vector<cv::Rect> faceDetection(shared_ptr<ColorFrame> frame);
-    std::vector<cv::Rect> faceDetection(cv::Mat frameGray, bool equalised = false);
+    void pixelateFaces(ColorFramePtr colorFrame, const QMap<int, cv::Rect>& faces);
 };
 
 } // End Namespace
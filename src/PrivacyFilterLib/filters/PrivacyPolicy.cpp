@@ -0,0 +1,295 @@
+#include "PrivacyPolicy.h"
+#include <QSettings>
+#include <QStringList>
+#include <QFile>
+#include <QDebug>
+
+namespace dai {
+
+PrivacyPolicyPtr PrivacyPolicy::load(const QString& fileName)
+{
+    if (!QFile::exists(fileName)) {
+        qDebug() << "Policy file not found" << fileName;
+        return nullptr;
+    }
+
+    QSettings settings(fileName, QSettings::IniFormat);
+
+    if (settings.status() != QSettings::NoError) {
+        qDebug() << "Policy file couldn't be read" << fileName;
+        return nullptr;
+    }
+
+    // Keys of [General] are top level keys for QSettings
+    ColorFilter defaultFilter;
+
+    if (!filterFromName(settings.value("default", "disabled").toString(), &defaultFilter)) {
+        qDebug() << "Unknown default filter in" << fileName;
+        return nullptr;
+    }
+
+    shared_ptr<PrivacyPolicy> policy = make_shared<PrivacyPolicy>(defaultFilter);
+    QStringList groups = settings.childGroups();
+    groups.sort();
+
+    for (const QString& group : groups)
+    {
+        settings.beginGroup(group);
+
+        Rule rule;
+        bool valid = filterFromName(settings.value("filter").toString(), &rule.filter);
+        rule.user = settings.value("user", 0).toInt();
+
+        // Nothing identifies the users while filtering yet
+        if (settings.contains("identity")) {
+            qDebug() << "Identity rules aren't supported, rule" << group << "in" << fileName;
+            valid = false;
+        }
+
+        const QStringList region = settings.value("region").toStringList();
+
+        if (region.size() == 4) {
+            rule.region = QRect(region[0].toInt(), region[1].toInt(), region[2].toInt(), region[3].toInt());
+        } else {
+            valid &= region.isEmpty();
+        }
+
+        const QString match = settings.value("match", "pixels").toString();
+        rule.wholeUser = match == "user";
+        valid &= rule.wholeUser || match == "pixels";
+
+        const QStringList distance = settings.value("distance").toStringList();
+
+        if (distance.size() == 2) {
+            rule.minDistance = distance[0].toFloat();
+            rule.maxDistance = distance[1].toFloat();
+        } else {
+            valid &= distance.isEmpty();
+        }
+
+        settings.endGroup();
+
+        if (!valid) {
+            qDebug() << "Invalid rule" << group << "in" << fileName;
+            return nullptr;
+        }
+
+        policy->addRule(rule);
+    }
+
+    return policy;
+}
+
+QString PrivacyPolicy::filterName(ColorFilter filter)
+{
+    switch (filter) {
+    case FILTER_DISABLED:     return "disabled";
+    case FILTER_INVISIBILITY: return "invisibility";
+    case FILTER_BLUR:         return "blur";
+    case FILTER_PIXELATION:   return "pixelation";
+    case FILTER_EMBOSS:       return "emboss";
+    case FILTER_SILHOUETTE:   return "silhouette";
+    case FILTER_SKELETON:     return "skeleton";
+    case FILTER_3DMODEL:      return "3dmodel";
+    case FILTER_POINTCLOUD:   return "pointcloud";
+    }
+
+    return "unknown";
+}
+
+bool PrivacyPolicy::filterFromName(const QString& name, ColorFilter* filter)
+{
+    for (int i=FILTER_DISABLED; i<=FILTER_POINTCLOUD; ++i) {
+        if (name.compare(filterName(ColorFilter(i)), Qt::CaseInsensitive) == 0) {
+            *filter = ColorFilter(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+PrivacyPolicy::PrivacyPolicy(ColorFilter defaultFilter)
+    : m_defaultFilter(defaultFilter)
+{
+    m_defaultRule.filter = defaultFilter;
+}
+
+void PrivacyPolicy::addRule(const Rule& rule)
+{
+    m_rules << rule;
+}
+
+QList<PrivacyPolicy::Assignment> PrivacyPolicy::apply(const MaskFrame& mask, MetadataFrame* metadata) const
+{
+    const int width = mask.width();
+    const int height = mask.height();
+    const int numFilters = FILTER_POINTCLOUD + 1;
+
+    // Bounding box of each user label (255 is the border, it isn't a user)
+    UserInfo info[256];
+    bool present[256] = {false};
+
+    for (int i=0; i<height; ++i)
+    {
+        const uint8_t* labels = mask.getRowPtr(i);
+
+        for (int j=0; j<width; ++j)
+        {
+            const uint8_t label = labels[j];
+
+            if (label == 0 || label == 255)
+                continue;
+
+            UserInfo& user = info[label];
+
+            if (!present[label]) {
+                present[label] = true;
+                user.minX = user.maxX = j;
+                user.minY = user.maxY = i;
+            } else {
+                user.minX = qMin(user.minX, j);
+                user.maxX = qMax(user.maxX, j);
+                user.maxY = i;
+            }
+        }
+    }
+
+    // Rules that may apply to each user. When the first one covers the whole user
+    // the filter is the same for all of its pixels
+    const Rule* uniform[256] = {nullptr};
+
+    for (int label=1; label<255; ++label)
+    {
+        if (!present[label])
+            continue;
+
+        UserInfo& user = info[label];
+
+        for (const Rule& rule : m_rules) {
+            if (!matchesUser(rule, label, user, metadata))
+                continue;
+
+            user.candidates << &rule;
+
+            if (rule.region.isNull() || rule.wholeUser)
+                break;
+        }
+
+        const Rule* last = user.candidates.isEmpty() ? nullptr : user.candidates.last();
+
+        if (!last || (!last->region.isNull() && !last->wholeUser))
+            user.candidates << &m_defaultRule;
+
+        if (user.candidates.size() == 1)
+            uniform[label] = user.candidates.first();
+    }
+
+    // Split the labels into one mask per filter
+    MaskFramePtr masks[numFilters];
+    bool assigned[numFilters][256] = {{false}};
+
+    for (int i=0; i<height; ++i)
+    {
+        const uint8_t* labels = mask.getRowPtr(i);
+
+        for (int j=0; j<width; ++j)
+        {
+            const uint8_t label = labels[j];
+
+            if (label == 0 || label == 255)
+                continue;
+
+            const Rule* rule = uniform[label];
+
+            if (!rule) {
+                for (const Rule* candidate : info[label].candidates) {
+                    if (candidate->region.isNull() || candidate->wholeUser || candidate->region.contains(j, i)) {
+                        rule = candidate;
+                        break;
+                    }
+                }
+            }
+
+            MaskFramePtr& target = masks[rule->filter];
+
+            if (!target)
+                target = make_shared<MaskFrame>(width, height);
+
+            target->getRowPtr(i)[j] = label;
+            assigned[rule->filter][label] = true;
+        }
+    }
+
+    QList<Assignment> result;
+
+    for (int filter=0; filter<numFilters; ++filter)
+    {
+        if (!masks[filter])
+            continue;
+
+        Assignment assignment;
+        assignment.filter = ColorFilter(filter);
+        assignment.mask = masks[filter];
+
+        for (int label=1; label<255; ++label) {
+            if (assigned[filter][label])
+                assignment.users << label;
+        }
+
+        result << assignment;
+    }
+
+    return result;
+}
+
+bool PrivacyPolicy::matchesUser(const Rule& rule, int userId, const UserInfo& info, MetadataFrame* metadata) const
+{
+    if (rule.user != 0 && rule.user != userId)
+        return false;
+
+    if (rule.minDistance > 0 || rule.maxDistance > 0) {
+        const float distance = userDistance(info, metadata);
+
+        if (distance <= 0 || (rule.minDistance > 0 && distance < rule.minDistance) ||
+                (rule.maxDistance > 0 && distance > rule.maxDistance))
+            return false;
+    }
+
+    if (!rule.region.isNull())
+    {
+        const QRect box(QPoint(info.minX, info.minY), QPoint(info.maxX, info.maxY));
+
+        if (rule.wholeUser && !rule.region.contains(box.center()))
+            return false;
+
+        // Pixel regions that don't touch the user never apply
+        if (!rule.wholeUser && !rule.region.intersects(box))
+            return false;
+    }
+
+    return true;
+}
+
+// NiTE doesn't say which box belongs to each user, so the box that contains the centre
+// of the user in the mask is used
+float PrivacyPolicy::userDistance(const UserInfo& info, MetadataFrame* metadata)
+{
+    if (!metadata)
+        return 0;
+
+    const float x = (info.minX + info.maxX) / 2.0f;
+    const float y = (info.minY + info.maxY) / 2.0f;
+
+    for (const BoundingBox& box : metadata->boundingBoxes()) {
+        const Point3f& min = box.getMin();
+        const Point3f& max = box.getMax();
+
+        if (x >= min[0] && x <= max[0] && y >= min[1] && y <= max[1])
+            return (min[2] + max[2]) / 2.0f;
+    }
+
+    return 0;
+}
+
+} // End Namespace
@@ -0,0 +1,99 @@
+#ifndef PRIVACYPOLICY_H
+#define PRIVACYPOLICY_H
+
+#include "types/MaskFrame.h"
+#include "types/MetadataFrame.h"
+#include "viewer/types.h"
+#include <QString>
+#include <QList>
+#include <QRect>
+
+namespace dai {
+
+class PrivacyPolicy;
+typedef shared_ptr<const PrivacyPolicy> PrivacyPolicyPtr;
+
+/**
+ * Decides the privacy level of each user, or of part of a user, instead of applying
+ * the same filter to the whole frame. Rules are evaluated in order and the first one
+ * that matches is used. Users that no rule matches get the default filter.
+ *
+ * A rule may require a user label of the mask, a distance to the camera (taken from the
+ * MetadataFrame bounding box of the user) and an image region. By default the region
+ * selects pixels, so only the part of the user inside it gets the filter. With
+ * match=user the region selects whole users whose bounding box centre is inside it.
+ *
+ * Policies are loaded from INI files. Rules are the groups of the file, evaluated in
+ * the order of their names:
+ *
+ *   [General]
+ *   default=blur
+ *
+ *   [rule01]
+ *   user=1
+ *   filter=disabled
+ *
+ *   [rule02]
+ *   region=0, 0, 320, 480
+ *   distance=0, 2500
+ *   filter=skeleton
+ *
+ * A policy is immutable once loaded, so it can be shared between threads and replaced
+ * as a whole while frames are being filtered.
+ *
+ * @brief The PrivacyPolicy class
+ */
+class PrivacyPolicy
+{
+public:
+    struct Rule {
+        int user = 0;               // Mask label, 0 = any
+        QRect region;               // Null = whole image
+        bool wholeUser = false;     // Region selects users instead of pixels
+        float minDistance = 0;      // Millimeters, 0 = no limit
+        float maxDistance = 0;
+        ColorFilter filter = FILTER_DISABLED;
+    };
+
+    /**
+     * Users (or parts of them) that get the same filter. mask keeps the original labels
+     * of the selected pixels and 0 elsewhere.
+     */
+    struct Assignment {
+        ColorFilter filter;
+        MaskFramePtr mask;
+        QList<int> users;
+    };
+
+    static PrivacyPolicyPtr load(const QString& fileName); // nullptr on error
+    static QString filterName(ColorFilter filter);
+    static bool filterFromName(const QString& name, ColorFilter* filter);
+
+    explicit PrivacyPolicy(ColorFilter defaultFilter = FILTER_DISABLED);
+    void addRule(const Rule& rule);
+    const QList<Rule>& rules() const {return m_rules;}
+    ColorFilter defaultFilter() const {return m_defaultFilter;}
+
+    /**
+     * Split the users of mask (labels before the border is added) by filter. metadata
+     * may be null, then rules with a distance don't match. Assignments are sorted by filter.
+     */
+    QList<Assignment> apply(const MaskFrame& mask, MetadataFrame* metadata) const;
+
+private:
+    struct UserInfo {
+        int minX, minY, maxX, maxY;
+        QList<const Rule*> candidates; // Rules that may apply to some pixel of the user
+    };
+
+    bool matchesUser(const Rule& rule, int userId, const UserInfo& info, MetadataFrame* metadata) const;
+    static float userDistance(const UserInfo& info, MetadataFrame* metadata);
+
+    ColorFilter m_defaultFilter;
+    QList<Rule> m_rules;
+    Rule m_defaultRule;
+};
+
+} // End Namespace
+
+#endif // PRIVACYPOLICY_H
@@ -0,0 +1,539 @@
+#include "SoftwareRenderer.h"
+#include "Parallel.h"
+#include <opencv2/imgproc/imgproc.hpp>
+#include <QThread>
+#include <QDebug>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+namespace dai {
+
+// Avatar T-pose in milimeters (Y points up, origin at JOINT_SPINE)
+Point3f SoftwareRenderer::avatarRestPose[20] = {
+    Point3f(0.0f, 480.0f, 0.0f),        // JOINT_HEAD
+    Point3f(0.0f, 260.0f, 0.0f),        // JOINT_CENTER_SHOULDER
+    Point3f(-180.0f, 250.0f, 0.0f),     // JOINT_LEFT_SHOULDER
+    Point3f(180.0f, 250.0f, 0.0f),      // JOINT_RIGHT_SHOULDER
+    Point3f(-460.0f, 250.0f, 0.0f),     // JOINT_LEFT_ELBOW
+    Point3f(460.0f, 250.0f, 0.0f),      // JOINT_RIGHT_ELBOW
+    Point3f(-700.0f, 250.0f, 0.0f),     // JOINT_LEFT_WRIST
+    Point3f(700.0f, 250.0f, 0.0f),      // JOINT_RIGHT_WRIST
+    Point3f(-780.0f, 250.0f, 0.0f),     // JOINT_LEFT_HAND
+    Point3f(780.0f, 250.0f, 0.0f),      // JOINT_RIGHT_HAND
+    Point3f(0.0f, 0.0f, 0.0f),          // JOINT_SPINE
+    Point3f(0.0f, -180.0f, 0.0f),       // JOINT_CENTER_HIP
+    Point3f(-100.0f, -210.0f, 0.0f),    // JOINT_LEFT_HIP
+    Point3f(100.0f, -210.0f, 0.0f),     // JOINT_RIGHT_HIP
+    Point3f(-100.0f, -640.0f, 0.0f),    // JOINT_LEFT_KNEE
+    Point3f(100.0f, -640.0f, 0.0f),     // JOINT_RIGHT_KNEE
+    Point3f(-100.0f, -1040.0f, 0.0f),   // JOINT_LEFT_ANKLE
+    Point3f(100.0f, -1040.0f, 0.0f),    // JOINT_RIGHT_ANKLE
+    Point3f(-100.0f, -1090.0f, -120.0f),// JOINT_LEFT_FOOT
+    Point3f(100.0f, -1090.0f, -120.0f)  // JOINT_RIGHT_FOOT
+};
+
+// Thickness of the avatar around each joint in milimeters
+float SoftwareRenderer::avatarJointRadius[20] = {
+    0.0f,   // JOINT_HEAD (drawn apart)
+    65.0f,  // JOINT_CENTER_SHOULDER
+    60.0f,  // JOINT_LEFT_SHOULDER
+    60.0f,  // JOINT_RIGHT_SHOULDER
+    48.0f,  // JOINT_LEFT_ELBOW
+    48.0f,  // JOINT_RIGHT_ELBOW
+    36.0f,  // JOINT_LEFT_WRIST
+    36.0f,  // JOINT_RIGHT_WRIST
+    42.0f,  // JOINT_LEFT_HAND
+    42.0f,  // JOINT_RIGHT_HAND
+    140.0f, // JOINT_SPINE
+    130.0f, // JOINT_CENTER_HIP
+    90.0f,  // JOINT_LEFT_HIP
+    90.0f,  // JOINT_RIGHT_HIP
+    60.0f,  // JOINT_LEFT_KNEE
+    60.0f,  // JOINT_RIGHT_KNEE
+    45.0f,  // JOINT_LEFT_ANKLE
+    45.0f,  // JOINT_RIGHT_ANKLE
+    45.0f,  // JOINT_LEFT_FOOT
+    45.0f   // JOINT_RIGHT_FOOT
+};
+
+static const float AVATAR_HEAD_RADIUS = 115.0f;
+static const float AVATAR_TORSO_RADIUS = 150.0f;
+
+static const RGBColor avatarColors[] = {
+    {90, 140, 200},
+    {200, 120, 80},
+    {110, 180, 110},
+    {190, 170, 70},
+    {160, 100, 180},
+    {80, 170, 170}
+};
+
+// Same colours used by SkeletonItem
+static const RGBColor limbColor = {0, 255, 255};
+static const RGBColor jointColor = {0, 0, 0};
+
+// Same parameters used by SilhouetteItem and silhouette.fsh
+static const RGBColor silhouetteColor = {127, 204, 0};
+static const int BLUR_RADIO = 15;
+static const int PIXEL_DIAMETER = 10;
+
+inline static bool isUserPixel(uint8_t mask)
+{
+    return mask > 0 && mask < 255;
+}
+
+inline static Vector3f rotateVector(const Quaternion& q, const Vector3f& v)
+{
+    // v' = v + 2w(u x v) + 2u x (u x v)
+    Vector3f u(q.x(), q.y(), q.z());
+    Vector3f t = Vector3f::crossProduct(u, v);
+    t = Vector3f(2*t.x(), 2*t.y(), 2*t.z());
+    Vector3f c = Vector3f::crossProduct(u, t);
+    return Vector3f(v.x() + q.w() * t.x() + c.x(),
+                    v.y() + q.w() * t.y() + c.y(),
+                    v.z() + q.w() * t.z() + c.z());
+}
+
+inline static Vector3f boneVector(const Point3f& from, const Point3f& to)
+{
+    return Vector3f(to[0] - from[0], to[1] - from[1], to[2] - from[2]);
+}
+
+SoftwareRenderer::SoftwareRenderer()
+    : m_tileSize(32)
+    , m_threads(QThread::idealThreadCount())
+{
+    if (m_threads < 1)
+        m_threads = 1;
+}
+
+void SoftwareRenderer::setTileSize(int size)
+{
+    m_tileSize = std::max(8, size);
+}
+
+void SoftwareRenderer::setThreadsCount(int count)
+{
+    m_threads = std::max(1, count);
+}
+
+void SoftwareRenderer::resetBackground()
+{
+    m_background.reset();
+}
+
+void SoftwareRenderer::render(ColorFilter filter, ColorFramePtr colorFrame, MaskFramePtr maskFrame, SkeletonFramePtr skeletonFrame)
+{
+    Q_ASSERT(colorFrame != nullptr && maskFrame != nullptr);
+
+    updateBackground(*colorFrame, *maskFrame);
+    renderFilter(filter, *colorFrame, *maskFrame, skeletonFrame);
+}
+
+void SoftwareRenderer::renderFilter(ColorFilter filter, ColorFrame& colorFrame, const MaskFrame& maskFrame, SkeletonFramePtr skeletonFrame)
+{
+    Q_ASSERT(m_background != nullptr);
+
+    if (filter == FILTER_DISABLED)
+        return;
+
+    if (filter == FILTER_BLUR || filter == FILTER_PIXELATION || filter == FILTER_EMBOSS) {
+        ColorFrame source = colorFrame;
+        renderSilhouette(filter, source, colorFrame, maskFrame);
+        return;
+    }
+
+    removeUsers(colorFrame, maskFrame);
+
+    if (filter == FILTER_SILHOUETTE) {
+        renderSilhouette(filter, colorFrame, colorFrame, maskFrame);
+        return;
+    }
+
+    if (skeletonFrame == nullptr)
+        return;
+
+    if (filter == FILTER_SKELETON) {
+        for (SkeletonPtr skeleton : skeletonFrame->skeletons())
+            renderSkeleton(*skeleton, colorFrame);
+    }
+    else if (filter == FILTER_3DMODEL) {
+        for (int userId : skeletonFrame->getAllUsersId())
+            renderAvatar(*skeletonFrame->getSkeleton(userId), userId, colorFrame);
+    }
+}
+
+void SoftwareRenderer::updateBackground(const ColorFrame& colorFrame, const MaskFrame& maskFrame)
+{
+    if (!m_background || m_background->width() != colorFrame.width() || m_background->height() != colorFrame.height()) {
+        m_background = make_shared<ColorFrame>(colorFrame.width(), colorFrame.height());
+        *m_background = colorFrame;
+        return;
+    }
+
+    // Learn background only where there is no user
+    for (int i=0; i<colorFrame.height(); ++i)
+    {
+        const RGBColor* src = colorFrame.getRowPtr(i);
+        const uint8_t* mask = maskFrame.getRowPtr(i);
+        RGBColor* dst = m_background->getRowPtr(i);
+
+        for (int j=0; j<colorFrame.width(); ++j) {
+            if (mask[j] == 0)
+                dst[j] = src[j];
+        }
+    }
+}
+
+void SoftwareRenderer::removeUsers(ColorFrame& colorFrame, const MaskFrame& maskFrame) const
+{
+    for (int i=0; i<colorFrame.height(); ++i)
+    {
+        RGBColor* dst = colorFrame.getRowPtr(i);
+        const uint8_t* mask = maskFrame.getRowPtr(i);
+        const RGBColor* bg = m_background->getRowPtr(i);
+
+        for (int j=0; j<colorFrame.width(); ++j) {
+            if (mask[j] > 0)
+                dst[j] = bg[j];
+        }
+    }
+}
+
+void SoftwareRenderer::renderSilhouette(ColorFilter filter, const ColorFrame& source, ColorFrame& target, const MaskFrame& maskFrame) const
+{
+    const int width = target.width();
+    const int height = target.height();
+    cv::Mat blurred;
+
+    if (filter == FILTER_BLUR) {
+        // Same separable kernel of SilhouetteItem (sigma = radio / 3)
+        cv::Mat source_mat(height, width, CV_8UC3, (void*) source.getDataPtr(), source.getStride());
+        cv::GaussianBlur(source_mat, blurred, cv::Size(2*BLUR_RADIO+1, 2*BLUR_RADIO+1),
+                         BLUR_RADIO / 3.0, BLUR_RADIO / 3.0, cv::BORDER_REPLICATE);
+    }
+
+    for (int i=0; i<height; ++i)
+    {
+        const uint8_t* mask = maskFrame.getRowPtr(i);
+        RGBColor* dst = target.getRowPtr(i);
+        const RGBColor* blockRow = source.getRowPtr(i - i % PIXEL_DIAMETER);
+        const RGBColor* prevRow = source.getRowPtr(std::max(0, i-1));
+        const RGBColor* nextRow = source.getRowPtr(std::min(height-1, i+1));
+
+        for (int j=0; j<width; ++j)
+        {
+            if (!isUserPixel(mask[j]))
+                continue;
+
+            switch (filter) {
+            case FILTER_SILHOUETTE:
+                dst[j] = silhouetteColor;
+                break;
+            case FILTER_BLUR: {
+                const cv::Vec3b& pixel = blurred.at<cv::Vec3b>(i, j);
+                dst[j] = RGBColor {pixel[0], pixel[1], pixel[2]};
+                break;
+            }
+            case FILTER_PIXELATION:
+                dst[j] = blockRow[j - j % PIXEL_DIAMETER];
+                break;
+            case FILTER_EMBOSS: {
+                const RGBColor& prev = prevRow[std::max(0, j-1)];
+                const RGBColor& next = nextRow[std::min(width-1, j+1)];
+                const float diff = ((next.red + next.green + next.blue) - (prev.red + prev.green + prev.blue)) / 3.0f;
+                const uint8_t gray = uint8_t(std::min(255.0f, std::max(0.0f, 127.5f + 5.0f * diff)));
+                dst[j] = RGBColor {gray, gray, gray};
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+}
+
+bool SoftwareRenderer::project(const Skeleton& skeleton, const Point3f& point, const ColorFrame& target, float* x, float* y) const
+{
+    if (skeleton.distanceUnits() == DISTANCE_PIXELS) {
+        *x = point[0];
+        *y = point[1];
+    }
+    else {
+        if (point[2] <= 0.0f)
+            return false;
+
+        skeleton.convertCoordinatesToDepth(point[0], point[1], point[2], x, y);
+    }
+
+    *x -= target.offset()[0];
+    *y -= target.offset()[1];
+    return true;
+}
+
+float SoftwareRenderer::projectRadius(const Skeleton& skeleton, const Point3f& point, float radius) const
+{
+    if (skeleton.distanceUnits() == DISTANCE_PIXELS || point[2] <= 0.0f)
+        return radius;
+
+    float x1, x2, y;
+    skeleton.convertCoordinatesToDepth(point[0], point[1], point[2], &x1, &y);
+    skeleton.convertCoordinatesToDepth(point[0] + radius, point[1], point[2], &x2, &y);
+    return std::abs(x2 - x1);
+}
+
+SoftwareRenderer::Capsule SoftwareRenderer::makeCapsule(float ax, float ay, float ra, float bx, float by, float rb,
+                                                        float depth, RGBColor color, bool shaded) const
+{
+    Capsule capsule;
+    capsule.ax = ax; capsule.ay = ay; capsule.ra = ra;
+    capsule.bx = bx; capsule.by = by; capsule.rb = rb;
+    capsule.depth = depth;
+    capsule.color = color;
+    capsule.shaded = shaded;
+
+    // One extra pixel for the anti-aliased border
+    capsule.minX = std::min(ax - ra, bx - rb) - 1.0f;
+    capsule.maxX = std::max(ax + ra, bx + rb) + 1.0f;
+    capsule.minY = std::min(ay - ra, by - rb) - 1.0f;
+    capsule.maxY = std::max(ay + ra, by + rb) + 1.0f;
+    return capsule;
+}
+
+void SoftwareRenderer::renderSkeleton(const Skeleton& skeleton, ColorFrame& target) const
+{
+    QVector<Capsule> capsules;
+    const Skeleton::SkeletonLimb* limbMap = skeleton.getLimbsMap();
+
+    for (int i=0; i<skeleton.getLimbsCount(); ++i)
+    {
+        const SkeletonJoint joint1 = skeleton.getJoint(limbMap[i].joint1);
+        const SkeletonJoint joint2 = skeleton.getJoint(limbMap[i].joint2);
+        float x1, y1, x2, y2;
+
+        if (!project(skeleton, joint1.getPosition(), target, &x1, &y1) ||
+                !project(skeleton, joint2.getPosition(), target, &x2, &y2))
+            continue;
+
+        float depth = (joint1.getPosition()[2] + joint2.getPosition()[2]) / 2;
+        capsules << makeCapsule(x1, y1, 1.5f, x2, y2, 1.5f, depth, limbColor, false);
+    }
+
+    for (const SkeletonJoint& joint : skeleton.joints())
+    {
+        float x, y;
+
+        if (joint.getType() >= SkeletonJoint::JOINT_USER_RESERVED ||
+                !project(skeleton, joint.getPosition(), target, &x, &y))
+            continue;
+
+        // Joints are drawn over limbs
+        capsules << makeCapsule(x, y, 4.0f, x, y, 4.0f, 0.0f, jointColor, false);
+    }
+
+    rasterise(capsules, target);
+}
+
+void SoftwareRenderer::renderAvatar(const Skeleton& skeleton, int userId, ColorFrame& target) const
+{
+    const int numJoints = SkeletonJoint::JOINT_USER_RESERVED;
+    SkeletonJoint joints[numJoints];
+    bool tracked[numJoints] = {false};
+
+    for (const SkeletonJoint& joint : skeleton.joints()) {
+        if (joint.getType() < numJoints) {
+            joints[joint.getType()] = joint;
+            tracked[joint.getType()] = skeleton.distanceUnits() == DISTANCE_PIXELS || joint.getPosition()[2] > 0.0f;
+        }
+    }
+
+    const int root = SkeletonJoint::JOINT_SPINE;
+    const int neck = SkeletonJoint::JOINT_CENTER_SHOULDER;
+
+    if (!tracked[root] || !tracked[neck])
+        return;
+
+    // Scale the avatar to the tracked torso, but keep its own proportions
+    const float unitsFactor = skeleton.distanceUnits() == DISTANCE_METERS ? 0.001f : 1.0f;
+    const float refTorso = boneVector(avatarRestPose[root], avatarRestPose[neck]).length();
+    float scale = boneVector(joints[root].getPosition(), joints[neck].getPosition()).length() / (refTorso * unitsFactor);
+    scale = std::min(1.6f, std::max(0.6f, scale)) * unitsFactor;
+
+    // Pose the avatar walking the limbs from the root (breadth-first)
+    Point3f posed[numJoints];
+    bool placed[numJoints] = {false};
+    const Skeleton::SkeletonLimb* limbMap = skeleton.getLimbsMap();
+    const int limbsCount = skeleton.getLimbsCount();
+    QVector<Skeleton::SkeletonLimb> bones;
+    QVector<int> queue;
+
+    posed[root] = joints[root].getPosition();
+    placed[root] = true;
+    queue << root;
+
+    for (int q=0; q<queue.size(); ++q)
+    {
+        const int parent = queue[q];
+
+        for (int i=0; i<limbsCount; ++i)
+        {
+            int child;
+
+            if (limbMap[i].joint1 == parent) child = limbMap[i].joint2;
+            else if (limbMap[i].joint2 == parent) child = limbMap[i].joint1;
+            else continue;
+
+            if (placed[child] || !tracked[child])
+                continue;
+
+            Vector3f tracked_dir = boneVector(joints[parent].getPosition(), joints[child].getPosition());
+            Vector3f rest_dir = boneVector(avatarRestPose[parent], avatarRestPose[child]);
+            const float length = rest_dir.length() * scale;
+
+            if (tracked_dir.length() == 0.0 || length == 0.0f)
+                continue;
+
+            tracked_dir.normalize();
+            rest_dir.normalize();
+
+            // Skinning: rotate the rest bone by the parent orientation. The tracked direction
+            // is used when the orientation is not reliable or it disagrees with the tracked bone.
+            Vector3f dir = tracked_dir;
+            const SkeletonJoint& parentJoint = joints[parent];
+
+            if (parentJoint.getOrientationConfidence() >= 0.5f) {
+                Quaternion orientation = parentJoint.getOrientation();
+                orientation.normalize();
+                Vector3f skinned_dir = rotateVector(orientation, rest_dir);
+
+                if (Vector3f::dotProduct(skinned_dir, tracked_dir) > 0.5)
+                    dir = skinned_dir;
+            }
+
+            posed[child] = Point3f(posed[parent][0] + dir.x() * length,
+                                   posed[parent][1] + dir.y() * length,
+                                   posed[parent][2] + dir.z() * length);
+            placed[child] = true;
+            queue << child;
+            bones << Skeleton::SkeletonLimb {(SkeletonJoint::JointType) parent, (SkeletonJoint::JointType) child};
+        }
+    }
+
+    // Build capsules
+    QVector<Capsule> capsules;
+    const RGBColor color = avatarColors[std::abs(userId) % (sizeof(avatarColors) / sizeof(RGBColor))];
+
+    auto addCapsule = [&](const Point3f& p1, float r1, const Point3f& p2, float r2) {
+        float x1, y1, x2, y2;
+        if (project(skeleton, p1, target, &x1, &y1) && project(skeleton, p2, target, &x2, &y2)) {
+            capsules << makeCapsule(x1, y1, projectRadius(skeleton, p1, r1 * scale),
+                                    x2, y2, projectRadius(skeleton, p2, r2 * scale),
+                                    (p1[2] + p2[2]) / 2, color, true);
+        }
+    };
+
+    // Torso
+    const int hip = placed[SkeletonJoint::JOINT_CENTER_HIP] ? SkeletonJoint::JOINT_CENTER_HIP : root;
+    addCapsule(posed[neck], AVATAR_TORSO_RADIUS, posed[hip], AVATAR_TORSO_RADIUS * 0.85f);
+
+    // Limbs
+    for (const Skeleton::SkeletonLimb& bone : bones) {
+        if (bone.joint2 == SkeletonJoint::JOINT_HEAD)
+            continue;
+        addCapsule(posed[bone.joint1], avatarJointRadius[bone.joint1],
+                   posed[bone.joint2], avatarJointRadius[bone.joint2]);
+    }
+
+    // Head
+    if (placed[SkeletonJoint::JOINT_HEAD]) {
+        const Point3f& head = posed[SkeletonJoint::JOINT_HEAD];
+        addCapsule(posed[neck], avatarJointRadius[neck] * 0.8f, head, avatarJointRadius[neck] * 0.8f);
+        addCapsule(head, AVATAR_HEAD_RADIUS, head, AVATAR_HEAD_RADIUS);
+    }
+
+    rasterise(capsules, target);
+}
+
+void SoftwareRenderer::rasterise(QVector<Capsule>& capsules, ColorFrame& target) const
+{
+    if (capsules.isEmpty())
+        return;
+
+    // Painter's algorithm: farther capsules first
+    std::stable_sort(capsules.begin(), capsules.end(), [](const Capsule& c1, const Capsule& c2) {
+        return c1.depth > c2.depth;
+    });
+
+    const int tilesX = (target.width() + m_tileSize - 1) / m_tileSize;
+    const int tilesY = (target.height() + m_tileSize - 1) / m_tileSize;
+    const int numTiles = tilesX * tilesY;
+    std::atomic<int> nextTile(0);
+
+    auto worker = [&]() {
+        int tile;
+        while ((tile = nextTile.fetch_add(1)) < numTiles) {
+            int x0 = (tile % tilesX) * m_tileSize;
+            int y0 = (tile / tilesX) * m_tileSize;
+            rasteriseTile(capsules, target, x0, y0, std::min(x0 + m_tileSize, target.width()),
+                          std::min(y0 + m_tileSize, target.height()));
+        }
+    };
+
+    runParallel(std::min(m_threads, numTiles), worker);
+}
+
+void SoftwareRenderer::rasteriseTile(const QVector<Capsule>& capsules, ColorFrame& target, int x0, int y0, int x1, int y1) const
+{
+    for (const Capsule& c : capsules)
+    {
+        if (c.maxX < x0 || c.minX >= x1 || c.maxY < y0 || c.minY >= y1)
+            continue;
+
+        const int cx0 = std::max(x0, int(std::floor(c.minX)));
+        const int cx1 = std::min(x1, int(std::ceil(c.maxX)) + 1);
+        const int cy0 = std::max(y0, int(std::floor(c.minY)));
+        const int cy1 = std::min(y1, int(std::ceil(c.maxY)) + 1);
+
+        const float dx = c.bx - c.ax;
+        const float dy = c.by - c.ay;
+        const float len2 = dx*dx + dy*dy;
+
+        for (int i=cy0; i<cy1; ++i)
+        {
+            RGBColor* pixel = target.getRowPtr(i);
+            const float py = i + 0.5f - c.ay;
+
+            for (int j=cx0; j<cx1; ++j)
+            {
+                const float px = j + 0.5f - c.ax;
+                float t = len2 > 0.0f ? (px*dx + py*dy) / len2 : 0.0f;
+                t = std::min(1.0f, std::max(0.0f, t));
+
+                const float ex = px - t*dx;
+                const float ey = py - t*dy;
+                const float dist = std::sqrt(ex*ex + ey*ey);
+                const float radius = c.ra + t * (c.rb - c.ra);
+                const float coverage = std::min(1.0f, std::max(0.0f, radius - dist + 0.5f));
+
+                if (coverage <= 0.0f)
+                    continue;
+
+                // Fake lighting so that the avatar looks rounded
+                float light = 1.0f;
+
+                if (c.shaded && radius > 0.0f) {
+                    float d = std::min(1.0f, dist / radius);
+                    light = 1.0f - 0.45f * d * d;
+                }
+
+                RGBColor& out = pixel[j];
+                out.red   = uint8_t(out.red   + coverage * (c.color.red * light - out.red));
+                out.green = uint8_t(out.green + coverage * (c.color.green * light - out.green));
+                out.blue  = uint8_t(out.blue  + coverage * (c.color.blue * light - out.blue));
+            }
+        }
+    }
+}
+
+} // End Namespace
@@ -0,0 +1,82 @@
+#ifndef SOFTWARERENDERER_H
+#define SOFTWARERENDERER_H
+
+#include "types/ColorFrame.h"
+#include "types/MaskFrame.h"
+#include "types/SkeletonFrame.h"
+#include "viewer/types.h"
+#include <QVector>
+
+namespace dai {
+
+/**
+ * CPU rasteriser for the privacy levels that replace the user by a synthetic
+ * drawing (FILTER_SKELETON and FILTER_3DMODEL). It does not need any GL context,
+ * so it can be used on headless machines instead of SkeletonItem and OgreScene.
+ * The silhouette effects (blur, pixelation, emboss and solid silhouette) follow
+ * silhouette.fsh.
+ *
+ * Limbs are drawn as anti-aliased capsules. The avatar is a simplified skinned
+ * model with its own body proportions, posed from the tracked skeleton (joint
+ * orientations when they are reliable, bone directions otherwise). Rendering is
+ * split in tiles that are processed in parallel.
+ *
+ * @brief The SoftwareRenderer class
+ */
+class SoftwareRenderer
+{
+public:
+    SoftwareRenderer();
+
+    /**
+     * Render the given filter into colorFrame. The user pixels (mask > 0) are replaced
+     * by the learned background before drawing the skeleton or avatar on top of it.
+     * FILTER_BLUR, FILTER_PIXELATION and FILTER_EMBOSS change the user pixels in place
+     * and FILTER_SILHOUETTE paints them over the background. As in the GL path, the
+     * border of the mask (value 255) is not considered part of the user by the effects.
+     */
+    void render(ColorFilter filter, ColorFramePtr colorFrame, MaskFramePtr maskFrame, SkeletonFramePtr skeletonFrame);
+
+    /**
+     * Same as render, but the background is not learned. Used to render several filters
+     * on the same frame, each one with the mask of its users, after updateBackground has
+     * been called with the mask of every user.
+     */
+    void renderFilter(ColorFilter filter, ColorFrame& colorFrame, const MaskFrame& maskFrame, SkeletonFramePtr skeletonFrame);
+    void updateBackground(const ColorFrame& colorFrame, const MaskFrame& maskFrame);
+    void renderSkeleton(const Skeleton& skeleton, ColorFrame& target) const;
+    void renderAvatar(const Skeleton& skeleton, int userId, ColorFrame& target) const;
+    void resetBackground();
+    void setTileSize(int size);
+    void setThreadsCount(int count);
+
+private:
+    struct Capsule {
+        float ax, ay;   // First endpoint (pixels)
+        float bx, by;   // Second endpoint (pixels)
+        float ra, rb;   // Radius at each endpoint (pixels)
+        float depth;    // Used to sort capsules (farther first)
+        RGBColor color;
+        bool shaded;
+        float minX, minY, maxX, maxY; // Bounding box
+    };
+
+    static Point3f avatarRestPose[20];
+    static float avatarJointRadius[20];
+
+    void removeUsers(ColorFrame& colorFrame, const MaskFrame& maskFrame) const;
+    void renderSilhouette(ColorFilter filter, const ColorFrame& source, ColorFrame& target, const MaskFrame& maskFrame) const;
+    bool project(const Skeleton& skeleton, const Point3f& point, const ColorFrame& target, float* x, float* y) const;
+    float projectRadius(const Skeleton& skeleton, const Point3f& point, float radius) const;
+    Capsule makeCapsule(float ax, float ay, float ra, float bx, float by, float rb, float depth, RGBColor color, bool shaded) const;
+    void rasterise(QVector<Capsule>& capsules, ColorFrame& target) const;
+    void rasteriseTile(const QVector<Capsule>& capsules, ColorFrame& target, int x0, int y0, int x1, int y1) const;
+
+    ColorFramePtr m_background;
+    int m_tileSize;
+    int m_threads;
+};
+
+} // End Namespace
+
+#endif // SOFTWARERENDERER_H
@@ -129,7 +129,7 @@ void OgreScene::prepareData(const dai::QHashDataFrames frames)
     if (frames.contains(dai::DataFrame::Skeleton))
     {
         shared_ptr<dai::SkeletonFrame> skeletonFrame = static_pointer_cast<dai::SkeletonFrame>( frames.value(dai::DataFrame::Skeleton) );
-        int userId = skeletonFrame->getAllUsersId().isEmpty() ? 0 : skeletonFrame->getAllUsersId().at(0);
+        int userId = skeletonFrame->firstUserId();
 
         if (userId > 0 && m_userId == -1) {
             // New user
@@ -1,10 +1,16 @@
 #include "ControlWindow.h"
 #include "ui_ControlWindow.h"
 #include "filters/PrivacyFilter.h"
+#include "playback/VideoWriterListener.h"
+#include "playback/Tracer.h"
+#include <QDateTime>
+#include <QShowEvent>
+#include <QDebug>
 
 ControlWindow::ControlWindow(dai::PrivacyFilter *privacy, QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::ControlWindow)
+    ui(new Ui::ControlWindow),
+    m_recorder(nullptr)
 {
     ui->setupUi(this);
     m_privacy = privacy;
@@ -12,6 +18,11 @@ ControlWindow::ControlWindow(dai::PrivacyFilter *privacy, QWidget *parent) :
 
 ControlWindow::~ControlWindow()
 {
+    if (m_recorder) {
+        delete m_recorder;
+        m_recorder = nullptr;
+    }
+
     delete ui;
 }
 
@@ -55,6 +66,25 @@ void ControlWindow::on_btnInvisibility_clicked()
     m_privacy->enableFilter(dai::ColorFilter::FILTER_INVISIBILITY);
 }
 
+void ControlWindow::on_btnPointCloud_clicked()
+{
+    m_privacy->enableFilter(dai::ColorFilter::FILTER_POINTCLOUD);
+}
+
+void ControlWindow::on_checkFaces_toggled(bool checked)
+{
+    m_privacy->enableFaceBlurring(checked);
+}
+
+// Face blurring may have been enabled by the configuration
+void ControlWindow::showEvent(QShowEvent* event)
+{
+    ui->checkFaces->blockSignals(true);
+    ui->checkFaces->setChecked(m_privacy->isFaceBlurringEnabled());
+    ui->checkFaces->blockSignals(false);
+    QMainWindow::showEvent(event);
+}
+
 void ControlWindow::on_btnSaveImage_clicked()
 {
     m_privacy->captureImage();
@@ -64,3 +94,40 @@ void ControlWindow::on_btnPause_clicked()
 {
     m_privacy->pause();
 }
+
+void ControlWindow::on_btnRecord_clicked()
+{
+    if (!m_recorder) {
+        QString fileName = "data/privacy_" + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") + ".avi";
+        m_recorder = new dai::VideoWriterListener(fileName);
+        m_privacy->addListener(m_recorder);
+        ui->btnRecord->setText("Stop Recording");
+    }
+    else {
+        m_privacy->removeListener(m_recorder);
+        m_recorder->close();
+
+        dai::VideoWriterListener::Stats stats = m_recorder->stats();
+        qDebug() << "Video saved to" << m_recorder->fileName() << "Written" << stats.framesWritten
+                 << "Dropped" << stats.framesDropped << "Encode fps" << stats.encodeFps;
+
+        delete m_recorder;
+        m_recorder = nullptr;
+        ui->btnRecord->setText("Start Recording");
+    }
+}
+
+void ControlWindow::on_btnTrace_clicked()
+{
+    if (!dai::Tracer::isEnabled()) {
+        dai::Tracer::clear();
+        dai::Tracer::setEnabled(true);
+        ui->btnTrace->setText("Stop Tracing");
+    }
+    else {
+        dai::Tracer::setEnabled(false);
+        QString fileName = "data/trace_" + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") + ".json";
+        dai::Tracer::exportChromeTrace(fileName);
+        ui->btnTrace->setText("Start Tracing");
+    }
+}
@@ -9,6 +9,7 @@ class ControlWindow;
 
 namespace dai {
 class PrivacyFilter;
+class VideoWriterListener;
 }
 
 class ControlWindow : public QMainWindow
@@ -19,6 +20,9 @@ public:
     explicit ControlWindow(dai::PrivacyFilter* privacy, QWidget *parent = 0);
     ~ControlWindow();
 
+protected:
+    void showEvent(QShowEvent* event) override;
+
 private slots:
     void on_btnNoPrivacy_clicked();
     void on_btnBlurring_clicked();
@@ -28,14 +32,21 @@ private slots:
     void on_btnSkeleton_clicked();
     void on_btnAvatar_clicked();
     void on_btnInvisibility_clicked();
+    void on_btnPointCloud_clicked();
+    void on_checkFaces_toggled(bool checked);
 
     void on_btnSaveImage_clicked();
 
     void on_btnPause_clicked();
 
+    void on_btnRecord_clicked();
+
+    void on_btnTrace_clicked();
+
 private:
     Ui::ControlWindow *ui;
     dai::PrivacyFilter *m_privacy;
+    dai::VideoWriterListener *m_recorder;
 };
 
 #endif // CONTROLWINDOW_H
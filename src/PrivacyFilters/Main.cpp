@@ -2,6 +2,7 @@
 #include "Config.h"
 #include "MainWindow.h"
 #include "filters/PrivacyFilter.h"
+#include "playback/RingRecorder.h"
 #include <opencv2/opencv.hpp>
 
 
@@ -10,6 +11,7 @@ int main(int argc, char *argv[])
     CoreLib_InitResources();
     PrivacyLib_InitResources();
     QApplication app(argc, argv);
+    dai::RingRecorder::installHandlers();
     MainWindow window;
     window.show();
     return app.exec();
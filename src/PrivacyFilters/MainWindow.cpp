@@ -4,9 +4,13 @@
 #include "openni/OpenNIColorInstance.h"
 #include "openni/OpenNIUserTrackerInstance.h"
 #include "openni/OpenNIDevice.h"
+#include "playback/RecordingInstance.h"
+#include "playback/SharedMemoryInstance.h"
+#include "types/MemoryTracker.h"
 #include <QElapsedTimer>
 #include <QSettings>
 #include <QFileDialog>
+#include <QFileInfo>
 
 using namespace std;
 
@@ -44,7 +48,8 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->btnOpenBrowser, &QPushButton::clicked, [=]() {
         QString fileName = QFileDialog::getOpenFileName(this, tr("Open File"),
                                                         "/home",
-                                                        tr("OpenNI Capture (*.oni)"));
+                                                        tr("OpenNI Capture (*.oni);;Recording (*%1)")
+                                                        .arg(dai::StreamRecording::extension()));
         if (!fileName.isEmpty()) {
             ui->linePath->setText(fileName);
             // Save file config
@@ -60,38 +65,124 @@ MainWindow::MainWindow(QWidget *parent) :
 MainWindow::~MainWindow()
 {
     m_playback.stop();
+    dai::MemoryTracker::stopReports();
     delete ui;
 }
 
 void MainWindow::on_btnStartKinect_clicked()
 {
-    // Setup device
-    if (ui->checkUseConnected->isChecked())
-        m_device = dai::OpenNIDevice::create();
+    const QString path = ui->linePath->text();
+    m_playback.clearInstances();
+
+    if (!ui->checkUseConnected->isChecked() && path.startsWith("shm:"))
+    {
+        // Frames published by another process (Transport/input of its config), read at its rate
+        m_playback.addInstance(make_shared<dai::SharedMemoryInstance>(path.mid(4), dai::DataFrame::Color | dai::DataFrame::Depth |
+                                                                      dai::DataFrame::Mask | dai::DataFrame::Skeleton));
+        m_playback.setPacingPolicy(dai::PACING_SLOWDOWN);
+        m_playback.setFPS(0);
+        m_playback.enableSynchronisation(false);
+    }
+    else if (!ui->checkUseConnected->isChecked() && path.endsWith(dai::StreamRecording::extension()))
+    {
+        // Recording made with StreamRecorder, played with its original timing
+        m_playback.addInstance(make_shared<dai::RecordingInstance>(path));
+        m_playback.setPacingPolicy(dai::PACING_REALTIME);
+        m_playback.enableSynchronisation(false);
+    }
     else
-        m_device = dai::OpenNIDevice::create(ui->linePath->text());
+    {
+        // Setup device
+        if (ui->checkUseConnected->isChecked())
+            m_device = dai::OpenNIDevice::create();
+        else
+            m_device = dai::OpenNIDevice::create(path);
 
-    // Create instances
-    shared_ptr<dai::OpenNIColorInstance> colorInstance =
-            make_shared<dai::OpenNIColorInstance>(m_device);
+        // Create instances
+        shared_ptr<dai::OpenNIColorInstance> colorInstance =
+                make_shared<dai::OpenNIColorInstance>(m_device);
 
-    shared_ptr<dai::OpenNIUserTrackerInstance> userTrackerInstance =
-            make_shared<dai::OpenNIUserTrackerInstance>(m_device);
+        shared_ptr<dai::OpenNIUserTrackerInstance> userTrackerInstance =
+                make_shared<dai::OpenNIUserTrackerInstance>(m_device);
 
-    // Open Device and configure playback
-    //m_device->setRegistration(true);
-    m_device->open();
+        // Open Device and configure playback
+        //m_device->setRegistration(true);
+        m_device->open();
+
+        if (m_device->isFile()) {
+            openni::PlaybackControl* oniPlayback = m_device->playbackControl();
+            oniPlayback->setSpeed(1.0f);
+        }
 
-    if (m_device->isFile()) {
-        openni::PlaybackControl* oniPlayback = m_device->playbackControl();
-        oniPlayback->setSpeed(1.0f);
+        // Create Main Producer
+        m_playback.addInstance(colorInstance);
+        m_playback.addInstance(userTrackerInstance);
+
+        // Colour and user tracker of a file are read ahead in parallel and aligned. A live device
+        // is read in turn, so frames aren't queued behind the newest one
+        m_playback.enableSynchronisation(m_device->isFile());
     }
 
-    // Create Main Producer
-    m_playback.clearInstances();
-    m_playback.addInstance(colorInstance);
-    m_playback.addInstance(userTrackerInstance);
-    m_playback.addListener(&m_privacyFilter);
+    QSettings settings(m_configFile, QSettings::IniFormat);
+
+    // Optional recording of the input frames (General/record), it can be played again opening the file
+    const QString recordFile = settings.value("General/record").toString();
+
+    // The recording would overwrite the file being played
+    const bool recordingInput = !recordFile.isEmpty() && !ui->checkUseConnected->isChecked() &&
+            QFileInfo(recordFile).exists() &&
+            QFileInfo(recordFile).canonicalFilePath() == QFileInfo(path).canonicalFilePath();
+
+    if (recordingInput) {
+        qDebug() << "The input can't be recorded to the file being played" << recordFile;
+    }
+    else if (!recordFile.isEmpty()) {
+        m_recorder = make_shared<dai::StreamRecorder>(recordFile);
+        m_playback.addListener(m_recorder.get());
+    }
+
+    // Last seconds of input and filtered frames, written on SIGUSR1 or on a crash (Ring/seconds, 0 disables them)
+    dai::RingRecorder::Settings ring;
+    ring.seconds = settings.value("Ring/seconds", ring.seconds).toInt();
+    ring.maxMegabytes = settings.value("Ring/maxMegabytes", ring.maxMegabytes).toInt();
+
+    if (ring.seconds > 0 && !m_inputRing) {
+        const QString ringDir = settings.value("Ring/directory", QApplication::applicationDirPath() + "/ring").toString();
+        m_inputRing = make_shared<dai::RingRecorder>("input", ringDir, ring);
+        m_outputRing = make_shared<dai::RingRecorder>("output", ringDir, ring);
+        m_playback.addListener(m_inputRing.get());
+        m_privacyFilter.addListener(m_outputRing.get());
+    }
+
+    // Input and filtered frames published for other processes (Transport/input, Transport/output)
+    const QString inputName = settings.value("Transport/input").toString();
+    const QString outputName = settings.value("Transport/output").toString();
+
+    if (!inputName.isEmpty() && !m_inputPublisher) {
+        m_inputPublisher = make_shared<dai::SharedMemoryPublisher>(inputName);
+        m_playback.addListener(m_inputPublisher.get());
+    }
+
+    if (!outputName.isEmpty() && !m_outputPublisher) {
+        m_outputPublisher = make_shared<dai::SharedMemoryPublisher>(outputName);
+        m_privacyFilter.addListener(m_outputPublisher.get());
+    }
+
+    // Memory of the frames (Memory/budgetMegabytes with Memory/policy warn or drop, and a
+    // report in the log every Memory/reportSeconds, 0 disables them)
+    const qint64 budget = settings.value("Memory/budgetMegabytes", 0).toLongLong() * 1024 * 1024;
+    const bool dropFrames = settings.value("Memory/policy", "warn").toString() == "drop";
+    dai::MemoryTracker::setBudget(QString(), budget, dropFrames ? dai::MemoryTracker::BUDGET_DROP
+                                                                : dai::MemoryTracker::BUDGET_WARN);
+    dai::MemoryTracker::startReports(settings.value("Memory/reportSeconds", 0).toInt());
+
+    // Skeletons are smoothed before the privacy filter (General/smoothing, enabled by default)
+    if (settings.value("General/smoothing", true).toBool()) {
+        m_playback.addListener(&m_skeletonFilter);
+        m_skeletonFilter.addListener(&m_privacyFilter);
+    } else {
+        m_playback.addListener(&m_privacyFilter);
+    }
 
     // Create viewers
     dai::InstanceViewerWindow* out_viewer_color = new dai::InstanceViewerWindow;
@@ -101,8 +192,26 @@ void MainWindow::on_btnStartKinect_clicked()
     //m_playback.addListener(out_viewer_color);
     m_privacyFilter.addListener(out_viewer_color);
 
+    // Virtual camera of the point cloud filter
+    dai::PointCloudRenderer::Settings pointCloud;
+    pointCloud.yaw = settings.value("PointCloud/yaw", pointCloud.yaw).toFloat();
+    pointCloud.pitch = settings.value("PointCloud/pitch", pointCloud.pitch).toFloat();
+    pointCloud.distance = settings.value("PointCloud/distance", pointCloud.distance).toFloat();
+    pointCloud.colourBackground = settings.value("PointCloud/colourBackground", pointCloud.colourBackground).toBool();
+    m_privacyFilter.setPointCloudSettings(pointCloud);
+
     // Run
     m_privacyFilter.enableFilter(FILTER_DISABLED);
+
+    // Faces are pixelated over any filter (General/faceBlurring, also in the control window)
+    m_privacyFilter.enableFaceBlurring(settings.value("General/faceBlurring", false).toBool());
+
+    // Optional policy file, it is loaded again when it changes
+    const QString policyFile = settings.value("General/policy").toString();
+
+    if (!policyFile.isEmpty() && !m_privacyFilter.loadPolicy(policyFile))
+        qDebug() << "The policy couldn't be loaded" << policyFile;
+
     m_control.show();
     out_viewer_color->show();
     m_playback.play();
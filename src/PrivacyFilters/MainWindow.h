@@ -5,6 +5,10 @@
 #include "playback/PlaybackControl.h"
 #include "filters/PrivacyFilter.h"
 #include "viewer/DepthFilter.h"
+#include "playback/SkeletonFilter.h"
+#include "playback/StreamRecorder.h"
+#include "playback/RingRecorder.h"
+#include "playback/SharedMemoryPublisher.h"
 #include "viewer/InstanceViewerWindow.h"
 
 #include "ControlWindow.h"
@@ -23,7 +27,13 @@ class MainWindow : public QMainWindow
 
     dai::OpenNIDevice*    m_device;
     dai::PlaybackControl  m_playback;
+    dai::SkeletonFilter   m_skeletonFilter;
     dai::PrivacyFilter    m_privacyFilter;
+    shared_ptr<dai::StreamRecorder> m_recorder;
+    shared_ptr<dai::RingRecorder> m_inputRing;
+    shared_ptr<dai::RingRecorder> m_outputRing;
+    shared_ptr<dai::SharedMemoryPublisher> m_inputPublisher;
+    shared_ptr<dai::SharedMemoryPublisher> m_outputPublisher;
     Ui::MainWindow *ui;
     QString m_configFile;
     ControlWindow m_control;